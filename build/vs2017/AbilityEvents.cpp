@@ -0,0 +1,63 @@
+#include "AbilityEvents.h"
+
+// ability event queue constructor
+// initialising ability event queue values
+
+AbilityEventQueue::AbilityEventQueue()
+{
+	Reset();
+}
+
+void AbilityEventQueue::Acquire(PICKUP_ABILITY ability)
+{
+	if (acquired[ability])
+	{
+		return;
+	}
+
+	acquired[ability] = true;
+	pending[pendingCount++] = ability;
+}
+
+bool AbilityEventQueue::PopEvent(PICKUP_ABILITY& ability)
+{
+	if (nextPending == pendingCount)
+	{
+		// empties the queue once everything is handled
+
+		pendingCount = 0;
+		nextPending = 0;
+
+		return false;
+	}
+
+	ability = pending[nextPending++];
+
+	return true;
+}
+
+void AbilityEventQueue::Reset()
+{
+	for (int i = 0; i < PICKUP_ABILITY_NUM; i++)
+	{
+		acquired[i] = false;
+	}
+
+	pendingCount = 0;
+	nextPending = 0;
+}
+
+const char* AbilityEventQueue::AbilityName(PICKUP_ABILITY ability)
+{
+	switch (ability)
+	{
+	case PICKUP_DASH:
+		return "dash";
+	case PICKUP_DOUBLE_JUMP:
+		return "double jump";
+	case PICKUP_RESET_WALL:
+		return "double jump reset";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// abilities the player can pick up
+
+enum PICKUP_ABILITY
+{
+	PICKUP_DASH,
+	PICKUP_DOUBLE_JUMP,
+	PICKUP_RESET_WALL,
+	PICKUP_ABILITY_NUM
+};
+
+// ability event queue
+// pickups are queued from the contact loop and handled once outside it
+// as bodies can't be switched off while walking the contact list
+// each ability only fires once per level, however many steps
+// the player spends touching the pickup
+
+class AbilityEventQueue
+{
+public:
+
+	// ability event queue constructor
+
+	AbilityEventQueue();
+
+	// queues the ability
+	// ignored if it has already been picked up
+
+	void Acquire(PICKUP_ABILITY ability);
+
+	// takes the next queued ability
+	// returns false once the queue is empty
+
+	bool PopEvent(PICKUP_ABILITY& ability);
+
+	// forgets every picked up ability
+	// used when the level starts
+
+	void Reset();
+
+	// getters
+
+	bool isAcquired(PICKUP_ABILITY ability) { return acquired[ability]; }
+
+	// name used for debug output
+
+	static const char* AbilityName(PICKUP_ABILITY ability);
+
+private:
+
+	// ability event queue variables
+	// each ability is only queued once so the queue never holds more than one of each
+
+	PICKUP_ABILITY pending[PICKUP_ABILITY_NUM];
+	int pendingCount;
+	int nextPending;
+	bool acquired[PICKUP_ABILITY_NUM];
+};
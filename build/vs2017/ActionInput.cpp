@@ -0,0 +1,157 @@
+#include "ActionInput.h"
+#include <input/input_manager.h>
+#include <input/sony_controller_input_manager.h>
+
+// how far the left stick has to be pushed
+// before it counts as a left / right press
+
+#define STICK_DEADZONE 0.5f
+
+// action input constructor
+// initialising action input values
+
+ActionInput::ActionInput()
+{
+	down = 0;
+	pressed = 0;
+	released = 0;
+
+	SetDefaultBindings();
+}
+
+// binds a key to an action
+
+void ActionInput::BindKey(INPUT_ACTION action, gef::Keyboard::KeyCode key)
+{
+	KeyBinding binding;
+	binding.action = action;
+	binding.key = key;
+
+	keyBindings.push_back(binding);
+}
+
+// binds a controller button to an action
+
+void ActionInput::BindButton(INPUT_ACTION action, UInt32 button)
+{
+	ButtonBinding binding;
+	binding.action = action;
+	binding.button = button;
+
+	buttonBindings.push_back(binding);
+}
+
+// removes all bindings
+
+void ActionInput::ClearBindings()
+{
+	keyBindings.clear();
+	buttonBindings.clear();
+}
+
+// sets up the keys shown in the How To Play screen
+// and matching buttons for the controller
+
+void ActionInput::SetDefaultBindings()
+{
+	ClearBindings();
+
+	// keyboard bindings
+
+	BindKey(ACTION_UP, gef::Keyboard::KC_UP);
+	BindKey(ACTION_DOWN, gef::Keyboard::KC_DOWN);
+	BindKey(ACTION_LEFT, gef::Keyboard::KC_LEFT);
+	BindKey(ACTION_RIGHT, gef::Keyboard::KC_RIGHT);
+	BindKey(ACTION_JUMP, gef::Keyboard::KC_UP);
+	BindKey(ACTION_DASH, gef::Keyboard::KC_LCONTROL);
+	BindKey(ACTION_CONFIRM, gef::Keyboard::KC_RETURN);
+	BindKey(ACTION_BACK, gef::Keyboard::KC_BACKSPACE);
+	BindKey(ACTION_SKIP, gef::Keyboard::KC_SPACE);
+	BindKey(ACTION_RESET, gef::Keyboard::KC_R);
+	BindKey(ACTION_PAUSE, gef::Keyboard::KC_P);
+	BindKey(ACTION_MAP_TOGGLE, gef::Keyboard::KC_M);
+	BindKey(ACTION_QUIT, gef::Keyboard::KC_ESCAPE);
+
+	// controller bindings
+
+	BindButton(ACTION_UP, gef_SONY_CTRL_UP);
+	BindButton(ACTION_DOWN, gef_SONY_CTRL_DOWN);
+	BindButton(ACTION_LEFT, gef_SONY_CTRL_LEFT);
+	BindButton(ACTION_RIGHT, gef_SONY_CTRL_RIGHT);
+	BindButton(ACTION_JUMP, gef_SONY_CTRL_CROSS);
+	BindButton(ACTION_DASH, gef_SONY_CTRL_SQUARE);
+	BindButton(ACTION_CONFIRM, gef_SONY_CTRL_CROSS);
+	BindButton(ACTION_BACK, gef_SONY_CTRL_CIRCLE);
+	BindButton(ACTION_SKIP, gef_SONY_CTRL_START);
+	BindButton(ACTION_RESET, gef_SONY_CTRL_TRIANGLE);
+	BindButton(ACTION_PAUSE, gef_SONY_CTRL_START);
+	BindButton(ACTION_MAP_TOGGLE, gef_SONY_CTRL_SELECT);
+}
+
+// reads the keyboard and controller
+// and builds the actions held down this frame
+
+void ActionInput::Update(gef::InputManager* im)
+{
+	UInt32 newDown = 0;
+
+	if (im)
+	{
+		// keyboard
+
+		const gef::Keyboard* kb = im->keyboard();
+
+		if (kb)
+		{
+			for (int i = 0; i < keyBindings.size(); i++)
+			{
+				if (kb->IsKeyDown(keyBindings[i].key))
+				{
+					newDown |= ActionBit(keyBindings[i].action);
+				}
+			}
+		}
+
+		// controller
+
+		gef::SonyControllerInputManager* controllerInput = im->controller_input();
+		const gef::SonyController* controller = controllerInput ? controllerInput->GetController(0) : NULL;
+
+		if (controller)
+		{
+			UInt32 buttons = controller->buttons_down();
+
+			for (int i = 0; i < buttonBindings.size(); i++)
+			{
+				if (buttons & buttonBindings[i].button)
+				{
+					newDown |= ActionBit(buttonBindings[i].action);
+				}
+			}
+
+			// left stick also moves left and right
+
+			if (controller->left_stick_x_axis() < -STICK_DEADZONE)
+			{
+				newDown |= ActionBit(ACTION_LEFT);
+			}
+
+			if (controller->left_stick_x_axis() > STICK_DEADZONE)
+			{
+				newDown |= ActionBit(ACTION_RIGHT);
+			}
+		}
+	}
+
+	UpdateFromActions(newDown);
+}
+
+// works out which actions were pressed and released
+// by comparing against last frame
+
+void ActionInput::UpdateFromActions(UInt32 downActions)
+{
+	pressed = downActions & ~down;
+	released = down & ~downActions;
+	down = downActions;
+}
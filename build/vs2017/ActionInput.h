@@ -0,0 +1,104 @@
+#pragma once
+#include <input/keyboard.h>
+#include <vector>
+
+// FRAMEWORK FORWARD DECLARATIONS
+namespace gef
+{
+	class InputManager;
+}
+
+// input actions
+// everything the game reacts to, separate from
+// which key or button is used to trigger it
+
+enum INPUT_ACTION
+{
+	ACTION_UP,
+	ACTION_DOWN,
+	ACTION_LEFT,
+	ACTION_RIGHT,
+	ACTION_JUMP,
+	ACTION_DASH,
+	ACTION_CONFIRM,
+	ACTION_BACK,
+	ACTION_SKIP,
+	ACTION_RESET,
+	ACTION_PAUSE,
+	ACTION_MAP_TOGGLE,
+	ACTION_QUIT,
+
+	// number of actions
+	// must stay at or below 32 to fit in the bitset
+	ACTION_COUNT
+};
+
+class ActionInput
+{
+public:
+
+	// action input constructor
+
+	ActionInput();
+
+	// binds keys and controller buttons to actions
+	// an action can have any number of bindings
+
+	void BindKey(INPUT_ACTION action, gef::Keyboard::KeyCode key);
+	void BindButton(INPUT_ACTION action, UInt32 button);
+	void ClearBindings();
+
+	// sets up the bindings used by the game
+	void SetDefaultBindings();
+
+	// reads the keyboard and controller once per frame
+	// and turns them into actions
+
+	void Update(gef::InputManager* im);
+
+	// sets the actions held down this frame directly
+	// used by Update, and by replays or bots to inject input
+
+	void UpdateFromActions(UInt32 downActions);
+
+	// checks the state of an action this frame
+
+	bool IsDown(INPUT_ACTION action) const { return (down & ActionBit(action)) != 0; }
+	bool IsPressed(INPUT_ACTION action) const { return (pressed & ActionBit(action)) != 0; }
+	bool IsReleased(INPUT_ACTION action) const { return (released & ActionBit(action)) != 0; }
+
+	// raw action bitsets for this frame
+
+	UInt32 getDownActions() const { return down; }
+	UInt32 getPressedActions() const { return pressed; }
+	UInt32 getReleasedActions() const { return released; }
+
+	// returns the bit used for an action
+	static UInt32 ActionBit(INPUT_ACTION action) { return 1u << action; }
+
+private:
+
+	// binding variables
+
+	struct KeyBinding
+	{
+		INPUT_ACTION action;
+		gef::Keyboard::KeyCode key;
+	};
+
+	struct ButtonBinding
+	{
+		INPUT_ACTION action;
+		UInt32 button;
+	};
+
+	std::vector<KeyBinding> keyBindings;
+	std::vector<ButtonBinding> buttonBindings;
+
+	// action state variables
+
+	UInt32 down;
+	UInt32 pressed;
+	UInt32 released;
+};
+
@@ -0,0 +1,129 @@
+#include "ActivityRegion.h"
+
+// activity region manager constructor
+// initialising activity region values
+
+ActivityRegionManager::ActivityRegionManager()
+{
+	activityRadius = 40.0f;
+	firstUpdate = true;
+}
+
+// adds a region to the level
+
+void ActivityRegionManager::AddRegion(b2Vec2 lowerBound, b2Vec2 upperBound)
+{
+	ActivityRegion region;
+	region.area.lowerBound = lowerBound;
+	region.area.upperBound = upperBound;
+	region.isActive = true;
+
+	regions.push_back(region);
+}
+
+// adds a body to the first region
+// that contains its position
+
+void ActivityRegionManager::AddBody(b2Body* body)
+{
+	if (body)
+	{
+		b2Vec2 pos = body->GetPosition();
+
+		for (int i = 0; i < regions.size(); i++)
+		{
+			if (pos.x >= regions[i].area.lowerBound.x && pos.x <= regions[i].area.upperBound.x &&
+				pos.y >= regions[i].area.lowerBound.y && pos.y <= regions[i].area.upperBound.y)
+			{
+				regions[i].bodies.push_back(body);
+				return;
+			}
+		}
+	}
+}
+
+// turns regions on or off based on the player position
+// only regions that change state touch their bodies
+// so the steady state cost is one check per region
+
+void ActivityRegionManager::Update(b2Vec2 playerPos)
+{
+	for (int i = 0; i < regions.size(); i++)
+	{
+		bool inRange = IsInRange(regions[i], playerPos);
+
+		if (firstUpdate || inRange != regions[i].isActive)
+		{
+			SetRegionActive(regions[i], inRange);
+		}
+	}
+
+	firstUpdate = false;
+}
+
+// removes all regions and bodies
+// the bodies themselves are destroyed with the world
+
+void ActivityRegionManager::Clear()
+{
+	regions.clear();
+	firstUpdate = true;
+}
+
+// returns the number of regions currently active
+
+int ActivityRegionManager::getActiveRegionCount()
+{
+	int count = 0;
+
+	for (int i = 0; i < regions.size(); i++)
+	{
+		if (regions[i].isActive)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+// returns the number of region bodies currently active
+
+int ActivityRegionManager::getActiveBodyCount()
+{
+	int count = 0;
+
+	for (int i = 0; i < regions.size(); i++)
+	{
+		if (regions[i].isActive)
+		{
+			count += regions[i].bodies.size();
+		}
+	}
+
+	return count;
+}
+
+// turns every body in the region on or off
+// inactive bodies keep their position and velocity
+// so they carry on exactly where they left off
+// once the player comes back
+
+void ActivityRegionManager::SetRegionActive(ActivityRegion& region, bool active)
+{
+	region.isActive = active;
+
+	for (int i = 0; i < region.bodies.size(); i++)
+	{
+		region.bodies[i]->SetActive(active);
+	}
+}
+
+// checks if the player is inside the region
+// grown by the activity radius
+
+bool ActivityRegionManager::IsInRange(const ActivityRegion& region, b2Vec2 playerPos)
+{
+	return playerPos.x >= region.area.lowerBound.x - activityRadius && playerPos.x <= region.area.upperBound.x + activityRadius &&
+		playerPos.y >= region.area.lowerBound.y - activityRadius && playerPos.y <= region.area.upperBound.y + activityRadius;
+}
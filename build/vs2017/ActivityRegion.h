@@ -0,0 +1,74 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+
+// activity region
+// an area of the level holding the moving
+// bodies (enemies, moving platforms) placed inside it
+// so they can be switched off while the player is far away
+
+struct ActivityRegion
+{
+	b2AABB area;
+	bool isActive;
+	std::vector<b2Body*> bodies;
+};
+
+class ActivityRegionManager
+{
+public:
+
+	// activity region manager constructor
+
+	ActivityRegionManager();
+
+	// adds a region to the level
+	// regions are checked in the order they are added
+
+	void AddRegion(b2Vec2 lowerBound, b2Vec2 upperBound);
+
+	// adds a body to the region containing
+	// its current position
+	// bodies outside every region are left alone
+
+	void AddBody(b2Body* body);
+
+	// turns regions on or off depending on
+	// whether the player is within the activity radius
+	// of them
+
+	void Update(b2Vec2 playerPos);
+
+	// removes all regions and bodies
+	// used when the level is released
+
+	void Clear();
+
+	// setters and getters
+
+	// distance outside a region the player
+	// can be before it is switched off
+	void setActivityRadius(float radius) { activityRadius = radius; }
+	float getActivityRadius() { return activityRadius; }
+
+	// number of regions / bodies currently being simulated
+	int getActiveRegionCount();
+	int getActiveBodyCount();
+
+private:
+
+	// turns every body in a region on or off
+	void SetRegionActive(ActivityRegion& region, bool active);
+
+	// checks if the player is close enough to a region
+	bool IsInRange(const ActivityRegion& region, b2Vec2 playerPos);
+
+	// activity region variables
+
+	std::vector<ActivityRegion> regions;
+	float activityRadius;
+
+	// used to force every region to be set on the first update
+	bool firstUpdate;
+};
+
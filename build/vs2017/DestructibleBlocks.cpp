@@ -0,0 +1,171 @@
+#include "DestructibleBlocks.h"
+#include <graphics/renderer_3d.h>
+
+// friction of the blocks, the same as the platforms
+
+#define BLOCK_FRICTION 1.25f
+
+// destructible blocks constructor
+// initialising destructible blocks values
+
+DestructibleBlocks::DestructibleBlocks()
+{
+	world = NULL;
+	halfSize = b2Vec2(0.5f, 0.5f);
+	crumbleSeconds = 0.5f;
+	maxBlocks = 0;
+	mesh = NULL;
+	meshScale = gef::Vector4(1.0f, 1.0f, 1.0f);
+}
+
+void DestructibleBlocks::Init(b2World* world, int maxBlocks, b2Vec2 halfSize, float crumbleSeconds)
+{
+	Clear();
+
+	this->world = world;
+	this->maxBlocks = maxBlocks;
+	this->halfSize = halfSize;
+	this->crumbleSeconds = crumbleSeconds;
+
+	objects.reserve(maxBlocks);
+	bodies.reserve(maxBlocks);
+	crumbleTimes.reserve(maxBlocks);
+}
+
+bool DestructibleBlocks::AddBlock(b2Vec2 position)
+{
+	if (!world || (int)bodies.size() >= maxBlocks)
+	{
+		return false;
+	}
+
+	// create a physics body
+	b2BodyDef body_def;
+	body_def.type = b2_staticBody;
+	body_def.position = position;
+
+	b2Body* body = world->CreateBody(&body_def);
+
+	// create the shape
+	b2PolygonShape shape;
+	shape.SetAsBox(halfSize.x, halfSize.y);
+
+	// create the fixture on the rigid body
+	b2FixtureDef fixture_def;
+	fixture_def.shape = &shape;
+	fixture_def.friction = BLOCK_FRICTION;
+
+	body->CreateFixture(&fixture_def);
+
+	objects.push_back(GameObject());
+	bodies.push_back(body);
+	crumbleTimes.push_back(-1.0f);
+
+	GameObject& object = objects.back();
+	object.set_type(DESTRUCTIBLE);
+	object.set_mesh(mesh);
+	object.setScale(meshScale);
+	object.UpdateFromSimulation(body);
+
+	body->SetUserData(&object);
+
+	return true;
+}
+
+void DestructibleBlocks::Update(float frame_time, const b2Body* playerBody, DestructionQueue& destruction)
+{
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		// starts crumbling once the player touches it
+
+		if (crumbleTimes[i] < 0.0f)
+		{
+			for (b2ContactEdge* edge = bodies[i]->GetContactList(); edge; edge = edge->next)
+			{
+				if (edge->other == playerBody && edge->contact->IsTouching())
+				{
+					crumbleTimes[i] = 0.0f;
+					break;
+				}
+			}
+
+			continue;
+		}
+
+		// queued once, on the update it runs out
+
+		float previousTime = crumbleTimes[i];
+		crumbleTimes[i] += frame_time;
+
+		if (previousTime < crumbleSeconds && crumbleTimes[i] >= crumbleSeconds)
+		{
+			destruction.Queue(bodies[i], DESTRUCTION_DESTROY);
+		}
+	}
+}
+
+bool DestructibleBlocks::Remove(const b2Body* body)
+{
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		if (bodies[i] != body)
+		{
+			continue;
+		}
+
+		// moves the last block into the gap
+		// and points its body at the object's new place
+
+		size_t last = bodies.size() - 1;
+
+		if (i != last)
+		{
+			objects[i] = objects[last];
+			bodies[i] = bodies[last];
+			crumbleTimes[i] = crumbleTimes[last];
+
+			bodies[i]->SetUserData(&objects[i]);
+		}
+
+		objects.pop_back();
+		bodies.pop_back();
+		crumbleTimes.pop_back();
+
+		return true;
+	}
+
+	return false;
+}
+
+void DestructibleBlocks::SetMesh(gef::Mesh* mesh, gef::Vector4 scale)
+{
+	this->mesh = mesh;
+	meshScale = scale;
+
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		objects[i].set_mesh(mesh);
+		objects[i].setScale(scale);
+		objects[i].UpdateFromSimulation(bodies[i]);
+	}
+}
+
+void DestructibleBlocks::Render(gef::Renderer3D* renderer)
+{
+	if (!mesh)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		renderer->DrawMesh(objects[i]);
+	}
+}
+
+void DestructibleBlocks::Clear()
+{
+	objects.clear();
+	bodies.clear();
+	crumbleTimes.clear();
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+#include "game_object.h"
+#include "DestructionQueue.h"
+
+// FRAMEWORK FORWARD DECLARATIONS
+namespace gef
+{
+	class Renderer3D;
+	class Mesh;
+};
+
+// destructible blocks
+// static blocks that crumble a short time after the player touches them
+// each block's values are kept in dense arrays, a destroyed block's place
+// is taken by the last block so only blocks still in the level are updated and drawn
+
+class DestructibleBlocks
+{
+public:
+
+	// destructible blocks constructor
+
+	DestructibleBlocks();
+
+	// sets the world blocks are created in, the most blocks,
+	// their half size and how long they last once touched
+
+	void Init(b2World* world, int maxBlocks, b2Vec2 halfSize, float crumbleSeconds);
+
+	// adds a block centred on the position
+	// returns false if there's no room for it
+
+	bool AddBlock(b2Vec2 position);
+
+	// starts any block the player is touching crumbling
+	// and queues the blocks that have finished to be destroyed
+
+	void Update(float frame_time, const b2Body* playerBody, DestructionQueue& destruction);
+
+	// takes out the block of a body the destruction queue destroyed
+	// returns false if the body wasn't a block
+
+	bool Remove(const b2Body* body);
+
+	// sets the mesh every block is drawn with
+
+	void SetMesh(gef::Mesh* mesh, gef::Vector4 scale);
+
+	// draws every block
+
+	void Render(gef::Renderer3D* renderer);
+
+	// forgets every block
+	// the bodies are left to be destroyed with the world
+
+	void Clear();
+
+	// getters
+
+	int getBlockCount() const { return (int)bodies.size(); }
+	int getMaxBlocks() const { return maxBlocks; }
+	const gef::Mesh* getMesh() const { return mesh; }
+
+private:
+
+	// destructible blocks variables
+
+	b2World* world;
+	b2Vec2 halfSize;
+	float crumbleSeconds;
+	int maxBlocks;
+
+	// block values, one entry each at the same index
+	// objects are reserved in Init so the ones given to bodies never move
+	std::vector<GameObject> objects;
+	std::vector<b2Body*> bodies;
+
+	// game time since the player first touched each block, below 0 if they haven't
+	std::vector<float> crumbleTimes;
+
+	gef::Mesh* mesh;
+	gef::Vector4 meshScale;
+};
@@ -0,0 +1,82 @@
+#include "DestructionQueue.h"
+#include "game_object.h"
+#include <algorithm>
+
+// destruction queue constructor
+// initialising destruction queue values
+
+DestructionQueue::DestructionQueue()
+{
+	disableOnly = false;
+	destroyedTotal = 0;
+}
+
+void DestructionQueue::Queue(b2Body* body, DESTRUCTION_ACTION action)
+{
+	if (!body)
+	{
+		return;
+	}
+
+	QueuedBody entry;
+	entry.body = body;
+	entry.action = disableOnly ? DESTRUCTION_DISABLE : action;
+
+	queued.push_back(entry);
+}
+
+int DestructionQueue::Flush(b2World* world)
+{
+	destroyed.clear();
+
+	if (queued.empty() || world->IsLocked())
+	{
+		return 0;
+	}
+
+	// orders the queue by body, destroying first
+	// so the first of each body's entries is the one kept
+
+	std::sort(queued.begin(), queued.end(), [](const QueuedBody& a, const QueuedBody& b)
+	{
+		return a.body != b.body ? a.body < b.body : a.action > b.action;
+	});
+
+	for (size_t i = 0; i < queued.size(); i++)
+	{
+		// skips the repeats of a body already handled
+
+		if (i > 0 && queued[i].body == queued[i - 1].body)
+		{
+			continue;
+		}
+
+		b2Body* body = queued[i].body;
+
+		if (queued[i].action == DESTRUCTION_DISABLE)
+		{
+			body->SetActive(false);
+			continue;
+		}
+
+		DestroyedBody entry;
+		entry.body = body;
+		entry.object = (GameObject*)body->GetUserData();
+		entry.position = body->GetPosition();
+		destroyed.push_back(entry);
+
+		world->DestroyBody(body);
+	}
+
+	queued.clear();
+	destroyedTotal += (int)destroyed.size();
+
+	return (int)destroyed.size();
+}
+
+void DestructionQueue::Clear()
+{
+	queued.clear();
+	destroyed.clear();
+	destroyedTotal = 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+
+class GameObject;
+
+// what happens to a queued body
+
+enum DESTRUCTION_ACTION
+{
+	DESTRUCTION_DISABLE,
+	DESTRUCTION_DESTROY
+};
+
+// a body destroyed by the last flush
+// the object and position are read from it before it goes
+// the body is only kept to compare against, it must not be used
+
+struct DestroyedBody
+{
+	b2Body* body;
+	GameObject* object;
+	b2Vec2 position;
+};
+
+// destruction queue
+// bodies can't be destroyed or switched off while the world is stepping
+// or while its contact list is walked, so they are queued and
+// handled together once the step and contact checks are done
+
+class DestructionQueue
+{
+public:
+
+	// destruction queue constructor
+
+	DestructionQueue();
+
+	// queues a body to be switched off or destroyed by the next flush
+	// a body queued more than once is only handled once, destroying it if asked to either time
+
+	void Queue(b2Body* body, DESTRUCTION_ACTION action);
+
+	// switches off or destroys every queued body
+	// the owners of the bodies destroyed let go of them after, reading getDestroyed
+	// does nothing while the world is stepping
+	// returns the number of bodies destroyed
+
+	int Flush(b2World* world);
+
+	// forgets the queued and destroyed bodies
+	// used when the world they were in is deleted
+
+	void Clear();
+
+	// setters and getters
+
+	// when set, bodies queued to be destroyed are only switched off
+	// used by the simulations, which switch the level back on when they reset
+	void setDisableOnly(bool disableOnly) { this->disableOnly = disableOnly; }
+
+	const std::vector<DestroyedBody>& getDestroyed() const { return destroyed; }
+	int getQueuedCount() const { return (int)queued.size(); }
+	int getDestroyedTotal() const { return destroyedTotal; }
+
+private:
+
+	struct QueuedBody
+	{
+		b2Body* body;
+		DESTRUCTION_ACTION action;
+	};
+
+	// destruction queue variables
+
+	std::vector<QueuedBody> queued;
+
+	// bodies destroyed by the last flush
+	std::vector<DestroyedBody> destroyed;
+
+	bool disableOnly;
+	int destroyedTotal;
+};
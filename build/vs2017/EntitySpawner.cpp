@@ -0,0 +1,304 @@
+#include "EntitySpawner.h"
+#include "Logger.h"
+#include <graphics/renderer_3d.h>
+
+// handles pack the slot, the archetype and the slot's generation
+// 16 bits of slot, 4 of archetype and 11 of generation keep them positive
+
+#define SPAWNER_SLOT_BITS 16
+#define SPAWNER_ARCHETYPE_BITS 4
+#define SPAWNER_GENERATION_BITS 11
+
+// most archetypes the spawner holds and bodies in each pool
+
+#define SPAWNER_MAX_ARCHETYPES (1 << SPAWNER_ARCHETYPE_BITS)
+#define SPAWNER_MAX_POOL_SIZE (1 << SPAWNER_SLOT_BITS)
+
+// where pooled bodies wait, well below the level
+
+#define SPAWNER_PARK_X 0.0f
+#define SPAWNER_PARK_Y -1000.0f
+
+// spawn archetype constructor
+// initialising spawn archetype values
+
+SpawnArchetype::SpawnArchetype()
+{
+	name = "";
+	objectType = GROUND;
+	bodyType = b2_dynamicBody;
+	halfSize = b2Vec2(0.5f, 0.5f);
+	density = 1.0f;
+	friction = 0.3f;
+	fixedRotation = false;
+	poolSize = 0;
+}
+
+// entity spawner constructor
+// initialising entity spawner values
+
+EntitySpawner::EntitySpawner()
+{
+	world = NULL;
+	pools.reserve(SPAWNER_MAX_ARCHETYPES);
+}
+
+void EntitySpawner::Init(b2World* world)
+{
+	Clear();
+
+	this->world = world;
+}
+
+int EntitySpawner::AddArchetype(const SpawnArchetype& archetype)
+{
+	if (!world || (int)pools.size() >= SPAWNER_MAX_ARCHETYPES || archetype.poolSize > SPAWNER_MAX_POOL_SIZE)
+	{
+		return -1;
+	}
+
+	pools.push_back(SpawnPool());
+
+	SpawnPool& pool = pools.back();
+	pool.archetype = archetype;
+	pool.mesh = NULL;
+
+	pool.stats.poolSize = archetype.poolSize;
+	pool.stats.active = 0;
+	pool.stats.peakActive = 0;
+	pool.stats.spawned = 0;
+	pool.stats.exhausted = 0;
+
+	pool.objects.resize(archetype.poolSize);
+	pool.bodies.resize(archetype.poolSize);
+	pool.lifetimes.assign(archetype.poolSize, 0.0f);
+	pool.generations.assign(archetype.poolSize, 0);
+	pool.activeIndex.assign(archetype.poolSize, -1);
+	pool.activeSlots.reserve(archetype.poolSize);
+	pool.freeSlots.reserve(archetype.poolSize);
+
+	// every body is created switched off
+	// so it has no broadphase proxy until it's spawned
+
+	b2BodyDef body_def;
+	body_def.type = archetype.bodyType;
+	body_def.position = b2Vec2(SPAWNER_PARK_X, SPAWNER_PARK_Y);
+	body_def.fixedRotation = archetype.fixedRotation;
+	body_def.active = false;
+
+	b2PolygonShape shape;
+	shape.SetAsBox(archetype.halfSize.x, archetype.halfSize.y);
+
+	b2FixtureDef fixture_def;
+	fixture_def.shape = &shape;
+	fixture_def.density = archetype.density;
+	fixture_def.friction = archetype.friction;
+
+	for (int i = 0; i < archetype.poolSize; i++)
+	{
+		pool.objects[i].set_type(archetype.objectType);
+
+		pool.bodies[i] = world->CreateBody(&body_def);
+		pool.bodies[i]->CreateFixture(&fixture_def);
+		pool.bodies[i]->SetUserData(&pool.objects[i]);
+	}
+
+	// the lowest slots are handed out first
+
+	for (int i = archetype.poolSize - 1; i >= 0; i--)
+	{
+		pool.freeSlots.push_back(i);
+	}
+
+	return (int)pools.size() - 1;
+}
+
+int EntitySpawner::Spawn(int archetype, b2Vec2 position, b2Vec2 velocity, float lifetime)
+{
+	if (archetype < 0 || archetype >= (int)pools.size())
+	{
+		return -1;
+	}
+
+	SpawnPool& pool = pools[archetype];
+
+	if (pool.freeSlots.empty())
+	{
+		pool.stats.exhausted++;
+		return -1;
+	}
+
+	int slot = pool.freeSlots.back();
+	pool.freeSlots.pop_back();
+
+	// placed while still switched off so the broadphase is only touched once
+
+	b2Body* body = pool.bodies[slot];
+	body->SetTransform(position, 0.0f);
+	body->SetLinearVelocity(velocity);
+	body->SetAngularVelocity(0.0f);
+	body->SetActive(true);
+	body->SetAwake(true);
+
+	pool.objects[slot].UpdateFromSimulation(body);
+	pool.lifetimes[slot] = lifetime;
+
+	pool.activeIndex[slot] = (int)pool.activeSlots.size();
+	pool.activeSlots.push_back(slot);
+
+	pool.stats.spawned++;
+	pool.stats.active = (int)pool.activeSlots.size();
+	pool.stats.peakActive = b2Max(pool.stats.peakActive, pool.stats.active);
+
+	int generation = (int)(pool.generations[slot] & ((1u << SPAWNER_GENERATION_BITS) - 1));
+
+	return (generation << (SPAWNER_SLOT_BITS + SPAWNER_ARCHETYPE_BITS)) | (archetype << SPAWNER_SLOT_BITS) | slot;
+}
+
+void EntitySpawner::Despawn(int handle)
+{
+	int archetype;
+	int slot;
+
+	// ignores handles already put back, even once their slot is spawned again
+
+	if (FindSlot(handle, archetype, slot))
+	{
+		Release(pools[archetype], slot);
+	}
+}
+
+void EntitySpawner::Update(float frame_time)
+{
+	for (size_t p = 0; p < pools.size(); p++)
+	{
+		SpawnPool& pool = pools[p];
+
+		// walked backwards as releasing moves the last slot into the gap
+
+		for (int i = (int)pool.activeSlots.size() - 1; i >= 0; i--)
+		{
+			int slot = pool.activeSlots[i];
+
+			if (pool.lifetimes[slot] > 0.0f)
+			{
+				pool.lifetimes[slot] -= frame_time;
+
+				if (pool.lifetimes[slot] <= 0.0f)
+				{
+					Release(pool, slot);
+					continue;
+				}
+			}
+
+			pool.objects[slot].UpdateFromSimulation(pool.bodies[slot]);
+		}
+	}
+}
+
+void EntitySpawner::SetMesh(int archetype, gef::Mesh* mesh, gef::Vector4 scale)
+{
+	SpawnPool& pool = pools[archetype];
+	pool.mesh = mesh;
+
+	for (size_t i = 0; i < pool.objects.size(); i++)
+	{
+		pool.objects[i].set_mesh(mesh);
+		pool.objects[i].setScale(scale);
+	}
+}
+
+void EntitySpawner::Render(gef::Renderer3D* renderer)
+{
+	for (size_t p = 0; p < pools.size(); p++)
+	{
+		const SpawnPool& pool = pools[p];
+
+		if (!pool.mesh)
+		{
+			continue;
+		}
+
+		for (size_t i = 0; i < pool.activeSlots.size(); i++)
+		{
+			renderer->DrawMesh(pool.objects[pool.activeSlots[i]]);
+		}
+	}
+}
+
+void EntitySpawner::PrintStats()
+{
+	for (size_t p = 0; p < pools.size(); p++)
+	{
+		const SpawnPoolStats& stats = pools[p].stats;
+
+		LOG_INFO(LOG_GAME, "spawner: %s pool of %i, %i spawned, %i at most at once, %i turned away empty",
+			pools[p].archetype.name, stats.poolSize, stats.spawned, stats.peakActive, stats.exhausted);
+	}
+}
+
+void EntitySpawner::Clear()
+{
+	pools.clear();
+}
+
+b2Body* EntitySpawner::getBody(int handle) const
+{
+	int archetype;
+	int slot;
+
+	if (!FindSlot(handle, archetype, slot))
+	{
+		return NULL;
+	}
+
+	return pools[archetype].bodies[slot];
+}
+
+bool EntitySpawner::FindSlot(int handle, int& archetype, int& slot) const
+{
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	slot = handle & ((1 << SPAWNER_SLOT_BITS) - 1);
+	archetype = (handle >> SPAWNER_SLOT_BITS) & ((1 << SPAWNER_ARCHETYPE_BITS) - 1);
+	unsigned int generation = (unsigned int)handle >> (SPAWNER_SLOT_BITS + SPAWNER_ARCHETYPE_BITS);
+
+	if (archetype >= (int)pools.size() || slot >= (int)pools[archetype].bodies.size())
+	{
+		return false;
+	}
+
+	const SpawnPool& pool = pools[archetype];
+
+	return pool.activeIndex[slot] >= 0 && (pool.generations[slot] & ((1u << SPAWNER_GENERATION_BITS) - 1)) == generation;
+}
+
+void EntitySpawner::Release(SpawnPool& pool, int slot)
+{
+	// switched off before it's moved so the broadphase isn't touched
+
+	b2Body* body = pool.bodies[slot];
+	body->SetActive(false);
+	body->SetTransform(b2Vec2(SPAWNER_PARK_X, SPAWNER_PARK_Y), 0.0f);
+	body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+
+	// moves the last active slot into the gap
+
+	int index = pool.activeIndex[slot];
+	int last = pool.activeSlots.back();
+
+	pool.activeSlots[index] = last;
+	pool.activeIndex[last] = index;
+	pool.activeSlots.pop_back();
+	pool.activeIndex[slot] = -1;
+
+	// handles given out for the slot no longer match it
+
+	pool.generations[slot]++;
+
+	pool.freeSlots.push_back(slot);
+	pool.stats.active = (int)pool.activeSlots.size();
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+#include "game_object.h"
+
+// FRAMEWORK FORWARD DECLARATIONS
+namespace gef
+{
+	class Renderer3D;
+	class Mesh;
+};
+
+// a kind of entity the spawner keeps a pool of
+// each has one box fixture
+
+struct SpawnArchetype
+{
+	SpawnArchetype();
+
+	// name used for debug output
+	const char* name;
+
+	OBJECT_TYPE objectType;
+	b2BodyType bodyType;
+	b2Vec2 halfSize;
+	float density;
+	float friction;
+	bool fixedRotation;
+
+	// bodies created up front, the most that can be spawned at once
+	int poolSize;
+};
+
+// how an archetype's pool has been used
+
+struct SpawnPoolStats
+{
+	int poolSize;
+	int active;
+	int peakActive;
+	int spawned;
+
+	// spawns turned away because every body was in use
+	int exhausted;
+};
+
+// entity spawner
+// entities spawned during a level are taken from pools of bodies and objects
+// created when the level starts, so spawning never creates a body
+// a pooled body waits switched off below the level, spawning moves it into place
+// and switches it on, despawning switches it off and puts it back in the pool
+// a handle holds its slot's generation, which goes up each time the slot is put back,
+// so a handle kept after its entity despawns never reaches the next one in the slot
+
+class EntitySpawner
+{
+public:
+
+	// entity spawner constructor
+
+	EntitySpawner();
+
+	// sets the world pooled bodies are created in
+
+	void Init(b2World* world);
+
+	// creates an archetype's pool of switched off bodies and their objects
+	// returns the archetype's index, -1 if there's no room for it
+
+	int AddArchetype(const SpawnArchetype& archetype);
+
+	// takes a body from the archetype's pool and places it
+	// a lifetime above 0 despawns it once that much game time has passed
+	// returns the entity's handle, -1 if the pool is empty
+
+	int Spawn(int archetype, b2Vec2 position, b2Vec2 velocity, float lifetime = 0.0f);
+
+	// puts a spawned entity back in its pool
+	// handles of entities already despawned are ignored
+
+	void Despawn(int handle);
+
+	// moves the spawned objects to their bodies
+	// and despawns those whose lifetime is up
+
+	void Update(float frame_time);
+
+	// sets the mesh an archetype's entities are drawn with
+
+	void SetMesh(int archetype, gef::Mesh* mesh, gef::Vector4 scale);
+
+	// draws every spawned entity
+
+	void Render(gef::Renderer3D* renderer);
+
+	// prints each pool's use to the debug output
+
+	void PrintStats();
+
+	// forgets every pool
+	// the bodies are left to be destroyed with the world
+
+	void Clear();
+
+	// getters
+
+	int getArchetypeCount() const { return (int)pools.size(); }
+	const SpawnPoolStats& getStats(int archetype) const { return pools[archetype].stats; }
+	gef::Mesh* getMesh(int archetype) const { return pools[archetype].mesh; }
+	// NULL if the entity has been despawned
+	b2Body* getBody(int handle) const;
+
+private:
+
+	// an archetype's pooled bodies and objects, one entry each at the same index
+	struct SpawnPool
+	{
+		SpawnArchetype archetype;
+		SpawnPoolStats stats;
+
+		// objects are sized once so the ones given to bodies never move
+		std::vector<GameObject> objects;
+		std::vector<b2Body*> bodies;
+		std::vector<float> lifetimes;
+
+		// goes up each time a slot is put back
+		std::vector<unsigned int> generations;
+
+		// slots in the pool, and the spawned slots so updates skip the rest
+		// activeIndex is each slot's place in activeSlots, -1 while pooled
+		std::vector<int> freeSlots;
+		std::vector<int> activeSlots;
+		std::vector<int> activeIndex;
+
+		gef::Mesh* mesh;
+	};
+
+	// puts a slot back in its pool
+	void Release(SpawnPool& pool, int slot);
+
+	// finds the slot of a handle whose entity is still spawned
+	bool FindSlot(int handle, int& archetype, int& slot) const;
+
+	// entity spawner variables
+
+	b2World* world;
+
+	// reserved up front so the objects in each pool never move
+	std::vector<SpawnPool> pools;
+};
@@ -0,0 +1,771 @@
+#include "FlyingSwarm.h"
+#include "Timer.h"
+#include "Logger.h"
+#include <graphics/mesh.h>
+#include <graphics/primitive.h>
+#include <graphics/vertex_buffer.h>
+#include <graphics/renderer_3d.h>
+#include <system/platform.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SSE is used on the PC builds
+// other platforms steer every agent with the scalar version
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define SWARM_SSE 1
+#include <xmmintrin.h>
+#else
+#define SWARM_SSE 0
+#endif
+
+// default swarm tuning
+
+#define SWARM_SEPARATION_WEIGHT 1.5f
+#define SWARM_ALIGNMENT_WEIGHT 1.0f
+#define SWARM_COHESION_WEIGHT 0.5f
+#define SWARM_SEEK_WEIGHT 1.0f
+#define SWARM_SEPARATION_RADIUS 1.0f
+#define SWARM_SEEK_RANGE 40.0f
+#define SWARM_MAX_SPEED 8.0f
+#define SWARM_MAX_FORCE 20.0f
+
+// smallest squared distance divided by, so agents on top of each other don't divide by zero
+
+#define SWARM_EPSILON 0.0001f
+
+// agents per square unit the benchmark spawns at
+// the area grows with the swarm so each agent has about as many neighbours
+
+#define SWARM_BENCHMARK_DENSITY 0.25f
+
+#if SWARM_SSE
+
+// adds the four values of an SSE register together
+
+static inline float HorizontalSum(__m128 value)
+{
+	__m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(value, shuffled);
+	shuffled = _mm_movehl_ps(shuffled, sums);
+	sums = _mm_add_ss(sums, shuffled);
+
+	return _mm_cvtss_f32(sums);
+}
+
+// picks a where the mask is set and b where it isn't
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+#endif
+
+// swarm tuning constructor
+// initialising swarm tuning values
+
+SwarmTuning::SwarmTuning()
+{
+	separationWeight = SWARM_SEPARATION_WEIGHT;
+	alignmentWeight = SWARM_ALIGNMENT_WEIGHT;
+	cohesionWeight = SWARM_COHESION_WEIGHT;
+	seekWeight = SWARM_SEEK_WEIGHT;
+	separationRadius = SWARM_SEPARATION_RADIUS;
+	seekRange = SWARM_SEEK_RANGE;
+	maxSpeed = SWARM_MAX_SPEED;
+	maxForce = SWARM_MAX_FORCE;
+}
+
+// flying swarm constructor
+// initialising flying swarm values
+
+FlyingSwarm::FlyingSwarm()
+{
+	bounds.lowerBound = b2Vec2(0.0f, 0.0f);
+	bounds.upperBound = b2Vec2(0.0f, 0.0f);
+	useSimd = SWARM_SSE != 0;
+	agentCount = 0;
+	maxAgents = 0;
+	neighbourRadius = 1.0f;
+	inverseCellSize = 1.0f;
+	columns = 0;
+	rows = 0;
+	platform = NULL;
+	mesh = NULL;
+	agentSize = 0.5f;
+}
+
+void FlyingSwarm::Init(int maxAgents, const b2AABB& bounds, float neighbourRadius)
+{
+	this->maxAgents = maxAgents;
+	this->bounds = bounds;
+	this->neighbourRadius = neighbourRadius;
+	agentCount = 0;
+
+	int padded = (maxAgents + 3) & ~3;
+
+	posX.assign(padded, 0.0f);
+	posY.assign(padded, 0.0f);
+	velX.assign(padded, 0.0f);
+	velY.assign(padded, 0.0f);
+	sortedPosX.assign(padded, 0.0f);
+	sortedPosY.assign(padded, 0.0f);
+	sortedVelX.assign(padded, 0.0f);
+	sortedVelY.assign(padded, 0.0f);
+	agentCells.assign(padded, 0);
+
+	sumPosX.assign(padded, 0.0f);
+	sumPosY.assign(padded, 0.0f);
+	sumVelX.assign(padded, 0.0f);
+	sumVelY.assign(padded, 0.0f);
+	separationX.assign(padded, 0.0f);
+	separationY.assign(padded, 0.0f);
+	neighbourCount.assign(padded, 0.0f);
+
+	// cells are as wide as the neighbour radius
+	// so every neighbour is in the cells around an agent's own
+
+	inverseCellSize = 1.0f / neighbourRadius;
+	columns = b2Max(1, (int)ceilf((bounds.upperBound.x - bounds.lowerBound.x) * inverseCellSize));
+	rows = b2Max(1, (int)ceilf((bounds.upperBound.y - bounds.lowerBound.y) * inverseCellSize));
+	cellStarts.assign(columns * rows + 1, 0);
+}
+
+bool FlyingSwarm::AddAgent(b2Vec2 position, b2Vec2 velocity)
+{
+	if (agentCount >= maxAgents)
+	{
+		return false;
+	}
+
+	posX[agentCount] = position.x;
+	posY[agentCount] = position.y;
+	velX[agentCount] = velocity.x;
+	velY[agentCount] = velocity.y;
+	agentCount++;
+
+	return true;
+}
+
+void FlyingSwarm::Spawn(int count, const b2AABB& area)
+{
+	for (int i = 0; i < count; i++)
+	{
+		float u = (float)rand() / RAND_MAX;
+		float v = (float)rand() / RAND_MAX;
+		float angle = b2_pi * 2.0f * (float)rand() / RAND_MAX;
+
+		b2Vec2 position(area.lowerBound.x + u * (area.upperBound.x - area.lowerBound.x),
+			area.lowerBound.y + v * (area.upperBound.y - area.lowerBound.y));
+		b2Vec2 velocity(cosf(angle) * tuning.maxSpeed * 0.5f, sinf(angle) * tuning.maxSpeed * 0.5f);
+
+		if (!AddAgent(position, velocity))
+		{
+			return;
+		}
+	}
+}
+
+void FlyingSwarm::Update(float frame_time, b2Vec2 target)
+{
+	if (agentCount == 0)
+	{
+		return;
+	}
+
+	BuildGrid();
+
+	for (int i = 0; i < agentCount; i++)
+	{
+		AccumulateNeighbours(i);
+	}
+
+	// the values are padded to a multiple of four
+	// so the last group is steered whole, the padding is never read back
+
+#if SWARM_SSE
+	if (useSimd)
+	{
+		for (int i = 0; i < agentCount; i += 4)
+		{
+			SteerSimd(i, frame_time, target);
+		}
+
+		return;
+	}
+#endif
+
+	for (int i = 0; i < agentCount; i++)
+	{
+		SteerScalar(i, frame_time, target);
+	}
+}
+
+int FlyingSwarm::CountInRadius(b2Vec2 centre, float radius) const
+{
+	if (agentCount == 0)
+	{
+		return 0;
+	}
+
+	int minX = CellX(centre.x - radius);
+	int maxX = CellX(centre.x + radius);
+	int minY = CellY(centre.y - radius);
+	int maxY = CellY(centre.y + radius);
+
+	int count = 0;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		// the cells along a row are next to each other in the arrays
+
+		int start = cellStarts[y * columns + minX];
+		int end = cellStarts[y * columns + maxX + 1];
+
+		for (int j = start; j < end; j++)
+		{
+			float dx = posX[j] - centre.x;
+			float dy = posY[j] - centre.y;
+
+			if (dx * dx + dy * dy <= radius * radius)
+			{
+				count++;
+			}
+		}
+	}
+
+	return count;
+}
+
+void FlyingSwarm::InitMesh(gef::Platform& platform, float agentSize)
+{
+	ReleaseMesh();
+
+	this->platform = &platform;
+	this->agentSize = agentSize;
+
+	// three vertices for every agent there could be
+	// unused ones are left at zero so their triangles aren't drawn
+
+	int vertexCount = maxAgents * 3;
+
+	if (vertexCount == 0)
+	{
+		return;
+	}
+
+	std::vector<gef::Mesh::Vertex> vertices(vertexCount);
+	memset(&vertices[0], 0, vertices.size() * sizeof(gef::Mesh::Vertex));
+
+	for (int v = 0; v < vertexCount; v++)
+	{
+		vertices[v].nz = 1.0f;
+	}
+
+	mesh = new gef::Mesh(platform);
+	mesh->InitVertexBuffer(platform, &vertices[0], vertexCount, sizeof(gef::Mesh::Vertex), false);
+
+	mesh->AllocatePrimitives(1);
+	gef::Primitive* primitive = mesh->GetPrimitive(0);
+
+	if (vertexCount <= 0xffff)
+	{
+		std::vector<UInt16> indices(vertexCount);
+
+		for (int v = 0; v < vertexCount; v++)
+		{
+			indices[v] = (UInt16)v;
+		}
+
+		primitive->InitIndexBuffer(platform, &indices[0], vertexCount, sizeof(UInt16));
+	}
+	else
+	{
+		std::vector<UInt32> indices(vertexCount);
+
+		for (int v = 0; v < vertexCount; v++)
+		{
+			indices[v] = (UInt32)v;
+		}
+
+		primitive->InitIndexBuffer(platform, &indices[0], vertexCount, sizeof(UInt32));
+	}
+
+	primitive->set_type(gef::TRIANGLE_LIST);
+
+	// the bounds cover everywhere the agents can fly
+	// so the mesh is never culled while any are in view
+
+	gef::Aabb aabb(gef::Vector4(bounds.lowerBound.x - agentSize, bounds.lowerBound.y - agentSize, -agentSize),
+		gef::Vector4(bounds.upperBound.x + agentSize, bounds.upperBound.y + agentSize, agentSize));
+	mesh->set_aabb(aabb);
+
+	gef::Sphere sphere(aabb);
+	mesh->set_bounding_sphere(sphere);
+
+	gef::Matrix44 transform;
+	transform.SetIdentity();
+
+	meshInstance.set_mesh(mesh);
+	meshInstance.set_transform(transform);
+}
+
+void FlyingSwarm::Render(gef::Renderer3D* renderer)
+{
+	if (!mesh || agentCount == 0)
+	{
+		return;
+	}
+
+	// each agent is a triangle with its point facing the way it flies
+
+	gef::Mesh::Vertex* vertices = (gef::Mesh::Vertex*)mesh->vertex_buffer()->vertex_data();
+
+	for (int i = 0; i < agentCount; i++)
+	{
+		float speed = sqrtf(velX[i] * velX[i] + velY[i] * velY[i]);
+		float dx = speed > SWARM_EPSILON ? velX[i] / speed : 1.0f;
+		float dy = speed > SWARM_EPSILON ? velY[i] / speed : 0.0f;
+
+		float backX = posX[i] - dx * agentSize * 0.6f;
+		float backY = posY[i] - dy * agentSize * 0.6f;
+		float sideX = -dy * agentSize * 0.6f;
+		float sideY = dx * agentSize * 0.6f;
+
+		gef::Mesh::Vertex* triangle = &vertices[i * 3];
+
+		triangle[0].px = posX[i] + dx * agentSize;
+		triangle[0].py = posY[i] + dy * agentSize;
+		triangle[1].px = backX + sideX;
+		triangle[1].py = backY + sideY;
+		triangle[2].px = backX - sideX;
+		triangle[2].py = backY - sideY;
+	}
+
+	mesh->vertex_buffer()->Update(*platform);
+	renderer->DrawMesh(meshInstance);
+}
+
+void FlyingSwarm::ReleaseMesh()
+{
+	delete mesh;
+	mesh = NULL;
+
+	meshInstance.set_mesh(NULL);
+}
+
+void FlyingSwarm::Clear()
+{
+	agentCount = 0;
+
+	// hides the triangles of the removed agents
+
+	if (mesh)
+	{
+		memset(mesh->vertex_buffer()->vertex_data(), 0, maxAgents * 3 * sizeof(gef::Mesh::Vertex));
+		mesh->vertex_buffer()->Update(*platform);
+	}
+}
+
+void FlyingSwarm::RunBenchmark(const b2AABB& bounds, float neighbourRadius, int maxAgents, int ticks, float budgetMS)
+{
+	b2Vec2 target = bounds.GetCenter();
+
+	for (int count = 250; ; count *= 2)
+	{
+		count = b2Min(count, maxAgents);
+
+		float halfSide = 0.5f * sqrtf(count / SWARM_BENCHMARK_DENSITY);
+
+		b2AABB area;
+		area.lowerBound = target - b2Vec2(halfSide, halfSide);
+		area.upperBound = target + b2Vec2(halfSide, halfSide);
+
+		// the same agents are timed with and without SSE
+
+		double tickMS[2] = { 0.0, 0.0 };
+
+		for (int simd = 0; simd < 2; simd++)
+		{
+			if (simd && !SWARM_SSE)
+			{
+				continue;
+			}
+
+			FlyingSwarm swarm;
+			swarm.Init(count, bounds, neighbourRadius);
+			swarm.setUseSimd(simd != 0);
+
+			srand(1);
+			swarm.Spawn(count, area);
+
+			Timer timer;
+			timer.Start();
+
+			for (int t = 0; t < ticks; t++)
+			{
+				swarm.Update(1.0f / 60.0f, target);
+			}
+
+			timer.GetTimeStop();
+			tickMS[simd] = timer.elapsedMS() / ticks;
+		}
+
+		double bestMS = SWARM_SSE ? tickMS[1] : tickMS[0];
+
+		LOG_INFO(LOG_GAME, "flying swarm: %i agents, scalar %.3fms, sse %.3fms a tick, %.1fns an agent, %s the %.1fms budget",
+			count, tickMS[0], tickMS[1], bestMS * 1000000.0 / count, bestMS <= budgetMS ? "within" : "over", budgetMS);
+
+		if (count >= maxAgents)
+		{
+			break;
+		}
+	}
+}
+
+int FlyingSwarm::CellX(float x) const
+{
+	return b2Clamp((int)((x - bounds.lowerBound.x) * inverseCellSize), 0, columns - 1);
+}
+
+int FlyingSwarm::CellY(float y) const
+{
+	return b2Clamp((int)((y - bounds.lowerBound.y) * inverseCellSize), 0, rows - 1);
+}
+
+void FlyingSwarm::BuildGrid()
+{
+	// counts the agents in each cell
+	// then places them working back from the end of each cell's range
+	// leaving each start where its first agent is
+
+	std::fill(cellStarts.begin(), cellStarts.end(), 0);
+
+	for (int i = 0; i < agentCount; i++)
+	{
+		agentCells[i] = CellY(posY[i]) * columns + CellX(posX[i]);
+		cellStarts[agentCells[i]]++;
+	}
+
+	for (size_t c = 1; c < cellStarts.size(); c++)
+	{
+		cellStarts[c] += cellStarts[c - 1];
+	}
+
+	for (int i = agentCount - 1; i >= 0; i--)
+	{
+		int sorted = --cellStarts[agentCells[i]];
+
+		sortedPosX[sorted] = posX[i];
+		sortedPosY[sorted] = posY[i];
+		sortedVelX[sorted] = velX[i];
+		sortedVelY[sorted] = velY[i];
+	}
+
+	posX.swap(sortedPosX);
+	posY.swap(sortedPosY);
+	velX.swap(sortedVelX);
+	velY.swap(sortedVelY);
+}
+
+void FlyingSwarm::AccumulateNeighbours(int agent)
+{
+	float x = posX[agent];
+	float y = posY[agent];
+	float radiusSquared = neighbourRadius * neighbourRadius;
+	float separationSquared = tuning.separationRadius * tuning.separationRadius;
+
+	int cellX = CellX(x);
+	int cellY = CellY(y);
+	int minX = b2Max(cellX - 1, 0);
+	int maxX = b2Min(cellX + 1, columns - 1);
+
+	float sums[7] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+#if SWARM_SSE
+	__m128 sumPX = _mm_setzero_ps();
+	__m128 sumPY = _mm_setzero_ps();
+	__m128 sumVX = _mm_setzero_ps();
+	__m128 sumVY = _mm_setzero_ps();
+	__m128 sepX = _mm_setzero_ps();
+	__m128 sepY = _mm_setzero_ps();
+	__m128 count = _mm_setzero_ps();
+
+	__m128 agentX = _mm_set1_ps(x);
+	__m128 agentY = _mm_set1_ps(y);
+	__m128 radius = _mm_set1_ps(radiusSquared);
+	__m128 separation = _mm_set1_ps(separationSquared);
+	__m128 epsilon = _mm_set1_ps(SWARM_EPSILON);
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+#endif
+
+	for (int row = b2Max(cellY - 1, 0); row <= b2Min(cellY + 1, rows - 1); row++)
+	{
+		// the three cells across the row are one run of agents
+
+		int j = cellStarts[row * columns + minX];
+		int end = cellStarts[row * columns + maxX + 1];
+
+#if SWARM_SSE
+		if (useSimd)
+		{
+			for (; j + 4 <= end; j += 4)
+			{
+				__m128 px = _mm_loadu_ps(&posX[j]);
+				__m128 py = _mm_loadu_ps(&posY[j]);
+				__m128 dx = _mm_sub_ps(px, agentX);
+				__m128 dy = _mm_sub_ps(py, agentY);
+				__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+				// in range and not the agent itself
+
+				__m128 inRadius = _mm_and_ps(_mm_cmplt_ps(d2, radius), _mm_cmpgt_ps(d2, zero));
+
+				sumPX = _mm_add_ps(sumPX, _mm_and_ps(inRadius, px));
+				sumPY = _mm_add_ps(sumPY, _mm_and_ps(inRadius, py));
+				sumVX = _mm_add_ps(sumVX, _mm_and_ps(inRadius, _mm_loadu_ps(&velX[j])));
+				sumVY = _mm_add_ps(sumVY, _mm_and_ps(inRadius, _mm_loadu_ps(&velY[j])));
+				count = _mm_add_ps(count, _mm_and_ps(inRadius, one));
+
+				// pushed away harder the closer they are
+
+				__m128 close = _mm_and_ps(inRadius, _mm_cmplt_ps(d2, separation));
+				__m128 inverse = _mm_div_ps(one, _mm_max_ps(d2, epsilon));
+
+				sepX = _mm_sub_ps(sepX, _mm_and_ps(close, _mm_mul_ps(dx, inverse)));
+				sepY = _mm_sub_ps(sepY, _mm_and_ps(close, _mm_mul_ps(dy, inverse)));
+			}
+		}
+#endif
+
+		// the rest of the row
+
+		for (; j < end; j++)
+		{
+			float dx = posX[j] - x;
+			float dy = posY[j] - y;
+			float d2 = dx * dx + dy * dy;
+
+			if (d2 <= 0.0f || d2 >= radiusSquared)
+			{
+				continue;
+			}
+
+			sums[0] += posX[j];
+			sums[1] += posY[j];
+			sums[2] += velX[j];
+			sums[3] += velY[j];
+			sums[6] += 1.0f;
+
+			if (d2 < separationSquared)
+			{
+				float inverse = 1.0f / b2Max(d2, SWARM_EPSILON);
+				sums[4] -= dx * inverse;
+				sums[5] -= dy * inverse;
+			}
+		}
+	}
+
+#if SWARM_SSE
+	sums[0] += HorizontalSum(sumPX);
+	sums[1] += HorizontalSum(sumPY);
+	sums[2] += HorizontalSum(sumVX);
+	sums[3] += HorizontalSum(sumVY);
+	sums[4] += HorizontalSum(sepX);
+	sums[5] += HorizontalSum(sepY);
+	sums[6] += HorizontalSum(count);
+#endif
+
+	sumPosX[agent] = sums[0];
+	sumPosY[agent] = sums[1];
+	sumVelX[agent] = sums[2];
+	sumVelY[agent] = sums[3];
+	separationX[agent] = sums[4];
+	separationY[agent] = sums[5];
+	neighbourCount[agent] = sums[6];
+}
+
+void FlyingSwarm::SteerScalar(int agent, float frame_time, b2Vec2 target)
+{
+	float px = posX[agent];
+	float py = posY[agent];
+	float vx = velX[agent];
+	float vy = velY[agent];
+
+	// separation
+
+	float fx = tuning.separationWeight * separationX[agent];
+	float fy = tuning.separationWeight * separationY[agent];
+
+	// alignment and cohesion, towards the neighbours' average velocity and position
+
+	float count = neighbourCount[agent];
+
+	if (count > 0.0f)
+	{
+		float inverse = 1.0f / count;
+
+		fx += tuning.alignmentWeight * (sumVelX[agent] * inverse - vx);
+		fy += tuning.alignmentWeight * (sumVelY[agent] * inverse - vy);
+		fx += tuning.cohesionWeight * (sumPosX[agent] * inverse - px);
+		fy += tuning.cohesionWeight * (sumPosY[agent] * inverse - py);
+	}
+
+	// seek, flying at full speed towards the target
+
+	float tx = target.x - px;
+	float ty = target.y - py;
+	float targetSquared = tx * tx + ty * ty;
+
+	if (targetSquared < tuning.seekRange * tuning.seekRange)
+	{
+		float inverse = tuning.maxSpeed / sqrtf(b2Max(targetSquared, SWARM_EPSILON));
+
+		fx += tuning.seekWeight * (tx * inverse - vx);
+		fy += tuning.seekWeight * (ty * inverse - vy);
+	}
+
+	// limits the force and speed
+
+	float forceSquared = fx * fx + fy * fy;
+
+	if (forceSquared > tuning.maxForce * tuning.maxForce)
+	{
+		float scale = tuning.maxForce / sqrtf(forceSquared);
+		fx *= scale;
+		fy *= scale;
+	}
+
+	vx += fx * frame_time;
+	vy += fy * frame_time;
+
+	float speedSquared = vx * vx + vy * vy;
+
+	if (speedSquared > tuning.maxSpeed * tuning.maxSpeed)
+	{
+		float scale = tuning.maxSpeed / sqrtf(speedSquared);
+		vx *= scale;
+		vy *= scale;
+	}
+
+	px += vx * frame_time;
+	py += vy * frame_time;
+
+	// turns back at the edges of the bounds
+
+	if (px < bounds.lowerBound.x) { px = bounds.lowerBound.x; vx = fabsf(vx); }
+	if (px > bounds.upperBound.x) { px = bounds.upperBound.x; vx = -fabsf(vx); }
+	if (py < bounds.lowerBound.y) { py = bounds.lowerBound.y; vy = fabsf(vy); }
+	if (py > bounds.upperBound.y) { py = bounds.upperBound.y; vy = -fabsf(vy); }
+
+	posX[agent] = px;
+	posY[agent] = py;
+	velX[agent] = vx;
+	velY[agent] = vy;
+}
+
+void FlyingSwarm::SteerSimd(int agent, float frame_time, b2Vec2 target)
+{
+#if SWARM_SSE
+	// the same steps as the scalar version
+	// with masks in place of the if statements
+
+	__m128 px = _mm_loadu_ps(&posX[agent]);
+	__m128 py = _mm_loadu_ps(&posY[agent]);
+	__m128 vx = _mm_loadu_ps(&velX[agent]);
+	__m128 vy = _mm_loadu_ps(&velY[agent]);
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 epsilon = _mm_set1_ps(SWARM_EPSILON);
+	__m128 maxSpeed = _mm_set1_ps(tuning.maxSpeed);
+	__m128 maxForce = _mm_set1_ps(tuning.maxForce);
+	__m128 dt = _mm_set1_ps(frame_time);
+
+	// separation
+
+	__m128 separationWeight = _mm_set1_ps(tuning.separationWeight);
+	__m128 fx = _mm_mul_ps(separationWeight, _mm_loadu_ps(&separationX[agent]));
+	__m128 fy = _mm_mul_ps(separationWeight, _mm_loadu_ps(&separationY[agent]));
+
+	// alignment and cohesion
+
+	__m128 count = _mm_loadu_ps(&neighbourCount[agent]);
+	__m128 hasNeighbours = _mm_cmpgt_ps(count, zero);
+	__m128 inverse = _mm_div_ps(one, _mm_max_ps(count, one));
+
+	__m128 alignmentWeight = _mm_set1_ps(tuning.alignmentWeight);
+	__m128 cohesionWeight = _mm_set1_ps(tuning.cohesionWeight);
+
+	__m128 ax = _mm_mul_ps(alignmentWeight, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&sumVelX[agent]), inverse), vx));
+	__m128 ay = _mm_mul_ps(alignmentWeight, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&sumVelY[agent]), inverse), vy));
+	__m128 cx = _mm_mul_ps(cohesionWeight, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&sumPosX[agent]), inverse), px));
+	__m128 cy = _mm_mul_ps(cohesionWeight, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&sumPosY[agent]), inverse), py));
+
+	fx = _mm_add_ps(fx, _mm_and_ps(hasNeighbours, _mm_add_ps(ax, cx)));
+	fy = _mm_add_ps(fy, _mm_and_ps(hasNeighbours, _mm_add_ps(ay, cy)));
+
+	// seek
+
+	__m128 tx = _mm_sub_ps(_mm_set1_ps(target.x), px);
+	__m128 ty = _mm_sub_ps(_mm_set1_ps(target.y), py);
+	__m128 targetSquared = _mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty));
+	__m128 inRange = _mm_cmplt_ps(targetSquared, _mm_set1_ps(tuning.seekRange * tuning.seekRange));
+	__m128 seekScale = _mm_div_ps(maxSpeed, _mm_sqrt_ps(_mm_max_ps(targetSquared, epsilon)));
+
+	__m128 seekWeight = _mm_set1_ps(tuning.seekWeight);
+	__m128 sx = _mm_mul_ps(seekWeight, _mm_sub_ps(_mm_mul_ps(tx, seekScale), vx));
+	__m128 sy = _mm_mul_ps(seekWeight, _mm_sub_ps(_mm_mul_ps(ty, seekScale), vy));
+
+	fx = _mm_add_ps(fx, _mm_and_ps(inRange, sx));
+	fy = _mm_add_ps(fy, _mm_and_ps(inRange, sy));
+
+	// limits the force and speed
+
+	__m128 forceSquared = _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy));
+	__m128 forceScale = Select(_mm_cmpgt_ps(forceSquared, _mm_mul_ps(maxForce, maxForce)),
+		_mm_div_ps(maxForce, _mm_sqrt_ps(_mm_max_ps(forceSquared, epsilon))), one);
+
+	vx = _mm_add_ps(vx, _mm_mul_ps(_mm_mul_ps(fx, forceScale), dt));
+	vy = _mm_add_ps(vy, _mm_mul_ps(_mm_mul_ps(fy, forceScale), dt));
+
+	__m128 speedSquared = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+	__m128 speedScale = Select(_mm_cmpgt_ps(speedSquared, _mm_mul_ps(maxSpeed, maxSpeed)),
+		_mm_div_ps(maxSpeed, _mm_sqrt_ps(_mm_max_ps(speedSquared, epsilon))), one);
+
+	vx = _mm_mul_ps(vx, speedScale);
+	vy = _mm_mul_ps(vy, speedScale);
+
+	px = _mm_add_ps(px, _mm_mul_ps(vx, dt));
+	py = _mm_add_ps(py, _mm_mul_ps(vy, dt));
+
+	// turns back at the edges of the bounds
+
+	__m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 lowerX = _mm_set1_ps(bounds.lowerBound.x);
+	__m128 upperX = _mm_set1_ps(bounds.upperBound.x);
+	__m128 lowerY = _mm_set1_ps(bounds.lowerBound.y);
+	__m128 upperY = _mm_set1_ps(bounds.upperBound.y);
+
+	vx = Select(_mm_cmplt_ps(px, lowerX), _mm_andnot_ps(signMask, vx), vx);
+	vx = Select(_mm_cmpgt_ps(px, upperX), _mm_or_ps(signMask, vx), vx);
+	vy = Select(_mm_cmplt_ps(py, lowerY), _mm_andnot_ps(signMask, vy), vy);
+	vy = Select(_mm_cmpgt_ps(py, upperY), _mm_or_ps(signMask, vy), vy);
+
+	px = _mm_min_ps(_mm_max_ps(px, lowerX), upperX);
+	py = _mm_min_ps(_mm_max_ps(py, lowerY), upperY);
+
+	_mm_storeu_ps(&posX[agent], px);
+	_mm_storeu_ps(&posY[agent], py);
+	_mm_storeu_ps(&velX[agent], vx);
+	_mm_storeu_ps(&velY[agent], vy);
+#else
+	for (int i = agent; i < b2Min(agent + 4, agentCount); i++)
+	{
+		SteerScalar(i, frame_time, target);
+	}
+#endif
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <graphics/mesh_instance.h>
+#include <vector>
+
+// FRAMEWORK FORWARD DECLARATIONS
+namespace gef
+{
+	class Platform;
+	class Renderer3D;
+	class Mesh;
+};
+
+// how the swarm steers
+// each weight scales its steering force before they are added up
+
+struct SwarmTuning
+{
+	SwarmTuning();
+
+	float separationWeight;
+	float alignmentWeight;
+	float cohesionWeight;
+	float seekWeight;
+
+	// neighbours closer than this are pushed away from
+	float separationRadius;
+
+	// agents closer to the target than this head for it
+	float seekRange;
+
+	float maxSpeed;
+	float maxForce;
+};
+
+// flying swarm
+// flocking enemies with no physics body, flying over the level and towards the player
+// agent values are kept in separate arrays and steered four at a time with SSE
+// they are sorted into a uniform grid over the bounds every tick so neighbours
+// in a row of cells sit next to each other in the arrays
+// every agent is drawn by one mesh rebuilt each frame
+
+class FlyingSwarm
+{
+public:
+
+	// flying swarm constructor
+
+	FlyingSwarm();
+
+	// sets the most agents the swarm holds, the area it stays in
+	// and how far away agents flock with each other, which is also the grid cell size
+
+	void Init(int maxAgents, const b2AABB& bounds, float neighbourRadius);
+
+	// adds an agent, returns false if the swarm is full
+
+	bool AddAgent(b2Vec2 position, b2Vec2 velocity);
+
+	// adds agents at random points in the area
+
+	void Spawn(int count, const b2AABB& area);
+
+	// steers and moves every agent, seeking the target if it's in range
+
+	void Update(float frame_time, b2Vec2 target);
+
+	// number of agents within the radius of the centre
+
+	int CountInRadius(b2Vec2 centre, float radius) const;
+
+	// creates the mesh every agent is drawn in
+	// agents are triangles pointing the way they fly
+
+	void InitMesh(gef::Platform& platform, float agentSize);
+
+	// moves the mesh's triangles to the agents and draws it
+
+	void Render(gef::Renderer3D* renderer);
+
+	// deletes the mesh
+
+	void ReleaseMesh();
+
+	// removes every agent
+
+	void Clear();
+
+	// times the update for a doubling number of agents up to the most given
+	// with and without SSE, printing the time per tick and per agent against the budget
+
+	static void RunBenchmark(const b2AABB& bounds, float neighbourRadius, int maxAgents, int ticks, float budgetMS);
+
+	// setters and getters
+
+	SwarmTuning& getTuning() { return tuning; }
+	void setUseSimd(bool useSimd) { this->useSimd = useSimd; }
+	int getAgentCount() const { return agentCount; }
+	b2Vec2 getPosition(int agent) const { return b2Vec2(posX[agent], posY[agent]); }
+
+private:
+
+	// grid cell of a position, clamped to the bounds
+	int CellX(float x) const;
+	int CellY(float y) const;
+
+	// sorts the agents by grid cell
+	void BuildGrid();
+
+	// adds up the neighbours of an agent from the three cells across each of the three rows around it
+	void AccumulateNeighbours(int agent);
+
+	// steers and moves agents from the sums
+	// the SSE version does four starting at the agent
+	void SteerScalar(int agent, float frame_time, b2Vec2 target);
+	void SteerSimd(int agent, float frame_time, b2Vec2 target);
+
+	// flying swarm variables
+
+	SwarmTuning tuning;
+	b2AABB bounds;
+	bool useSimd;
+
+	int agentCount;
+	int maxAgents;
+
+	// agent values, sized to a multiple of four
+	// so the last agents can be steered as a whole group
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> velX;
+	std::vector<float> velY;
+
+	// values sorted into during the grid build, swapped with the ones above after
+	std::vector<float> sortedPosX;
+	std::vector<float> sortedPosY;
+	std::vector<float> sortedVelX;
+	std::vector<float> sortedVelY;
+	std::vector<int> agentCells;
+
+	// neighbour sums for each agent
+	std::vector<float> sumPosX;
+	std::vector<float> sumPosY;
+	std::vector<float> sumVelX;
+	std::vector<float> sumVelY;
+	std::vector<float> separationX;
+	std::vector<float> separationY;
+	std::vector<float> neighbourCount;
+
+	// grid, cell c holds agents from cellStarts[c] to cellStarts[c + 1]
+	float neighbourRadius;
+	float inverseCellSize;
+	int columns;
+	int rows;
+	std::vector<int> cellStarts;
+
+	// batched mesh
+	gef::Platform* platform;
+	gef::Mesh* mesh;
+	gef::MeshInstance meshInstance;
+	float agentSize;
+};
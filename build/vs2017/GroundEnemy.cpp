@@ -1,5 +1,6 @@
 #include "GroundEnemy.h"
 #include <graphics/renderer_3d.h>
+#include <math.h>
 
 // ground enemy constructor
 // initialising ground enemy values
@@ -21,7 +22,14 @@ void GroundEnemy::Init(b2World* world_, PrimitiveBuilder* primitive_builder_)
 	this->setSize(gef::Vector4(1.0f, 2.0f, 1.0f));
 
 	// sets mesh of ground enemy
-	this->set_mesh(primitive_builder_->CreateBoxMesh(this->getSize()));
+	// simulations without a renderer pass no primitive builder
+
+	if (primitive_builder_)
+	{
+		gef::Vector4 box_scale;
+		this->set_mesh(primitive_builder_->AcquireScaledBoxMesh(this->getSize(), box_scale));
+		this->setScale(box_scale);
+	}
 
 	// create a physics body for the ground enemy
 	b2BodyDef body_def;
@@ -112,6 +120,14 @@ void GroundEnemy::PlayerCollisionResponse(Player* playerCheck, b2Body* playerBod
 
 void GroundEnemy::Movement(float startPos, float endPos, float speed)
 {
+	// body is frozen while its activity region is off
+	// so no impulses build up until the player comes back
+
+	if (!GEBody->IsActive())
+	{
+		return;
+	}
+
 	if (endPos > startPos)
 	{
 		if (GEBody->GetPosition().x >= endPos)
@@ -175,6 +191,48 @@ void GroundEnemy::Movement(float startPos, float endPos, float speed)
 	}
 }
 
+// heads towards the target the same way as movement
+// jumping needs a jump speed and the enemy on the ground
+
+void GroundEnemy::MoveTowards(b2Vec2 target, float speed, float jumpSpeed)
+{
+	if (!GEBody->IsActive())
+	{
+		return;
+	}
+
+	float offset = target.x - GEBody->GetPosition().x;
+
+	if (offset > 0.0f && GEBody->GetLinearVelocity().x <= speed)
+	{
+		GEBody->ApplyLinearImpulseToCenter(b2Vec2(speed, 0.0f), true);
+	}
+
+	else if (offset < 0.0f && GEBody->GetLinearVelocity().x >= -speed)
+	{
+		GEBody->ApplyLinearImpulseToCenter(b2Vec2(-speed, 0.0f), true);
+	}
+
+	if (jumpSpeed > 0.0f && fabsf(GEBody->GetLinearVelocity().y) < 0.01f)
+	{
+		GEBody->ApplyLinearImpulseToCenter(b2Vec2(0.0f, GEBody->GetMass() * jumpSpeed), true);
+	}
+}
+
+// moves the body back to the position it was created at
+// and stops it so the movement starts again from the beginning
+
+void GroundEnemy::Reset()
+{
+	endPointReached = false;
+
+	GEBody->SetTransform(GEPosition, 0.0f);
+	GEBody->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+	GEBody->SetAwake(true);
+
+	this->UpdateFromSimulation(GEBody);
+}
+
 // renders the ground enemy when called in scene app
 
 void GroundEnemy::RenderGroundEnemy(gef::Renderer3D* renderer, PrimitiveBuilder* primitive_builder_)
@@ -37,6 +37,17 @@ class GroundEnemy : public GameObject
 
 		void Movement(float startPos, float endPos, float speed);
 
+		// chase movement
+		// heads along the x-axis towards the target at the speed given
+		// jumping with the jump speed given when it's on the ground
+
+		void MoveTowards(b2Vec2 target, float speed, float jumpSpeed);
+
+		// moves the ground enemy back to its starting position
+		// heading towards its end point again
+
+		void Reset();
+
 		// collision response if the ground enemy
 		// collides with the player
 		void PlayerCollisionResponse(Player* playerCheck, b2Body* playerBody);
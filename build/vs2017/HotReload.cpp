@@ -0,0 +1,332 @@
+#include "HotReload.h"
+#include <system/debug_log.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// longest line read from a tuning or level file
+
+#define MAX_LINE_LENGTH 256
+
+// smallest change in position that moves a body
+
+#define POSITION_EPSILON 0.0001f
+
+// file watcher constructor
+// initialising file watcher values
+
+FileWatcher::FileWatcher(float pollSeconds)
+{
+	this->pollSeconds = pollSeconds;
+	timeToPoll = pollSeconds;
+}
+
+int FileWatcher::AddFile(const char* filename)
+{
+	WatchedFile file;
+	file.filename = filename;
+	file.modifiedTime = ModifiedTime(filename);
+	file.changed = false;
+
+	files.push_back(file);
+
+	return (int)files.size() - 1;
+}
+
+bool FileWatcher::Update(float frame_time)
+{
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		files[i].changed = false;
+	}
+
+	timeToPoll -= frame_time;
+
+	if (timeToPoll > 0.0f)
+	{
+		return false;
+	}
+
+	timeToPoll = pollSeconds;
+
+	bool anyChanged = false;
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		long long modifiedTime = ModifiedTime(files[i].filename.c_str());
+
+		// editors often save by deleting then writing the file
+		// so a missing file is not a change
+
+		if (modifiedTime != 0 && modifiedTime != files[i].modifiedTime)
+		{
+			files[i].modifiedTime = modifiedTime;
+			files[i].changed = true;
+			anyChanged = true;
+		}
+	}
+
+	return anyChanged;
+}
+
+bool FileWatcher::HasChanged(int index) const
+{
+	if (index < 0 || index >= (int)files.size())
+	{
+		return false;
+	}
+
+	return files[index].changed;
+}
+
+void FileWatcher::Clear()
+{
+	files.clear();
+	timeToPoll = pollSeconds;
+}
+
+long long FileWatcher::ModifiedTime(const char* filename)
+{
+	struct stat info;
+
+	if (stat(filename, &info) != 0)
+	{
+		return 0;
+	}
+
+	return (long long)info.st_mtime;
+}
+
+// tuning file
+
+void TuningFile::Bind(const char* name, float* value)
+{
+	TuningValue tuningValue;
+	tuningValue.name = name;
+	tuningValue.value = value;
+
+	values.push_back(tuningValue);
+}
+
+int TuningFile::Load(const char* filename)
+{
+	FILE* file = fopen(filename, "r");
+
+	if (!file)
+	{
+		return -1;
+	}
+
+	int changedCount = 0;
+	char line[MAX_LINE_LENGTH];
+
+	while (fgets(line, sizeof(line), file))
+	{
+		char name[MAX_LINE_LENGTH];
+		float value;
+
+		// skips comments and blank lines
+
+		if (line[0] == '#' || sscanf(line, "%255s %f", name, &value) != 2)
+		{
+			continue;
+		}
+
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (values[i].name == name)
+			{
+				if (*values[i].value != value)
+				{
+					gef::DebugOut("tuning: %s %.3f -> %.3f\n", name, *values[i].value, value);
+					*values[i].value = value;
+					changedCount++;
+				}
+
+				break;
+			}
+		}
+	}
+
+	fclose(file);
+
+	return changedCount;
+}
+
+bool TuningFile::Write(const char* filename) const
+{
+	FILE* file = fopen(filename, "w");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "# tuning values, saved changes are picked up while the game runs\n");
+
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		fprintf(file, "%s %g\n", values[i].name.c_str(), *values[i].value);
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+// level layout
+
+void LevelLayout::AddBodies(const char* family, b2Body* const* bodies, int count)
+{
+	BodyFamily bodyFamily;
+	bodyFamily.name = family;
+	bodyFamily.bodies = bodies;
+	bodyFamily.count = count;
+
+	bodyFamilies.push_back(bodyFamily);
+}
+
+void LevelLayout::AddRoutes(const char* family, PatrolRoute* routes, int count)
+{
+	RouteFamily routeFamily;
+	routeFamily.name = family;
+	routeFamily.routes = routes;
+	routeFamily.count = count;
+
+	routeFamilies.push_back(routeFamily);
+}
+
+int LevelLayout::Apply(const char* filename)
+{
+	FILE* file = fopen(filename, "r");
+
+	if (!file)
+	{
+		return -1;
+	}
+
+	int changedCount = 0;
+	char line[MAX_LINE_LENGTH];
+
+	while (fgets(line, sizeof(line), file))
+	{
+		char type[MAX_LINE_LENGTH];
+		char family[MAX_LINE_LENGTH];
+		int index;
+		float values[3];
+
+		int read = sscanf(line, "%255s %255s %i %f %f %f", type, family, &index, &values[0], &values[1], &values[2]);
+
+		if (line[0] == '#' || read < 5)
+		{
+			continue;
+		}
+
+		// moves a body if its position is different
+		// bodies keep their angle and are woken so contacts update
+
+		if (strcmp(type, "body") == 0)
+		{
+			for (size_t f = 0; f < bodyFamilies.size(); f++)
+			{
+				const BodyFamily& bodyFamily = bodyFamilies[f];
+
+				if (bodyFamily.name != family || index < 0 || index >= bodyFamily.count)
+				{
+					continue;
+				}
+
+				b2Body* body = bodyFamily.bodies[index];
+				b2Vec2 position(values[0], values[1]);
+
+				if (fabsf(body->GetPosition().x - position.x) > POSITION_EPSILON ||
+					fabsf(body->GetPosition().y - position.y) > POSITION_EPSILON)
+				{
+					body->SetTransform(position, body->GetAngle());
+					body->SetAwake(true);
+					changedCount++;
+				}
+
+				break;
+			}
+		}
+
+		// changes a patrol route
+
+		else if (strcmp(type, "route") == 0 && read == 6)
+		{
+			for (size_t f = 0; f < routeFamilies.size(); f++)
+			{
+				const RouteFamily& routeFamily = routeFamilies[f];
+
+				if (routeFamily.name != family || index < 0 || index >= routeFamily.count)
+				{
+					continue;
+				}
+
+				PatrolRoute& route = routeFamily.routes[index];
+
+				if (route.start != values[0] || route.end != values[1] || route.speed != values[2])
+				{
+					route.start = values[0];
+					route.end = values[1];
+					route.speed = values[2];
+					changedCount++;
+				}
+
+				break;
+			}
+		}
+	}
+
+	fclose(file);
+
+	return changedCount;
+}
+
+bool LevelLayout::Write(const char* filename) const
+{
+	FILE* file = fopen(filename, "w");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "# level layout, saved changes are picked up while the game runs\n");
+	fprintf(file, "# body family index x y\n");
+	fprintf(file, "# route family index start end speed\n");
+
+	for (size_t f = 0; f < bodyFamilies.size(); f++)
+	{
+		const BodyFamily& bodyFamily = bodyFamilies[f];
+
+		for (int i = 0; i < bodyFamily.count; i++)
+		{
+			fprintf(file, "body %s %i %g %g\n", bodyFamily.name.c_str(), i,
+				bodyFamily.bodies[i]->GetPosition().x, bodyFamily.bodies[i]->GetPosition().y);
+		}
+	}
+
+	for (size_t f = 0; f < routeFamilies.size(); f++)
+	{
+		const RouteFamily& routeFamily = routeFamilies[f];
+
+		for (int i = 0; i < routeFamily.count; i++)
+		{
+			fprintf(file, "route %s %i %g %g %g\n", routeFamily.name.c_str(), i,
+				routeFamily.routes[i].start, routeFamily.routes[i].end, routeFamily.routes[i].speed);
+		}
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+void LevelLayout::Clear()
+{
+	bodyFamilies.clear();
+	routeFamilies.clear();
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <string>
+#include <vector>
+
+// file watcher
+// checks a list of files for changes every so often
+// by comparing their last modified times
+
+class FileWatcher
+{
+public:
+
+	// file watcher constructor
+	// pollSeconds is how often the files are checked
+
+	FileWatcher(float pollSeconds = 0.5f);
+
+	// adds a file to watch
+	// returns its index for HasChanged
+
+	int AddFile(const char* filename);
+
+	// counts down to the next check and checks the files when it is due
+	// returns true if any file changed since the last check
+
+	bool Update(float frame_time);
+
+	// returns true if the file changed in the last check
+
+	bool HasChanged(int index) const;
+
+	// forgets every file
+
+	void Clear();
+
+private:
+
+	struct WatchedFile
+	{
+		std::string filename;
+		long long modifiedTime;
+		bool changed;
+	};
+
+	// returns the file's last modified time
+	// or 0 if it can't be read
+	static long long ModifiedTime(const char* filename);
+
+	// file watcher variables
+
+	std::vector<WatchedFile> files;
+	float pollSeconds;
+	float timeToPoll;
+};
+
+// tuning file
+// text file of "name value" lines
+// each name is bound to a float the game reads
+
+class TuningFile
+{
+public:
+
+	// binds a name in the file to a value
+	// the value keeps its current value if the file doesn't set it
+
+	void Bind(const char* name, float* value);
+
+	// reads the file and sets every bound value it names
+	// returns the number of values that changed or -1 if the file can't be read
+
+	int Load(const char* filename);
+
+	// writes every bound value and its current value
+
+	bool Write(const char* filename) const;
+
+	// forgets every bound value
+
+	void Clear() { values.clear(); }
+
+private:
+
+	struct TuningValue
+	{
+		std::string name;
+		float* value;
+	};
+
+	std::vector<TuningValue> values;
+};
+
+// patrol route
+// a moving body goes between start and end at speed
+// along the x axis, or the y axis if yAxis is set
+
+struct PatrolRoute
+{
+	float start;
+	float end;
+	float speed;
+	bool yAxis;
+};
+
+// level layout
+// text file of the level's body positions and patrol routes
+// reloading it moves the live bodies that changed in place
+//
+// body lines are "body family index x y"
+// route lines are "route family index start end speed"
+// bodies and routes can only be moved, not added or removed
+
+class LevelLayout
+{
+public:
+
+	// adds a group of bodies the file can move
+
+	void AddBodies(const char* family, b2Body* const* bodies, int count);
+
+	// adds a group of patrol routes the file can change
+
+	void AddRoutes(const char* family, PatrolRoute* routes, int count);
+
+	// reads the file, diffs it against the live bodies and routes
+	// and patches anything that changed
+	// returns the number of bodies and routes changed or -1 if the file can't be read
+
+	int Apply(const char* filename);
+
+	// writes the live positions and routes
+
+	bool Write(const char* filename) const;
+
+	// forgets every family
+	// called when the level is released
+
+	void Clear();
+
+private:
+
+	struct BodyFamily
+	{
+		std::string name;
+		b2Body* const* bodies;
+		int count;
+	};
+
+	struct RouteFamily
+	{
+		std::string name;
+		PatrolRoute* routes;
+		int count;
+	};
+
+	std::vector<BodyFamily> bodyFamilies;
+	std::vector<RouteFamily> routeFamilies;
+};
+
@@ -0,0 +1,200 @@
+#include "InputLatency.h"
+#include <system/debug_log.h>
+#include <algorithm>
+#include <vector>
+
+// how many frames an input can wait to be used
+// before it is thrown away
+// moving from standing only applies an impulse on the next frame
+
+#define MAX_CONSUME_FRAMES 2
+
+// input latency tracker constructor
+// initialising input latency values
+
+InputLatencyTracker::InputLatencyTracker()
+{
+	isEnabled = false;
+	frameNum = 0;
+	stepNum = 0;
+	inputActions = 0;
+	inputFrame = 0;
+	consumeStep = 0;
+
+	Reset();
+}
+
+// turns tracking on or off
+
+void InputLatencyTracker::setEnabled(bool enabled)
+{
+	isEnabled = enabled;
+	stage = STAGE_NONE;
+}
+
+// called at the start of every frame
+// drops any input that was never used
+
+void InputLatencyTracker::OnFrameStart()
+{
+	frameNum++;
+
+	if (stage == STAGE_WAITING_CONSUME && frameNum - inputFrame > MAX_CONSUME_FRAMES)
+	{
+		stage = STAGE_NONE;
+	}
+}
+
+// starts following a new input
+// the time is taken when the input is read
+// as that is the earliest the game can know about it
+
+void InputLatencyTracker::OnInputEdge(unsigned int pressedActions)
+{
+	if (!isEnabled || pressedActions == 0)
+	{
+		return;
+	}
+
+	// an input still on its way to the screen is kept
+	// a newer input replaces one that has not been used yet
+
+	if (stage == STAGE_NONE || stage == STAGE_WAITING_CONSUME)
+	{
+		stage = STAGE_WAITING_CONSUME;
+		inputTime = std::chrono::steady_clock::now();
+		inputActions = pressedActions;
+		inputFrame = frameNum;
+	}
+}
+
+// marks the input as used once the player
+// has been moved by one of its actions
+
+void InputLatencyTracker::OnInputConsumed(unsigned int movedActions)
+{
+	if (isEnabled && stage == STAGE_WAITING_CONSUME && (movedActions & inputActions) != 0)
+	{
+		stage = STAGE_WAITING_STEP;
+		consumeStep = stepNum;
+	}
+}
+
+// the impulse only changes the player transform
+// once the world has been stepped after it
+
+void InputLatencyTracker::OnSimulationStep()
+{
+	stepNum++;
+
+	if (isEnabled && stage == STAGE_WAITING_STEP && stepNum > consumeStep)
+	{
+		stage = STAGE_WAITING_RENDER;
+	}
+}
+
+// finishes the sample once the new transform is drawn
+
+void InputLatencyTracker::OnFrameRendered()
+{
+	if (isEnabled && stage == STAGE_WAITING_RENDER)
+	{
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inputTime).count();
+
+		AddSample(ms, frameNum - inputFrame);
+		stage = STAGE_NONE;
+	}
+}
+
+// removes all samples
+
+void InputLatencyTracker::Reset()
+{
+	stage = STAGE_NONE;
+	sampleCount = 0;
+	nextSample = 0;
+}
+
+// adds a finished sample to the ring buffer
+
+void InputLatencyTracker::AddSample(double ms, int frames)
+{
+	samples[nextSample].ms = ms;
+	samples[nextSample].frames = frames;
+
+	nextSample = (nextSample + 1) % INPUT_LATENCY_SAMPLE_NUM;
+
+	if (sampleCount < INPUT_LATENCY_SAMPLE_NUM)
+	{
+		sampleCount++;
+	}
+}
+
+// builds the latency report from all samples kept
+
+void InputLatencyTracker::BuildReport(InputLatencyReport& report, LinearArena* scratch)
+{
+	report.sampleCount = sampleCount;
+	report.minMS = 0.0;
+	report.averageMS = 0.0;
+	report.p50MS = 0.0;
+	report.p95MS = 0.0;
+	report.maxMS = 0.0;
+
+	for (int i = 0; i <= INPUT_LATENCY_MAX_FRAMES; i++)
+	{
+		report.frameHistogram[i] = 0;
+	}
+
+	if (sampleCount == 0)
+	{
+		return;
+	}
+
+	// sorts a copy of the times for the percentiles
+	// using the scratch arena so the HUD does not allocate every frame
+
+	std::vector<double> heapTimes;
+	double* times = scratch ? (double*)scratch->Allocate(sampleCount * sizeof(double), alignof(double)) : NULL;
+
+	if (!times)
+	{
+		heapTimes.resize(sampleCount);
+		times = &heapTimes[0];
+	}
+
+	double total = 0.0;
+
+	for (int i = 0; i < sampleCount; i++)
+	{
+		times[i] = samples[i].ms;
+		total += samples[i].ms;
+
+		int bucket = std::min(std::max(samples[i].frames, 0), INPUT_LATENCY_MAX_FRAMES);
+		report.frameHistogram[bucket]++;
+	}
+
+	std::sort(times, times + sampleCount);
+
+	report.minMS = times[0];
+	report.maxMS = times[sampleCount - 1];
+	report.averageMS = total / sampleCount;
+	report.p50MS = times[(sampleCount - 1) / 2];
+	report.p95MS = times[((sampleCount - 1) * 95) / 100];
+}
+
+// prints the latency report to the debug output
+
+void InputLatencyTracker::PrintReport()
+{
+	InputLatencyReport report;
+	BuildReport(report);
+
+	gef::DebugOut("input latency: %i samples, min %.2fms, avg %.2fms, p50 %.2fms, p95 %.2fms, max %.2fms\n",
+		report.sampleCount, report.minMS, report.averageMS, report.p50MS, report.p95MS, report.maxMS);
+
+	for (int i = 0; i <= INPUT_LATENCY_MAX_FRAMES; i++)
+	{
+		gef::DebugOut("input latency: %i%s frames: %i\n", i, i == INPUT_LATENCY_MAX_FRAMES ? "+" : "", report.frameHistogram[i]);
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <chrono>
+#include "LinearArena.h"
+
+// number of latency samples kept
+// older samples are overwritten once full
+
+#define INPUT_LATENCY_SAMPLE_NUM 512
+
+// highest frame count kept in the histogram
+// anything later goes in the last bucket
+
+#define INPUT_LATENCY_MAX_FRAMES 4
+
+// input latency report
+// times are in milliseconds from the frame the input
+// was read to the end of the frame that drew its result
+
+struct InputLatencyReport
+{
+	int sampleCount;
+	double minMS;
+	double averageMS;
+	double p50MS;
+	double p95MS;
+	double maxMS;
+	int frameHistogram[INPUT_LATENCY_MAX_FRAMES + 1];
+};
+
+class InputLatencyTracker
+{
+public:
+
+	// input latency tracker constructor
+
+	InputLatencyTracker();
+
+	// turns tracking on or off
+	// nothing is recorded while off
+
+	void setEnabled(bool enabled);
+	bool getEnabled() { return isEnabled; }
+
+	// called at the start of every frame
+	void OnFrameStart();
+
+	// called once the input has been read
+	// takes the actions pressed this frame that should move the player
+	void OnInputEdge(unsigned int pressedActions);
+
+	// called after the player has handled input
+	// takes the actions the player was moved by this frame, such as a jump started
+	// the input followed is only used if one of its actions is among them
+	void OnInputConsumed(unsigned int movedActions);
+
+	// called after each physics world step
+	void OnSimulationStep();
+
+	// called once a frame has finished rendering
+	void OnFrameRendered();
+
+	// removes all samples
+	void Reset();
+
+	// builds or prints the latency report
+	// scratch memory for sorting is taken from the arena if given
+	void BuildReport(InputLatencyReport& report, LinearArena* scratch = NULL);
+	void PrintReport();
+
+private:
+
+	// stage of the input currently being followed
+
+	enum LATENCY_STAGE
+	{
+		STAGE_NONE,
+		STAGE_WAITING_CONSUME,
+		STAGE_WAITING_STEP,
+		STAGE_WAITING_RENDER
+	};
+
+	// completed sample
+
+	struct LatencySample
+	{
+		double ms;
+		int frames;
+	};
+
+	// adds a finished sample to the ring buffer
+	void AddSample(double ms, int frames);
+
+	// tracker variables
+
+	bool isEnabled;
+
+	unsigned int frameNum;
+	unsigned int stepNum;
+
+	// input currently being followed
+	// only one input is followed at a time
+
+	LATENCY_STAGE stage;
+	std::chrono::steady_clock::time_point inputTime;
+	unsigned int inputActions;
+	unsigned int inputFrame;
+	unsigned int consumeStep;
+
+	// finished samples
+
+	LatencySample samples[INPUT_LATENCY_SAMPLE_NUM];
+	int sampleCount;
+	int nextSample;
+};
+
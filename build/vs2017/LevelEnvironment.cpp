@@ -0,0 +1,245 @@
+#include "LevelEnvironment.h"
+#include "Timer.h"
+#include "Logger.h"
+#include <stdlib.h>
+
+// rewards
+// the level climbs up to the collectable so new height is rewarded
+
+#define ENV_REWARD_HEIGHT 0.1f
+#define ENV_REWARD_HIT -1.0f
+#define ENV_REWARD_ABILITY 5.0f
+#define ENV_REWARD_WIN 100.0f
+#define ENV_REWARD_DEATH -10.0f
+#define ENV_REWARD_TICK -0.001f
+
+// hazards further than this from the player aren't observed
+
+#define ENV_HAZARD_RANGE 20.0f
+
+// level environment constructor
+// initialising level environment values
+
+LevelEnvironment::LevelEnvironment()
+{
+	simulations = NULL;
+	envCount = 0;
+}
+
+LevelEnvironment::~LevelEnvironment()
+{
+	Release();
+}
+
+void LevelEnvironment::Init(const LevelDescription& level, const PlayerTuning& tuning, int envCount, int maxTicks)
+{
+	Release();
+
+	this->envCount = envCount;
+	simulations = new LevelSimulation[envCount];
+
+	for (int i = 0; i < envCount; i++)
+	{
+		simulations[i].Init(level, NULL, tuning, maxTicks);
+	}
+
+	previousActions.assign(envCount, 0);
+	previousResults.assign(envCount, SimulationResult());
+
+	spikePositions.clear();
+
+	for (size_t i = 0; i < level.staticBodies.size(); i++)
+	{
+		if (level.staticBodies[i].objectType == SPIKE)
+		{
+			spikePositions.push_back(level.staticBodies[i].position);
+		}
+	}
+}
+
+void LevelEnvironment::Reset(float* observations)
+{
+	for (int i = 0; i < envCount; i++)
+	{
+		simulations[i].Reset();
+		previousActions[i] = 0;
+		previousResults[i] = simulations[i].getResult();
+
+		WriteObservation(i, observations + i * ENV_OBSERVATION_SIZE);
+	}
+}
+
+void LevelEnvironment::Step(const unsigned char* actions, float* observations, float* rewards, bool* dones)
+{
+	for (int i = 0; i < envCount; i++)
+	{
+		LevelSimulation& simulation = simulations[i];
+
+		simulation.Step(InputScript::KeysToInput(actions[i], previousActions[i]));
+		previousActions[i] = actions[i];
+
+		// rewards what changed this tick
+
+		const SimulationResult& result = simulation.getResult();
+		const SimulationResult& previous = previousResults[i];
+
+		float reward = ENV_REWARD_TICK;
+		reward += (result.highestY - previous.highestY) * ENV_REWARD_HEIGHT;
+		reward += (result.playerHits - previous.playerHits) * ENV_REWARD_HIT;
+		reward += (result.abilitiesAcquired - previous.abilitiesAcquired) * ENV_REWARD_ABILITY;
+
+		if (result.won)
+		{
+			reward += ENV_REWARD_WIN;
+		}
+
+		if (result.died)
+		{
+			reward += ENV_REWARD_DEATH;
+		}
+
+		rewards[i] = reward;
+		dones[i] = simulation.isFinished();
+
+		// starts the next run straight away
+
+		if (dones[i])
+		{
+			simulation.Reset();
+			previousActions[i] = 0;
+		}
+
+		previousResults[i] = simulation.getResult();
+
+		WriteObservation(i, observations + i * ENV_OBSERVATION_SIZE);
+	}
+}
+
+void LevelEnvironment::Release()
+{
+	delete[] simulations;
+	simulations = NULL;
+	envCount = 0;
+
+	previousActions.clear();
+	previousResults.clear();
+	spikePositions.clear();
+}
+
+void LevelEnvironment::WriteObservation(int env, float* observation)
+{
+	LevelSimulation& simulation = simulations[env];
+	Player& player = simulation.getPlayer();
+	b2Body* playerBody = simulation.getPlayerBody();
+
+	b2Vec2 position = playerBody->GetPosition();
+	b2Vec2 velocity = playerBody->GetLinearVelocity();
+
+	observation[OBS_POSITION_X] = position.x;
+	observation[OBS_POSITION_Y] = position.y;
+	observation[OBS_VELOCITY_X] = velocity.x;
+	observation[OBS_VELOCITY_Y] = velocity.y;
+	observation[OBS_PLAYER_STATE] = (float)player.getPlayerState();
+	observation[OBS_HEALTH] = (float)player.getHealth();
+	observation[OBS_DASH_ACTIVE] = player.getDashActive() ? 1.0f : 0.0f;
+	observation[OBS_DOUBLE_JUMP_ACTIVE] = player.getDoubleJumpActive() ? 1.0f : 0.0f;
+	observation[OBS_RESET_WALL_ACTIVE] = player.getResetWallActive() ? 1.0f : 0.0f;
+
+	// keeps the nearest hazards in range, sorted by distance
+	// there are few enough to check them all
+
+	b2Vec2 nearest[ENV_NEARBY_HAZARDS];
+	float nearestDistance[ENV_NEARBY_HAZARDS];
+	int nearestCount = 0;
+
+	int hazardCount = (int)spikePositions.size() + simulation.getGroundEnemyCount();
+
+	for (int h = 0; h < hazardCount; h++)
+	{
+		b2Vec2 offset = (h < (int)spikePositions.size() ? spikePositions[h] :
+			simulation.getGroundEnemyPosition(h - (int)spikePositions.size())) - position;
+
+		float distance = offset.LengthSquared();
+
+		if (distance > ENV_HAZARD_RANGE * ENV_HAZARD_RANGE)
+		{
+			continue;
+		}
+
+		if (nearestCount == ENV_NEARBY_HAZARDS && distance >= nearestDistance[nearestCount - 1])
+		{
+			continue;
+		}
+
+		// shifts further hazards down to make room
+
+		int slot = nearestCount < ENV_NEARBY_HAZARDS ? nearestCount++ : nearestCount - 1;
+
+		while (slot > 0 && nearestDistance[slot - 1] > distance)
+		{
+			nearest[slot] = nearest[slot - 1];
+			nearestDistance[slot] = nearestDistance[slot - 1];
+			slot--;
+		}
+
+		nearest[slot] = offset;
+		nearestDistance[slot] = distance;
+	}
+
+	float* hazards = observation + OBS_HAZARDS;
+
+	for (int n = 0; n < ENV_NEARBY_HAZARDS; n++)
+	{
+		bool found = n < nearestCount;
+
+		hazards[n * 3] = found ? nearest[n].x : 0.0f;
+		hazards[n * 3 + 1] = found ? nearest[n].y : 0.0f;
+		hazards[n * 3 + 2] = found ? 1.0f : 0.0f;
+	}
+}
+
+void LevelEnvironment::RunBenchmark(int steps)
+{
+	if (envCount == 0 || steps <= 0)
+	{
+		return;
+	}
+
+	std::vector<float> observations(envCount * ENV_OBSERVATION_SIZE);
+	std::vector<float> rewards(envCount);
+	std::vector<unsigned char> actions(envCount);
+	bool* dones = new bool[envCount];
+
+	Reset(&observations[0]);
+	srand(1);
+
+	int episodes = 0;
+
+	Timer timer;
+	timer.Start();
+
+	for (int s = 0; s < steps; s++)
+	{
+		for (int i = 0; i < envCount; i++)
+		{
+			actions[i] = (unsigned char)(rand() & (INPUT_LEFT | INPUT_RIGHT | INPUT_JUMP | INPUT_DASH));
+		}
+
+		Step(&actions[0], &observations[0], &rewards[0], dones);
+
+		for (int i = 0; i < envCount; i++)
+		{
+			episodes += dones[i] ? 1 : 0;
+		}
+	}
+
+	timer.GetTimeStop();
+	double ms = timer.elapsedMS();
+
+	delete[] dones;
+
+	double envSteps = (double)steps * envCount;
+
+	LOG_INFO(LOG_GAME, "level environment: %i envs, %i steps, %i episodes finished in %.1fms, %.0f env steps/s",
+		envCount, steps, episodes, ms, ms > 0.0 ? envSteps * 1000.0 / ms : 0.0);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include "LevelSimulation.h"
+
+// nearest hazards written into each observation
+
+#define ENV_NEARBY_HAZARDS 4
+
+// observation layout
+// each environment writes ENV_OBSERVATION_SIZE floats in this order
+// hazards are spikes and ground enemies, nearest first,
+// each as x and y from the player and 1 if there is one in range or 0 if not
+
+enum ENV_OBSERVATION
+{
+	OBS_POSITION_X,
+	OBS_POSITION_Y,
+	OBS_VELOCITY_X,
+	OBS_VELOCITY_Y,
+	OBS_PLAYER_STATE,
+	OBS_HEALTH,
+	OBS_DASH_ACTIVE,
+	OBS_DOUBLE_JUMP_ACTIVE,
+	OBS_RESET_WALL_ACTIVE,
+	OBS_HAZARDS,
+	ENV_OBSERVATION_SIZE = OBS_HAZARDS + ENV_NEARBY_HAZARDS * 3
+};
+
+// level environment
+// a batch of level simulations stepped in lockstep by an automated player
+// actions are INPUT_KEY bits held for the tick, presses come from the last action
+// observations, rewards and dones are written straight into the caller's arrays
+// a finished run is reset in place and its observation is the new run's first
+//
+// one batch runs on the calling thread
+// use a batch per thread to spread environments across cores
+
+class LevelEnvironment
+{
+public:
+
+	// level environment constructor
+
+	LevelEnvironment();
+	~LevelEnvironment();
+
+	// builds the environments from the captured level
+	// the level must outlive the batch
+
+	void Init(const LevelDescription& level, const PlayerTuning& tuning, int envCount, int maxTicks);
+
+	// starts a new run in every environment
+	// observations holds envCount * ENV_OBSERVATION_SIZE floats
+
+	void Reset(float* observations);
+
+	// steps every environment one tick
+	// actions holds envCount INPUT_KEY masks
+	// observations holds envCount * ENV_OBSERVATION_SIZE floats, rewards and dones envCount each
+
+	void Step(const unsigned char* actions, float* observations, float* rewards, bool* dones);
+
+	// destroys every environment
+
+	void Release();
+
+	// steps the batch with random actions and prints env steps per second
+
+	void RunBenchmark(int steps);
+
+	// getters
+
+	int getEnvCount() const { return envCount; }
+
+private:
+
+	// writes one environment's observation
+	void WriteObservation(int env, float* observation);
+
+	// level environment variables
+
+	LevelSimulation* simulations;
+	int envCount;
+
+	// keys held last tick, used to find presses
+	std::vector<unsigned char> previousActions;
+
+	// results at the last step, used to give the reward for this one
+	std::vector<SimulationResult> previousResults;
+
+	// spikes never move so their positions are read once
+	std::vector<b2Vec2> spikePositions;
+};
@@ -0,0 +1,214 @@
+#include "LevelRules.h"
+#include "GroundEnemy.h"
+
+// friction of the reset walls once the Double Jump Reset ability is picked up
+// they have none before so the player slides off
+
+#define RESET_WALL_FRICTION 3.5f
+
+// level contact results constructor
+// initialising level contact results values
+
+LevelContactResults::LevelContactResults()
+{
+	playerHits = 0;
+	collectableReached = false;
+}
+
+void ProcessLevelContacts(b2World* world, b2Body* playerBody, AbilityEventQueue& abilities, LevelContactResults& results)
+{
+	for (b2Contact* contact = world->GetContactList(); contact; contact = contact->GetNext())
+	{
+		if (!contact->IsTouching())
+		{
+			continue;
+		}
+
+		// get the colliding bodies
+		b2Body* bodyA = contact->GetFixtureA()->GetBody();
+		b2Body* bodyB = contact->GetFixtureB()->GetBody();
+
+		// seperate class objects
+		// declared for collision
+
+		Player* player = NULL;
+		GroundEnemy* groundEnemy = NULL;
+
+		// objects only checked for, declared as game objects
+
+		GameObject* spikeEnv = NULL;
+		GameObject* theCollectable = NULL;
+		GameObject* stickyWall = NULL;
+		GameObject* movingPlat = NULL;
+		GameObject* dashAbility = NULL;
+		GameObject* doubleJumpAbility = NULL;
+		GameObject* resetWallAbility = NULL;
+
+		// setting each side of the contact to the correct object / object type
+
+		GameObject* gameObjects[2] = { (GameObject*)bodyA->GetUserData(), (GameObject*)bodyB->GetUserData() };
+
+		for (int side = 0; side < 2; side++)
+		{
+			GameObject* gameObject = gameObjects[side];
+
+			if (!gameObject)
+			{
+				continue;
+			}
+
+			switch (gameObject->type())
+			{
+			case PLAYER:
+				player = (Player*)gameObject;
+				break;
+			case GROUND_ENEMY:
+				groundEnemy = (GroundEnemy*)gameObject;
+				break;
+			case SPIKE:
+				spikeEnv = gameObject;
+				break;
+			case STICKY_WALL:
+				stickyWall = gameObject;
+				break;
+			case MOVING:
+				movingPlat = gameObject;
+				break;
+			case ABILITY_DASH:
+				dashAbility = gameObject;
+				break;
+			case ABILITY_DJ:
+				doubleJumpAbility = gameObject;
+				break;
+			case ABILITY_RW:
+				resetWallAbility = gameObject;
+				break;
+			case COLLECTABLE:
+				theCollectable = gameObject;
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (!player)
+		{
+			continue;
+		}
+
+		// checks if player is colliding with a
+		// Double Jump Reset wall --- stickyWall was original name of ability / object
+
+		if (stickyWall)
+		{
+			// checks if player state is currently or just was on the wall
+			// also checks if player has Double Jump Reset ability unlocked
+
+			if (player->getPlayerState() != ON_WALL && player->getPlayerPreviousState() != ON_WALL && player->getResetWallActive() == true)
+			{
+				player->setPlayerState(ON_WALL);
+			}
+		}
+
+		// checks if player is colliding with a
+		// moving platform
+
+		if (movingPlat)
+		{
+			// checks if player state is currently or just was on a moving platform
+
+			if (player->getPlayerState() != ON_MOVING_PLAT && player->getPlayerPreviousState() != ON_MOVING_PLAT)
+			{
+				player->setPlayerState(ON_MOVING_PLAT);
+			}
+		}
+
+		// checks if player is colliding with a
+		// ground enemy
+
+		if (groundEnemy)
+		{
+			// carries out enemy's collision response to player
+			groundEnemy->PlayerCollisionResponse(player, playerBody);
+
+			player->DecrementHealth();
+			results.playerHits++;
+		}
+
+		// checks if player is colliding with a
+		// spike
+
+		if (spikeEnv)
+		{
+			player->DecrementHealth();
+			results.playerHits++;
+		}
+
+		// queues any ability touched to be given to the player
+		// once the contact loop is finished
+
+		if (dashAbility)
+		{
+			abilities.Acquire(PICKUP_DASH);
+		}
+
+		if (doubleJumpAbility)
+		{
+			abilities.Acquire(PICKUP_DOUBLE_JUMP);
+		}
+
+		if (resetWallAbility)
+		{
+			abilities.Acquire(PICKUP_RESET_WALL);
+		}
+
+		// checks if player is colliding with
+		// the Morph Ball object
+
+		if (theCollectable)
+		{
+			results.collectableReached = true;
+		}
+	}
+}
+
+void ApplyAbility(PICKUP_ABILITY ability, Player& player, b2Body* pickupBody, b2Body* const* resetWallBodies, int resetWallCount,
+	DestructionQueue& destruction)
+{
+	// activates the ability for the player
+
+	switch (ability)
+	{
+	case PICKUP_DASH:
+		player.setDashActive(true);
+		break;
+
+	case PICKUP_DOUBLE_JUMP:
+		player.setDoubleJumpActive(true);
+		break;
+
+	case PICKUP_RESET_WALL:
+		player.setResetWallActive(true);
+
+		// makes the reset walls grippy so the player can hold on
+		// contacts already touching a wall mix their friction again
+
+		for (int i = 0; i < resetWallCount; i++)
+		{
+			resetWallBodies[i]->GetFixtureList()->SetFriction(RESET_WALL_FRICTION);
+
+			for (b2ContactEdge* edge = resetWallBodies[i]->GetContactList(); edge; edge = edge->next)
+			{
+				edge->contact->ResetFriction();
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// removes the body of the ability object once the step is done
+
+	destruction.Queue(pickupBody, DESTRUCTION_DESTROY);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include "AbilityEvents.h"
+#include "DestructionQueue.h"
+
+class Player;
+
+// level rules
+// the game's response to touching contacts and picked up abilities
+// shared by the game and the headless simulations so both play by the same rules
+
+// things that happened during one step's contacts
+// the caller decides what to do with them, such as playing sounds
+
+struct LevelContactResults
+{
+	LevelContactResults();
+
+	// number of contacts that hurt the player
+	int playerHits;
+
+	// player touched the end of level collectable
+	bool collectableReached;
+};
+
+// runs the collision response for every touching contact in the world
+// abilities touched are queued rather than applied
+// as bodies can't be switched off while walking the contact list
+
+void ProcessLevelContacts(b2World* world, b2Body* playerBody, AbilityEventQueue& abilities, LevelContactResults& results);
+
+// gives the player a picked up ability and changes the level to match
+// queues the pickup body to be destroyed and grips the reset walls for Double Jump Reset
+
+void ApplyAbility(PICKUP_ABILITY ability, Player& player, b2Body* pickupBody, b2Body* const* resetWallBodies, int resetWallCount,
+	DestructionQueue& destruction);
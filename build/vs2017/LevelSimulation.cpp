@@ -0,0 +1,591 @@
+#include "LevelSimulation.h"
+#include "LevelRules.h"
+#include <stdio.h>
+#include <string.h>
+
+// fixed step used by the game
+
+#define SIMULATION_TIME_STEP (1.0f / 60.0f)
+#define SIMULATION_VELOCITY_ITERATIONS 6
+#define SIMULATION_POSITION_ITERATIONS 2
+
+// longest line read from an input script
+
+#define MAX_SCRIPT_LINE 64
+
+//
+// level description
+//
+
+void LevelDescription::Clear()
+{
+	staticBodies.clear();
+	movingPlatforms.clear();
+	platformRoutes.clear();
+	enemyPositions.clear();
+	enemyRoutes.clear();
+	playerHealth = 0;
+}
+
+void LevelDescription::AddStaticBody(const b2Body* body)
+{
+	staticBodies.push_back(DescribeBody(body));
+}
+
+void LevelDescription::AddMovingPlatform(const b2Body* body, const PatrolRoute& route)
+{
+	movingPlatforms.push_back(DescribeBody(body));
+	platformRoutes.push_back(route);
+}
+
+void LevelDescription::AddGroundEnemy(b2Vec2 position, const PatrolRoute& route)
+{
+	enemyPositions.push_back(position);
+	enemyRoutes.push_back(route);
+}
+
+void LevelDescription::SetPlayer(const b2Body* body, int health)
+{
+	player = DescribeBody(body);
+	playerHealth = health;
+}
+
+LevelBodyDesc LevelDescription::DescribeBody(const b2Body* body)
+{
+	LevelBodyDesc desc;
+	desc.bodyType = body->GetType();
+	desc.position = body->GetPosition();
+	desc.angle = body->GetAngle();
+	desc.fixedRotation = body->IsFixedRotation();
+
+	GameObject* object = (GameObject*)body->GetUserData();
+	desc.objectType = object ? object->type() : GROUND;
+
+	// every body in the level is one box centred on the body
+	// so its size is the shape's box in body space
+
+	const b2Fixture* fixture = body->GetFixtureList();
+
+	desc.halfSize = b2Vec2(0.5f, 0.5f);
+	desc.friction = 0.0f;
+	desc.density = 0.0f;
+	desc.isSensor = false;
+
+	if (fixture)
+	{
+		b2Transform identity;
+		identity.SetIdentity();
+
+		b2AABB box;
+		fixture->GetShape()->ComputeAABB(&box, identity, 0);
+
+		// polygons are padded by their skin radius
+		float radius = fixture->GetShape()->m_radius;
+
+		desc.halfSize = b2Vec2(0.5f * (box.upperBound.x - box.lowerBound.x) - radius,
+			0.5f * (box.upperBound.y - box.lowerBound.y) - radius);
+		desc.friction = fixture->GetFriction();
+		desc.density = fixture->GetDensity();
+		desc.isSensor = fixture->IsSensor();
+	}
+
+	return desc;
+}
+
+//
+// input script
+//
+
+bool InputScript::Load(const char* filename)
+{
+	FILE* file = fopen(filename, "r");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	ticks.clear();
+
+	char line[MAX_SCRIPT_LINE];
+
+	while (fgets(line, sizeof(line), file))
+	{
+		int count;
+		char keys[MAX_SCRIPT_LINE];
+
+		if (line[0] == '#' || sscanf(line, "%i %63s", &count, keys) != 2)
+		{
+			continue;
+		}
+
+		Add(count, strchr(keys, 'L') != NULL, strchr(keys, 'R') != NULL,
+			strchr(keys, 'J') != NULL, strchr(keys, 'D') != NULL);
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+bool InputScript::Save(const char* filename) const
+{
+	FILE* file = fopen(filename, "w");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "# ticks keys, keys are L R J D or - for none\n");
+
+	size_t start = 0;
+
+	while (start < ticks.size())
+	{
+		size_t end = start;
+
+		while (end < ticks.size() && ticks[end] == ticks[start])
+		{
+			end++;
+		}
+
+		char keys[5];
+		int keyCount = 0;
+
+		if (ticks[start] & INPUT_LEFT) keys[keyCount++] = 'L';
+		if (ticks[start] & INPUT_RIGHT) keys[keyCount++] = 'R';
+		if (ticks[start] & INPUT_JUMP) keys[keyCount++] = 'J';
+		if (ticks[start] & INPUT_DASH) keys[keyCount++] = 'D';
+		if (keyCount == 0) keys[keyCount++] = '-';
+		keys[keyCount] = '\0';
+
+		fprintf(file, "%i %s\n", (int)(end - start), keys);
+
+		start = end;
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+void InputScript::Add(int count, bool left, bool right, bool jump, bool dash)
+{
+	unsigned char held = (left ? INPUT_LEFT : 0) | (right ? INPUT_RIGHT : 0) |
+		(jump ? INPUT_JUMP : 0) | (dash ? INPUT_DASH : 0);
+
+	for (int i = 0; i < count; i++)
+	{
+		ticks.push_back(held);
+	}
+}
+
+void InputScript::Record(const PlayerInput& input)
+{
+	// presses only last one tick
+	// so they are recorded as held for that tick
+
+	Add(1, input.leftDown, input.rightDown, input.upPressed, input.dashPressed);
+}
+
+PlayerInput InputScript::GetInput(int tick) const
+{
+	unsigned char held = tick >= 0 && tick < (int)ticks.size() ? ticks[tick] : 0;
+	unsigned char previous = tick > 0 && tick - 1 < (int)ticks.size() ? ticks[tick - 1] : 0;
+
+	return KeysToInput(held, previous);
+}
+
+PlayerInput InputScript::KeysToInput(unsigned int held, unsigned int previous)
+{
+	PlayerInput input;
+	input.upPressed = (held & INPUT_JUMP) && !(previous & INPUT_JUMP);
+	input.leftDown = (held & INPUT_LEFT) != 0;
+	input.rightDown = (held & INPUT_RIGHT) != 0;
+	input.leftReleased = !(held & INPUT_LEFT) && (previous & INPUT_LEFT);
+	input.rightReleased = !(held & INPUT_RIGHT) && (previous & INPUT_RIGHT);
+	input.dashPressed = (held & INPUT_DASH) && !(previous & INPUT_DASH);
+
+	return input;
+}
+
+//
+// simulation result
+//
+
+SimulationResult::SimulationResult()
+{
+	ticks = 0;
+	won = false;
+	died = false;
+	health = 0;
+	playerHits = 0;
+	abilitiesAcquired = 0;
+	finalPosition = b2Vec2(0.0f, 0.0f);
+	highestY = 0.0f;
+}
+
+//
+// level simulation
+//
+
+// level simulation constructor
+// initialising level simulation values
+
+LevelSimulation::LevelSimulation()
+{
+	level = NULL;
+	world = NULL;
+	playerBody = NULL;
+	script = NULL;
+	maxTicks = 0;
+	finished = true;
+	destruction.setDisableOnly(true);
+
+	for (int i = 0; i < PICKUP_ABILITY_NUM; i++)
+	{
+		pickupBodies[i] = NULL;
+	}
+}
+
+LevelSimulation::~LevelSimulation()
+{
+	Release();
+}
+
+void LevelSimulation::Init(const LevelDescription& level, const InputScript* script, const PlayerTuning& tuning, int maxTicks)
+{
+	Release();
+
+	this->level = &level;
+	this->script = script;
+	this->tuning = tuning;
+	this->maxTicks = maxTicks;
+
+	int bodyCount = 1 + (int)level.staticBodies.size() + (int)level.movingPlatforms.size() + (int)level.enemyPositions.size();
+
+	b2Vec2 gravity(0.0f, -9.81f);
+	world = physicsMemory.CreateWorld(gravity, bodyCount, bodyCount);
+
+	// player
+	// its values are set when the run starts below
+
+	playerBody = CreateBody(level.player, &player);
+
+	// static bodies
+	// reserved first so the user data pointers stay put
+
+	staticObjects.clear();
+	staticObjects.reserve(level.staticBodies.size());
+	staticBodies.clear();
+	resetWallBodies.clear();
+
+	for (int i = 0; i < PICKUP_ABILITY_NUM; i++)
+	{
+		pickupBodies[i] = NULL;
+	}
+
+	for (size_t i = 0; i < level.staticBodies.size(); i++)
+	{
+		const LevelBodyDesc& desc = level.staticBodies[i];
+
+		staticObjects.push_back(GameObject());
+		staticObjects.back().set_type(desc.objectType);
+
+		b2Body* body = CreateBody(desc, &staticObjects.back());
+		staticBodies.push_back(body);
+
+		// keeps the bodies changed by picking up abilities
+
+		switch (desc.objectType)
+		{
+		case ABILITY_DASH:
+			pickupBodies[PICKUP_DASH] = body;
+			break;
+		case ABILITY_DJ:
+			pickupBodies[PICKUP_DOUBLE_JUMP] = body;
+			break;
+		case ABILITY_RW:
+			pickupBodies[PICKUP_RESET_WALL] = body;
+			break;
+		case STICKY_WALL:
+			resetWallBodies.push_back(body);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// moving platforms
+
+	movingPlatforms.clear();
+	movingPlatforms.resize(level.movingPlatforms.size());
+	movingPlatformBodies.clear();
+
+	for (size_t i = 0; i < level.movingPlatforms.size(); i++)
+	{
+		movingPlatformBodies.push_back(CreateBody(level.movingPlatforms[i], &movingPlatforms[i]));
+	}
+
+	platformRoutes = level.platformRoutes;
+
+	// ground enemies
+	// created without meshes as there is nothing to draw them
+
+	groundEnemies.clear();
+	groundEnemies.resize(level.enemyPositions.size());
+
+	for (size_t i = 0; i < level.enemyPositions.size(); i++)
+	{
+		groundEnemies[i].setPosition(level.enemyPositions[i]);
+		groundEnemies[i].Init(world, NULL);
+	}
+
+	enemyRoutes = level.enemyRoutes;
+
+	Reset();
+}
+
+void LevelSimulation::Reset()
+{
+	if (!world)
+	{
+		return;
+	}
+
+	result = SimulationResult();
+	finished = false;
+
+	// player starts again with full health and no abilities
+
+	player = Player();
+	player.getTuning() = tuning;
+	player.setHealth(level->playerHealth);
+	player.setDashActive(false);
+	player.setDoubleJumpActive(false);
+	player.setResetWallActive(false);
+	abilityEvents.Reset();
+	destruction.Clear();
+
+	ResetBody(playerBody, level->player);
+
+	// pickups come back and the reset walls lose their grip
+	// contacts already touching a wall mix their friction again
+
+	for (size_t i = 0; i < staticBodies.size(); i++)
+	{
+		staticBodies[i]->SetActive(true);
+		staticBodies[i]->GetFixtureList()->SetFriction(level->staticBodies[i].friction);
+	}
+
+	for (size_t i = 0; i < resetWallBodies.size(); i++)
+	{
+		for (b2ContactEdge* edge = resetWallBodies[i]->GetContactList(); edge; edge = edge->next)
+		{
+			edge->contact->ResetFriction();
+		}
+	}
+
+	// moving platforms and enemies start their routes again
+
+	for (size_t i = 0; i < movingPlatforms.size(); i++)
+	{
+		movingPlatforms[i] = MovingPlatform();
+		ResetBody(movingPlatformBodies[i], level->movingPlatforms[i]);
+	}
+
+	for (size_t i = 0; i < groundEnemies.size(); i++)
+	{
+		groundEnemies[i].Reset();
+	}
+
+	result.highestY = playerBody->GetPosition().y;
+}
+
+bool LevelSimulation::Step()
+{
+	PlayerInput input = { false, false, false, false, false, false };
+
+	if (script)
+	{
+		input = script->GetInput(result.ticks);
+	}
+
+	return Step(input);
+}
+
+bool LevelSimulation::Step(const PlayerInput& input)
+{
+	if (finished)
+	{
+		return false;
+	}
+
+	// same order as the game update
+
+	world->Step(SIMULATION_TIME_STEP, SIMULATION_VELOCITY_ITERATIONS, SIMULATION_POSITION_ITERATIONS);
+
+	LevelContactResults contactResults;
+	ProcessLevelContacts(world, playerBody, abilityEvents, contactResults);
+
+	result.playerHits += contactResults.playerHits;
+
+	PICKUP_ABILITY ability;
+
+	while (abilityEvents.PopEvent(ability))
+	{
+		ApplyAbility(ability, player, pickupBodies[ability],
+			resetWallBodies.empty() ? NULL : &resetWallBodies[0], (int)resetWallBodies.size(), destruction);
+
+		result.abilitiesAcquired++;
+	}
+
+	destruction.Flush(world);
+
+	for (size_t i = 0; i < movingPlatforms.size(); i++)
+	{
+		const PatrolRoute& route = platformRoutes[i];
+
+		if (route.yAxis)
+		{
+			movingPlatforms[i].setPlatPosAndSpeedYaxis(movingPlatformBodies[i], route.start, route.end, route.speed);
+		}
+		else
+		{
+			movingPlatforms[i].setPlatPosAndSpeedXaxis(movingPlatformBodies[i], route.start, route.end, route.speed);
+		}
+	}
+
+	for (size_t i = 0; i < groundEnemies.size(); i++)
+	{
+		groundEnemies[i].Movement(enemyRoutes[i].start, enemyRoutes[i].end, enemyRoutes[i].speed);
+	}
+
+	player.HandleInput(input, playerBody, SIMULATION_TIME_STEP);
+
+	// records how the run is going
+
+	result.ticks++;
+	result.health = player.getHealth();
+	result.finalPosition = playerBody->GetPosition();
+
+	if (result.finalPosition.y > result.highestY)
+	{
+		result.highestY = result.finalPosition.y;
+	}
+
+	result.won = contactResults.collectableReached;
+	result.died = player.getHealth() < 1;
+
+	finished = result.won || result.died || result.ticks >= maxTicks;
+
+	return !finished;
+}
+
+void LevelSimulation::PlacePlayer(b2Vec2 position, b2Vec2 velocity, PLAYER_STATE current, PLAYER_STATE previous,
+	PLAYER_STATE secondPrevious, unsigned int abilities)
+{
+	playerBody->SetTransform(position, playerBody->GetAngle());
+	playerBody->SetLinearVelocity(velocity);
+	playerBody->SetAwake(true);
+
+	// the state history is shifted in oldest first
+
+	player.setPlayerState(secondPrevious);
+	player.setPlayerState(previous);
+	player.setPlayerState(current);
+
+	// goes through the same queue as touching the pickups
+
+	for (int i = 0; i < PICKUP_ABILITY_NUM; i++)
+	{
+		if (abilities & (1 << i))
+		{
+			abilityEvents.Acquire((PICKUP_ABILITY)i);
+		}
+	}
+
+	PICKUP_ABILITY ability;
+
+	while (abilityEvents.PopEvent(ability))
+	{
+		ApplyAbility(ability, player, pickupBodies[ability],
+			resetWallBodies.empty() ? NULL : &resetWallBodies[0], (int)resetWallBodies.size(), destruction);
+	}
+
+	destruction.Flush(world);
+
+	if (position.y > result.highestY)
+	{
+		result.highestY = position.y;
+	}
+}
+
+unsigned int LevelSimulation::getAbilities()
+{
+	unsigned int abilities = 0;
+
+	for (int i = 0; i < PICKUP_ABILITY_NUM; i++)
+	{
+		if (abilityEvents.isAcquired((PICKUP_ABILITY)i))
+		{
+			abilities |= 1 << i;
+		}
+	}
+
+	return abilities;
+}
+
+void LevelSimulation::Release()
+{
+	// the bodies go with the world
+	// so the objects pointing at them are cleared too
+
+	delete world;
+	world = NULL;
+	playerBody = NULL;
+	level = NULL;
+
+	staticObjects.clear();
+	staticBodies.clear();
+	movingPlatforms.clear();
+	movingPlatformBodies.clear();
+	groundEnemies.clear();
+	resetWallBodies.clear();
+
+	finished = true;
+}
+
+b2Body* LevelSimulation::CreateBody(const LevelBodyDesc& desc, GameObject* object)
+{
+	b2BodyDef body_def;
+	body_def.type = desc.bodyType;
+	body_def.position = desc.position;
+	body_def.angle = desc.angle;
+	body_def.fixedRotation = desc.fixedRotation;
+
+	b2Body* body = world->CreateBody(&body_def);
+
+	b2PolygonShape shape;
+	shape.SetAsBox(desc.halfSize.x, desc.halfSize.y);
+
+	b2FixtureDef fixture_def;
+	fixture_def.shape = &shape;
+	fixture_def.friction = desc.friction;
+	fixture_def.density = desc.density;
+	fixture_def.isSensor = desc.isSensor;
+
+	body->CreateFixture(&fixture_def);
+	body->SetUserData(object);
+
+	return body;
+}
+
+void LevelSimulation::ResetBody(b2Body* body, const LevelBodyDesc& desc)
+{
+	body->SetTransform(desc.position, desc.angle);
+	body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+	body->SetAngularVelocity(0.0f);
+	body->SetAwake(true);
+}
@@ -0,0 +1,239 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+#include "game_object.h"
+#include "GroundEnemy.h"
+#include "HotReload.h"
+#include "AbilityEvents.h"
+#include "DestructionQueue.h"
+#include "PhysicsMemory.h"
+
+// level body description
+// one box shaped body, read from a body in the live level
+
+struct LevelBodyDesc
+{
+	b2BodyType bodyType;
+	OBJECT_TYPE objectType;
+	b2Vec2 position;
+	float angle;
+	b2Vec2 halfSize;
+	float friction;
+	float density;
+	bool isSensor;
+	bool fixedRotation;
+};
+
+// level description
+// everything needed to build a copy of the level without a renderer
+// captured from the game once the level has been created
+
+class LevelDescription
+{
+public:
+
+	// forgets every body
+
+	void Clear();
+
+	// adds bodies read from the live level
+
+	void AddStaticBody(const b2Body* body);
+	void AddMovingPlatform(const b2Body* body, const PatrolRoute& route);
+	void AddGroundEnemy(b2Vec2 position, const PatrolRoute& route);
+	void SetPlayer(const b2Body* body, int health);
+
+	// returns the description of a box shaped body
+
+	static LevelBodyDesc DescribeBody(const b2Body* body);
+
+	// level description variables
+
+	std::vector<LevelBodyDesc> staticBodies;
+
+	std::vector<LevelBodyDesc> movingPlatforms;
+	std::vector<PatrolRoute> platformRoutes;
+
+	std::vector<b2Vec2> enemyPositions;
+	std::vector<PatrolRoute> enemyRoutes;
+
+	LevelBodyDesc player;
+	int playerHealth;
+};
+
+// keys held on one tick, one bit each
+// used by input scripts and as the actions of a level environment
+
+enum INPUT_KEY
+{
+	INPUT_LEFT = 1,
+	INPUT_RIGHT = 2,
+	INPUT_JUMP = 4,
+	INPUT_DASH = 8
+};
+
+// input script
+// the player's input for each tick, played back by a simulation
+// saved as lines of "ticks keys", keys being any of L R J D or - for none
+// keys are held for the ticks given, a key held on one line and the next stays held
+
+class InputScript
+{
+public:
+
+	// reads a script file
+	// returns false if it can't be read
+
+	bool Load(const char* filename);
+
+	// writes the script, joining ticks with the same keys onto one line
+
+	bool Save(const char* filename) const;
+
+	// adds ticks holding the keys
+
+	void Add(int ticks, bool left, bool right, bool jump, bool dash);
+
+	// adds one tick of input read from the player
+	// used to record a run
+
+	void Record(const PlayerInput& input);
+
+	// returns the input for a tick
+	// presses and releases come from comparing with the tick before
+	// there is no input past the end of the script
+
+	PlayerInput GetInput(int tick) const;
+
+	// turns the keys held this tick and last tick into player input
+
+	static PlayerInput KeysToInput(unsigned int held, unsigned int previous);
+
+	void Clear() { ticks.clear(); }
+
+	int getTickCount() const { return (int)ticks.size(); }
+
+private:
+
+	// keys held on each tick, one bit per key
+	std::vector<unsigned char> ticks;
+};
+
+// simulation result
+// how one copy of the level finished
+
+struct SimulationResult
+{
+	SimulationResult();
+
+	int ticks;
+	bool won;
+	bool died;
+	int health;
+	int playerHits;
+	int abilitiesAcquired;
+	b2Vec2 finalPosition;
+	float highestY;
+};
+
+// level simulation
+// one isolated copy of the level with its own world, player and enemies
+// steps at a fixed rate with scripted input and no renderer or audio
+// nothing is shared between simulations so each can run on its own thread
+
+class LevelSimulation
+{
+public:
+
+	// level simulation constructor
+
+	LevelSimulation();
+	~LevelSimulation();
+
+	// builds the copy of the level
+	// the level and script must outlive the simulation
+
+	void Init(const LevelDescription& level, const InputScript* script, const PlayerTuning& tuning, int maxTicks);
+
+	// puts every body back where the level starts and begins a new run
+	// the world and its bodies are kept, so nothing is allocated
+
+	void Reset();
+
+	// steps one fixed tick the same way the game updates
+	// returns false once the player has won, died or run out of ticks
+
+	bool Step();
+
+	// steps one tick with the input given instead of the script's
+
+	bool Step(const PlayerInput& input);
+
+	// moves the player to any point of a run
+	// abilities is one bit per PICKUP_ABILITY, given as if their pickups were touched
+	// used to search from a state without replaying the run up to it
+
+	void PlacePlayer(b2Vec2 position, b2Vec2 velocity, PLAYER_STATE current, PLAYER_STATE previous,
+		PLAYER_STATE secondPrevious, unsigned int abilities);
+
+	// one bit per PICKUP_ABILITY the player has picked up
+
+	unsigned int getAbilities();
+
+	// destroys the world
+
+	void Release();
+
+	// getters
+
+	bool isFinished() const { return finished; }
+	const SimulationResult& getResult() const { return result; }
+
+	Player& getPlayer() { return player; }
+	b2Body* getPlayerBody() { return playerBody; }
+
+	int getGroundEnemyCount() const { return (int)groundEnemies.size(); }
+	b2Vec2 getGroundEnemyPosition(int index) { return groundEnemies[index].getBody()->GetPosition(); }
+
+private:
+
+	// creates a box body from its description
+	b2Body* CreateBody(const LevelBodyDesc& desc, GameObject* object);
+
+	// moves a body back to its description and stops it
+	void ResetBody(b2Body* body, const LevelBodyDesc& desc);
+
+	// level simulation variables
+
+	const LevelDescription* level;
+	PlayerTuning tuning;
+
+	b2World* world;
+	PhysicsMemory physicsMemory;
+
+	Player player;
+	b2Body* playerBody;
+
+	// game objects give the bodies their type for the level rules
+	std::vector<GameObject> staticObjects;
+	std::vector<b2Body*> staticBodies;
+	std::vector<MovingPlatform> movingPlatforms;
+	std::vector<b2Body*> movingPlatformBodies;
+	std::vector<GroundEnemy> groundEnemies;
+
+	std::vector<PatrolRoute> platformRoutes;
+	std::vector<PatrolRoute> enemyRoutes;
+
+	b2Body* pickupBodies[PICKUP_ABILITY_NUM];
+	std::vector<b2Body*> resetWallBodies;
+
+	AbilityEventQueue abilityEvents;
+
+	// picked up pickups are only switched off so a reset can switch them back on
+	DestructionQueue destruction;
+
+	const InputScript* script;
+	int maxTicks;
+	bool finished;
+	SimulationResult result;
+};
@@ -0,0 +1,62 @@
+#include "LinearArena.h"
+#include <system/debug_log.h>
+#include <stdint.h>
+
+// linear arena constructor
+// initialising linear arena values
+
+LinearArena::LinearArena(size_t size, const char* name)
+{
+	buffer = new char[size];
+	capacity = size;
+	used = 0;
+	highWatermark = 0;
+	failedAllocations = 0;
+	arenaName = name;
+}
+
+LinearArena::~LinearArena()
+{
+	delete[] buffer;
+	buffer = NULL;
+}
+
+// moves the arena pointer forward
+// padding it to the alignment asked for
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+	uintptr_t base = (uintptr_t)buffer;
+	size_t start = ((base + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+
+	if (start + size > capacity)
+	{
+		failedAllocations++;
+		return NULL;
+	}
+
+	used = start + size;
+
+	if (used > highWatermark)
+	{
+		highWatermark = used;
+	}
+
+	return buffer + start;
+}
+
+// frees everything allocated from the arena
+// the high watermark is kept
+
+void LinearArena::Reset()
+{
+	used = 0;
+}
+
+// prints the arena usage to the debug output
+
+void LinearArena::PrintStats()
+{
+	gef::DebugOut("%s arena: used %u, high watermark %u of %u bytes, %i failed allocations\n",
+		arenaName, (unsigned int)used, (unsigned int)highWatermark, (unsigned int)capacity, failedAllocations);
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <memory>
+
+// linear arena
+// hands out memory from one block by moving a pointer forward
+// nothing is freed on its own, the whole arena is reset at once
+
+class LinearArena
+{
+public:
+
+	// linear arena constructor
+	// allocates the whole block up front
+
+	LinearArena(size_t size, const char* name);
+	~LinearArena();
+
+	// returns memory from the arena
+	// returns NULL if the arena is full
+
+	void* Allocate(size_t size, size_t alignment = 16);
+
+	// frees everything allocated from the arena
+
+	void Reset();
+
+	// prints the arena usage to the debug output
+
+	void PrintStats();
+
+	// getters for arena stats
+
+	size_t getCapacity() { return capacity; }
+	size_t getUsed() { return used; }
+	size_t getHighWatermark() { return highWatermark; }
+	int getFailedAllocations() { return failedAllocations; }
+
+private:
+
+	// arena is not copyable as it owns its block
+	LinearArena(const LinearArena&);
+	LinearArena& operator=(const LinearArena&);
+
+	// arena variables
+
+	char* buffer;
+	size_t capacity;
+	size_t used;
+	size_t highWatermark;
+	int failedAllocations;
+	const char* arenaName;
+};
+
+// types an arena allocator takes from the heap instead of the arena
+// MSVC debug builds give each container a proxy through the rebound allocator
+// which lives as long as the container, so it can't be freed by an arena reset
+
+template<class T>
+struct ArenaUsesHeap
+{
+	static const bool value = false;
+};
+
+#if defined(_MSC_VER) && defined(_ITERATOR_DEBUG_LEVEL) && _ITERATOR_DEBUG_LEVEL != 0
+template<>
+struct ArenaUsesHeap<std::_Container_proxy>
+{
+	static const bool value = true;
+};
+#endif
+
+// arena allocator
+// lets std containers take their storage from a linear arena
+// deallocate does nothing, the memory comes back when the arena is reset
+// so containers must release their storage before the reset
+
+template<class T>
+class ArenaAllocator
+{
+public:
+
+	typedef T value_type;
+
+	ArenaAllocator(LinearArena* arena) : arena_(arena) {}
+
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+	T* allocate(size_t n)
+	{
+		if (ArenaUsesHeap<T>::value)
+		{
+			return std::allocator<T>().allocate(n);
+		}
+
+		void* ptr = arena_->Allocate(n * sizeof(T), alignof(T));
+
+		if (!ptr)
+		{
+			throw std::bad_alloc();
+		}
+
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t n)
+	{
+		if (ArenaUsesHeap<T>::value)
+		{
+			std::allocator<T>().deallocate(ptr, n);
+		}
+	}
+
+	LinearArena* arena() const { return arena_; }
+
+private:
+
+	LinearArena* arena_;
+};
+
+template<class T, class U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() == b.arena(); }
+
+template<class T, class U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() != b.arena(); }
+
+// releases the storage of a container using an arena allocator
+// clear() keeps the storage, so this must be used before the arena is reset
+
+template<class Container>
+inline void ReleaseArenaContainer(Container& container)
+{
+	Container(container.get_allocator()).swap(container);
+}
+
@@ -0,0 +1,380 @@
+#include "Logger.h"
+#include <system/debug_log.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <stdio.h>
+#include <string.h>
+
+// time the logging thread sleeps when the buffer is empty
+
+#define LOG_IDLE_SLEEP_MS 2
+
+// longest message printed, including the level and category prefix
+
+#define LOG_LINE_LENGTH 512
+
+namespace
+{
+	// ring buffer slot
+	// the sequence says whether the slot is free for the writer
+	// or holds a record for the logging thread
+	struct LogSlot
+	{
+		std::atomic<size_t> sequence;
+		LogRecord record;
+	};
+
+	LogSlot* slots = NULL;
+	size_t slotMask = 0;
+
+	// next slot to write, shared by every thread that logs
+	std::atomic<size_t> writePosition(0);
+
+	// next slot to read, only used by the logging thread
+	size_t readPosition = 0;
+
+	std::atomic<int> currentLevel(LOG_COMPILED_LEVEL);
+	std::atomic<bool> running(false);
+	std::atomic<unsigned int> droppedCount(0);
+
+	std::thread logThread;
+
+	std::chrono::steady_clock::time_point startTime;
+
+	const char* levelNames[] = { "trace", "debug", "info", "warning", "error" };
+	const char* categoryNames[LOG_CATEGORY_COUNT] = { "game", "physics", "render", "audio", "memory" };
+
+	// takes the next record out of the ring buffer
+	// returns false if it is empty
+	bool Pop(LogRecord& record)
+	{
+		LogSlot& slot = slots[readPosition & slotMask];
+
+		if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+		{
+			return false;
+		}
+
+		record = slot.record;
+
+		// frees the slot for the writer one lap ahead
+		slot.sequence.store(readPosition + slotMask + 1, std::memory_order_release);
+		readPosition++;
+
+		return true;
+	}
+
+	// reads an argument as an integer, for * widths and precisions
+	long long ArgToInt(const LogArg& arg)
+	{
+		return arg.type == LOG_ARG_DOUBLE ? (long long)arg.d : (long long)arg.i;
+	}
+
+	// appends one formatted argument for a printf conversion
+	// the conversion picks how the raw argument is read
+	// length modifiers in the format are replaced as every integer is stored 64 bit
+	void AppendArg(std::string& line, const std::string& spec, char conversion, const LogArg& arg)
+	{
+		char buffer[128];
+
+		switch (conversion)
+		{
+		case 'd':
+		case 'i':
+		case 'c':
+		{
+			long long value = ArgToInt(arg);
+
+			if (conversion == 'c')
+			{
+				snprintf(buffer, sizeof(buffer), (spec + "c").c_str(), (int)value);
+			}
+			else
+			{
+				snprintf(buffer, sizeof(buffer), (spec + "lld").c_str(), value);
+			}
+			break;
+		}
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+		{
+			unsigned long long value = arg.type == LOG_ARG_DOUBLE ? (unsigned long long)arg.d : (unsigned long long)arg.u;
+			snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), value);
+			break;
+		}
+		case 's':
+			snprintf(buffer, sizeof(buffer), (spec + "s").c_str(), arg.type == LOG_ARG_STRING && arg.s ? arg.s : "(null)");
+			break;
+		case 'p':
+			snprintf(buffer, sizeof(buffer), (spec + "p").c_str(), arg.p);
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+		{
+			double value = arg.type == LOG_ARG_DOUBLE ? arg.d :
+				(arg.type == LOG_ARG_UINT ? (double)arg.u : (double)arg.i);
+			snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+			break;
+		}
+		default:
+			// anything else, %n included, is printed as written and never given to snprintf
+
+			line += spec;
+			line += conversion;
+			return;
+		}
+
+		line += buffer;
+	}
+
+	// formats a record into one line and prints it
+	void Print(const LogRecord& record)
+	{
+		char prefix[64];
+		double seconds = record.time / 1000000000.0;
+		snprintf(prefix, sizeof(prefix), "[%.3f][%s][%s] ", seconds, levelNames[record.level], categoryNames[record.category]);
+
+		std::string line = prefix;
+		int argIndex = 0;
+
+		for (const char* c = record.format; *c; c++)
+		{
+			if (*c != '%')
+			{
+				line += *c;
+				continue;
+			}
+
+			c++;
+
+			if (*c == '%')
+			{
+				line += '%';
+				continue;
+			}
+
+			// flags, width and precision are kept
+			// length modifiers are skipped
+
+			std::string spec = "%";
+
+			while (*c && strchr("-+ #0123456789.*", *c))
+			{
+				if (*c != '*')
+				{
+					spec += *c;
+					c++;
+					continue;
+				}
+
+				// a * width or precision is read from the next argument
+				// and written into the spec, so snprintf is only given one
+				// a negative precision counts as none, as in printf
+
+				long long value = argIndex < record.argCount ? ArgToInt(record.args[argIndex++]) : 0;
+				value = value < -LOG_LINE_LENGTH ? -LOG_LINE_LENGTH : (value > LOG_LINE_LENGTH ? LOG_LINE_LENGTH : value);
+
+				if (spec[spec.size() - 1] == '.' && value < 0)
+				{
+					spec.resize(spec.size() - 1);
+				}
+				else
+				{
+					spec += std::to_string(value);
+				}
+
+				c++;
+			}
+
+			while (*c && strchr("hlLqjzt", *c))
+			{
+				c++;
+			}
+
+			if (!*c)
+			{
+				break;
+			}
+
+			if (argIndex < record.argCount)
+			{
+				AppendArg(line, spec, *c, record.args[argIndex++]);
+			}
+		}
+
+		if (line.size() > LOG_LINE_LENGTH)
+		{
+			line.resize(LOG_LINE_LENGTH);
+		}
+
+		// messages are printed one line each
+
+		if (line.empty() || line[line.size() - 1] != '\n')
+		{
+			line += '\n';
+		}
+
+		gef::DebugOut("%s", line.c_str());
+	}
+
+	// prints every record in the buffer
+	void Drain()
+	{
+		LogRecord record;
+
+		while (Pop(record))
+		{
+			Print(record);
+		}
+	}
+
+	// logging thread
+	// formats and prints records away from the game loop
+	void LogThreadMain()
+	{
+		while (running.load(std::memory_order_acquire))
+		{
+			LogRecord record;
+
+			if (Pop(record))
+			{
+				Print(record);
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(LOG_IDLE_SLEEP_MS));
+			}
+		}
+	}
+}
+
+void Logger::Start(int capacity)
+{
+	if (running.load())
+	{
+		return;
+	}
+
+	size_t slotCount = 1;
+
+	while (slotCount < (size_t)capacity)
+	{
+		slotCount <<= 1;
+	}
+
+	slots = new LogSlot[slotCount];
+	slotMask = slotCount - 1;
+
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	writePosition.store(0);
+	readPosition = 0;
+	droppedCount.store(0);
+	startTime = std::chrono::steady_clock::now();
+
+	running.store(true, std::memory_order_release);
+	logThread = std::thread(LogThreadMain);
+}
+
+void Logger::Stop()
+{
+	if (!running.load())
+	{
+		return;
+	}
+
+	running.store(false, std::memory_order_release);
+	logThread.join();
+
+	// prints what the thread didn't get to
+
+	Drain();
+
+	if (droppedCount.load() > 0)
+	{
+		gef::DebugOut("logger: %u messages dropped, buffer was full\n", droppedCount.load());
+	}
+
+	delete[] slots;
+	slots = NULL;
+	slotMask = 0;
+}
+
+void Logger::SetLevel(int level)
+{
+	currentLevel.store(level, std::memory_order_relaxed);
+}
+
+int Logger::GetLevel()
+{
+	return currentLevel.load(std::memory_order_relaxed);
+}
+
+bool Logger::IsEnabled(int level)
+{
+	return level >= currentLevel.load(std::memory_order_relaxed) && running.load(std::memory_order_relaxed);
+}
+
+unsigned int Logger::GetDroppedCount()
+{
+	return droppedCount.load();
+}
+
+int64_t Logger::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Logger::Push(const LogRecord& record)
+{
+	// claims a slot by moving the write position on
+	// several threads can log at once, each gets its own slot
+
+	size_t position = writePosition.load(std::memory_order_relaxed);
+	LogSlot* slot;
+
+	for (;;)
+	{
+		slot = &slots[position & slotMask];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+		if (difference == 0)
+		{
+			if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// the logging thread hasn't freed this slot yet
+			// so the buffer is full
+
+			droppedCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			position = writePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->record = record;
+
+	// hands the slot to the logging thread
+	slot->sequence.store(position + 1, std::memory_order_release);
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <stdint.h>
+
+// log levels
+// numbers so they can be compared by the preprocessor
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+
+// calls below this level are compiled out completely
+// the level set at runtime filters the rest
+
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// most arguments one record holds
+// any past this are dropped from the message
+
+#define LOG_MAX_ARGS 8
+
+// log categories
+// printed with each message so output can be filtered
+
+enum LOG_CATEGORY
+{
+	LOG_GAME,
+	LOG_PHYSICS,
+	LOG_RENDER,
+	LOG_AUDIO,
+	LOG_MEMORY,
+	LOG_CATEGORY_COUNT
+};
+
+// argument types stored in a record
+
+enum LOG_ARG_TYPE
+{
+	LOG_ARG_INT,
+	LOG_ARG_UINT,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_STRING,
+	LOG_ARG_POINTER
+};
+
+// one argument copied raw into a record
+// strings are stored as pointers so must be literals
+// or otherwise outlive the message being printed
+
+struct LogArg
+{
+	int type;
+
+	union
+	{
+		int64_t i;
+		uint64_t u;
+		double d;
+		const char* s;
+		const void* p;
+	};
+};
+
+// one log call
+// the format string pointer identifies the message
+// nothing is formatted until the logging thread prints it
+
+struct LogRecord
+{
+	const char* format;
+	int64_t time;
+	int level;
+	LOG_CATEGORY category;
+	int argCount;
+	LogArg args[LOG_MAX_ARGS];
+};
+
+namespace Logger
+{
+	// starts the logging thread
+	// capacity is the number of records the ring buffer holds, rounded up to a power of two
+
+	void Start(int capacity = 4096);
+
+	// stops the logging thread and prints anything still in the buffer
+
+	void Stop();
+
+	// sets the lowest level printed
+
+	void SetLevel(int level);
+	int GetLevel();
+
+	// returns true if a message at this level would be printed
+
+	bool IsEnabled(int level);
+
+	// number of records dropped because the buffer was full
+
+	unsigned int GetDroppedCount();
+
+	// copies a record into the ring buffer
+	// never waits, the record is dropped if the buffer is full
+
+	void Push(const LogRecord& record);
+
+	// copies an argument into a record
+
+	inline LogArg MakeArg(int value) { LogArg arg; arg.type = LOG_ARG_INT; arg.i = value; return arg; }
+	inline LogArg MakeArg(long value) { LogArg arg; arg.type = LOG_ARG_INT; arg.i = value; return arg; }
+	inline LogArg MakeArg(long long value) { LogArg arg; arg.type = LOG_ARG_INT; arg.i = value; return arg; }
+	inline LogArg MakeArg(unsigned int value) { LogArg arg; arg.type = LOG_ARG_UINT; arg.u = value; return arg; }
+	inline LogArg MakeArg(unsigned long value) { LogArg arg; arg.type = LOG_ARG_UINT; arg.u = value; return arg; }
+	inline LogArg MakeArg(unsigned long long value) { LogArg arg; arg.type = LOG_ARG_UINT; arg.u = value; return arg; }
+	inline LogArg MakeArg(bool value) { LogArg arg; arg.type = LOG_ARG_INT; arg.i = value ? 1 : 0; return arg; }
+	inline LogArg MakeArg(double value) { LogArg arg; arg.type = LOG_ARG_DOUBLE; arg.d = value; return arg; }
+	inline LogArg MakeArg(const char* value) { LogArg arg; arg.type = LOG_ARG_STRING; arg.s = value; return arg; }
+	inline LogArg MakeArg(const void* value) { LogArg arg; arg.type = LOG_ARG_POINTER; arg.p = value; return arg; }
+
+	// fills in a record's arguments one at a time
+
+	inline void PackArgs(LogRecord&)
+	{
+	}
+
+	template<typename T, typename... Rest>
+	inline void PackArgs(LogRecord& record, T value, Rest... rest)
+	{
+		if (record.argCount < LOG_MAX_ARGS)
+		{
+			record.args[record.argCount++] = MakeArg(value);
+		}
+
+		PackArgs(record, rest...);
+	}
+
+	// returns the time used to stamp records
+
+	int64_t Now();
+
+	// builds a record and pushes it into the ring buffer
+	// called through the LOG_ macros
+
+	template<typename... Args>
+	void Write(int level, LOG_CATEGORY category, const char* format, Args... args)
+	{
+		if (!IsEnabled(level))
+		{
+			return;
+		}
+
+		LogRecord record;
+		record.format = format;
+		record.time = Now();
+		record.level = level;
+		record.category = category;
+		record.argCount = 0;
+
+		PackArgs(record, args...);
+		Push(record);
+	}
+}
+
+// logging macros
+// each level below LOG_COMPILED_LEVEL expands to nothing
+// so its arguments aren't even evaluated
+
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(category, ...) Logger::Write(LOG_LEVEL_TRACE, category, __VA_ARGS__)
+#else
+#define LOG_TRACE(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(category, ...) Logger::Write(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(category, ...) Logger::Write(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(category, ...) Logger::Write(LOG_LEVEL_WARNING, category, __VA_ARGS__)
+#else
+#define LOG_WARNING(category, ...) ((void)0)
+#endif
+
+#define LOG_ERROR(category, ...) Logger::Write(LOG_LEVEL_ERROR, category, __VA_ARGS__)
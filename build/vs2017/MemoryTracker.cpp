@@ -0,0 +1,431 @@
+#include "MemoryTracker.h"
+#include <system/debug_log.h>
+#include <atomic>
+#include <thread>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+// most leaks printed from one report
+// the rest are only counted
+
+#define MAX_LEAKS_PRINTED 32
+
+namespace
+{
+	// allocation header
+	// placed in front of every tracked allocation
+	// kept at 16 bytes aligned so the memory after it is too
+
+	struct alignas(16) AllocationHeader
+	{
+		AllocationHeader* prev;
+		AllocationHeader* next;
+		size_t size;
+		unsigned int sequence;
+		unsigned int category;
+	};
+
+	// tracked allocation counters
+	// plain data so they are ready before any constructor runs
+
+	struct CategoryCounters
+	{
+		size_t liveBytes;
+		size_t peakBytes;
+		size_t budgetBytes;
+		int liveCount;
+		int totalCount;
+		bool overBudget;
+		bool budgetReported;
+	};
+
+	CategoryCounters counters[MEM_CATEGORY_COUNT];
+	AllocationHeader* liveList = NULL;
+	unsigned int allocationSequence = 0;
+
+	// guards the counters and live list
+	// allocations can come from the framework's own threads
+	// a spinlock on a flag that is constant initialised, so it can be used by allocations
+	// made during static construction or destruction in any translation unit
+	std::atomic_flag trackerFlag = ATOMIC_FLAG_INIT;
+
+	// holds the tracker lock until it goes out of scope
+
+	struct TrackerLock
+	{
+		TrackerLock()
+		{
+			while (trackerFlag.test_and_set(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		~TrackerLock()
+		{
+			trackerFlag.clear(std::memory_order_release);
+		}
+	};
+
+	// current category for this thread
+	thread_local MEMORY_CATEGORY currentCategory = MEM_GENERAL;
+
+	const char* categoryNames[MEM_CATEGORY_COUNT] =
+	{
+		"general",
+		"physics",
+		"render",
+		"audio",
+		"ui",
+		"level"
+	};
+
+	void* TrackedAlloc(size_t size)
+	{
+		AllocationHeader* header = (AllocationHeader*)malloc(sizeof(AllocationHeader) + size);
+
+		if (!header)
+		{
+			return NULL;
+		}
+
+		header->size = size;
+		header->category = currentCategory;
+		header->prev = NULL;
+
+		{
+			TrackerLock lock;
+
+			CategoryCounters& category = counters[header->category];
+			category.liveBytes += size;
+			category.liveCount++;
+			category.totalCount++;
+
+			if (category.liveBytes > category.peakBytes)
+			{
+				category.peakBytes = category.liveBytes;
+			}
+
+			if (category.budgetBytes > 0 && category.liveBytes > category.budgetBytes)
+			{
+				category.overBudget = true;
+			}
+
+			header->sequence = ++allocationSequence;
+			header->next = liveList;
+
+			if (liveList)
+			{
+				liveList->prev = header;
+			}
+
+			liveList = header;
+		}
+
+		return header + 1;
+	}
+
+	void TrackedFree(void* ptr)
+	{
+		if (!ptr)
+		{
+			return;
+		}
+
+		AllocationHeader* header = (AllocationHeader*)ptr - 1;
+
+		{
+			TrackerLock lock;
+
+			CategoryCounters& category = counters[header->category];
+			category.liveBytes -= header->size;
+			category.liveCount--;
+
+			if (header->prev)
+			{
+				header->prev->next = header->next;
+			}
+
+			else
+			{
+				liveList = header->next;
+			}
+
+			if (header->next)
+			{
+				header->next->prev = header->prev;
+			}
+		}
+
+		free(header);
+	}
+
+	void* TrackedNew(size_t size)
+	{
+		// new must return a unique pointer even for zero bytes
+
+		if (size == 0)
+		{
+			size = 1;
+		}
+
+		void* ptr = TrackedAlloc(size);
+
+		if (!ptr)
+		{
+			throw std::bad_alloc();
+		}
+
+		return ptr;
+	}
+}
+
+// memory scope
+// swaps this thread's category for the length of the scope
+
+MemoryScope::MemoryScope(MEMORY_CATEGORY category)
+{
+	previousCategory = currentCategory;
+	currentCategory = category;
+}
+
+MemoryScope::~MemoryScope()
+{
+	currentCategory = previousCategory;
+}
+
+const char* MemoryTracker::CategoryName(MEMORY_CATEGORY category)
+{
+	if (category < 0 || category >= MEM_CATEGORY_COUNT)
+	{
+		return "unknown";
+	}
+
+	return categoryNames[category];
+}
+
+void MemoryTracker::SetBudget(MEMORY_CATEGORY category, size_t bytes)
+{
+	TrackerLock lock;
+
+	counters[category].budgetBytes = bytes;
+	counters[category].overBudget = bytes > 0 && counters[category].liveBytes > bytes;
+	counters[category].budgetReported = false;
+}
+
+void MemoryTracker::TakeSnapshot(MemorySnapshot& snapshot)
+{
+	TrackerLock lock;
+
+	for (int i = 0; i < MEM_CATEGORY_COUNT; i++)
+	{
+		snapshot.categories[i].liveBytes = counters[i].liveBytes;
+		snapshot.categories[i].peakBytes = counters[i].peakBytes;
+		snapshot.categories[i].budgetBytes = counters[i].budgetBytes;
+		snapshot.categories[i].liveCount = counters[i].liveCount;
+		snapshot.categories[i].totalCount = counters[i].totalCount;
+	}
+
+	snapshot.sequence = allocationSequence;
+}
+
+// budget flags are set inside new
+// the message is printed here as printing can allocate
+
+bool MemoryTracker::CheckBudgets()
+{
+	bool anyOverBudget = false;
+
+	for (int i = 0; i < MEM_CATEGORY_COUNT; i++)
+	{
+		size_t liveBytes = 0;
+		size_t budgetBytes = 0;
+		bool report = false;
+
+		{
+			TrackerLock lock;
+
+			if (counters[i].overBudget)
+			{
+				anyOverBudget = true;
+				report = !counters[i].budgetReported;
+				counters[i].budgetReported = true;
+				liveBytes = counters[i].liveBytes;
+				budgetBytes = counters[i].budgetBytes;
+			}
+		}
+
+		if (report)
+		{
+			gef::DebugOut("memory: %s over budget, %u / %u bytes\n", categoryNames[i], (unsigned int)liveBytes, (unsigned int)budgetBytes);
+		}
+	}
+
+	return anyOverBudget;
+}
+
+void MemoryTracker::PrintReport()
+{
+	MemorySnapshot snapshot;
+	TakeSnapshot(snapshot);
+
+	for (int i = 0; i < MEM_CATEGORY_COUNT; i++)
+	{
+		const MemoryCategoryStats& category = snapshot.categories[i];
+
+		gef::DebugOut("memory: %-8s %10u live bytes in %6i allocations, %10u peak, %10u budget, %8i total allocations\n",
+			categoryNames[i], (unsigned int)category.liveBytes, category.liveCount,
+			(unsigned int)category.peakBytes, (unsigned int)category.budgetBytes, category.totalCount);
+	}
+}
+
+// live allocations newer than the baseline are copied out under the lock
+// then printed once it is released
+
+int MemoryTracker::PrintLeaks(const MemorySnapshot& baseline)
+{
+	struct Leak
+	{
+		size_t size;
+		unsigned int sequence;
+		unsigned int category;
+	};
+
+	Leak leaks[MAX_LEAKS_PRINTED];
+	int leakCount = 0;
+	size_t leakBytes[MEM_CATEGORY_COUNT] = {};
+
+	{
+		TrackerLock lock;
+
+		for (AllocationHeader* header = liveList; header; header = header->next)
+		{
+			if (header->sequence <= baseline.sequence)
+			{
+				continue;
+			}
+
+			if (leakCount < MAX_LEAKS_PRINTED)
+			{
+				leaks[leakCount].size = header->size;
+				leaks[leakCount].sequence = header->sequence;
+				leaks[leakCount].category = header->category;
+			}
+
+			leakBytes[header->category] += header->size;
+			leakCount++;
+		}
+	}
+
+	if (leakCount == 0)
+	{
+		gef::DebugOut("memory: no leaks\n");
+		return 0;
+	}
+
+	for (int i = 0; i < leakCount && i < MAX_LEAKS_PRINTED; i++)
+	{
+		gef::DebugOut("memory: leaked %u bytes, %s, allocation #%u\n",
+			(unsigned int)leaks[i].size, categoryNames[leaks[i].category], leaks[i].sequence);
+	}
+
+	for (int i = 0; i < MEM_CATEGORY_COUNT; i++)
+	{
+		if (leakBytes[i] > 0)
+		{
+			gef::DebugOut("memory: %s leaked %u bytes\n", categoryNames[i], (unsigned int)leakBytes[i]);
+		}
+	}
+
+	gef::DebugOut("memory: %i leaked allocations\n", leakCount);
+
+	return leakCount;
+}
+
+bool MemoryTracker::WriteCSV(const char* filename)
+{
+	MemorySnapshot snapshot;
+	TakeSnapshot(snapshot);
+
+	FILE* file = fopen(filename, "w");
+
+	if (!file)
+	{
+		gef::DebugOut("memory: could not write %s\n", filename);
+		return false;
+	}
+
+	fprintf(file, "category,live_bytes,live_count,peak_bytes,budget_bytes,total_count\n");
+
+	for (int i = 0; i < MEM_CATEGORY_COUNT; i++)
+	{
+		const MemoryCategoryStats& category = snapshot.categories[i];
+
+		fprintf(file, "%s,%u,%i,%u,%u,%i\n", categoryNames[i],
+			(unsigned int)category.liveBytes, category.liveCount,
+			(unsigned int)category.peakBytes, (unsigned int)category.budgetBytes, category.totalCount);
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+#if MEMORY_TRACKING
+
+// global operator new / delete hooks
+// every allocation through new in the game and framework comes through here
+// Box2D allocates with malloc so it is not counted, see PhysicsMemory
+
+void* operator new(size_t size)
+{
+	return TrackedNew(size);
+}
+
+void* operator new[](size_t size)
+{
+	return TrackedNew(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedAlloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedAlloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	TrackedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	TrackedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	TrackedFree(ptr);
+}
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+
+// turns the global operator new / delete hooks on or off
+// on in debug builds only, as every allocation pays for the lock and header
+// when off every function here still works but reports nothing
+
+#ifndef MEMORY_TRACKING
+#ifdef _DEBUG
+#define MEMORY_TRACKING 1
+#else
+#define MEMORY_TRACKING 0
+#endif
+#endif
+
+// memory categories
+// every allocation made with new is counted against the
+// category at the top of the memory scope stack
+
+enum MEMORY_CATEGORY
+{
+	MEM_GENERAL,
+	MEM_PHYSICS,
+	MEM_RENDER,
+	MEM_AUDIO,
+	MEM_UI,
+	MEM_LEVEL,
+	MEM_CATEGORY_COUNT
+};
+
+// counters for one category
+
+struct MemoryCategoryStats
+{
+	size_t liveBytes;
+	size_t peakBytes;
+	size_t budgetBytes;
+	int liveCount;
+	int totalCount;
+};
+
+// copy of every category's counters at one point in time
+// the sequence number is the count of allocations made so far
+
+struct MemorySnapshot
+{
+	MemoryCategoryStats categories[MEM_CATEGORY_COUNT];
+	unsigned int sequence;
+};
+
+// memory scope
+// tags every allocation made while it is alive with a category
+// scopes nest, the previous category comes back when it ends
+
+class MemoryScope
+{
+public:
+
+	MemoryScope(MEMORY_CATEGORY category);
+	~MemoryScope();
+
+private:
+
+	MEMORY_CATEGORY previousCategory;
+};
+
+namespace MemoryTracker
+{
+	// returns the name shown in reports for a category
+
+	const char* CategoryName(MEMORY_CATEGORY category);
+
+	// sets how many bytes a category may have live at once
+	// zero means no budget
+
+	void SetBudget(MEMORY_CATEGORY category, size_t bytes);
+
+	// copies the current counters
+
+	void TakeSnapshot(MemorySnapshot& snapshot);
+
+	// prints any category that has gone over its budget
+	// each category is only reported the first time it goes over
+	// returns true if any category is over budget
+
+	bool CheckBudgets();
+
+	// prints every category's counters to the debug output
+
+	void PrintReport();
+
+	// prints every allocation made after the baseline that is still live
+	// returns the number of leaked allocations
+
+	int PrintLeaks(const MemorySnapshot& baseline);
+
+	// writes every category's counters to a csv file
+
+	bool WriteCSV(const char* filename);
+}
+
@@ -0,0 +1,494 @@
+#include "MeshLod.h"
+#include "SceneBlob.h"
+#include <graphics/scene.h>
+#include <graphics/mesh_data.h>
+#include <graphics/primitive.h>
+#include <system/platform.h>
+#include <system/debug_log.h>
+#include <unordered_map>
+#include <string.h>
+#include <string>
+#include <math.h>
+
+// cells along the longest side of the model
+// used to merge vertices for each lower level of detail
+
+static const int kLodGridResolution[MESH_LOD_NUM] = { 0, 24, 10 };
+
+// smallest radius on screen in pixels for each level of detail
+
+static const float kLodScreenRadius[MESH_LOD_NUM] = { 80.0f, 25.0f, 0.0f };
+
+namespace
+{
+	// simplified mesh
+	// vertices and one index list for each primitive
+
+	struct SimplifiedMesh
+	{
+		std::vector<gef::Mesh::Vertex> vertices;
+		std::vector<std::vector<UInt32> > primitives;
+		int triangleCount;
+	};
+
+	UInt32 ReadIndex(const void* indices, int indexByteSize, int i)
+	{
+		if (indexByteSize == 2)
+		{
+			return ((const UInt16*)indices)[i];
+		}
+
+		return ((const UInt32*)indices)[i];
+	}
+
+	// vertex clustering
+	// the model's bounds are split into a grid, every vertex in a cell
+	// is merged into one at their average position and normal
+	// triangles with two corners in the same cell are dropped
+
+	bool SimplifyMeshData(const gef::MeshData& source, int gridResolution, SimplifiedMesh& simplified)
+	{
+		// only plain position, normal and uv vertices can be merged
+
+		if (source.vertex_data.vertex_byte_size != sizeof(gef::Mesh::Vertex) || source.vertex_data.num_vertices <= 0)
+		{
+			return false;
+		}
+
+		const gef::Mesh::Vertex* vertices = (const gef::Mesh::Vertex*)source.vertex_data.vertices;
+		int vertexCount = source.vertex_data.num_vertices;
+
+		// bounds of the vertices
+
+		float minBounds[3] = { vertices[0].px, vertices[0].py, vertices[0].pz };
+		float maxBounds[3] = { vertices[0].px, vertices[0].py, vertices[0].pz };
+
+		for (int i = 1; i < vertexCount; i++)
+		{
+			const float position[3] = { vertices[i].px, vertices[i].py, vertices[i].pz };
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				minBounds[axis] = position[axis] < minBounds[axis] ? position[axis] : minBounds[axis];
+				maxBounds[axis] = position[axis] > maxBounds[axis] ? position[axis] : maxBounds[axis];
+			}
+		}
+
+		float longestSide = 0.0f;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (maxBounds[axis] - minBounds[axis] > longestSide)
+			{
+				longestSide = maxBounds[axis] - minBounds[axis];
+			}
+		}
+
+		if (longestSide <= 0.0f)
+		{
+			return false;
+		}
+
+		float cellSize = longestSide / gridResolution;
+
+		// assigns every vertex to a cluster
+
+		std::unordered_map<UInt64, UInt32> cellClusters;
+		std::vector<UInt32> vertexClusters(vertexCount);
+		std::vector<int> clusterCounts;
+
+		simplified.vertices.clear();
+
+		for (int i = 0; i < vertexCount; i++)
+		{
+			const gef::Mesh::Vertex& vertex = vertices[i];
+
+			UInt64 cellX = (UInt64)((vertex.px - minBounds[0]) / cellSize);
+			UInt64 cellY = (UInt64)((vertex.py - minBounds[1]) / cellSize);
+			UInt64 cellZ = (UInt64)((vertex.pz - minBounds[2]) / cellSize);
+			UInt64 cell = (cellX << 42) | (cellY << 21) | cellZ;
+
+			std::unordered_map<UInt64, UInt32>::iterator found = cellClusters.find(cell);
+
+			if (found == cellClusters.end())
+			{
+				// first vertex in the cell starts the cluster
+				// and gives it its uv
+
+				UInt32 cluster = (UInt32)simplified.vertices.size();
+				cellClusters[cell] = cluster;
+				vertexClusters[i] = cluster;
+
+				simplified.vertices.push_back(vertex);
+				clusterCounts.push_back(1);
+			}
+			else
+			{
+				UInt32 cluster = found->second;
+				vertexClusters[i] = cluster;
+
+				gef::Mesh::Vertex& merged = simplified.vertices[cluster];
+				merged.px += vertex.px;
+				merged.py += vertex.py;
+				merged.pz += vertex.pz;
+				merged.nx += vertex.nx;
+				merged.ny += vertex.ny;
+				merged.nz += vertex.nz;
+				clusterCounts[cluster]++;
+			}
+		}
+
+		// averages each cluster
+
+		for (size_t i = 0; i < simplified.vertices.size(); i++)
+		{
+			gef::Mesh::Vertex& merged = simplified.vertices[i];
+			float count = (float)clusterCounts[i];
+
+			merged.px /= count;
+			merged.py /= count;
+			merged.pz /= count;
+
+			float normalLength = sqrtf(merged.nx * merged.nx + merged.ny * merged.ny + merged.nz * merged.nz);
+
+			if (normalLength > 0.0f)
+			{
+				merged.nx /= normalLength;
+				merged.ny /= normalLength;
+				merged.nz /= normalLength;
+			}
+		}
+
+		// remaps the triangles onto the clusters
+
+		simplified.primitives.resize(source.primitives.size());
+		simplified.triangleCount = 0;
+
+		for (size_t p = 0; p < source.primitives.size(); p++)
+		{
+			const gef::PrimitiveData* primitive = source.primitives[p];
+			std::vector<UInt32>& indices = simplified.primitives[p];
+			indices.clear();
+
+			for (int i = 0; i + 2 < (int)primitive->num_indices; i += 3)
+			{
+				UInt32 a = vertexClusters[ReadIndex(primitive->indices, primitive->index_byte_size, i)];
+				UInt32 b = vertexClusters[ReadIndex(primitive->indices, primitive->index_byte_size, i + 1)];
+				UInt32 c = vertexClusters[ReadIndex(primitive->indices, primitive->index_byte_size, i + 2)];
+
+				if (a != b && b != c && a != c)
+				{
+					indices.push_back(a);
+					indices.push_back(b);
+					indices.push_back(c);
+				}
+			}
+
+			simplified.triangleCount += (int)indices.size() / 3;
+		}
+
+		return true;
+	}
+
+	// counts the triangles in mesh data
+
+	int CountTriangles(const gef::MeshData& source)
+	{
+		int triangleCount = 0;
+
+		for (size_t p = 0; p < source.primitives.size(); p++)
+		{
+			triangleCount += (int)source.primitives[p]->num_indices / 3;
+		}
+
+		return triangleCount;
+	}
+}
+
+// mesh lod constructor
+// initialising mesh lod values
+
+MeshLod::MeshLod()
+{
+	for (int i = 0; i < MESH_LOD_NUM; i++)
+	{
+		meshes[i] = NULL;
+		builtMeshes[i] = NULL;
+		lodScenes[i] = NULL;
+		triangleCounts[i] = 0;
+	}
+
+	boundingRadius = 0.0f;
+}
+
+MeshLod::~MeshLod()
+{
+	CleanUp();
+}
+
+void MeshLod::Init(gef::Platform& platform, gef::Scene* scene, const char* filename)
+{
+	CleanUp();
+
+	if (!scene || scene->meshes.empty() || scene->mesh_data.empty())
+	{
+		return;
+	}
+
+	const gef::Mesh* sourceMesh = scene->meshes.front();
+	const gef::MeshData& sourceData = scene->mesh_data.front();
+
+	meshes[0] = sourceMesh;
+	triangleCounts[0] = CountTriangles(sourceData);
+	boundingRadius = sourceMesh->bounding_sphere().radius();
+
+	for (int lod = 1; lod < MESH_LOD_NUM; lod++)
+	{
+		// uses the lod cooked offline if there is one
+
+		std::string lodFilename = LodFilename(filename, lod);
+		gef::Scene* lodScene = new gef::Scene();
+
+		if (lodScene->ReadSceneFromFile(platform, lodFilename.c_str()))
+		{
+			lodScene->CreateMaterials(platform);
+			lodScene->CreateMeshes(platform);
+		}
+
+		if (!lodScene->meshes.empty() && !lodScene->mesh_data.empty())
+		{
+			lodScenes[lod] = lodScene;
+			meshes[lod] = lodScene->meshes.front();
+			triangleCounts[lod] = CountTriangles(lodScene->mesh_data.front());
+			continue;
+		}
+
+		delete lodScene;
+
+		// otherwise simplifies the mesh now
+
+		builtMeshes[lod] = BuildLodMesh(platform, sourceData, sourceMesh, lod);
+
+		if (builtMeshes[lod])
+		{
+			meshes[lod] = builtMeshes[lod];
+		}
+		else
+		{
+			// the mesh can't be simplified so the level above is used
+
+			meshes[lod] = meshes[lod - 1];
+			triangleCounts[lod] = triangleCounts[lod - 1];
+		}
+	}
+
+	gef::DebugOut("mesh lod: %s %i / %i / %i triangles\n", filename, triangleCounts[0], triangleCounts[1], triangleCounts[2]);
+}
+
+void MeshLod::InitFromBlob(const SceneBlob& blob)
+{
+	CleanUp();
+
+	if (blob.getMeshCount() == 0)
+	{
+		return;
+	}
+
+	// blobs cooked without lod files repeat the last level they have
+
+	for (int lod = 0; lod < MESH_LOD_NUM; lod++)
+	{
+		int index = lod < blob.getMeshCount() ? lod : blob.getMeshCount() - 1;
+
+		meshes[lod] = blob.GetMesh(index);
+		triangleCounts[lod] = blob.getTriangleCount(index);
+	}
+
+	boundingRadius = meshes[0]->bounding_sphere().radius();
+}
+
+void MeshLod::CleanUp()
+{
+	for (int i = 0; i < MESH_LOD_NUM; i++)
+	{
+		delete builtMeshes[i];
+		builtMeshes[i] = NULL;
+
+		delete lodScenes[i];
+		lodScenes[i] = NULL;
+
+		meshes[i] = NULL;
+		triangleCounts[i] = 0;
+	}
+
+	boundingRadius = 0.0f;
+}
+
+const gef::Mesh* MeshLod::SelectMesh(float screenRadius) const
+{
+	for (int lod = 0; lod < MESH_LOD_NUM - 1; lod++)
+	{
+		if (screenRadius >= kLodScreenRadius[lod])
+		{
+			return meshes[lod];
+		}
+	}
+
+	return meshes[MESH_LOD_NUM - 1];
+}
+
+int MeshLod::getTriangleCount(int lod) const
+{
+	if (lod < 0 || lod >= MESH_LOD_NUM)
+	{
+		return 0;
+	}
+
+	return triangleCounts[lod];
+}
+
+std::string MeshLod::LodFilename(const char* filename, int lod)
+{
+	std::string name(filename);
+	std::string::size_type extension = name.rfind('.');
+
+	if (extension != std::string::npos)
+	{
+		name = name.substr(0, extension);
+	}
+
+	return name + "_lod" + std::to_string(lod) + ".scn";
+}
+
+// builds a gef mesh from simplified data
+// each primitive keeps the material of the primitive it came from
+
+gef::Mesh* MeshLod::BuildLodMesh(gef::Platform& platform, const gef::MeshData& source, const gef::Mesh* sourceMesh, int lod)
+{
+	SimplifiedMesh simplified;
+
+	if (!SimplifyMeshData(source, kLodGridResolution[lod], simplified) || simplified.triangleCount == 0)
+	{
+		return NULL;
+	}
+
+	gef::Mesh* mesh = gef::Mesh::Create(platform);
+	mesh->InitVertexBuffer(platform, &simplified.vertices[0], (UInt32)simplified.vertices.size(), sizeof(gef::Mesh::Vertex));
+	mesh->AllocatePrimitives((UInt32)simplified.primitives.size());
+
+	bool shortIndices = simplified.vertices.size() <= 0xffff;
+
+	for (size_t p = 0; p < simplified.primitives.size(); p++)
+	{
+		gef::Primitive* primitive = mesh->GetPrimitive((UInt32)p);
+		const std::vector<UInt32>& indices = simplified.primitives[p];
+
+		primitive->set_type(gef::TRIANGLE_LIST);
+		primitive->set_material(sourceMesh->GetPrimitive((UInt32)p)->material());
+
+		if (indices.empty())
+		{
+			continue;
+		}
+
+		if (shortIndices)
+		{
+			std::vector<UInt16> shortIndexBuffer(indices.begin(), indices.end());
+			primitive->InitIndexBuffer(platform, &shortIndexBuffer[0], (UInt32)shortIndexBuffer.size(), sizeof(UInt16));
+		}
+		else
+		{
+			primitive->InitIndexBuffer(platform, &indices[0], (UInt32)indices.size(), sizeof(UInt32));
+		}
+	}
+
+	// bounds stay the same as the source so culling is unchanged
+
+	mesh->set_aabb(sourceMesh->aabb());
+	mesh->set_bounding_sphere(sourceMesh->bounding_sphere());
+
+	triangleCounts[lod] = simplified.triangleCount;
+
+	return mesh;
+}
+
+// reads the scene once for each lower level of detail
+// swaps every mesh's vertices and indices for the simplified ones
+// and writes it back out with the same materials and textures
+
+bool MeshLod::CookLodScenes(gef::Platform& platform, const char* filename)
+{
+	for (int lod = 1; lod < MESH_LOD_NUM; lod++)
+	{
+		gef::Scene scene;
+
+		if (!scene.ReadSceneFromFile(platform, filename))
+		{
+			gef::DebugOut("mesh lod: could not read %s\n", filename);
+			return false;
+		}
+
+		for (std::list<gef::MeshData>::iterator meshData = scene.mesh_data.begin(); meshData != scene.mesh_data.end(); ++meshData)
+		{
+			SimplifiedMesh simplified;
+
+			if (!SimplifyMeshData(*meshData, kLodGridResolution[lod], simplified))
+			{
+				continue;
+			}
+
+			// replaces the vertices
+			// memory is allocated the same way the scene reader does so the scene frees it
+
+			delete[] (UInt8*)meshData->vertex_data.vertices;
+
+			UInt8* vertices = new UInt8[simplified.vertices.size() * sizeof(gef::Mesh::Vertex)];
+			memcpy(vertices, &simplified.vertices[0], simplified.vertices.size() * sizeof(gef::Mesh::Vertex));
+
+			meshData->vertex_data.vertices = vertices;
+			meshData->vertex_data.num_vertices = (Int32)simplified.vertices.size();
+
+			// replaces each primitive's indices with 16 bit indices where they fit
+
+			int indexByteSize = simplified.vertices.size() <= 0xffff ? sizeof(UInt16) : sizeof(UInt32);
+
+			for (size_t p = 0; p < meshData->primitives.size(); p++)
+			{
+				gef::PrimitiveData* primitive = meshData->primitives[p];
+				const std::vector<UInt32>& indices = simplified.primitives[p];
+
+				delete[] (UInt8*)primitive->indices;
+
+				UInt8* indexBuffer = new UInt8[indices.size() * indexByteSize + 1];
+
+				for (size_t i = 0; i < indices.size(); i++)
+				{
+					if (indexByteSize == sizeof(UInt16))
+					{
+						((UInt16*)indexBuffer)[i] = (UInt16)indices[i];
+					}
+					else
+					{
+						((UInt32*)indexBuffer)[i] = indices[i];
+					}
+				}
+
+				primitive->indices = indexBuffer;
+				primitive->num_indices = (Int32)indices.size();
+				primitive->index_byte_size = indexByteSize;
+			}
+		}
+
+		std::string lodFilename = LodFilename(filename, lod);
+
+		if (!scene.WriteSceneToFile(platform, lodFilename.c_str()))
+		{
+			gef::DebugOut("mesh lod: could not write %s\n", lodFilename.c_str());
+			return false;
+		}
+
+		gef::DebugOut("mesh lod: wrote %s\n", lodFilename.c_str());
+	}
+
+	return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <graphics/mesh.h>
+#include <vector>
+#include <string>
+
+namespace gef
+{
+	class Platform;
+	class Scene;
+	class MeshData;
+}
+
+// number of levels of detail kept for a model
+// level 0 is the mesh as it was exported
+
+#define MESH_LOD_NUM 3
+
+// mesh lod
+// holds a model's mesh at each level of detail
+// and picks one from how big the model is on screen
+//
+// lower levels are simplified offline into name_lod1.scn, name_lod2.scn
+// by CookLodScenes, if those files are missing they are simplified on load
+
+class SceneBlob;
+
+class MeshLod
+{
+public:
+
+	// mesh lod constructor
+
+	MeshLod();
+	~MeshLod();
+
+	// sets up every level of detail for the first mesh in a loaded scene
+	// filename is the scene's file, used to find its lod files
+
+	void Init(gef::Platform& platform, gef::Scene* scene, const char* filename);
+
+	// sets up every level of detail from a loaded scene blob
+	// mesh i of the blob is level of detail i
+
+	void InitFromBlob(const SceneBlob& blob);
+
+	// frees the lower levels of detail
+	// level 0 belongs to the scene passed to Init
+
+	void CleanUp();
+
+	// returns the mesh for a model with the given radius on screen in pixels
+
+	const gef::Mesh* SelectMesh(float screenRadius) const;
+
+	// returns true once Init has found a mesh
+
+	bool isLoaded() const { return meshes[0] != NULL; }
+
+	// returns the radius of the model's bounding sphere before it is transformed
+
+	float getBoundingRadius() const { return boundingRadius; }
+
+	// returns the triangle count at a level of detail
+
+	int getTriangleCount(int lod) const;
+
+	// offline step
+	// simplifies every mesh in a scene file and writes a scene file for each lower level of detail
+	// returns false if the scene could not be read or written
+
+	static bool CookLodScenes(gef::Platform& platform, const char* filename);
+
+	// returns the lod scene filename for a scene file
+	// spike.scn becomes spike_lod1.scn
+
+	static std::string LodFilename(const char* filename, int lod);
+
+private:
+
+	// mesh lod is not copyable as it owns its meshes
+	MeshLod(const MeshLod&);
+	MeshLod& operator=(const MeshLod&);
+
+	// builds a level of detail mesh from the scene's mesh data
+	gef::Mesh* BuildLodMesh(gef::Platform& platform, const gef::MeshData& source, const gef::Mesh* sourceMesh, int lod);
+
+	// mesh lod variables
+
+	const gef::Mesh* meshes[MESH_LOD_NUM];
+	gef::Mesh* builtMeshes[MESH_LOD_NUM];
+	gef::Scene* lodScenes[MESH_LOD_NUM];
+	int triangleCounts[MESH_LOD_NUM];
+	float boundingRadius;
+};
+
@@ -0,0 +1,451 @@
+#include "NavGraph.h"
+#include <math.h>
+#include <float.h>
+
+// furthest apart nodes along a surface are
+
+#define NAV_NODE_SPACING 4.0f
+
+// gap left between boxes so touching bodies don't block each other
+
+#define NAV_SKIN 0.05f
+
+// extra seconds added to a jump so walking is picked when it's as quick
+
+#define NAV_JUMP_COST 0.25f
+
+// navigation graph constructor
+// initialising navigation graph values
+
+NavGraph::NavGraph()
+{
+	physics.halfWidth = 1.0f;
+	physics.halfHeight = 1.0f;
+	physics.walkSpeed = 1.0f;
+	physics.jumpSpeed = 0.0f;
+	physics.gravity = 9.81f;
+}
+
+void NavGraph::Build(const LevelDescription& level, const NavAgentPhysics& physics)
+{
+	Clear();
+
+	this->physics = physics;
+
+	// solid static bodies block the enemies
+	// spikes block but aren't walked on, sensors are ignored
+
+	std::vector<bool> walkable;
+
+	for (size_t i = 0; i < level.staticBodies.size(); i++)
+	{
+		const LevelBodyDesc& desc = level.staticBodies[i];
+
+		if (desc.isSensor || desc.angle != 0.0f)
+		{
+			continue;
+		}
+
+		b2AABB box;
+		box.lowerBound = desc.position - desc.halfSize;
+		box.upperBound = desc.position + desc.halfSize;
+
+		solids.push_back(box);
+		walkable.push_back(desc.objectType != SPIKE);
+	}
+
+	// surfaces and their nodes
+	// nodes the enemy wouldn't fit at are kept out
+
+	for (size_t s = 0; s < solids.size(); s++)
+	{
+		if (!walkable[s])
+		{
+			continue;
+		}
+
+		NavSurface surface;
+		surface.left = solids[s].lowerBound.x;
+		surface.right = solids[s].upperBound.x;
+		surface.top = solids[s].upperBound.y;
+		surface.firstNode = (int)nodes.size();
+		surface.nodeCount = 0;
+
+		int surfaceIndex = (int)surfaces.size();
+		surfaces.push_back(surface);
+		surfaceSolids.push_back((int)s);
+
+		float start = surface.left + physics.halfWidth;
+		float end = surface.right - physics.halfWidth;
+
+		if (end < start)
+		{
+			start = end = 0.5f * (surface.left + surface.right);
+		}
+
+		int count = 1 + (int)ceilf((end - start) / NAV_NODE_SPACING);
+		float spacing = count > 1 ? (end - start) / (count - 1) : 0.0f;
+
+		for (int n = 0; n < count; n++)
+		{
+			NavNode node;
+			node.position = b2Vec2(start + n * spacing, surface.top + physics.halfHeight + NAV_SKIN);
+			node.surface = surfaceIndex;
+			node.firstEdge = 0;
+			node.edgeCount = 0;
+
+			if (IsBlocked(AgentBox(node.position), surfaceIndex))
+			{
+				continue;
+			}
+
+			nodes.push_back(node);
+			surfaces[surfaceIndex].nodeCount++;
+		}
+	}
+
+	// edges are gathered for each node then packed together
+
+	std::vector<std::vector<NavEdge> > adjacency(nodes.size());
+
+	for (size_t s = 0; s < surfaces.size(); s++)
+	{
+		const NavSurface& surface = surfaces[s];
+
+		if (surface.nodeCount == 0)
+		{
+			continue;
+		}
+
+		// walks between neighbouring nodes unless something is in the way
+
+		for (int n = surface.firstNode; n < surface.firstNode + surface.nodeCount - 1; n++)
+		{
+			b2AABB between = AgentBox(nodes[n].position);
+			between.Combine(AgentBox(nodes[n + 1].position));
+
+			if (IsBlocked(between, (int)s))
+			{
+				continue;
+			}
+
+			NavEdge edge;
+			edge.type = NAV_EDGE_WALK;
+			edge.cost = (nodes[n + 1].position.x - nodes[n].position.x) / physics.walkSpeed;
+
+			edge.to = n + 1;
+			adjacency[n].push_back(edge);
+
+			edge.to = n;
+			adjacency[n + 1].push_back(edge);
+		}
+
+		// falls off both ends
+
+		AddFallEdge(adjacency, (int)s, surface.firstNode, -1.0f);
+		AddFallEdge(adjacency, (int)s, surface.firstNode + surface.nodeCount - 1, 1.0f);
+
+		// jumps to any other surface in reach
+
+		if (physics.jumpSpeed > 0.0f)
+		{
+			for (size_t t = 0; t < surfaces.size(); t++)
+			{
+				if (t != s && surfaces[t].nodeCount > 0)
+				{
+					AddJumpEdge(adjacency, (int)s, (int)t);
+				}
+			}
+		}
+	}
+
+	for (size_t n = 0; n < nodes.size(); n++)
+	{
+		nodes[n].firstEdge = (int)edges.size();
+		nodes[n].edgeCount = (int)adjacency[n].size();
+		edges.insert(edges.end(), adjacency[n].begin(), adjacency[n].end());
+	}
+}
+
+void NavGraph::Clear()
+{
+	surfaces.clear();
+	nodes.clear();
+	edges.clear();
+	solids.clear();
+	surfaceSolids.clear();
+}
+
+int NavGraph::FindNode(b2Vec2 position) const
+{
+	// the highest surface under the position
+
+	int best = -1;
+	float bestTop = -FLT_MAX;
+
+	for (size_t s = 0; s < surfaces.size(); s++)
+	{
+		const NavSurface& surface = surfaces[s];
+
+		if (surface.nodeCount == 0 || position.x < surface.left || position.x > surface.right)
+		{
+			continue;
+		}
+
+		if (surface.top <= position.y + NAV_SKIN && surface.top > bestTop)
+		{
+			best = (int)s;
+			bestTop = surface.top;
+		}
+	}
+
+	if (best >= 0)
+	{
+		return ClosestNodeOnSurface(best, position.x);
+	}
+
+	// nothing underneath, so any node will do
+
+	int closest = -1;
+	float closestDistance = FLT_MAX;
+
+	for (size_t n = 0; n < nodes.size(); n++)
+	{
+		float distance = b2DistanceSquared(nodes[n].position, position);
+
+		if (distance < closestDistance)
+		{
+			closest = (int)n;
+			closestDistance = distance;
+		}
+	}
+
+	return closest;
+}
+
+const NavEdge* NavGraph::FindEdge(int from, int to) const
+{
+	const NavNode& node = nodes[from];
+
+	for (int e = node.firstEdge; e < node.firstEdge + node.edgeCount; e++)
+	{
+		if (edges[e].to == to)
+		{
+			return &edges[e];
+		}
+	}
+
+	return NULL;
+}
+
+float NavGraph::Heuristic(int from, int to) const
+{
+	// time to walk the distance across, which no edge beats
+	// walks cost exactly that, falls add the drop and jumps add at least the take off
+	// height is left out as a long drop can cost less than its length at any speed
+
+	return fabsf(nodes[to].position.x - nodes[from].position.x) / physics.walkSpeed;
+}
+
+int NavGraph::getEdgeTypeCount(NAV_EDGE_TYPE type) const
+{
+	int count = 0;
+
+	for (size_t e = 0; e < edges.size(); e++)
+	{
+		if (edges[e].type == type)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+bool NavGraph::IsBlocked(const b2AABB& box, int ignoreSurface) const
+{
+	int ignoreSolid = ignoreSurface >= 0 ? surfaceSolids[ignoreSurface] : -1;
+
+	for (size_t i = 0; i < solids.size(); i++)
+	{
+		if ((int)i != ignoreSolid && b2TestOverlap(box, solids[i]))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+b2AABB NavGraph::AgentBox(b2Vec2 position) const
+{
+	b2Vec2 halfSize(physics.halfWidth - NAV_SKIN, physics.halfHeight - NAV_SKIN);
+
+	b2AABB box;
+	box.lowerBound = position - halfSize;
+	box.upperBound = position + halfSize;
+
+	return box;
+}
+
+int NavGraph::ClosestNodeOnSurface(int surface, float x) const
+{
+	const NavSurface& s = surfaces[surface];
+	int closest = -1;
+	float closestDistance = FLT_MAX;
+
+	for (int n = s.firstNode; n < s.firstNode + s.nodeCount; n++)
+	{
+		float distance = fabsf(nodes[n].position.x - x);
+
+		if (distance < closestDistance)
+		{
+			closest = n;
+			closestDistance = distance;
+		}
+	}
+
+	return closest;
+}
+
+float NavGraph::JumpAirTime(float height) const
+{
+	// time to rise and come back down onto a surface the height given above
+	// the later of the two times the jump passes that height
+
+	float v = physics.jumpSpeed;
+	float root = v * v - 2.0f * physics.gravity * height;
+
+	if (root < 0.0f)
+	{
+		return -1.0f;
+	}
+
+	return (v + sqrtf(root)) / physics.gravity;
+}
+
+void NavGraph::AddFallEdge(std::vector<std::vector<NavEdge> >& adjacency, int surface, int fromNode, float direction)
+{
+	const NavSurface& from = surfaces[surface];
+	const NavNode& node = nodes[fromNode];
+
+	// the point just past the end of the surface
+
+	float x = direction < 0.0f ? from.left - physics.halfWidth - NAV_SKIN : from.right + physics.halfWidth + NAV_SKIN;
+	b2Vec2 stepOff(x, node.position.y);
+
+	if (IsBlocked(AgentBox(stepOff), surface))
+	{
+		return;
+	}
+
+	// lands on the highest surface below
+
+	int landing = -1;
+	float landingTop = -FLT_MAX;
+
+	for (size_t s = 0; s < surfaces.size(); s++)
+	{
+		const NavSurface& to = surfaces[s];
+
+		if ((int)s == surface || to.nodeCount == 0 || x < to.left || x > to.right)
+		{
+			continue;
+		}
+
+		if (to.top < from.top && to.top > landingTop)
+		{
+			landing = (int)s;
+			landingTop = to.top;
+		}
+	}
+
+	if (landing < 0)
+	{
+		return;
+	}
+
+	int toNode = ClosestNodeOnSurface(landing, x);
+	const NavNode& target = nodes[toNode];
+
+	// nothing can be in the way of the drop
+
+	b2AABB drop = AgentBox(stepOff);
+	drop.Combine(AgentBox(b2Vec2(x, target.position.y)));
+
+	if (IsBlocked(drop, landing))
+	{
+		return;
+	}
+
+	float height = node.position.y - target.position.y;
+
+	NavEdge edge;
+	edge.to = toNode;
+	edge.type = NAV_EDGE_FALL;
+	edge.cost = fabsf(target.position.x - node.position.x) / physics.walkSpeed + sqrtf(2.0f * height / physics.gravity);
+
+	adjacency[fromNode].push_back(edge);
+}
+
+void NavGraph::AddJumpEdge(std::vector<std::vector<NavEdge> >& adjacency, int fromSurface, int toSurface)
+{
+	const NavSurface& from = surfaces[fromSurface];
+	const NavSurface& to = surfaces[toSurface];
+
+	float height = to.top - from.top;
+
+	// drops are left to the fall edges
+
+	if (height <= 0.0f)
+	{
+		return;
+	}
+
+	float airTime = JumpAirTime(height);
+
+	if (airTime < 0.0f)
+	{
+		return;
+	}
+
+	// takes off from the node nearest the other surface
+	// and lands on the node nearest that
+
+	float towards = b2Clamp(0.5f * (to.left + to.right), from.left, from.right);
+	int fromNode = ClosestNodeOnSurface(fromSurface, towards);
+	int toNode = ClosestNodeOnSurface(toSurface, nodes[fromNode].position.x);
+
+	const NavNode& start = nodes[fromNode];
+	const NavNode& end = nodes[toNode];
+
+	float distance = fabsf(end.position.x - start.position.x);
+
+	if (distance > physics.walkSpeed * airTime)
+	{
+		return;
+	}
+
+	// rises straight up, then moves across at the landing height
+	// either part being blocked, such as by the surface itself from below, stops the jump
+
+	b2Vec2 apex(start.position.x, end.position.y);
+
+	b2AABB rise = AgentBox(start.position);
+	rise.Combine(AgentBox(apex));
+
+	b2AABB across = AgentBox(apex);
+	across.Combine(AgentBox(end.position));
+
+	if (IsBlocked(rise, fromSurface) || IsBlocked(across, toSurface))
+	{
+		return;
+	}
+
+	NavEdge edge;
+	edge.to = toNode;
+	edge.type = NAV_EDGE_JUMP;
+	edge.cost = b2Max(distance / physics.walkSpeed, airTime) + NAV_JUMP_COST;
+
+	adjacency[fromNode].push_back(edge);
+}
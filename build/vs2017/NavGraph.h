@@ -0,0 +1,142 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+#include "LevelSimulation.h"
+
+// ways of getting from one navigation node to another
+
+enum NAV_EDGE_TYPE
+{
+	NAV_EDGE_WALK,
+	NAV_EDGE_FALL,
+	NAV_EDGE_JUMP
+};
+
+struct NavEdge
+{
+	int to;
+	NAV_EDGE_TYPE type;
+
+	// seconds the move takes
+	float cost;
+};
+
+// a point an enemy can stand at
+// the position is the centre of the enemy's body
+
+struct NavNode
+{
+	b2Vec2 position;
+	int surface;
+
+	// this node's edges in the edge array
+	int firstEdge;
+	int edgeCount;
+};
+
+// the top of one static body
+
+struct NavSurface
+{
+	float left;
+	float right;
+	float top;
+
+	int firstNode;
+	int nodeCount;
+};
+
+// size and movement of the enemies using the graph
+// jump and fall edges are only added where these can make them
+
+struct NavAgentPhysics
+{
+	float halfWidth;
+	float halfHeight;
+	float walkSpeed;
+	float jumpSpeed;
+	float gravity;
+};
+
+// navigation graph
+// nodes along the top of every static body, joined by walk edges along the surface
+// and fall and jump edges to other surfaces within reach of the enemy physics
+// built once when the level loads, edges are stored together for each node
+// moving platforms aren't included as they don't stay put
+
+class NavGraph
+{
+public:
+
+	// navigation graph constructor
+
+	NavGraph();
+
+	// builds the graph from the static bodies of the level
+
+	void Build(const LevelDescription& level, const NavAgentPhysics& physics);
+
+	// forgets every node and edge
+
+	void Clear();
+
+	// returns the node on the surface under the position closest to it
+	// or the closest node if there is no surface under it, -1 if the graph is empty
+
+	int FindNode(b2Vec2 position) const;
+
+	// returns the edge between two nodes, NULL if they aren't joined
+
+	const NavEdge* FindEdge(int from, int to) const;
+
+	// estimated seconds between two nodes, used to guide the search
+
+	float Heuristic(int from, int to) const;
+
+	// getters
+
+	int getNodeCount() const { return (int)nodes.size(); }
+	int getEdgeCount() const { return (int)edges.size(); }
+	int getSurfaceCount() const { return (int)surfaces.size(); }
+	const NavSurface& getSurface(int index) const { return surfaces[index]; }
+	const NavNode& getNode(int index) const { return nodes[index]; }
+	const NavEdge* getEdges(int node) const { return nodes[node].edgeCount == 0 ? NULL : &edges[nodes[node].firstEdge]; }
+
+	// number of edges of each type
+
+	int getEdgeTypeCount(NAV_EDGE_TYPE type) const;
+
+private:
+
+	// checks if a box overlaps any solid body other than the surface given
+	bool IsBlocked(const b2AABB& box, int ignoreSurface) const;
+
+	// returns the enemy's box standing at a point
+	b2AABB AgentBox(b2Vec2 position) const;
+
+	// returns the valid node on a surface closest to the x position, -1 if it has none
+	int ClosestNodeOnSurface(int surface, float x) const;
+
+	// seconds in the air jumping up by the height given, negative if it's too high
+	float JumpAirTime(float height) const;
+
+	// adds the fall edges off one end of a surface
+	void AddFallEdge(std::vector<std::vector<NavEdge> >& adjacency, int surface, int fromNode, float direction);
+
+	// adds a jump edge between two surfaces if one can be made
+	void AddJumpEdge(std::vector<std::vector<NavEdge> >& adjacency, int fromSurface, int toSurface);
+
+	// navigation graph variables
+
+	NavAgentPhysics physics;
+
+	std::vector<NavSurface> surfaces;
+	std::vector<NavNode> nodes;
+	std::vector<NavEdge> edges;
+
+	// every solid static body, surfaces or not
+	std::vector<b2AABB> solids;
+
+	// which solid each surface is the top of
+	std::vector<int> surfaceSolids;
+};
@@ -0,0 +1,401 @@
+#include "NavPlanner.h"
+#include <algorithm>
+#include <math.h>
+
+// distance from a node an agent counts as having reached it
+
+#define NAV_ARRIVE_DISTANCE 0.75f
+#define NAV_ARRIVE_HEIGHT 1.5f
+
+// navigation planner constructor
+// initialising navigation planner values
+
+NavPlanner::NavPlanner()
+{
+	graph = NULL;
+	cacheSize = 0;
+	cacheClock = 0;
+	searching = false;
+	searchAgent = -1;
+	searchStart = -1;
+	searchGoal = -1;
+	searchStamp = 0;
+	cacheHits = 0;
+	cacheMisses = 0;
+	searchCount = 0;
+}
+
+void NavPlanner::Init(const NavGraph* graph, int agentCount, int cacheSize)
+{
+	this->graph = graph;
+	this->cacheSize = cacheSize;
+
+	Clear();
+
+	agents.resize(agentCount);
+
+	for (int i = 0; i < agentCount; i++)
+	{
+		ClearAgent(i);
+	}
+}
+
+void NavPlanner::SetGoal(int agent, int startNode, int goalNode)
+{
+	NavAgent& a = agents[agent];
+
+	if (startNode < 0 || goalNode < 0)
+	{
+		ClearAgent(agent);
+		return;
+	}
+
+	// keeps the path it has, or the one being waited for
+
+	if (a.goalNode == goalNode && (a.waiting || IsOnPath(a, startNode)))
+	{
+		return;
+	}
+
+	a.startNode = startNode;
+	a.goalNode = goalNode;
+	a.path.clear();
+	a.pathIndex = 0;
+
+	const NavCacheEntry* cached = FindCached(startNode, goalNode);
+
+	if (cached)
+	{
+		cacheHits++;
+		a.path = cached->path;
+		a.waiting = false;
+		return;
+	}
+
+	// a search that found nothing isn't run again until the graph changes
+
+	if (unreachable.count(MakeKey(startNode, goalNode)))
+	{
+		cacheHits++;
+		a.waiting = false;
+		return;
+	}
+
+	cacheMisses++;
+
+	if (!a.waiting)
+	{
+		a.waiting = true;
+		waitingAgents.push_back(agent);
+	}
+}
+
+void NavPlanner::ClearAgent(int agent)
+{
+	NavAgent& a = agents[agent];
+	a.startNode = -1;
+	a.goalNode = -1;
+	a.path.clear();
+	a.pathIndex = 0;
+
+	// left in the waiting list, skipped when it comes up
+	a.waiting = false;
+}
+
+void NavPlanner::Update(int expansionBudget)
+{
+	if (!graph)
+	{
+		return;
+	}
+
+	while (expansionBudget > 0)
+	{
+		if (!searching && !BeginSearch())
+		{
+			return;
+		}
+
+		if (open.empty())
+		{
+			EndSearch(false);
+			continue;
+		}
+
+		std::pop_heap(open.begin(), open.end());
+		NavOpen top = open.back();
+		open.pop_back();
+
+		if (closed[top.node])
+		{
+			continue;
+		}
+
+		if (top.node == searchGoal)
+		{
+			EndSearch(true);
+			continue;
+		}
+
+		closed[top.node] = true;
+		expansionBudget--;
+
+		const NavNode& node = graph->getNode(top.node);
+		const NavEdge* edges = graph->getEdges(top.node);
+
+		for (int e = 0; e < node.edgeCount; e++)
+		{
+			int next = edges[e].to;
+			float cost = costs[top.node] + edges[e].cost;
+
+			if (stamps[next] != searchStamp)
+			{
+				stamps[next] = searchStamp;
+				closed[next] = false;
+			}
+			else if (closed[next] || cost >= costs[next])
+			{
+				continue;
+			}
+
+			costs[next] = cost;
+			parents[next] = top.node;
+
+			NavOpen entry;
+			entry.priority = cost + graph->Heuristic(next, searchGoal);
+			entry.node = next;
+			open.push_back(entry);
+			std::push_heap(open.begin(), open.end());
+		}
+	}
+}
+
+bool NavPlanner::GetWaypoint(int agent, b2Vec2 position, b2Vec2& waypoint, bool& jump)
+{
+	NavAgent& a = agents[agent];
+
+	if (a.waiting || a.path.empty())
+	{
+		return false;
+	}
+
+	// moves on past the nodes already reached
+
+	while (a.pathIndex < (int)a.path.size())
+	{
+		b2Vec2 node = graph->getNode(a.path[a.pathIndex]).position;
+
+		if (fabsf(node.x - position.x) > NAV_ARRIVE_DISTANCE || fabsf(node.y - position.y) > NAV_ARRIVE_HEIGHT)
+		{
+			break;
+		}
+
+		a.pathIndex++;
+	}
+
+	if (a.pathIndex >= (int)a.path.size())
+	{
+		return false;
+	}
+
+	waypoint = graph->getNode(a.path[a.pathIndex]).position;
+	jump = false;
+
+	if (a.pathIndex > 0)
+	{
+		const NavEdge* edge = graph->FindEdge(a.path[a.pathIndex - 1], a.path[a.pathIndex]);
+		jump = edge && edge->type == NAV_EDGE_JUMP;
+	}
+
+	return true;
+}
+
+void NavPlanner::Clear()
+{
+	for (size_t i = 0; i < agents.size(); i++)
+	{
+		ClearAgent((int)i);
+	}
+
+	waitingAgents.clear();
+	cache.clear();
+	cacheIndex.clear();
+	cacheClock = 0;
+	unreachable.clear();
+
+	searching = false;
+	open.clear();
+
+	int nodeCount = graph ? graph->getNodeCount() : 0;
+	costs.assign(nodeCount, 0.0f);
+	parents.assign(nodeCount, -1);
+	stamps.assign(nodeCount, 0);
+	closed.assign(nodeCount, false);
+	searchStamp = 0;
+}
+
+bool NavPlanner::BeginSearch()
+{
+	while (!waitingAgents.empty())
+	{
+		int agent = waitingAgents.front();
+		waitingAgents.pop_front();
+
+		NavAgent& a = agents[agent];
+
+		if (!a.waiting)
+		{
+			continue;
+		}
+
+		// an earlier search may have found this path already
+
+		const NavCacheEntry* cached = FindCached(a.startNode, a.goalNode);
+
+		if (cached)
+		{
+			a.path = cached->path;
+			a.pathIndex = 0;
+			a.waiting = false;
+			continue;
+		}
+
+		if (unreachable.count(MakeKey(a.startNode, a.goalNode)))
+		{
+			a.waiting = false;
+			continue;
+		}
+
+		searching = true;
+		searchAgent = agent;
+		searchStart = a.startNode;
+		searchGoal = a.goalNode;
+		searchCount++;
+
+		// a new stamp forgets every node value from the last search
+
+		searchStamp++;
+		open.clear();
+
+		stamps[searchStart] = searchStamp;
+		closed[searchStart] = false;
+		costs[searchStart] = 0.0f;
+		parents[searchStart] = -1;
+
+		NavOpen entry;
+		entry.priority = graph->Heuristic(searchStart, searchGoal);
+		entry.node = searchStart;
+		open.push_back(entry);
+
+		return true;
+	}
+
+	return false;
+}
+
+void NavPlanner::EndSearch(bool found)
+{
+	searching = false;
+
+	std::vector<int> path;
+
+	if (found)
+	{
+		for (int n = searchGoal; n >= 0; n = parents[n])
+		{
+			path.push_back(n);
+		}
+
+		std::reverse(path.begin(), path.end());
+		AddCached(searchStart, searchGoal, path);
+	}
+	else
+	{
+		unreachable.insert(MakeKey(searchStart, searchGoal));
+	}
+
+	// the agent may have asked for somewhere else while it waited
+
+	NavAgent& a = agents[searchAgent];
+
+	if (a.waiting && a.startNode == searchStart && a.goalNode == searchGoal)
+	{
+		a.path = path;
+		a.pathIndex = 0;
+		a.waiting = false;
+	}
+}
+
+bool NavPlanner::IsOnPath(const NavAgent& agent, int node) const
+{
+	for (int i = b2Max(agent.pathIndex - 1, 0); i < (int)agent.path.size(); i++)
+	{
+		if (agent.path[i] == node)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const NavPlanner::NavCacheEntry* NavPlanner::FindCached(int startNode, int goalNode)
+{
+	std::unordered_map<uint64_t, int>::iterator found = cacheIndex.find(MakeKey(startNode, goalNode));
+
+	if (found == cacheIndex.end())
+	{
+		return NULL;
+	}
+
+	NavCacheEntry& entry = cache[found->second];
+	entry.lastUsed = ++cacheClock;
+
+	return &entry;
+}
+
+void NavPlanner::AddCached(int startNode, int goalNode, const std::vector<int>& path)
+{
+	if (cacheSize <= 0)
+	{
+		return;
+	}
+
+	uint64_t key = MakeKey(startNode, goalNode);
+
+	if (cacheIndex.find(key) != cacheIndex.end())
+	{
+		return;
+	}
+
+	int slot;
+
+	if ((int)cache.size() < cacheSize)
+	{
+		slot = (int)cache.size();
+		cache.push_back(NavCacheEntry());
+	}
+	else
+	{
+		// replaces the least recently used path
+
+		slot = 0;
+
+		for (int i = 1; i < (int)cache.size(); i++)
+		{
+			if (cache[i].lastUsed < cache[slot].lastUsed)
+			{
+				slot = i;
+			}
+		}
+
+		cacheIndex.erase(cache[slot].key);
+	}
+
+	NavCacheEntry& entry = cache[slot];
+	entry.key = key;
+	entry.path = path;
+	entry.lastUsed = ++cacheClock;
+
+	cacheIndex[key] = slot;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include "NavGraph.h"
+
+// navigation planner
+// finds paths over the navigation graph for any number of agents, such as enemies
+// paths found are cached by start and goal so agents heading the same way share them
+// as are the starts and goals with no path, so an unreachable goal is only searched once
+// only one search runs at a time and it carries on across frames,
+// so the work done each frame is capped however many agents are waiting
+// an agent keeps its path while it stays on it and its goal doesn't change
+
+class NavPlanner
+{
+public:
+
+	// navigation planner constructor
+
+	NavPlanner();
+
+	// sets the graph and number of agents
+	// cacheSize is the number of paths kept
+
+	void Init(const NavGraph* graph, int agentCount, int cacheSize);
+
+	// asks for a path between two nodes for an agent
+	// a cached path is used straight away, otherwise the agent waits for a search
+	// does nothing if the agent already has a path to the goal it is still on
+
+	void SetGoal(int agent, int startNode, int goalNode);
+
+	// forgets an agent's path and goal
+
+	void ClearAgent(int agent);
+
+	// runs waiting searches until the number of nodes given have been expanded
+
+	void Update(int expansionBudget);
+
+	// returns the next node on the agent's path to move to
+	// skipping any the position has already reached
+	// jump is set if the move to it is a jump
+	// returns false if the agent has no path yet or has reached its goal
+
+	bool GetWaypoint(int agent, b2Vec2 position, b2Vec2& waypoint, bool& jump);
+
+	// forgets every path and the cache, including the goals found unreachable
+	// used when the graph is rebuilt
+
+	void Clear();
+
+	// getters
+
+	int getCacheHits() const { return cacheHits; }
+	int getCacheMisses() const { return cacheMisses; }
+	int getSearchCount() const { return searchCount; }
+
+private:
+
+	// an agent's goal and path
+	struct NavAgent
+	{
+		int startNode;
+		int goalNode;
+		std::vector<int> path;
+		int pathIndex;
+		bool waiting;
+	};
+
+	// a path kept in the cache
+	struct NavCacheEntry
+	{
+		uint64_t key;
+		std::vector<int> path;
+		unsigned int lastUsed;
+	};
+
+	// a node waiting to be expanded
+	struct NavOpen
+	{
+		float priority;
+		int node;
+
+		bool operator<(const NavOpen& other) const { return priority > other.priority; }
+	};
+
+	// starts the search for the next waiting agent
+	// returns false if no agent is waiting
+	bool BeginSearch();
+
+	// finishes the running search, giving the path to the agent if it still wants it
+	void EndSearch(bool found);
+
+	// checks if the node is on the rest of the agent's path
+	bool IsOnPath(const NavAgent& agent, int node) const;
+
+	// looks up and adds cached paths
+	const NavCacheEntry* FindCached(int startNode, int goalNode);
+	void AddCached(int startNode, int goalNode, const std::vector<int>& path);
+
+	static uint64_t MakeKey(int startNode, int goalNode) { return ((uint64_t)(unsigned int)startNode << 32) | (unsigned int)goalNode; }
+
+	// navigation planner variables
+
+	const NavGraph* graph;
+
+	std::vector<NavAgent> agents;
+	std::deque<int> waitingAgents;
+
+	// path cache, least recently used is replaced first
+	std::vector<NavCacheEntry> cache;
+	std::unordered_map<uint64_t, int> cacheIndex;
+	int cacheSize;
+	unsigned int cacheClock;
+
+	// starts and goals searched without finding a path
+	std::unordered_set<uint64_t> unreachable;
+
+	// running search
+	// node values are only valid if their stamp matches the search
+	bool searching;
+	int searchAgent;
+	int searchStart;
+	int searchGoal;
+	std::vector<NavOpen> open;
+	std::vector<float> costs;
+	std::vector<int> parents;
+	std::vector<unsigned int> stamps;
+	std::vector<bool> closed;
+	unsigned int searchStamp;
+
+	int cacheHits;
+	int cacheMisses;
+	int searchCount;
+};
@@ -0,0 +1,600 @@
+#include "PatrolEnemyManager.h"
+#include "Timer.h"
+#include "Logger.h"
+#include <graphics/renderer_3d.h>
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+// number of grid buckets cells are hashed into
+
+#define PATROL_GRID_BUCKETS 4096
+
+// large primes used to hash cell coordinates into buckets
+
+#define PATROL_HASH_X 73856093
+#define PATROL_HASH_Y 19349663
+
+// segments shorter than this are too small to patrol
+
+#define PATROL_MIN_SEGMENT_LENGTH 1.0f
+
+// a promoted enemy this slow after the settle time
+// and this close to a segment's height goes back to patrolling
+
+#define PATROL_SETTLE_SECONDS 0.5f
+#define PATROL_SETTLE_SPEED 0.5f
+#define PATROL_LAND_HEIGHT 0.25f
+
+// a promoted enemy that hasn't landed on a segment by now,
+// such as one knocked off the level, is put back on its own
+
+#define PATROL_RETURN_SECONDS 5.0f
+
+// half the size of the view box the benchmark checks each frame
+
+#define PATROL_BENCHMARK_VIEW_X 30.0f
+#define PATROL_BENCHMARK_VIEW_Y 20.0f
+
+// patrol enemy manager constructor
+// initialising patrol enemy manager values
+
+PatrolEnemyManager::PatrolEnemyManager()
+{
+	world = NULL;
+	halfSize = b2Vec2(1.0f, 1.0f);
+	cellSize = 8.0f;
+	inverseCellSize = 1.0f / cellSize;
+	time = 0.0;
+	promotedCount = 0;
+	visualScale = gef::Vector4(1.0f, 1.0f, 1.0f);
+	visual.set_type(PATROL_ENEMY);
+	gridStarts.assign(PATROL_GRID_BUCKETS + 1, 0);
+	bucketStamps.assign(PATROL_GRID_BUCKETS, 0);
+	queryStamp = 0;
+}
+
+void PatrolEnemyManager::Init(b2World* world, b2Vec2 halfSize, float cellSize, int promotedCount)
+{
+	Clear();
+
+	this->world = world;
+	this->halfSize = halfSize;
+	this->cellSize = cellSize;
+	inverseCellSize = 1.0f / cellSize;
+
+	promoted.resize(promotedCount);
+
+	for (int i = 0; i < promotedCount; i++)
+	{
+		promoted[i].enemy = -1;
+		promoted[i].body = NULL;
+		promoted[i].time = 0.0f;
+		promoted[i].object.set_type(PATROL_ENEMY);
+	}
+}
+
+int PatrolEnemyManager::AddSegment(float left, float right, float y)
+{
+	PatrolSegment segment;
+	segment.left = left;
+	segment.right = right;
+	segment.y = y;
+
+	segments.push_back(segment);
+
+	return (int)segments.size() - 1;
+}
+
+void PatrolEnemyManager::AddSegments(const NavGraph& graph)
+{
+	// nodes on a surface are stored left to right
+	// a run ends where a wall or the surface's end stops the walk edges
+
+	for (int s = 0; s < graph.getSurfaceCount(); s++)
+	{
+		const NavSurface& surface = graph.getSurface(s);
+		int runStart = surface.firstNode;
+
+		for (int n = surface.firstNode; n < surface.firstNode + surface.nodeCount; n++)
+		{
+			bool last = n == surface.firstNode + surface.nodeCount - 1;
+
+			if (!last && graph.FindEdge(n, n + 1))
+			{
+				continue;
+			}
+
+			const NavNode& start = graph.getNode(runStart);
+			const NavNode& end = graph.getNode(n);
+
+			if (end.position.x - start.position.x >= PATROL_MIN_SEGMENT_LENGTH)
+			{
+				AddSegment(start.position.x, end.position.x, start.position.y);
+			}
+
+			runStart = n + 1;
+		}
+	}
+}
+
+int PatrolEnemyManager::AddEnemy(int segment, float distance, float speed)
+{
+	enemySegments.push_back(segment);
+	enemyDistances.push_back(distance);
+	enemySpeeds.push_back(speed);
+	enemyX.push_back(0.0f);
+	enemyY.push_back(0.0f);
+	enemyPromoted.push_back(-1);
+	enemyBuckets.push_back(0);
+	gridEnemies.push_back(0);
+
+	int enemy = (int)enemySegments.size() - 1;
+	UpdatePosition(enemy);
+
+	return enemy;
+}
+
+void PatrolEnemyManager::SpawnEnemies(int count, float speed)
+{
+	if (segments.empty())
+	{
+		return;
+	}
+
+	// running total of segment lengths
+	// a random point along it picks a segment, so longer ones get more enemies
+
+	std::vector<float> totals(segments.size());
+	float total = 0.0f;
+
+	for (size_t s = 0; s < segments.size(); s++)
+	{
+		total += segments[s].right - segments[s].left;
+		totals[s] = total;
+	}
+
+	// seeded so the same enemies are spawned every run
+
+	srand(1);
+
+	for (int i = 0; i < count; i++)
+	{
+		float point = total * (float)rand() / RAND_MAX;
+		int segment = (int)(std::lower_bound(totals.begin(), totals.end(), point) - totals.begin());
+		segment = b2Min(segment, (int)segments.size() - 1);
+
+		float length = segments[segment].right - segments[segment].left;
+		float distance = 2.0f * length * (float)rand() / RAND_MAX;
+
+		// speeds vary a little so enemies on a segment spread out
+
+		float enemySpeed = speed * (0.75f + 0.5f * (float)rand() / RAND_MAX);
+
+		AddEnemy(segment, distance, enemySpeed);
+	}
+
+	BuildGrid();
+}
+
+void PatrolEnemyManager::Update(float frame_time)
+{
+	time += frame_time;
+
+	for (int i = 0; i < (int)enemySegments.size(); i++)
+	{
+		if (enemyPromoted[i] < 0)
+		{
+			UpdatePosition(i);
+		}
+	}
+
+	// promoted enemies follow their bodies until they land
+
+	for (int s = 0; s < (int)promoted.size(); s++)
+	{
+		PromotedEnemy& p = promoted[s];
+
+		if (!p.body)
+		{
+			continue;
+		}
+
+		p.time += frame_time;
+		p.object.UpdateFromSimulation(p.body);
+
+		b2Vec2 position = p.body->GetPosition();
+		enemyX[p.enemy] = position.x;
+		enemyY[p.enemy] = position.y;
+
+		if (p.time < PATROL_SETTLE_SECONDS)
+		{
+			continue;
+		}
+
+		if (p.body->GetLinearVelocity().Length() < PATROL_SETTLE_SPEED)
+		{
+			int segment = FindSegment(position);
+
+			if (segment >= 0)
+			{
+				enemySegments[p.enemy] = segment;
+				Demote(s);
+				continue;
+			}
+		}
+
+		if (p.time >= PATROL_RETURN_SECONDS)
+		{
+			Demote(s);
+		}
+	}
+
+	BuildGrid();
+}
+
+int PatrolEnemyManager::QueryAABB(const b2AABB& box, std::vector<int>& results)
+{
+	if (enemySegments.empty())
+	{
+		return 0;
+	}
+
+	// enemies are in the cell of their centre
+	// so the box is grown by their size to catch ones poking into it
+
+	b2AABB grown;
+	grown.lowerBound = box.lowerBound - halfSize;
+	grown.upperBound = box.upperBound + halfSize;
+
+	int minX = CellCoord(grown.lowerBound.x);
+	int minY = CellCoord(grown.lowerBound.y);
+	int maxX = CellCoord(grown.upperBound.x);
+	int maxY = CellCoord(grown.upperBound.y);
+
+	// cells sharing a bucket would give the same enemies twice
+	// so each bucket is stamped with the query and skipped if already checked
+
+	NextQueryStamp();
+	int found = 0;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			int bucket = BucketIndex(x, y);
+
+			if (bucketStamps[bucket] == queryStamp)
+			{
+				continue;
+			}
+
+			bucketStamps[bucket] = queryStamp;
+
+			for (int g = gridStarts[bucket]; g < gridStarts[bucket + 1]; g++)
+			{
+				int enemy = gridEnemies[g];
+
+				if (enemyX[enemy] < grown.lowerBound.x || enemyX[enemy] > grown.upperBound.x ||
+					enemyY[enemy] < grown.lowerBound.y || enemyY[enemy] > grown.upperBound.y)
+				{
+					continue;
+				}
+
+				results.push_back(enemy);
+				found++;
+			}
+		}
+	}
+
+	return found;
+}
+
+bool PatrolEnemyManager::Promote(int enemy, b2Vec2 velocity)
+{
+	if (!world || enemyPromoted[enemy] >= 0)
+	{
+		return false;
+	}
+
+	int slot = -1;
+
+	for (int s = 0; s < (int)promoted.size(); s++)
+	{
+		if (!promoted[s].body)
+		{
+			slot = s;
+			break;
+		}
+	}
+
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	// the same body as a ground enemy
+
+	b2BodyDef body_def;
+	body_def.type = b2_dynamicBody;
+	body_def.position = getPosition(enemy);
+	body_def.fixedRotation = true;
+
+	b2PolygonShape shape;
+	shape.SetAsBox(halfSize.x, halfSize.y);
+
+	b2FixtureDef fixture_def;
+	fixture_def.shape = &shape;
+	fixture_def.density = 2.0f;
+
+	PromotedEnemy& p = promoted[slot];
+	p.enemy = enemy;
+	p.time = 0.0f;
+	p.body = world->CreateBody(&body_def);
+	p.body->CreateFixture(&fixture_def);
+	p.body->SetLinearVelocity(velocity);
+	p.body->SetUserData(&p.object);
+
+	p.object.set_mesh(visual.mesh());
+	p.object.setScale(visualScale);
+	p.object.UpdateFromSimulation(p.body);
+
+	enemyPromoted[enemy] = slot;
+	promotedCount++;
+
+	return true;
+}
+
+void PatrolEnemyManager::SetMesh(gef::Mesh* mesh, gef::Vector4 scale)
+{
+	visual.set_mesh(mesh);
+	visualScale = scale;
+}
+
+void PatrolEnemyManager::Render(gef::Renderer3D* renderer, const b2AABB& view)
+{
+	if (!visual.mesh())
+	{
+		return;
+	}
+
+	// one mesh instance moved to each enemy in view
+	// the list is kept between frames so it's only allocated while it grows
+
+	visible.clear();
+	QueryAABB(view, visible);
+
+	for (size_t i = 0; i < visible.size(); i++)
+	{
+		gef::Matrix44 transform;
+		transform.Scale(visualScale);
+		transform.SetTranslation(gef::Vector4(enemyX[visible[i]], enemyY[visible[i]], 0.0f));
+
+		visual.set_transform(transform);
+		renderer->DrawMesh(visual);
+	}
+
+	for (size_t s = 0; s < promoted.size(); s++)
+	{
+		if (promoted[s].body)
+		{
+			renderer->DrawMesh(promoted[s].object);
+		}
+	}
+}
+
+void PatrolEnemyManager::RunBenchmark(int frames, float budgetMS)
+{
+	if (enemySegments.empty() || frames <= 0)
+	{
+		return;
+	}
+
+	// a player sized box and a view sized box, as Render asks for, are checked each frame
+	// centred on a different enemy so the queries find something
+
+	std::vector<int> results;
+	results.reserve(64);
+
+	double totalMS = 0.0;
+	double worstMS = 0.0;
+	int overBudget = 0;
+	int hits = 0;
+	int viewed = 0;
+
+	for (int f = 0; f < frames; f++)
+	{
+		// timed straight from the clock as Timer rounds to whole milliseconds
+
+		timer_clock::time_point start = timer_clock::now();
+
+		Update(1.0f / 60.0f);
+
+		b2Vec2 centre = getPosition(f % getEnemyCount());
+
+		b2AABB player;
+		player.lowerBound = centre - b2Vec2(1.0f, 1.0f);
+		player.upperBound = centre + b2Vec2(1.0f, 1.0f);
+
+		results.clear();
+		hits += QueryAABB(player, results);
+
+		b2AABB view;
+		view.lowerBound = centre - b2Vec2(PATROL_BENCHMARK_VIEW_X, PATROL_BENCHMARK_VIEW_Y);
+		view.upperBound = centre + b2Vec2(PATROL_BENCHMARK_VIEW_X, PATROL_BENCHMARK_VIEW_Y);
+
+		visible.clear();
+		viewed += QueryAABB(view, visible);
+
+		double frameMS = std::chrono::duration<double, std::milli>(timer_clock::now() - start).count();
+
+		totalMS += frameMS;
+		worstMS = b2Max(worstMS, frameMS);
+
+		if (frameMS > budgetMS)
+		{
+			overBudget++;
+		}
+	}
+
+	LOG_INFO(LOG_GAME, "patrol enemies: %i enemies on %i segments, %i frames, %i player hits, %i in view a frame",
+		getEnemyCount(), getSegmentCount(), frames, hits, viewed / frames);
+	LOG_INFO(LOG_GAME, "patrol enemies: update and queries average %.3fms, worst %.3fms, %i frames over the %.1fms budget",
+		totalMS / frames, worstMS, overBudget, budgetMS);
+}
+
+void PatrolEnemyManager::Clear()
+{
+	for (size_t s = 0; s < promoted.size(); s++)
+	{
+		if (promoted[s].body && world)
+		{
+			world->DestroyBody(promoted[s].body);
+		}
+
+		promoted[s].body = NULL;
+		promoted[s].enemy = -1;
+	}
+
+	promotedCount = 0;
+	time = 0.0;
+
+	segments.clear();
+	enemySegments.clear();
+	enemyDistances.clear();
+	enemySpeeds.clear();
+	enemyX.clear();
+	enemyY.clear();
+	enemyPromoted.clear();
+	enemyBuckets.clear();
+	gridEnemies.clear();
+	std::fill(gridStarts.begin(), gridStarts.end(), 0);
+}
+
+void PatrolEnemyManager::UpdatePosition(int enemy)
+{
+	// walks right along the segment then back
+	// the distance along the cycle gives where it is
+
+	const PatrolSegment& segment = segments[enemySegments[enemy]];
+	float length = segment.right - segment.left;
+
+	double cycle = 2.0 * length;
+	double distance = fmod(time * enemySpeeds[enemy] + enemyDistances[enemy], cycle);
+
+	if (distance < 0.0)
+	{
+		distance += cycle;
+	}
+
+	enemyX[enemy] = segment.left + (float)(distance <= length ? distance : cycle - distance);
+	enemyY[enemy] = segment.y;
+}
+
+void PatrolEnemyManager::Demote(int slot)
+{
+	PromotedEnemy& p = promoted[slot];
+	int enemy = p.enemy;
+
+	const PatrolSegment& segment = segments[enemySegments[enemy]];
+	float length = segment.right - segment.left;
+	float x = p.body->GetPosition().x;
+
+	// carries on from where it landed if it's on its segment
+	// heading the way it was moving
+
+	if (x >= segment.left && x <= segment.right && fabsf(p.body->GetPosition().y - segment.y) < PATROL_LAND_HEIGHT)
+	{
+		double cycle = 2.0 * length;
+		double along = x - segment.left;
+		double distance = p.body->GetLinearVelocity().x >= 0.0f ? along : cycle - along;
+
+		enemyDistances[enemy] = (float)fmod(distance - fmod(time * enemySpeeds[enemy], cycle) + cycle, cycle);
+	}
+
+	world->DestroyBody(p.body);
+
+	p.body = NULL;
+	p.enemy = -1;
+
+	enemyPromoted[enemy] = -1;
+	promotedCount--;
+
+	UpdatePosition(enemy);
+}
+
+int PatrolEnemyManager::FindSegment(b2Vec2 position) const
+{
+	for (size_t s = 0; s < segments.size(); s++)
+	{
+		const PatrolSegment& segment = segments[s];
+
+		if (position.x >= segment.left && position.x <= segment.right && fabsf(position.y - segment.y) < PATROL_LAND_HEIGHT)
+		{
+			return (int)s;
+		}
+	}
+
+	return -1;
+}
+
+int PatrolEnemyManager::CellCoord(float position) const
+{
+	return (int)floorf(position * inverseCellSize);
+}
+
+void PatrolEnemyManager::NextQueryStamp()
+{
+	queryStamp++;
+
+	// when the stamp wraps every bucket is reset
+	// so none are skipped by an old stamp
+
+	if (queryStamp == 0)
+	{
+		std::fill(bucketStamps.begin(), bucketStamps.end(), 0);
+		queryStamp = 1;
+	}
+}
+
+int PatrolEnemyManager::BucketIndex(int x, int y) const
+{
+	unsigned int hash = ((unsigned int)x * PATROL_HASH_X) ^ ((unsigned int)y * PATROL_HASH_Y);
+	return (int)(hash % PATROL_GRID_BUCKETS);
+}
+
+void PatrolEnemyManager::BuildGrid()
+{
+	// counts the enemies in each bucket
+	// then places them working back from the end of each bucket's range
+	// leaving each start where its first enemy is
+
+	std::fill(gridStarts.begin(), gridStarts.end(), 0);
+
+	int count = (int)enemySegments.size();
+
+	for (int i = 0; i < count; i++)
+	{
+		if (enemyPromoted[i] >= 0)
+		{
+			enemyBuckets[i] = -1;
+			continue;
+		}
+
+		enemyBuckets[i] = BucketIndex(CellCoord(enemyX[i]), CellCoord(enemyY[i]));
+		gridStarts[enemyBuckets[i]]++;
+	}
+
+	for (int b = 1; b <= PATROL_GRID_BUCKETS; b++)
+	{
+		gridStarts[b] += gridStarts[b - 1];
+	}
+
+	for (int i = count - 1; i >= 0; i--)
+	{
+		if (enemyBuckets[i] >= 0)
+		{
+			gridEnemies[--gridStarts[enemyBuckets[i]]] = i;
+		}
+	}
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+#include "game_object.h"
+#include "NavGraph.h"
+
+// FRAMEWORK FORWARD DECLARATIONS
+namespace gef
+{
+	class Renderer3D;
+	class Mesh;
+};
+
+// a stretch of ground a patrol enemy walks back and forth along
+// y is the height of the enemy's centre while on it
+
+struct PatrolSegment
+{
+	float left;
+	float right;
+	float y;
+};
+
+// patrol enemy manager
+// enemies with no physics body while they patrol, for levels with thousands of them
+// each one's position is worked out from the time, its segment and speed
+// so nothing builds up frame to frame and Box2D never sees them
+// they are sorted into a grid every update to find the ones touching the player
+// an enemy knocked back is given a body until it lands on a segment again
+
+class PatrolEnemyManager
+{
+public:
+
+	// patrol enemy manager constructor
+
+	PatrolEnemyManager();
+
+	// sets the world promoted enemies are created in, NULL to never promote
+	// the enemy size and the grid cell size, which should be at least the enemy width
+	// promotedCount is the most enemies that can have a body at once
+
+	void Init(b2World* world, b2Vec2 halfSize, float cellSize, int promotedCount);
+
+	// adds a segment, returning its index
+
+	int AddSegment(float left, float right, float y);
+
+	// adds a segment for each run of walk edges in the graph
+
+	void AddSegments(const NavGraph& graph);
+
+	// adds an enemy walking along a segment
+	// distance is how far along its back and forth cycle it starts
+	// returns its index
+
+	int AddEnemy(int segment, float distance, float speed);
+
+	// adds enemies spread over every segment, more on the longer ones
+
+	void SpawnEnemies(int count, float speed);
+
+	// moves every enemy to where it is at the current time
+	// and rebuilds the grid
+
+	void Update(float frame_time);
+
+	// adds the enemies without a body overlapping the box to results
+	// returns the number added
+
+	int QueryAABB(const b2AABB& box, std::vector<int>& results);
+
+	// gives an enemy a body moving at the velocity given
+	// returns false if it already has one or none are free
+
+	bool Promote(int enemy, b2Vec2 velocity);
+
+	// sets the mesh every enemy is drawn with
+
+	void SetMesh(gef::Mesh* mesh, gef::Vector4 scale);
+
+	// draws the enemies within the box
+
+	void Render(gef::Renderer3D* renderer, const b2AABB& view);
+
+	// times updates, player queries and view queries for a number of frames
+	// results are printed to the debug output against the budget
+
+	void RunBenchmark(int frames, float budgetMS);
+
+	// removes every enemy and segment, destroying any promoted bodies
+
+	void Clear();
+
+	// getters
+
+	int getEnemyCount() const { return (int)enemySegments.size(); }
+	int getSegmentCount() const { return (int)segments.size(); }
+	int getPromotedCount() const { return promotedCount; }
+	b2Vec2 getPosition(int enemy) const { return b2Vec2(enemyX[enemy], enemyY[enemy]); }
+	const gef::Mesh* getMesh() { return visual.mesh(); }
+
+private:
+
+	// an enemy with a body
+	struct PromotedEnemy
+	{
+		int enemy;
+		b2Body* body;
+		float time;
+
+		// set as the body's user data and drawn from it
+		GameObject object;
+	};
+
+	// position of an enemy along its segment at the current time
+	void UpdatePosition(int enemy);
+
+	// takes a promoted enemy's body away and puts it back to patrolling
+	// carrying on from where it landed in the direction it was heading
+	void Demote(int slot);
+
+	// finds the segment the position is standing on, -1 if none
+	int FindSegment(b2Vec2 position) const;
+
+	// grid cell and bucket of a position
+	int CellCoord(float position) const;
+	int BucketIndex(int x, int y) const;
+
+	// sorts the enemies without a body into the grid buckets
+	void BuildGrid();
+
+	// moves on the stamp buckets are marked with as a query checks them
+	void NextQueryStamp();
+
+	// patrol enemy manager variables
+
+	b2World* world;
+	b2Vec2 halfSize;
+	float cellSize;
+	float inverseCellSize;
+
+	// game time the positions are worked out from
+	double time;
+
+	std::vector<PatrolSegment> segments;
+
+	// enemy values, one entry each
+	// kept in separate arrays as the update only reads a few
+	std::vector<int> enemySegments;
+	std::vector<float> enemyDistances;
+	std::vector<float> enemySpeeds;
+	std::vector<float> enemyX;
+	std::vector<float> enemyY;
+
+	// promoted slot of each enemy, -1 without a body
+	std::vector<int> enemyPromoted;
+
+	// sized once in Init so the objects given to bodies never move
+	std::vector<PromotedEnemy> promoted;
+	int promotedCount;
+
+	// grid buckets, enemies sorted by bucket
+	// bucket b holds gridEnemies from gridStarts[b] to gridStarts[b + 1]
+	std::vector<int> gridStarts;
+	std::vector<int> gridEnemies;
+	std::vector<int> enemyBuckets;
+
+	// stamp of the last query to check each bucket
+	std::vector<unsigned int> bucketStamps;
+	unsigned int queryStamp;
+
+	// enemies in view, kept so rendering doesn't allocate each frame
+	std::vector<int> visible;
+
+	// drawn at every enemy position
+	GameObject visual;
+	gef::Vector4 visualScale;
+};
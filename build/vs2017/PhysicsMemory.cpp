@@ -0,0 +1,140 @@
+#include "PhysicsMemory.h"
+#include <system/debug_log.h>
+
+// physics memory constructor
+// initialising physics memory values
+
+PhysicsMemory::PhysicsMemory()
+{
+	reservedBodies = 0;
+	reservedFixtures = 0;
+	peakBodies = 0;
+	peakContacts = 0;
+	peakProxies = 0;
+}
+
+// creates the world and reserves space for the level
+
+b2World* PhysicsMemory::CreateWorld(const b2Vec2& gravity, int bodyCapacity, int fixtureCapacity)
+{
+	b2World* world = new b2World(gravity);
+
+	ReserveCapacity(world, bodyCapacity, fixtureCapacity);
+
+	return world;
+}
+
+// creates the level's worth of bodies and fixtures then destroys them
+// the block allocator keeps the freed blocks for the real bodies
+// and the broadphase tree keeps its grown node array
+// contacts are not reserved as they need overlapping bodies to create
+
+void PhysicsMemory::ReserveCapacity(b2World* world, int bodyCapacity, int fixtureCapacity)
+{
+	reservedBodies = bodyCapacity;
+	reservedFixtures = fixtureCapacity;
+
+	if (bodyCapacity <= 0)
+	{
+		return;
+	}
+
+	b2Body** bodies = new b2Body*[bodyCapacity];
+
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.5f);
+
+	b2FixtureDef fixture_def;
+	fixture_def.shape = &shape;
+
+	for (int i = 0; i < bodyCapacity; i++)
+	{
+		// static bodies spread apart so no contacts are made
+
+		b2BodyDef body_def;
+		body_def.type = b2_staticBody;
+		body_def.position = b2Vec2(i * 2.0f, 0.0f);
+
+		bodies[i] = world->CreateBody(&body_def);
+		bodies[i]->CreateFixture(&fixture_def);
+	}
+
+	// any fixtures over one per body go on the first body
+
+	for (int i = bodyCapacity; i < fixtureCapacity; i++)
+	{
+		bodies[0]->CreateFixture(&fixture_def);
+	}
+
+	for (int i = 0; i < bodyCapacity; i++)
+	{
+		world->DestroyBody(bodies[i]);
+	}
+
+	delete[] bodies;
+}
+
+// records the highest counts seen
+
+void PhysicsMemory::Update(b2World* world)
+{
+	if (world)
+	{
+		if (world->GetBodyCount() > peakBodies)
+		{
+			peakBodies = world->GetBodyCount();
+		}
+
+		if (world->GetContactCount() > peakContacts)
+		{
+			peakContacts = world->GetContactCount();
+		}
+
+		if (world->GetProxyCount() > peakProxies)
+		{
+			peakProxies = world->GetProxyCount();
+		}
+	}
+}
+
+// estimated bytes used by the world's bodies, fixtures and contacts
+
+size_t PhysicsMemory::EstimateBytes(int bodyCount, int fixtureCount, int contactCount)
+{
+	return bodyCount * sizeof(b2Body) +
+		fixtureCount * (sizeof(b2Fixture) + sizeof(b2PolygonShape) + sizeof(b2FixtureProxy)) +
+		contactCount * sizeof(b2Contact);
+}
+
+// prints counts and estimated memory to the debug output
+
+void PhysicsMemory::PrintStats(b2World* world)
+{
+	if (!world)
+	{
+		return;
+	}
+
+	// counts all fixtures in the world
+
+	int fixtureCount = 0;
+
+	for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+	{
+		for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+		{
+			fixtureCount++;
+		}
+	}
+
+	gef::DebugOut("physics: %i bodies (%i reserved, %i peak), %i fixtures (%i reserved), %i peak contacts, %i peak proxies\n",
+		world->GetBodyCount(), reservedBodies, peakBodies, fixtureCount, reservedFixtures, peakContacts, peakProxies);
+
+	gef::DebugOut("physics: ~%u bytes in use, ~%u bytes at peak\n",
+		(unsigned int)EstimateBytes(world->GetBodyCount(), fixtureCount, world->GetContactCount()),
+		(unsigned int)EstimateBytes(peakBodies, fixtureCount, peakContacts));
+
+	peakBodies = 0;
+	peakContacts = 0;
+	peakProxies = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <box2d/Box2D.h>
+
+// physics memory
+// creates the b2World with space reserved for the level
+// and keeps track of how much the world is using
+//
+// the Box2D version used here has no hook for b2Alloc / b2Free
+// so instead of replacing the allocator, the world's own block
+// allocator and broadphase are grown to the level size up front
+// and freed together when the world is deleted
+
+class PhysicsMemory
+{
+public:
+
+	// physics memory constructor
+
+	PhysicsMemory();
+
+	// creates the world and reserves space for
+	// the number of bodies and fixtures the level will create
+
+	b2World* CreateWorld(const b2Vec2& gravity, int bodyCapacity, int fixtureCapacity);
+
+	// records the highest counts seen
+	// called after each world step
+
+	void Update(b2World* world);
+
+	// prints counts and estimated memory to the debug output
+	// and resets the highest counts
+
+	void PrintStats(b2World* world);
+
+	// estimated bytes used by the world's bodies, fixtures and contacts
+
+	size_t EstimateBytes(int bodyCount, int fixtureCount, int contactCount);
+
+private:
+
+	// creates and destroys placeholder bodies so the block allocator
+	// and broadphase tree grow once to the size needed
+	void ReserveCapacity(b2World* world, int bodyCapacity, int fixtureCapacity);
+
+	// physics memory variables
+
+	int reservedBodies;
+	int reservedFixtures;
+
+	int peakBodies;
+	int peakContacts;
+	int peakProxies;
+};
+
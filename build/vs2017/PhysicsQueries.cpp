@@ -0,0 +1,557 @@
+#include "PhysicsQueries.h"
+#include "Timer.h"
+#include "Logger.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+// queries taken by a thread at a time
+
+#define QUERY_CHUNK 16
+
+// batches smaller than this are run on the calling thread
+// as waking the workers would take longer
+
+#define QUERY_PARALLEL_MIN 64
+
+// most threads used, including the calling thread
+
+#define QUERY_MAX_THREADS 8
+
+namespace
+{
+	// returned for tickets not in the last batch
+
+	const PhysicsQueryResult emptyResult;
+
+	// checks if a fixture is left out of a query
+
+	bool IsIgnored(const b2Fixture* fixture, const PhysicsQuery& query)
+	{
+		return fixture->GetBody() == query.ignoreBody || (fixture->IsSensor() && !query.includeSensors);
+	}
+
+	// keeps the closest fixture along a ray
+
+	class ClosestRayCallback : public b2RayCastCallback
+	{
+	public:
+
+		ClosestRayCallback(const PhysicsQuery& query, PhysicsQueryResult& result) : query(query), result(result) {}
+
+		float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction)
+		{
+			if (IsIgnored(fixture, query))
+			{
+				return -1.0f;
+			}
+
+			result.hit = true;
+			result.point = point;
+			result.normal = normal;
+			result.fraction = fraction;
+			result.body = fixture->GetBody();
+
+			// clips the ray so only closer fixtures are reported after this
+
+			return fraction;
+		}
+
+	private:
+
+		const PhysicsQuery& query;
+		PhysicsQueryResult& result;
+	};
+
+	// counts fixtures whose bounding box overlaps the query's box
+
+	class OverlapCallback : public b2QueryCallback
+	{
+	public:
+
+		OverlapCallback(const PhysicsQuery& query, PhysicsQueryResult& result) : query(query), result(result) {}
+
+		bool ReportFixture(b2Fixture* fixture)
+		{
+			// the broadphase boxes are fattened so the fixture's own is checked too
+
+			if (IsIgnored(fixture, query) || !b2TestOverlap(fixture->GetAABB(0), query.box))
+			{
+				return true;
+			}
+
+			if (!result.hit)
+			{
+				result.hit = true;
+				result.body = fixture->GetBody();
+			}
+
+			result.overlapCount++;
+
+			return true;
+		}
+
+	private:
+
+		const PhysicsQuery& query;
+		PhysicsQueryResult& result;
+	};
+
+	// keeps the closest fixture box the query's box runs into
+	// the box is swept by growing each fixture box by its half size and casting its centre
+
+	class BoxCastCallback : public b2QueryCallback
+	{
+	public:
+
+		BoxCastCallback(const PhysicsQuery& query, PhysicsQueryResult& result) : query(query), result(result)
+		{
+			result.fraction = 1.0f;
+		}
+
+		bool ReportFixture(b2Fixture* fixture)
+		{
+			if (IsIgnored(fixture, query))
+			{
+				return true;
+			}
+
+			const b2AABB& fixtureBox = fixture->GetAABB(0);
+
+			b2AABB grown;
+			grown.lowerBound = fixtureBox.lowerBound - query.halfSize;
+			grown.upperBound = fixtureBox.upperBound + query.halfSize;
+
+			float fraction;
+			b2Vec2 normal;
+
+			if (CastAgainst(grown, fraction, normal) && fraction <= result.fraction)
+			{
+				result.hit = true;
+				result.fraction = fraction;
+				result.normal = normal;
+				result.point = query.start + fraction * query.translation;
+				result.body = fixture->GetBody();
+			}
+
+			return true;
+		}
+
+	private:
+
+		// slab test of the centre's path against the box
+		// a centre starting inside hits at the start with no normal
+
+		bool CastAgainst(const b2AABB& box, float& fraction, b2Vec2& normal) const
+		{
+			float enter = 0.0f;
+			float exit = 1.0f;
+			normal.SetZero();
+
+			for (int axis = 0; axis < 2; axis++)
+			{
+				float start = axis == 0 ? query.start.x : query.start.y;
+				float delta = axis == 0 ? query.translation.x : query.translation.y;
+				float lower = axis == 0 ? box.lowerBound.x : box.lowerBound.y;
+				float upper = axis == 0 ? box.upperBound.x : box.upperBound.y;
+
+				if (fabsf(delta) < FLT_EPSILON)
+				{
+					if (start < lower || start > upper)
+					{
+						return false;
+					}
+
+					continue;
+				}
+
+				float inverse = 1.0f / delta;
+				float t1 = (lower - start) * inverse;
+				float t2 = (upper - start) * inverse;
+				float sign = -1.0f;
+
+				if (t1 > t2)
+				{
+					float swap = t1;
+					t1 = t2;
+					t2 = swap;
+					sign = 1.0f;
+				}
+
+				if (t1 > enter)
+				{
+					enter = t1;
+					normal = axis == 0 ? b2Vec2(sign, 0.0f) : b2Vec2(0.0f, sign);
+				}
+
+				exit = b2Min(exit, t2);
+
+				if (enter > exit)
+				{
+					return false;
+				}
+			}
+
+			fraction = enter;
+
+			return true;
+		}
+
+		const PhysicsQuery& query;
+		PhysicsQueryResult& result;
+	};
+}
+
+// physics query result constructor
+// initialising physics query result values
+
+PhysicsQueryResult::PhysicsQueryResult()
+{
+	hit = false;
+	point.SetZero();
+	normal.SetZero();
+	fraction = 1.0f;
+	body = NULL;
+	overlapCount = 0;
+}
+
+// physics queries constructor
+// initialising physics queries values
+
+PhysicsQueries::PhysicsQueries() : nextQuery(0)
+{
+	resultBatch = 0;
+	batchWorld = NULL;
+	batchNumber = 0;
+	busyWorkers = 0;
+	stopping = false;
+	lastExecuteMS = 0.0;
+}
+
+PhysicsQueries::~PhysicsQueries()
+{
+	Release();
+}
+
+void PhysicsQueries::Init(int threadCount)
+{
+	Release();
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+
+	threadCount = b2Clamp(threadCount, 1, QUERY_MAX_THREADS);
+
+	// the calling thread is one of them
+
+	stopping = false;
+
+	for (int i = 0; i < threadCount - 1; i++)
+	{
+		workers.push_back(std::thread(&PhysicsQueries::WorkerMain, this, batchNumber));
+	}
+}
+
+PhysicsQueryTicket PhysicsQueries::SubmitRayCast(b2Vec2 p1, b2Vec2 p2, const b2Body* ignoreBody, bool includeSensors)
+{
+	PhysicsQuery query;
+	query.type = QUERY_RAY;
+	query.start = p1;
+	query.translation = p2 - p1;
+	query.halfSize.SetZero();
+	query.ignoreBody = ignoreBody;
+	query.includeSensors = includeSensors;
+
+	pending.push_back(query);
+
+	return MakeTicket();
+}
+
+PhysicsQueryTicket PhysicsQueries::SubmitOverlap(const b2AABB& box, const b2Body* ignoreBody, bool includeSensors)
+{
+	PhysicsQuery query;
+	query.type = QUERY_OVERLAP;
+	query.start = box.GetCenter();
+	query.translation.SetZero();
+	query.halfSize = box.GetExtents();
+	query.box = box;
+	query.ignoreBody = ignoreBody;
+	query.includeSensors = includeSensors;
+
+	pending.push_back(query);
+
+	return MakeTicket();
+}
+
+PhysicsQueryTicket PhysicsQueries::SubmitBoxCast(b2Vec2 centre, b2Vec2 halfSize, b2Vec2 translation, const b2Body* ignoreBody, bool includeSensors)
+{
+	PhysicsQuery query;
+	query.type = QUERY_BOX_CAST;
+	query.start = centre;
+	query.translation = translation;
+	query.halfSize = halfSize;
+	query.ignoreBody = ignoreBody;
+	query.includeSensors = includeSensors;
+
+	// the area the box passes through, searched for fixtures
+
+	b2Vec2 end = centre + translation;
+	query.box.lowerBound = b2Min(centre, end) - halfSize;
+	query.box.upperBound = b2Max(centre, end) + halfSize;
+
+	pending.push_back(query);
+
+	return MakeTicket();
+}
+
+void PhysicsQueries::Execute(const b2World* world)
+{
+	Timer timer;
+	timer.Start();
+
+	// the queued queries become the batch
+	// and new ones can be queued while reading the results
+
+	batch.swap(pending);
+	pending.clear();
+
+	results.resize(batch.size());
+	resultBatch++;
+	batchWorld = world;
+	nextQuery = 0;
+
+	if (workers.empty() || (int)batch.size() < QUERY_PARALLEL_MIN)
+	{
+		RunChunks();
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers = (int)workers.size();
+			batchNumber++;
+		}
+
+		wakeCondition.notify_all();
+
+		RunChunks();
+
+		// waits for the workers to finish their last chunks
+
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+	}
+
+	batchWorld = NULL;
+
+	timer.GetTimeStop();
+	lastExecuteMS = timer.elapsedMS();
+}
+
+const PhysicsQueryResult& PhysicsQueries::getResult(const PhysicsQueryTicket& ticket) const
+{
+	if (ticket.batch != resultBatch || ticket.index < 0 || ticket.index >= (int)results.size())
+	{
+		return emptyResult;
+	}
+
+	return results[ticket.index];
+}
+
+void PhysicsQueries::Clear()
+{
+	pending.clear();
+	batch.clear();
+	results.clear();
+
+	// moves on a batch so no ticket handed out before matches
+
+	resultBatch++;
+}
+
+PhysicsQueryTicket PhysicsQueries::MakeTicket() const
+{
+	PhysicsQueryTicket ticket;
+	ticket.index = (int)pending.size() - 1;
+	ticket.batch = resultBatch + 1;
+
+	return ticket;
+}
+
+void PhysicsQueries::Release()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wakeCondition.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	workers.clear();
+	Clear();
+}
+
+void PhysicsQueries::RunBenchmark(const b2World* world, const b2AABB& area, int rayCount)
+{
+	if (rayCount <= 0)
+	{
+		return;
+	}
+
+	// rays between random points in the area
+
+	std::vector<b2Vec2> points(rayCount * 2);
+	srand(1);
+
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		float u = (float)rand() / RAND_MAX;
+		float v = (float)rand() / RAND_MAX;
+		points[i].x = area.lowerBound.x + u * (area.upperBound.x - area.lowerBound.x);
+		points[i].y = area.lowerBound.y + v * (area.upperBound.y - area.lowerBound.y);
+	}
+
+	// one at a time, as gameplay calling the world directly would
+
+	Timer timer;
+	int syncHits = 0;
+	timer.Start();
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		PhysicsQuery query;
+		query.type = QUERY_RAY;
+		query.start = points[i * 2];
+		query.translation = points[i * 2 + 1] - points[i * 2];
+		query.ignoreBody = NULL;
+		query.includeSensors = false;
+
+		PhysicsQueryResult result;
+		ClosestRayCallback callback(query, result);
+		world->RayCast(&callback, points[i * 2], points[i * 2 + 1]);
+
+		if (result.hit)
+		{
+			syncHits++;
+		}
+	}
+
+	timer.GetTimeStop();
+	double syncMS = timer.elapsedMS();
+
+	// the same rays as one batch
+	// anything already queued is kept for the real batch
+
+	std::vector<PhysicsQuery> queued;
+	queued.swap(pending);
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		SubmitRayCast(points[i * 2], points[i * 2 + 1]);
+	}
+
+	Execute(world);
+
+	int batchHits = 0;
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		if (results[i].hit)
+		{
+			batchHits++;
+		}
+	}
+
+	pending.swap(queued);
+	results.clear();
+
+	LOG_INFO(LOG_GAME, "physics queries: %i rays, one at a time %.2fms (%i hits), batched on %i threads %.2fms (%i hits)",
+		rayCount, syncMS, syncHits, getThreadCount(), lastExecuteMS, batchHits);
+}
+
+PhysicsQueryResult PhysicsQueries::RunQuery(const PhysicsQuery& query) const
+{
+	PhysicsQueryResult result;
+
+	switch (query.type)
+	{
+	case QUERY_RAY:
+	{
+		ClosestRayCallback callback(query, result);
+		batchWorld->RayCast(&callback, query.start, query.start + query.translation);
+		break;
+	}
+	case QUERY_OVERLAP:
+	{
+		OverlapCallback callback(query, result);
+		batchWorld->QueryAABB(&callback, query.box);
+		break;
+	}
+	case QUERY_BOX_CAST:
+	{
+		BoxCastCallback callback(query, result);
+		batchWorld->QueryAABB(&callback, query.box);
+		break;
+	}
+	}
+
+	return result;
+}
+
+void PhysicsQueries::RunChunks()
+{
+	int count = (int)batch.size();
+
+	for (;;)
+	{
+		int start = nextQuery.fetch_add(QUERY_CHUNK);
+
+		if (start >= count)
+		{
+			return;
+		}
+
+		int end = b2Min(start + QUERY_CHUNK, count);
+
+		// each query writes only its own result
+
+		for (int i = start; i < end; i++)
+		{
+			results[i] = RunQuery(batch[i]);
+		}
+	}
+}
+
+void PhysicsQueries::WorkerMain(unsigned int seenBatch)
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [this, seenBatch] { return stopping || batchNumber != seenBatch; });
+
+			if (stopping)
+			{
+				return;
+			}
+
+			seenBatch = batchNumber;
+		}
+
+		RunChunks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+
+		doneCondition.notify_one();
+	}
+}
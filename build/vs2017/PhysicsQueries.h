@@ -0,0 +1,170 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// kinds of physics query
+
+enum PHYSICS_QUERY_TYPE
+{
+	QUERY_RAY,
+	QUERY_OVERLAP,
+	QUERY_BOX_CAST
+};
+
+// a query waiting for the next batch
+
+struct PhysicsQuery
+{
+	PHYSICS_QUERY_TYPE type;
+
+	// ray start and end, or box centre and the distance it's cast
+	b2Vec2 start;
+	b2Vec2 translation;
+
+	// box half size for casts, the box itself for overlaps
+	b2Vec2 halfSize;
+	b2AABB box;
+
+	// body left out of the query, such as the one asking
+	const b2Body* ignoreBody;
+	bool includeSensors;
+};
+
+// what a query found
+
+struct PhysicsQueryResult
+{
+	PhysicsQueryResult();
+
+	bool hit;
+
+	// closest hit of a ray or cast
+	// fraction is how far along it the hit is, point is where the ray or box centre was
+	b2Vec2 point;
+	b2Vec2 normal;
+	float fraction;
+
+	// body hit, or the first found overlapping
+	b2Body* body;
+
+	// number of fixtures overlapping, overlap queries only
+	int overlapCount;
+};
+
+// ticket for a submitted query
+// the batch is kept so a ticket kept too long can't read a later query's result
+
+struct PhysicsQueryTicket
+{
+	PhysicsQueryTicket() : index(-1), batch(0) {}
+
+	bool isValid() const { return index >= 0; }
+
+	int index;
+	unsigned int batch;
+};
+
+// physics queries
+// ray casts, box overlaps and box casts asked for during a tick are gathered
+// and run together in one batch after the next world step
+// the batch is split between worker threads, which only read the world's broadphase
+// so it must not be stepped or changed while the batch runs
+// results are kept until the batch after, read back with the ticket each submit returns
+// box overlaps and casts test against each fixture's bounding box,
+// exact for the level's axis aligned boxes
+
+class PhysicsQueries
+{
+public:
+
+	// physics queries constructor and destructor
+	// the destructor stops the worker threads
+
+	PhysicsQueries();
+	~PhysicsQueries();
+
+	// starts the worker threads
+	// threadCount includes the calling thread, 0 uses one per core
+
+	void Init(int threadCount);
+
+	// queues a query for the next batch, returning its ticket
+
+	PhysicsQueryTicket SubmitRayCast(b2Vec2 p1, b2Vec2 p2, const b2Body* ignoreBody = NULL, bool includeSensors = false);
+	PhysicsQueryTicket SubmitOverlap(const b2AABB& box, const b2Body* ignoreBody = NULL, bool includeSensors = false);
+	PhysicsQueryTicket SubmitBoxCast(b2Vec2 centre, b2Vec2 halfSize, b2Vec2 translation, const b2Body* ignoreBody = NULL, bool includeSensors = false);
+
+	// runs every queued query against the world
+	// the results replace the last batch's
+
+	void Execute(const b2World* world);
+
+	// result of a query from the last batch
+	// tickets from any other batch, or never submitted, give an empty result
+
+	const PhysicsQueryResult& getResult(const PhysicsQueryTicket& ticket) const;
+
+	// forgets the queued queries and results
+	// tickets already handed out give empty results after
+	// used when the world they refer to is deleted
+
+	void Clear();
+
+	// stops the worker threads
+
+	void Release();
+
+	// times a number of random rays across the area run one at a time
+	// against the same rays run as a batch, printing both to the debug output
+
+	void RunBenchmark(const b2World* world, const b2AABB& area, int rayCount);
+
+	// getters
+
+	int getPendingCount() const { return (int)pending.size(); }
+	int getThreadCount() const { return (int)workers.size() + 1; }
+	double getLastExecuteMS() const { return lastExecuteMS; }
+
+private:
+
+	// ticket for the query just added to pending
+	PhysicsQueryTicket MakeTicket() const;
+
+	// runs one query
+	PhysicsQueryResult RunQuery(const PhysicsQuery& query) const;
+
+	// takes chunks of the batch until it's all done
+	// run by the workers and the calling thread together
+	void RunChunks();
+
+	// worker thread loop, waits for a batch after the one given then helps run it
+	void WorkerMain(unsigned int seenBatch);
+
+	// physics queries variables
+
+	std::vector<PhysicsQuery> pending;
+
+	// the batch being run, then the results read back
+	// resultBatch counts the batches run, pending queries go in the one after
+	std::vector<PhysicsQuery> batch;
+	std::vector<PhysicsQueryResult> results;
+	unsigned int resultBatch;
+	const b2World* batchWorld;
+	std::atomic<int> nextQuery;
+
+	// worker threads
+	// batchNumber goes up to wake them for each batch
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	unsigned int batchNumber;
+	int busyWorkers;
+	bool stopping;
+
+	double lastExecuteMS;
+};
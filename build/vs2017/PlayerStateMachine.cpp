@@ -0,0 +1,521 @@
+#include "PlayerStateMachine.h"
+
+// default player tuning
+// the tuning file can change these while the game runs
+
+#define JUMP_VALUE 11.0f
+#define DOUBLE_JUMP_VALUE 11.0f
+
+// player movement limits
+
+#define GROUNDED_VELOCITY 0.05f
+#define MOVE_SPEED_LIMIT 6.0f
+#define MOVE_IMPULSE 1.0f
+#define DASH_SPEED_LIMIT 16.0f
+#define DASH_IMPULSE 8.0f
+#define DOUBLE_JUMP_FALL_LIMIT -25.0f
+
+namespace
+{
+	// direction used to mirror the left and right states
+	// right is positive x, left is negative x
+
+	enum DIRECTION
+	{
+		DIR_LEFT = -1,
+		DIR_RIGHT = 1
+	};
+
+	// mirrored input helpers
+
+	template<int Dir>
+	inline bool IsDirDown(const PlayerInput& input)
+	{
+		return Dir == DIR_RIGHT ? input.rightDown : input.leftDown;
+	}
+
+	template<int Dir>
+	inline bool IsDirReleased(const PlayerInput& input)
+	{
+		return Dir == DIR_RIGHT ? input.rightReleased : input.leftReleased;
+	}
+
+	// checks if the player has no vertical velocity
+	// or when probed, is standing on ground and not moving up off it
+
+	inline bool IsGrounded(const PlayerStateContext& ctx)
+	{
+		if (ctx.groundProbed)
+		{
+			return ctx.grounded && ctx.velocity.y <= ctx.tuning->groundedVelocity;
+		}
+
+		return ctx.velocity.y <= ctx.tuning->groundedVelocity && ctx.velocity.y >= -ctx.tuning->groundedVelocity;
+	}
+
+	// adds an impulse to be applied once the tick is finished
+
+	inline void AddImpulse(PlayerStateContext& ctx, float x, float y)
+	{
+		ctx.impulse += b2Vec2(x, y);
+		ctx.hasImpulse = true;
+	}
+
+	// base state
+	// states without enter or exit actions use these
+
+	struct PlayerStateBase
+	{
+		static void Enter(PlayerStateContext& ctx) {}
+		static void Exit(PlayerStateContext& ctx) {}
+	};
+
+	// all player states
+
+	struct StandingState : PlayerStateBase
+	{
+		static constexpr PLAYER_STATE kState = STANDING;
+		static void Update(PlayerStateContext& ctx);
+	};
+
+	template<int Dir>
+	struct MovingState : PlayerStateBase
+	{
+		static constexpr PLAYER_STATE kState = Dir == DIR_RIGHT ? MOVING_RIGHT : MOVING_LEFT;
+		static void Update(PlayerStateContext& ctx);
+	};
+
+	template<int Dir>
+	struct DashingState : PlayerStateBase
+	{
+		static constexpr PLAYER_STATE kState = Dir == DIR_RIGHT ? DASHING_RIGHT : DASHING_LEFT;
+
+		// dashes the player, limiting the dash speed
+		static void Enter(PlayerStateContext& ctx)
+		{
+			if (Dir * ctx.velocity.x <= ctx.tuning->dashSpeedLimit)
+			{
+				AddImpulse(ctx, Dir * ctx.tuning->dashImpulse, 0.0f);
+			}
+		}
+
+		static void Update(PlayerStateContext& ctx);
+	};
+
+	struct JumpingState : PlayerStateBase
+	{
+		static constexpr PLAYER_STATE kState = JUMPING;
+
+		static void Enter(PlayerStateContext& ctx)
+		{
+			AddImpulse(ctx, 0.0f, ctx.tuning->jumpValue);
+		}
+
+		static void Update(PlayerStateContext& ctx);
+	};
+
+	struct DoubleJumpingState : PlayerStateBase
+	{
+		static constexpr PLAYER_STATE kState = DOUBLE_JUMPING;
+
+		static void Enter(PlayerStateContext& ctx)
+		{
+			AddImpulse(ctx, 0.0f, ctx.tuning->doubleJumpValue);
+		}
+
+		static void Update(PlayerStateContext& ctx);
+	};
+
+	struct OnWallState : PlayerStateBase
+	{
+		static constexpr PLAYER_STATE kState = ON_WALL;
+		static void Update(PlayerStateContext& ctx);
+	};
+
+	struct OnMovingPlatState : PlayerStateBase
+	{
+		static constexpr PLAYER_STATE kState = ON_MOVING_PLAT;
+		static void Update(PlayerStateContext& ctx);
+	};
+
+	// maps each PLAYER_STATE value to its state type
+
+	template<PLAYER_STATE S> struct StateType;
+	template<> struct StateType<STANDING> { typedef StandingState type; };
+	template<> struct StateType<MOVING_RIGHT> { typedef MovingState<DIR_RIGHT> type; };
+	template<> struct StateType<MOVING_LEFT> { typedef MovingState<DIR_LEFT> type; };
+	template<> struct StateType<DASHING_RIGHT> { typedef DashingState<DIR_RIGHT> type; };
+	template<> struct StateType<DASHING_LEFT> { typedef DashingState<DIR_LEFT> type; };
+	template<> struct StateType<JUMPING> { typedef JumpingState type; };
+	template<> struct StateType<DOUBLE_JUMPING> { typedef DoubleJumpingState type; };
+	template<> struct StateType<ON_WALL> { typedef OnWallState type; };
+	template<> struct StateType<ON_MOVING_PLAT> { typedef OnMovingPlatState type; };
+
+	// exit table
+	// the state being left is only known at run time
+	// as an earlier transition in the same tick may have changed it
+
+	typedef void (*PlayerStateFunc)(PlayerStateContext& ctx);
+
+	const PlayerStateFunc kExitTable[PLAYER_STATE_COUNT] =
+	{
+		&StandingState::Exit,
+		&MovingState<DIR_RIGHT>::Exit,
+		&MovingState<DIR_LEFT>::Exit,
+		&DashingState<DIR_RIGHT>::Exit,
+		&DashingState<DIR_LEFT>::Exit,
+		&JumpingState::Exit,
+		&DoubleJumpingState::Exit,
+		&OnWallState::Exit,
+		&OnMovingPlatState::Exit
+	};
+
+	// moves the state machine to a new state
+	// shifting the state history the same way as Player::setPlayerState
+
+	template<PLAYER_STATE From, PLAYER_STATE To>
+	inline void Transition(PlayerStateContext& ctx)
+	{
+		static_assert(IsPlayerTransitionAllowed(From, To), "player state transition missing from kPlayerStateTransitions");
+
+		kExitTable[ctx.current](ctx);
+
+		ctx.secondPrevious = ctx.previous;
+		ctx.previous = ctx.current;
+		ctx.current = To;
+		ctx.transitionCount++;
+
+		StateType<To>::type::Enter(ctx);
+	}
+
+	// moving can dash or turn and then jump or stop in the same tick
+	// so the second transition is checked from the state it really leaves
+
+	template<int Dir, PLAYER_STATE To>
+	inline void MovingChainedTransition(PlayerStateContext& ctx)
+	{
+		if (ctx.current == DashingState<Dir>::kState)
+		{
+			Transition<DashingState<Dir>::kState, To>(ctx);
+		}
+		else if (ctx.current == MovingState<-Dir>::kState)
+		{
+			Transition<MovingState<-Dir>::kState, To>(ctx);
+		}
+		else
+		{
+			Transition<MovingState<Dir>::kState, To>(ctx);
+		}
+	}
+
+	// standing
+
+	void StandingState::Update(PlayerStateContext& ctx)
+	{
+		const PlayerInput& in = ctx.input;
+
+		// jumps if player is standing still
+
+		if (in.upPressed && IsGrounded(ctx))
+		{
+			Transition<kState, JUMPING>(ctx);
+		}
+
+		// allows for player to jump after coming off a Double Jump Reset wall
+
+		else if (in.upPressed && ctx.previous == ON_WALL)
+		{
+			Transition<kState, JUMPING>(ctx);
+		}
+
+		// allows for player to double jump while falling before reaching a certain velocity
+
+		else if (in.upPressed && ctx.velocity.y > ctx.tuning->doubleJumpFallLimit && ctx.secondPrevious == JUMPING && (ctx.previous == MOVING_LEFT || ctx.previous == MOVING_RIGHT) && ctx.doubleJumpActive)
+		{
+			Transition<kState, DOUBLE_JUMPING>(ctx);
+		}
+
+		// moves the player right
+
+		else if (in.rightDown)
+		{
+			Transition<kState, MOVING_RIGHT>(ctx);
+		}
+
+		// moves the player left
+
+		else if (in.leftDown)
+		{
+			Transition<kState, MOVING_LEFT>(ctx);
+		}
+	}
+
+	// moving left / right
+	// Dir mirrors the velocity checks, impulses and keys
+
+	template<int Dir>
+	void MovingState<Dir>::Update(PlayerStateContext& ctx)
+	{
+		const PlayerInput& in = ctx.input;
+		const float forwardVelocity = Dir * ctx.velocity.x;
+
+		// limits speed player can reach when moving
+
+		if (forwardVelocity <= ctx.tuning->moveSpeedLimit)
+		{
+			AddImpulse(ctx, Dir * ctx.tuning->moveImpulse, 0.0f);
+		}
+
+		// dashes player if ability is active
+
+		else if (IsDirDown<Dir>(in) && in.dashPressed && ctx.dashActive)
+		{
+			Transition<kState, DashingState<Dir>::kState>(ctx);
+		}
+
+		// moves player the other way
+
+		else if (IsDirDown<-Dir>(in))
+		{
+			Transition<kState, MovingState<-Dir>::kState>(ctx);
+		}
+
+		// allows player to jump while moving
+		// stops player from jumping infinitely
+
+		if (in.upPressed && IsGrounded(ctx))
+		{
+			MovingChainedTransition<Dir, JUMPING>(ctx);
+		}
+
+		// allows player to jump on a moving platform while moving
+
+		else if (IsDirDown<Dir>(in) && in.upPressed && ctx.previous == ON_MOVING_PLAT && ctx.secondPrevious != JUMPING)
+		{
+			MovingChainedTransition<Dir, JUMPING>(ctx);
+		}
+
+		// allows player to double jump after being on a moving platform while moving
+
+		else if (IsDirDown<Dir>(in) && in.upPressed && ctx.previous == ON_MOVING_PLAT && ctx.secondPrevious == JUMPING && ctx.doubleJumpActive)
+		{
+			MovingChainedTransition<Dir, DOUBLE_JUMPING>(ctx);
+		}
+
+		// allows player to double jump while moving if ability is active
+
+		else if (IsDirDown<Dir>(in) && in.upPressed && ctx.previous == JUMPING && ctx.doubleJumpActive)
+		{
+			MovingChainedTransition<Dir, DOUBLE_JUMPING>(ctx);
+		}
+
+		// allows player to jump after being on a Double Jump Reset wall
+
+		else if (IsDirDown<Dir>(in) && in.upPressed && ctx.previous == ON_WALL)
+		{
+			MovingChainedTransition<Dir, JUMPING>(ctx);
+		}
+
+		// brings player to a standing state
+
+		else if (IsDirReleased<Dir>(in))
+		{
+			MovingChainedTransition<Dir, STANDING>(ctx);
+		}
+	}
+
+	// dashing left / right
+	// both directions check left first
+
+	template<int Dir>
+	void DashingState<Dir>::Update(PlayerStateContext& ctx)
+	{
+		// moves player left
+
+		if (ctx.input.leftDown)
+		{
+			Transition<kState, MOVING_LEFT>(ctx);
+		}
+
+		// moves player right
+
+		else if (ctx.input.rightDown)
+		{
+			Transition<kState, MOVING_RIGHT>(ctx);
+		}
+	}
+
+	// jumping
+
+	void JumpingState::Update(PlayerStateContext& ctx)
+	{
+		// allows player to double jump if ability is active
+
+		if (ctx.input.upPressed && ctx.doubleJumpActive)
+		{
+			Transition<kState, DOUBLE_JUMPING>(ctx);
+		}
+
+		// brings player to a standing state
+		// if no input is present and the player comes
+		// to a complete stop
+
+		else if (IsGrounded(ctx))
+		{
+			Transition<kState, STANDING>(ctx);
+		}
+
+		// moves player right
+
+		else if (ctx.input.rightDown)
+		{
+			Transition<kState, MOVING_RIGHT>(ctx);
+		}
+
+		// moves player left
+
+		else if (ctx.input.leftDown)
+		{
+			Transition<kState, MOVING_LEFT>(ctx);
+		}
+	}
+
+	// double jumping
+
+	void DoubleJumpingState::Update(PlayerStateContext& ctx)
+	{
+		// brings player to a standing state
+		// if no input is present and the player comes
+		// to a complete stop
+
+		if (IsGrounded(ctx))
+		{
+			Transition<kState, STANDING>(ctx);
+		}
+
+		// moves player right
+
+		else if (ctx.input.rightDown)
+		{
+			Transition<kState, MOVING_RIGHT>(ctx);
+		}
+
+		// moves player left
+
+		else if (ctx.input.leftDown)
+		{
+			Transition<kState, MOVING_LEFT>(ctx);
+		}
+	}
+
+	// on a Double Jump Reset wall
+
+	void OnWallState::Update(PlayerStateContext& ctx)
+	{
+		// moves player right
+		// off from wall
+
+		if (ctx.input.rightDown)
+		{
+			Transition<kState, MOVING_RIGHT>(ctx);
+		}
+
+		// moves player left
+		// off from wall
+
+		else if (ctx.input.leftDown)
+		{
+			Transition<kState, MOVING_LEFT>(ctx);
+		}
+	}
+
+	// on a moving platform
+
+	void OnMovingPlatState::Update(PlayerStateContext& ctx)
+	{
+		// allows player to jump from moving platform
+
+		if (ctx.input.upPressed && ctx.previous != ON_MOVING_PLAT)
+		{
+			Transition<kState, JUMPING>(ctx);
+		}
+
+		// allows player to move right on moving platform
+
+		else if (ctx.input.rightDown)
+		{
+			Transition<kState, MOVING_RIGHT>(ctx);
+		}
+
+		// allows player to move left on moving platform
+
+		else if (ctx.input.leftDown)
+		{
+			Transition<kState, MOVING_LEFT>(ctx);
+		}
+	}
+
+	// update table
+	// indexed by PLAYER_STATE so each tick is a single call
+
+	const PlayerStateFunc kUpdateTable[PLAYER_STATE_COUNT] =
+	{
+		&StandingState::Update,
+		&MovingState<DIR_RIGHT>::Update,
+		&MovingState<DIR_LEFT>::Update,
+		&DashingState<DIR_RIGHT>::Update,
+		&DashingState<DIR_LEFT>::Update,
+		&JumpingState::Update,
+		&DoubleJumpingState::Update,
+		&OnWallState::Update,
+		&OnMovingPlatState::Update
+	};
+}
+
+// player tuning constructor
+// starts with the default values
+
+PlayerTuning::PlayerTuning()
+{
+	jumpValue = JUMP_VALUE;
+	doubleJumpValue = DOUBLE_JUMP_VALUE;
+	groundedVelocity = GROUNDED_VELOCITY;
+	moveSpeedLimit = MOVE_SPEED_LIMIT;
+	moveImpulse = MOVE_IMPULSE;
+	dashSpeedLimit = DASH_SPEED_LIMIT;
+	dashImpulse = DASH_IMPULSE;
+	doubleJumpFallLimit = DOUBLE_JUMP_FALL_LIMIT;
+}
+
+// sets up a context from the current player values
+
+void InitPlayerStateContext(PlayerStateContext& ctx, const PlayerInput& input, b2Vec2 velocity,
+	PLAYER_STATE current, PLAYER_STATE previous, PLAYER_STATE secondPrevious,
+	bool doubleJumpActive, bool dashActive, const PlayerTuning& tuning)
+{
+	ctx.tuning = &tuning;
+	ctx.input = input;
+	ctx.velocity = velocity;
+	ctx.doubleJumpActive = doubleJumpActive;
+	ctx.dashActive = dashActive;
+	ctx.groundProbed = false;
+	ctx.grounded = false;
+
+	ctx.current = current;
+	ctx.previous = previous;
+	ctx.secondPrevious = secondPrevious;
+
+	ctx.impulse.SetZero();
+	ctx.hasImpulse = false;
+	ctx.transitionCount = 0;
+}
+
+// runs one tick of the player state machine
+
+void UpdatePlayerStateMachine(PlayerStateContext& ctx)
+{
+	if (ctx.current >= 0 && ctx.current < PLAYER_STATE_COUNT)
+	{
+		kUpdateTable[ctx.current](ctx);
+	}
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <box2d/Box2D.h>
+
+// player states
+// used to determine what the 
+// player is doing and how to control
+// the player during said state
+
+enum PLAYER_STATE
+{
+	STANDING,
+	MOVING_RIGHT,
+	MOVING_LEFT,
+	DASHING_RIGHT,
+	DASHING_LEFT,
+	JUMPING,
+	DOUBLE_JUMPING,
+	ON_WALL,
+	ON_MOVING_PLAT,
+
+	// number of player states
+	// used to size the state machine tables
+	PLAYER_STATE_COUNT
+};
+
+// input used by the player state machine
+// filled in once per tick from the keyboard
+// or any other input source
+
+struct PlayerInput
+{
+	bool upPressed;
+	bool leftDown;
+	bool rightDown;
+	bool leftReleased;
+	bool rightReleased;
+	bool dashPressed;
+};
+
+// player tuning
+// impulses and speed limits used by the state machine
+
+struct PlayerTuning
+{
+	PlayerTuning();
+
+	float jumpValue;
+	float doubleJumpValue;
+	float groundedVelocity;
+	float moveSpeedLimit;
+	float moveImpulse;
+	float dashSpeedLimit;
+	float dashImpulse;
+	float doubleJumpFallLimit;
+};
+
+// everything the player state machine reads and writes in a tick
+// the velocity is read from the body once before the tick
+// and any impulses are added up and applied once after it
+
+struct PlayerStateContext
+{
+	// inputs
+	const PlayerTuning* tuning;
+	PlayerInput input;
+	b2Vec2 velocity;
+	bool doubleJumpActive;
+	bool dashActive;
+
+	// ground found under the player by a probe, used over the velocity check when probed
+	bool groundProbed;
+	bool grounded;
+
+	// state history
+	PLAYER_STATE current;
+	PLAYER_STATE previous;
+	PLAYER_STATE secondPrevious;
+
+	// outputs
+	b2Vec2 impulse;
+	bool hasImpulse;
+	int transitionCount;
+};
+
+// transitions each state's update is allowed to request
+// checked at compile time when a state asks for a transition
+// ON_WALL and ON_MOVING_PLAT are entered from collisions
+// in scene app, not from the state machine
+
+struct PlayerStateTransition
+{
+	PLAYER_STATE from;
+	PLAYER_STATE to;
+};
+
+constexpr PlayerStateTransition kPlayerStateTransitions[] =
+{
+	{ STANDING, JUMPING },
+	{ STANDING, DOUBLE_JUMPING },
+	{ STANDING, MOVING_RIGHT },
+	{ STANDING, MOVING_LEFT },
+
+	{ MOVING_RIGHT, DASHING_RIGHT },
+	{ MOVING_RIGHT, MOVING_LEFT },
+	{ MOVING_RIGHT, JUMPING },
+	{ MOVING_RIGHT, DOUBLE_JUMPING },
+	{ MOVING_RIGHT, STANDING },
+
+	{ MOVING_LEFT, DASHING_LEFT },
+	{ MOVING_LEFT, MOVING_RIGHT },
+	{ MOVING_LEFT, JUMPING },
+	{ MOVING_LEFT, DOUBLE_JUMPING },
+	{ MOVING_LEFT, STANDING },
+
+	{ DASHING_RIGHT, MOVING_LEFT },
+	{ DASHING_RIGHT, MOVING_RIGHT },
+
+	{ DASHING_LEFT, MOVING_LEFT },
+	{ DASHING_LEFT, MOVING_RIGHT },
+
+	// taken in the same tick a moving state starts a dash
+
+	{ DASHING_RIGHT, JUMPING },
+	{ DASHING_RIGHT, DOUBLE_JUMPING },
+	{ DASHING_RIGHT, STANDING },
+
+	{ DASHING_LEFT, JUMPING },
+	{ DASHING_LEFT, DOUBLE_JUMPING },
+	{ DASHING_LEFT, STANDING },
+
+	{ JUMPING, DOUBLE_JUMPING },
+	{ JUMPING, STANDING },
+	{ JUMPING, MOVING_RIGHT },
+	{ JUMPING, MOVING_LEFT },
+
+	{ DOUBLE_JUMPING, STANDING },
+	{ DOUBLE_JUMPING, MOVING_RIGHT },
+	{ DOUBLE_JUMPING, MOVING_LEFT },
+
+	{ ON_WALL, MOVING_RIGHT },
+	{ ON_WALL, MOVING_LEFT },
+
+	{ ON_MOVING_PLAT, JUMPING },
+	{ ON_MOVING_PLAT, MOVING_RIGHT },
+	{ ON_MOVING_PLAT, MOVING_LEFT }
+};
+
+// checks if a transition is in the table above
+
+constexpr bool IsPlayerTransitionAllowed(PLAYER_STATE from, PLAYER_STATE to, int index = 0)
+{
+	return index < (int)(sizeof(kPlayerStateTransitions) / sizeof(kPlayerStateTransitions[0])) &&
+		((kPlayerStateTransitions[index].from == from && kPlayerStateTransitions[index].to == to) ||
+		IsPlayerTransitionAllowed(from, to, index + 1));
+}
+
+// sets up a context from the current player values
+// ready for a tick of the state machine
+
+void InitPlayerStateContext(PlayerStateContext& ctx, const PlayerInput& input, b2Vec2 velocity,
+	PLAYER_STATE current, PLAYER_STATE previous, PLAYER_STATE secondPrevious,
+	bool doubleJumpActive, bool dashActive, const PlayerTuning& tuning);
+
+// runs one tick of the player state machine
+// only reads and writes the context so it can be
+// run without a window, keyboard or physics body
+
+void UpdatePlayerStateMachine(PlayerStateContext& ctx);
+
@@ -0,0 +1,112 @@
+#include "PrimitiveBenchmark.h"
+#include "primitive_builder.h"
+#include "Timer.h"
+#include <graphics/mesh.h>
+#include <system/debug_log.h>
+
+// number of meshes built when timing generation
+
+#define BENCHMARK_MESH_NUM 100
+
+// post transform cache sizes compared
+// small for older hardware, large for current
+
+#define SMALL_VERTEX_CACHE 16
+#define LARGE_VERTEX_CACHE 32
+
+// benchmark sphere radius
+
+#define BENCHMARK_SPHERE_RADIUS 1.0f
+
+// prints one line for a triangle list in generation order
+// and after vertex cache ordering
+
+static void PrintSphereResult(int lod, int phi)
+{
+	int vertexCount = phi * phi + 2;
+
+	std::vector<UInt32> before;
+	PrimitiveBuilder::BuildSphereIndices(phi, phi, before);
+
+	std::vector<UInt32> after = before;
+	PrimitiveBuilder::OptimiseVertexCache(after, vertexCount);
+
+	int triangleCount = (int)before.size() / 3;
+
+	// vertices transformed per draw is the triangle count times the miss ratio
+
+	float smallBefore = PrimitiveBuilder::CalculateACMR(before, SMALL_VERTEX_CACHE);
+	float smallAfter = PrimitiveBuilder::CalculateACMR(after, SMALL_VERTEX_CACHE);
+	float largeBefore = PrimitiveBuilder::CalculateACMR(before, LARGE_VERTEX_CACHE);
+	float largeAfter = PrimitiveBuilder::CalculateACMR(after, LARGE_VERTEX_CACHE);
+
+	gef::DebugOut("benchmark: sphere lod %i (%ix%i), %i triangles, %i vertices\n", lod, phi, phi, triangleCount, vertexCount);
+	gef::DebugOut("benchmark:   acmr cache %i: %.3f -> %.3f, cache %i: %.3f -> %.3f\n",
+		SMALL_VERTEX_CACHE, smallBefore, smallAfter, LARGE_VERTEX_CACHE, largeBefore, largeAfter);
+	gef::DebugOut("benchmark:   vertex transforms per draw (cache %i): %i -> %i\n",
+		LARGE_VERTEX_CACHE, (int)(largeBefore * triangleCount), (int)(largeAfter * triangleCount));
+	gef::DebugOut("benchmark:   index bytes: %i -> %i, primitives: 2 -> 1\n",
+		(int)(before.size() * sizeof(UInt32)), (int)(after.size() * (vertexCount <= 0xffff ? sizeof(UInt16) : sizeof(UInt32))));
+}
+
+void RunPrimitiveBenchmark(PrimitiveBuilder* primitive_builder)
+{
+	if (!primitive_builder)
+	{
+		return;
+	}
+
+	// triangle order and index size for every sphere level of detail
+
+	for (int lod = 0; lod < PrimitiveBuilder::kNumSphereLods; lod++)
+	{
+		PrintSphereResult(lod, PrimitiveBuilder::GetSphereLodTessellation(lod));
+	}
+
+	// boxes keep 24 vertices so each face has its own normal
+	// but are drawn with one primitive instead of one per face
+
+	gef::DebugOut("benchmark: box, 12 triangles, index bytes: %i -> %i, primitives: 6 -> 1\n",
+		(int)(36 * sizeof(UInt32)), (int)(36 * sizeof(UInt16)));
+
+	// time to build and upload meshes
+
+	Timer timer;
+	gef::Mesh* meshes[BENCHMARK_MESH_NUM];
+
+	for (int lod = 0; lod < PrimitiveBuilder::kNumSphereLods; lod++)
+	{
+		timer.Start();
+
+		for (int i = 0; i < BENCHMARK_MESH_NUM; i++)
+		{
+			meshes[i] = primitive_builder->CreateSphereMesh(BENCHMARK_SPHERE_RADIUS,
+				PrimitiveBuilder::GetSphereLodTessellation(lod), PrimitiveBuilder::GetSphereLodTessellation(lod));
+		}
+
+		timer.GetTimeStop();
+
+		gef::DebugOut("benchmark: sphere lod %i built in %.3fms each\n", lod, timer.elapsedMS() / BENCHMARK_MESH_NUM);
+
+		for (int i = 0; i < BENCHMARK_MESH_NUM; i++)
+		{
+			delete meshes[i];
+		}
+	}
+
+	timer.Start();
+
+	for (int i = 0; i < BENCHMARK_MESH_NUM; i++)
+	{
+		meshes[i] = primitive_builder->CreateBoxMesh(gef::Vector4(0.5f, 0.5f, 0.5f));
+	}
+
+	timer.GetTimeStop();
+
+	gef::DebugOut("benchmark: box built in %.3fms each\n", timer.elapsedMS() / BENCHMARK_MESH_NUM);
+
+	for (int i = 0; i < BENCHMARK_MESH_NUM; i++)
+	{
+		delete meshes[i];
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+class PrimitiveBuilder;
+
+// primitive benchmark
+// compares the primitive builder's meshes before and after
+// 16 bit indices and vertex cache ordering
+// results are printed to the debug output
+
+void RunPrimitiveBenchmark(PrimitiveBuilder* primitive_builder);
+
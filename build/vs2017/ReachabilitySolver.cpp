@@ -0,0 +1,606 @@
+#include "ReachabilitySolver.h"
+#include "Timer.h"
+#include "Logger.h"
+#include <math.h>
+#include <queue>
+#include <thread>
+
+// grid the player states are snapped to
+// velocities inside the grounded range share one step so jumping is judged the same
+
+#define REACH_CELL_SIZE 1.0f
+#define REACH_VELOCITY_STEP 2.0f
+
+// ticks each move is held for
+
+#define REACH_MOVE_TICKS 12
+
+// moves tried from every state
+// a direction held for the whole move, with jump or dash pressed on its first tick
+
+#define REACH_MOVE_NUM 9
+
+// nodes each thread expands before the results are merged
+
+#define REACH_BATCH_PER_THREAD 16
+
+// ability bits a region starts with, so any found has fewer
+
+#define REACH_ALL_ABILITIES ((1u << PICKUP_ABILITY_NUM) - 1)
+
+// fixed step the simulation runs at
+
+#define REACH_TICKS_PER_SECOND 60.0f
+
+namespace
+{
+	const unsigned char moveDirections[3] = { 0, INPUT_LEFT, INPUT_RIGHT };
+	const unsigned char movePresses[3] = { 0, INPUT_JUMP, INPUT_DASH };
+
+	// keys held on the first tick of a move and for the rest of it
+
+	unsigned char MoveFirstKeys(int move)
+	{
+		return moveDirections[move / 3] | movePresses[move % 3];
+	}
+
+	unsigned char MoveHeldKeys(int move)
+	{
+		return moveDirections[move / 3];
+	}
+
+	int CountBits(unsigned int bits)
+	{
+		int count = 0;
+
+		for (; bits; bits &= bits - 1)
+		{
+			count++;
+		}
+
+		return count;
+	}
+
+	// snaps a value to a signed grid step packed into the bits given
+
+	uint64_t PackStep(int step, int bits)
+	{
+		int half = 1 << (bits - 1);
+
+		if (step < -half)
+		{
+			step = -half;
+		}
+		else if (step > half - 1)
+		{
+			step = half - 1;
+		}
+
+		return (uint64_t)(step + half) & ((1ull << bits) - 1);
+	}
+}
+
+// reachability solver constructor
+// initialising reachability solver values
+
+ReachabilitySolver::ReachabilitySolver()
+{
+	goalPosition = b2Vec2(0.0f, 0.0f);
+	groundedVelocity = 0.0f;
+	goalHalfSize = b2Vec2(0.0f, 0.0f);
+	goalReach = 0.0f;
+	maxTickDistance = 1.0f;
+	goalNode = -1;
+	parProven = false;
+	expandedCount = 0;
+	threadsUsed = 0;
+	solveMS = 0.0;
+	simulations = NULL;
+	batchNumber = 0;
+	busyWorkers = 0;
+	stopping = false;
+}
+
+void ReachabilitySolver::AddRegion(const char* name, b2Vec2 lowerBound, b2Vec2 upperBound)
+{
+	ReachRegion region;
+	region.name = name;
+	region.area.lowerBound = lowerBound;
+	region.area.upperBound = upperBound;
+	region.firstTick = -1;
+	region.fewestAbilities = REACH_ALL_ABILITIES;
+
+	regions.push_back(region);
+}
+
+bool ReachabilitySolver::Solve(const LevelDescription& level, const PlayerTuning& tuning, int maxNodes, int threadCount)
+{
+	Clear();
+
+	// the search heads for the collectable
+
+	bool hasGoal = false;
+
+	for (size_t i = 0; i < level.staticBodies.size(); i++)
+	{
+		if (level.staticBodies[i].objectType == COLLECTABLE)
+		{
+			goalPosition = level.staticBodies[i].position;
+			goalHalfSize = level.staticBodies[i].halfSize;
+			hasGoal = true;
+		}
+	}
+
+	if (!hasGoal)
+	{
+		return false;
+	}
+
+	groundedVelocity = tuning.groundedVelocity;
+
+	// box2d never moves a body further than b2_maxTranslation in a step
+	// so the heuristic can't overestimate, however fast a dash, jump or fall is
+
+	maxTickDistance = b2_maxTranslation;
+
+	// the collectable is touched before the centres meet
+
+	goalReach = level.player.halfSize.Length() + goalHalfSize.Length() + 2.0f * b2_polygonRadius;
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+
+	if (threadCount <= 0)
+	{
+		threadCount = 1;
+	}
+
+	threadsUsed = threadCount;
+
+	Timer timer;
+	timer.Start();
+
+	// one simulation for each thread, reset before every move
+
+	simulations = new LevelSimulation[threadCount];
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		simulations[i].Init(level, NULL, tuning, REACH_MOVE_TICKS);
+	}
+
+	// workers wait for each batch rather than being started for it
+	// the calling thread is the last of them
+
+	stopping = false;
+
+	for (int i = 0; i < threadCount - 1; i++)
+	{
+		workers.push_back(std::thread(&ReachabilitySolver::WorkerMain, this, i, batchNumber));
+	}
+
+	// starts where the level starts
+
+	Player& startPlayer = simulations[0].getPlayer();
+
+	ReachNode start;
+	start.position = level.player.position;
+	start.velocity = b2Vec2(0.0f, 0.0f);
+	start.states[0] = (unsigned char)startPlayer.getPlayerState();
+	start.states[1] = (unsigned char)startPlayer.getPlayerPreviousState();
+	start.states[2] = (unsigned char)startPlayer.getPlayerSecondPreviousState();
+	start.abilities = 0;
+	start.heldKeys = 0;
+	start.ticks = 0;
+	start.parent = -1;
+	start.move = 0;
+
+	nodes.push_back(start);
+	visited[MakeKey(start)] = 0;
+	RecordRegions(start);
+
+	std::priority_queue<ReachOpen> open;
+
+	ReachOpen first;
+	first.priority = Heuristic(start.position);
+	first.node = 0;
+	open.push(first);
+
+	while (!open.empty() && (int)nodes.size() < maxNodes)
+	{
+		// takes the cheapest nodes that could still beat the best route
+
+		batch.clear();
+
+		while (!open.empty() && (int)batch.size() < threadCount * REACH_BATCH_PER_THREAD)
+		{
+			ReachOpen top = open.top();
+			open.pop();
+
+			// left behind when a cheaper way to the same state was found
+
+			if (visited[MakeKey(nodes[top.node])] != top.node)
+			{
+				continue;
+			}
+
+			if (goalNode >= 0 && top.priority >= nodes[goalNode].ticks)
+			{
+				continue;
+			}
+
+			batch.push_back(top.node);
+		}
+
+		if (batch.empty())
+		{
+			break;
+		}
+
+		// the calling thread expands the last share itself
+
+		results.assign(batch.size() * REACH_MOVE_NUM, ReachResult());
+
+		if (!workers.empty())
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers = (int)workers.size();
+			batchNumber++;
+		}
+
+		wakeCondition.notify_all();
+
+		ExpandWorker(simulations[threadCount - 1], threadCount - 1, threadCount);
+
+		// waits for the workers to finish their shares
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+		}
+
+		expandedCount += (int)batch.size();
+
+		// merges the new states on this thread
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const ReachResult& result = results[i];
+
+			if (!result.valid)
+			{
+				continue;
+			}
+
+			uint64_t key = MakeKey(result.node);
+			std::unordered_map<uint64_t, int>::iterator found = visited.find(key);
+			int index;
+
+			if (found == visited.end())
+			{
+				index = (int)nodes.size();
+				nodes.push_back(result.node);
+				visited[key] = index;
+			}
+			else if (result.node.ticks < nodes[found->second].ticks)
+			{
+				// added as a new node so routes through the old one stay whole
+
+				index = (int)nodes.size();
+				nodes.push_back(result.node);
+				found->second = index;
+			}
+			else
+			{
+				continue;
+			}
+
+			RecordRegions(result.node);
+
+			if (result.won)
+			{
+				if (goalNode < 0 || result.node.ticks < nodes[goalNode].ticks)
+				{
+					goalNode = index;
+				}
+
+				continue;
+			}
+
+			ReachOpen next;
+			next.priority = result.node.ticks + Heuristic(result.node.position);
+			next.node = index;
+			open.push(next);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wakeCondition.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	workers.clear();
+
+	delete[] simulations;
+	simulations = NULL;
+
+	// the par time is only the fastest if nothing left open could still beat it
+
+	while (!open.empty() && visited[MakeKey(nodes[open.top().node])] != open.top().node)
+	{
+		open.pop();
+	}
+
+	parProven = goalNode >= 0 && (open.empty() || open.top().priority >= nodes[goalNode].ticks);
+
+	timer.GetTimeStop();
+	solveMS = timer.elapsedMS();
+
+	return goalNode >= 0;
+}
+
+void ReachabilitySolver::WorkerMain(int worker, unsigned int seenBatch)
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [this, seenBatch] { return stopping || batchNumber != seenBatch; });
+
+			if (stopping)
+			{
+				return;
+			}
+
+			seenBatch = batchNumber;
+		}
+
+		ExpandWorker(simulations[worker], worker, threadsUsed);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+
+		doneCondition.notify_one();
+	}
+}
+
+void ReachabilitySolver::ExpandWorker(LevelSimulation& simulation, int worker, int workerCount)
+{
+	// nodes are only read here, new ones are added after every thread finishes
+
+	for (size_t i = worker; i < batch.size(); i += workerCount)
+	{
+		const ReachNode& from = nodes[batch[i]];
+
+		for (int move = 0; move < REACH_MOVE_NUM; move++)
+		{
+			RunMove(simulation, from, batch[i], move, results[i * REACH_MOVE_NUM + move]);
+		}
+	}
+}
+
+void ReachabilitySolver::RunMove(LevelSimulation& simulation, const ReachNode& from, int fromIndex, int move, ReachResult& result)
+{
+	result.valid = false;
+	result.won = false;
+
+	simulation.Reset();
+	simulation.PlacePlayer(from.position, from.velocity, (PLAYER_STATE)from.states[0],
+		(PLAYER_STATE)from.states[1], (PLAYER_STATE)from.states[2], from.abilities);
+
+	unsigned char previous = from.heldKeys;
+	int ticks = 0;
+
+	while (ticks < REACH_MOVE_TICKS)
+	{
+		unsigned char keys = ticks == 0 ? MoveFirstKeys(move) : MoveHeldKeys(move);
+
+		simulation.Step(InputScript::KeysToInput(keys, previous));
+		previous = keys;
+		ticks++;
+
+		const SimulationResult& progress = simulation.getResult();
+
+		if (progress.playerHits > 0 || progress.died)
+		{
+			return;
+		}
+
+		if (progress.won)
+		{
+			result.won = true;
+			break;
+		}
+	}
+
+	Player& player = simulation.getPlayer();
+	b2Body* body = simulation.getPlayerBody();
+
+	ReachNode& node = result.node;
+	node.position = body->GetPosition();
+	node.velocity = body->GetLinearVelocity();
+	node.states[0] = (unsigned char)player.getPlayerState();
+	node.states[1] = (unsigned char)player.getPlayerPreviousState();
+	node.states[2] = (unsigned char)player.getPlayerSecondPreviousState();
+	node.abilities = (unsigned char)simulation.getAbilities();
+	node.heldKeys = previous;
+	node.ticks = from.ticks + ticks;
+	node.parent = fromIndex;
+	node.move = (unsigned char)move;
+
+	result.valid = true;
+}
+
+uint64_t ReachabilitySolver::MakeKey(const ReachNode& node) const
+{
+	int cellX = (int)floorf(node.position.x / REACH_CELL_SIZE);
+	int cellY = (int)floorf(node.position.y / REACH_CELL_SIZE);
+
+	// grounded velocities get a step to themselves
+
+	int stepX = (int)floorf(node.velocity.x / REACH_VELOCITY_STEP);
+	int stepY = 0;
+
+	if (node.velocity.y > groundedVelocity)
+	{
+		stepY = 1 + (int)((node.velocity.y - groundedVelocity) / REACH_VELOCITY_STEP);
+	}
+	else if (node.velocity.y < -groundedVelocity)
+	{
+		stepY = -1 - (int)((-node.velocity.y - groundedVelocity) / REACH_VELOCITY_STEP);
+	}
+
+	// 16 + 16 + 7 + 8 bits of position and velocity
+	// 12 bits of state history, 3 of abilities and 2 of held direction
+
+	uint64_t key = PackStep(cellX, 16);
+	key |= PackStep(cellY, 16) << 16;
+	key |= PackStep(stepX, 7) << 32;
+	key |= PackStep(stepY, 8) << 39;
+	key |= (uint64_t)(node.states[0] & 15) << 47;
+	key |= (uint64_t)(node.states[1] & 15) << 51;
+	key |= (uint64_t)(node.states[2] & 15) << 55;
+	key |= (uint64_t)(node.abilities & 7) << 59;
+	key |= (uint64_t)(node.heldKeys & (INPUT_LEFT | INPUT_RIGHT)) << 62;
+
+	return key;
+}
+
+float ReachabilitySolver::Heuristic(b2Vec2 position) const
+{
+	// ticks to get in touching distance moving as far as a body can each step
+
+	return b2Max(b2Distance(position, goalPosition) - goalReach, 0.0f) / maxTickDistance;
+}
+
+void ReachabilitySolver::RecordRegions(const ReachNode& node)
+{
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		ReachRegion& region = regions[i];
+		const b2AABB& area = region.area;
+
+		if (node.position.x < area.lowerBound.x || node.position.x > area.upperBound.x ||
+			node.position.y < area.lowerBound.y || node.position.y > area.upperBound.y)
+		{
+			continue;
+		}
+
+		if (region.firstTick < 0 || node.ticks < region.firstTick)
+		{
+			region.firstTick = node.ticks;
+		}
+
+		if (CountBits(node.abilities) < CountBits(region.fewestAbilities))
+		{
+			region.fewestAbilities = node.abilities;
+		}
+	}
+}
+
+bool ReachabilitySolver::BuildRoute(InputScript& script) const
+{
+	if (goalNode < 0)
+	{
+		return false;
+	}
+
+	std::vector<int> route;
+
+	for (int n = goalNode; nodes[n].parent >= 0; n = nodes[n].parent)
+	{
+		route.push_back(n);
+	}
+
+	script.Clear();
+
+	for (int i = (int)route.size() - 1; i >= 0; i--)
+	{
+		const ReachNode& node = nodes[route[i]];
+		int ticks = node.ticks - nodes[node.parent].ticks;
+
+		unsigned char firstKeys = MoveFirstKeys(node.move);
+		unsigned char heldKeys = MoveHeldKeys(node.move);
+
+		script.Add(1, (firstKeys & INPUT_LEFT) != 0, (firstKeys & INPUT_RIGHT) != 0,
+			(firstKeys & INPUT_JUMP) != 0, (firstKeys & INPUT_DASH) != 0);
+		script.Add(ticks - 1, (heldKeys & INPUT_LEFT) != 0, (heldKeys & INPUT_RIGHT) != 0, false, false);
+	}
+
+	return true;
+}
+
+float ReachabilitySolver::getParSeconds() const
+{
+	return goalNode >= 0 ? nodes[goalNode].ticks / REACH_TICKS_PER_SECOND : -1.0f;
+}
+
+void ReachabilitySolver::PrintReport() const
+{
+	if (goalNode >= 0)
+	{
+		LOG_INFO(LOG_GAME, "reachability: collectable reached, par time %.2fs (%i ticks), %s", getParSeconds(), nodes[goalNode].ticks,
+			parProven ? "fastest on the grid" : "upper bound as the search stopped early");
+	}
+	else
+	{
+		LOG_INFO(LOG_GAME, "reachability: collectable not reached");
+	}
+
+	LOG_INFO(LOG_GAME, "reachability: %i states found, %i expanded on %i threads in %.1fms",
+		(int)nodes.size(), expandedCount, threadsUsed, solveMS);
+
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		const ReachRegion& region = regions[i];
+
+		if (region.firstTick < 0)
+		{
+			LOG_INFO(LOG_GAME, "reachability: %s not reached", region.name);
+			continue;
+		}
+
+		LOG_INFO(LOG_GAME, "reachability: %s reached at %.2fs%s", region.name,
+			region.firstTick / REACH_TICKS_PER_SECOND, region.fewestAbilities == 0 ? " with no abilities" : "");
+
+		// one line for each ability needed
+		// the logger formats later on its own thread, so only lasting strings are passed
+
+		for (int a = 0; a < PICKUP_ABILITY_NUM; a++)
+		{
+			if (region.fewestAbilities & (1 << a))
+			{
+				LOG_INFO(LOG_GAME, "reachability: %s needs %s", region.name, AbilityEventQueue::AbilityName((PICKUP_ABILITY)a));
+			}
+		}
+	}
+}
+
+void ReachabilitySolver::Clear()
+{
+	nodes.clear();
+	visited.clear();
+
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		regions[i].firstTick = -1;
+		regions[i].fewestAbilities = REACH_ALL_ABILITIES;
+	}
+
+	goalNode = -1;
+	parProven = false;
+	expandedCount = 0;
+	threadsUsed = 0;
+	solveMS = 0.0;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "LevelSimulation.h"
+
+// reachability region
+// an area of the level reported on by the solver
+
+struct ReachRegion
+{
+	const char* name;
+	b2AABB area;
+
+	// earliest tick the player got into the region, -1 if never
+	int firstTick;
+
+	// fewest abilities, one bit per PICKUP_ABILITY, the region was reached with
+	unsigned int fewestAbilities;
+};
+
+// reachability solver
+// searches the level for a route to the collectable using the real player physics
+// player states are snapped to a grid of position, velocity, state history,
+// abilities and held direction, and each grid state is only expanded once
+// a state is expanded by placing the player in a simulation and
+// holding each move for a short time, spread across threads in batches
+// the threads are started once for each search and wait between batches
+// the par time is the fastest route between grid states, not between every
+// possible input, and only an upper bound if the search stops at maxNodes first
+//
+// moving platforms and enemies start their routes again for every move
+// so routes that need them at a certain point are approximate
+// moves that hurt the player aren't followed
+
+class ReachabilitySolver
+{
+public:
+
+	// reachability solver constructor
+
+	ReachabilitySolver();
+
+	// adds an area to report on
+
+	void AddRegion(const char* name, b2Vec2 lowerBound, b2Vec2 upperBound);
+
+	// searches from the player's start until the collectable is reached
+	// by the fastest route on the grid, or maxNodes states have been found
+	// threads at 0 uses one per core
+	// returns true if the collectable was reached
+
+	bool Solve(const LevelDescription& level, const PlayerTuning& tuning, int maxNodes, int threadCount = 0);
+
+	// writes the moves of the fastest route found as an input script
+
+	bool BuildRoute(InputScript& script) const;
+
+	// prints the par time, search size and each region
+
+	void PrintReport() const;
+
+	// forgets the last search, regions are kept
+
+	void Clear();
+
+	// getters
+
+	bool isReachable() const { return goalNode >= 0; }
+	bool isParProven() const { return parProven; }
+	float getParSeconds() const;
+	int getNodeCount() const { return (int)nodes.size(); }
+	const ReachRegion& getRegion(int index) const { return regions[index]; }
+
+private:
+
+	// one grid state found by the search
+	struct ReachNode
+	{
+		b2Vec2 position;
+		b2Vec2 velocity;
+		unsigned char states[3];
+		unsigned char abilities;
+		unsigned char heldKeys;
+		int ticks;
+		int parent;
+		unsigned char move;
+	};
+
+	// a node waiting to be expanded, cheapest first
+	struct ReachOpen
+	{
+		float priority;
+		int node;
+
+		bool operator<(const ReachOpen& other) const { return priority > other.priority; }
+	};
+
+	// the state a move ended in
+	struct ReachResult
+	{
+		ReachNode node;
+		bool valid;
+		bool won;
+	};
+
+	// expands the batch nodes given to one thread
+	void ExpandWorker(LevelSimulation& simulation, int worker, int workerCount);
+
+	// worker thread loop, waits for a batch after the one given then expands its share
+	void WorkerMain(int worker, unsigned int seenBatch);
+
+	// runs one move from a node in the simulation
+	void RunMove(LevelSimulation& simulation, const ReachNode& from, int fromIndex, int move, ReachResult& result);
+
+	// packs the grid state of a node into a key
+	uint64_t MakeKey(const ReachNode& node) const;
+
+	// estimated ticks left to reach the collectable
+	float Heuristic(b2Vec2 position) const;
+
+	// updates the regions with a newly found node
+	void RecordRegions(const ReachNode& node);
+
+	// reachability solver variables
+
+	std::vector<ReachRegion> regions;
+
+	std::vector<ReachNode> nodes;
+	std::unordered_map<uint64_t, int> visited;
+
+	b2Vec2 goalPosition;
+	b2Vec2 goalHalfSize;
+	float groundedVelocity;
+
+	// distance between the player's and collectable's centres when they touch
+	float goalReach;
+
+	// furthest any body moves in one tick
+	float maxTickDistance;
+
+	int goalNode;
+
+	// no open state could still beat the par time
+	bool parProven;
+
+	int expandedCount;
+	int threadsUsed;
+	double solveMS;
+
+	// the nodes being expanded and the states their moves ended in
+	std::vector<int> batch;
+	std::vector<ReachResult> results;
+
+	// one simulation for each thread, only set while solving
+	LevelSimulation* simulations;
+
+	// worker threads
+	// batchNumber goes up to wake them for each batch
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	unsigned int batchNumber;
+	int busyWorkers;
+	bool stopping;
+};
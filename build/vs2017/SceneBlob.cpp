@@ -0,0 +1,478 @@
+#include "SceneBlob.h"
+#include "MeshLod.h"
+#include "load_texture.h"
+#include <graphics/scene.h>
+#include <graphics/mesh.h>
+#include <graphics/primitive.h>
+#include <graphics/material.h>
+#include <graphics/texture.h>
+#include <system/platform.h>
+#include <system/debug_log.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <map>
+
+// alignment of the vertex and index data in the blob
+
+#define SCENE_BLOB_ALIGNMENT 16
+
+#define NO_MATERIAL 0xffffffff
+
+namespace
+{
+	// scene blob writer
+	// appends data to the blob and returns where it went
+
+	class BlobWriter
+	{
+	public:
+
+		unsigned int Append(const void* data, size_t size, size_t alignment)
+		{
+			while (bytes.size() % alignment != 0)
+			{
+				bytes.push_back(0);
+			}
+
+			unsigned int offset = (unsigned int)bytes.size();
+			bytes.resize(bytes.size() + size);
+
+			if (data)
+			{
+				memcpy(&bytes[offset], data, size);
+			}
+
+			return offset;
+		}
+
+		unsigned int AppendString(const std::string& text)
+		{
+			return Append(text.c_str(), text.size() + 1, 1);
+		}
+
+		template<class T>
+		T* At(unsigned int offset)
+		{
+			return (T*)&bytes[offset];
+		}
+
+		std::vector<unsigned char> bytes;
+	};
+
+	// strips the authoring folders from a texture path
+	// G:/project/media/spike.png becomes spike.png
+
+	std::string RelativeTexturePath(const std::string& path)
+	{
+		std::string::size_type slash = path.find_last_of("/\\");
+
+		if (slash == std::string::npos)
+		{
+			return path;
+		}
+
+		return path.substr(slash + 1);
+	}
+
+	// a material as stored in the blob
+	// used to share materials between the scenes cooked together
+
+	typedef std::pair<unsigned int, std::string> MaterialKey;
+
+	// checks count elements of the size given starting at offset are inside the blob
+	// worked out in 64 bits so large counts can't wrap around
+
+	bool InBlob(unsigned int offset, unsigned int count, unsigned int elementSize, size_t blobSize)
+	{
+		unsigned long long end = (unsigned long long)offset + (unsigned long long)count * elementSize;
+
+		return end <= blobSize;
+	}
+
+	// checks a string starting at offset ends inside the blob
+
+	bool StringInBlob(const unsigned char* blob, unsigned int offset, size_t blobSize)
+	{
+		return offset < blobSize && memchr(blob + offset, 0, blobSize - offset) != NULL;
+	}
+
+	// checks every offset and count in the blob before any of it is read
+	// so a truncated or corrupt file is turned away rather than read past its end
+
+	bool ValidateBlob(const unsigned char* blob, size_t blobSize)
+	{
+		const SceneBlobHeader* header = (const SceneBlobHeader*)blob;
+
+		if (!InBlob(header->materialsOffset, header->materialCount, sizeof(SceneBlobMaterial), blobSize) ||
+			!InBlob(header->meshesOffset, header->meshCount, sizeof(SceneBlobMesh), blobSize))
+		{
+			return false;
+		}
+
+		const SceneBlobMaterial* blobMaterials = (const SceneBlobMaterial*)(blob + header->materialsOffset);
+
+		for (unsigned int i = 0; i < header->materialCount; i++)
+		{
+			if (blobMaterials[i].textureNameOffset != 0 && !StringInBlob(blob, blobMaterials[i].textureNameOffset, blobSize))
+			{
+				return false;
+			}
+		}
+
+		const SceneBlobMesh* blobMeshes = (const SceneBlobMesh*)(blob + header->meshesOffset);
+
+		for (unsigned int m = 0; m < header->meshCount; m++)
+		{
+			const SceneBlobMesh& blobMesh = blobMeshes[m];
+
+			// element sizes come from the file as well, so are checked before the ranges using them
+
+			if (blobMesh.vertexByteSize == 0)
+			{
+				return false;
+			}
+
+			if (!InBlob(blobMesh.verticesOffset, blobMesh.vertexCount, blobMesh.vertexByteSize, blobSize) ||
+				!InBlob(blobMesh.primitivesOffset, blobMesh.primitiveCount, sizeof(SceneBlobPrimitive), blobSize))
+			{
+				return false;
+			}
+
+			const SceneBlobPrimitive* blobPrimitives = (const SceneBlobPrimitive*)(blob + blobMesh.primitivesOffset);
+
+			for (unsigned int p = 0; p < blobMesh.primitiveCount; p++)
+			{
+				// index buffers are only ever 16 or 32 bit
+
+				if (blobPrimitives[p].indexByteSize != 2 && blobPrimitives[p].indexByteSize != 4)
+				{
+					return false;
+				}
+
+				if (!InBlob(blobPrimitives[p].indicesOffset, blobPrimitives[p].indexCount, blobPrimitives[p].indexByteSize, blobSize))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+}
+
+// scene blob constructor
+
+SceneBlob::SceneBlob()
+{
+}
+
+SceneBlob::~SceneBlob()
+{
+	CleanUp();
+}
+
+bool SceneBlob::Load(gef::Platform& platform, const char* filename)
+{
+	CleanUp();
+
+	FILE* file = fopen(filename, "rb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if (fileSize < (long)sizeof(SceneBlobHeader))
+	{
+		fclose(file);
+		return false;
+	}
+
+	// the whole file in one read
+	// the buffer is over allocated and the blob placed at the first 16 byte boundary in it
+	// as the heap only promises 8 on some platforms, so the data inside stays aligned
+
+	std::vector<unsigned char> buffer(fileSize + SCENE_BLOB_ALIGNMENT - 1);
+	unsigned char* blob = &buffer[0];
+
+	while ((size_t)blob % SCENE_BLOB_ALIGNMENT != 0)
+	{
+		blob++;
+	}
+
+	size_t bytesRead = fread(blob, 1, fileSize, file);
+	fclose(file);
+
+	const SceneBlobHeader* header = (const SceneBlobHeader*)blob;
+
+	if (bytesRead != (size_t)fileSize || header->magic != SCENE_BLOB_MAGIC || header->version != SCENE_BLOB_VERSION || header->fileSize != (unsigned int)fileSize)
+	{
+		gef::DebugOut("scene blob: %s is not a version %i scene blob\n", filename, SCENE_BLOB_VERSION);
+		return false;
+	}
+
+	if (!ValidateBlob(blob, (size_t)fileSize))
+	{
+		gef::DebugOut("scene blob: %s is truncated or corrupt\n", filename);
+		return false;
+	}
+
+	// materials and their textures
+
+	const SceneBlobMaterial* blobMaterials = (const SceneBlobMaterial*)(blob + header->materialsOffset);
+
+	for (unsigned int i = 0; i < header->materialCount; i++)
+	{
+		gef::Material* material = new gef::Material();
+		material->set_colour(blobMaterials[i].colour);
+
+		if (blobMaterials[i].textureNameOffset != 0)
+		{
+			gef::Texture* texture = CreateTextureFromPNG((const char*)(blob + blobMaterials[i].textureNameOffset), platform);
+
+			if (texture)
+			{
+				textures.push_back(texture);
+				material->set_texture(texture);
+			}
+		}
+
+		materials.push_back(material);
+	}
+
+	// meshes straight from the blob data
+
+	const SceneBlobMesh* blobMeshes = (const SceneBlobMesh*)(blob + header->meshesOffset);
+
+	for (unsigned int m = 0; m < header->meshCount; m++)
+	{
+		const SceneBlobMesh& blobMesh = blobMeshes[m];
+
+		gef::Mesh* mesh = gef::Mesh::Create(platform);
+		mesh->InitVertexBuffer(platform, blob + blobMesh.verticesOffset, blobMesh.vertexCount, blobMesh.vertexByteSize);
+		mesh->AllocatePrimitives(blobMesh.primitiveCount);
+
+		const SceneBlobPrimitive* blobPrimitives = (const SceneBlobPrimitive*)(blob + blobMesh.primitivesOffset);
+		int triangleCount = 0;
+
+		for (unsigned int p = 0; p < blobMesh.primitiveCount; p++)
+		{
+			gef::Primitive* primitive = mesh->GetPrimitive(p);
+			primitive->set_type(gef::TRIANGLE_LIST);
+
+			if (blobPrimitives[p].indexCount > 0)
+			{
+				primitive->InitIndexBuffer(platform, blob + blobPrimitives[p].indicesOffset, blobPrimitives[p].indexCount, blobPrimitives[p].indexByteSize);
+			}
+
+			if (blobPrimitives[p].materialIndex < materials.size())
+			{
+				primitive->set_material(materials[blobPrimitives[p].materialIndex]);
+			}
+
+			triangleCount += blobPrimitives[p].indexCount / 3;
+		}
+
+		mesh->set_aabb(gef::Aabb(gef::Vector4(blobMesh.aabbMin[0], blobMesh.aabbMin[1], blobMesh.aabbMin[2]),
+			gef::Vector4(blobMesh.aabbMax[0], blobMesh.aabbMax[1], blobMesh.aabbMax[2])));
+		mesh->set_bounding_sphere(gef::Sphere(gef::Vector4(blobMesh.sphereCentre[0], blobMesh.sphereCentre[1], blobMesh.sphereCentre[2]), blobMesh.sphereRadius));
+
+		meshes.push_back(mesh);
+		triangleCounts.push_back(triangleCount);
+	}
+
+	// the gpu buffers hold their own copy so the blob is freed here
+
+	return !meshes.empty();
+}
+
+void SceneBlob::CleanUp()
+{
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		delete meshes[i];
+	}
+
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		delete materials[i];
+	}
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		delete textures[i];
+	}
+
+	meshes.clear();
+	triangleCounts.clear();
+	materials.clear();
+	textures.clear();
+}
+
+gef::Mesh* SceneBlob::GetMesh(int index) const
+{
+	if (index < 0 || index >= (int)meshes.size())
+	{
+		return NULL;
+	}
+
+	return meshes[index];
+}
+
+int SceneBlob::getTriangleCount(int index) const
+{
+	if (index < 0 || index >= (int)triangleCounts.size())
+	{
+		return 0;
+	}
+
+	return triangleCounts[index];
+}
+
+// reads name.scn and any name_lodN.scn
+// and writes the first mesh of each into one blob
+
+bool SceneBlob::Cook(gef::Platform& platform, const char* sceneFilename, const char* blobFilename)
+{
+	std::vector<gef::Scene*> scenes;
+
+	for (int lod = 0; lod < MESH_LOD_NUM; lod++)
+	{
+		std::string filename = lod == 0 ? std::string(sceneFilename) : MeshLod::LodFilename(sceneFilename, lod);
+		gef::Scene* scene = new gef::Scene();
+
+		if (!scene->ReadSceneFromFile(platform, filename.c_str()) || scene->mesh_data.empty())
+		{
+			delete scene;
+
+			if (lod == 0)
+			{
+				gef::DebugOut("scene blob: could not read %s\n", filename.c_str());
+				return false;
+			}
+
+			break;
+		}
+
+		scenes.push_back(scene);
+	}
+
+	BlobWriter writer;
+	unsigned int headerOffset = writer.Append(NULL, sizeof(SceneBlobHeader), SCENE_BLOB_ALIGNMENT);
+
+	// the tables are written first so their offsets don't move
+	// and are filled in as the data after them is appended
+
+	unsigned int meshCount = (unsigned int)scenes.size();
+	unsigned int meshesOffset = writer.Append(NULL, meshCount * sizeof(SceneBlobMesh), SCENE_BLOB_ALIGNMENT);
+
+	std::vector<SceneBlobMaterial> blobMaterials;
+	std::map<MaterialKey, unsigned int> materialIndices;
+
+	for (unsigned int m = 0; m < meshCount; m++)
+	{
+		gef::Scene* scene = scenes[m];
+		const gef::MeshData& meshData = scene->mesh_data.front();
+
+		SceneBlobMesh blobMesh;
+		blobMesh.aabbMin[0] = meshData.aabb.min_vtx().x();
+		blobMesh.aabbMin[1] = meshData.aabb.min_vtx().y();
+		blobMesh.aabbMin[2] = meshData.aabb.min_vtx().z();
+		blobMesh.aabbMax[0] = meshData.aabb.max_vtx().x();
+		blobMesh.aabbMax[1] = meshData.aabb.max_vtx().y();
+		blobMesh.aabbMax[2] = meshData.aabb.max_vtx().z();
+		blobMesh.sphereCentre[0] = meshData.bounding_sphere.position().x();
+		blobMesh.sphereCentre[1] = meshData.bounding_sphere.position().y();
+		blobMesh.sphereCentre[2] = meshData.bounding_sphere.position().z();
+		blobMesh.sphereRadius = meshData.bounding_sphere.radius();
+		blobMesh.vertexCount = meshData.vertex_data.num_vertices;
+		blobMesh.vertexByteSize = meshData.vertex_data.vertex_byte_size;
+		blobMesh.verticesOffset = writer.Append(meshData.vertex_data.vertices,
+			meshData.vertex_data.num_vertices * meshData.vertex_data.vertex_byte_size, SCENE_BLOB_ALIGNMENT);
+		blobMesh.primitiveCount = (unsigned int)meshData.primitives.size();
+		blobMesh.primitivesOffset = writer.Append(NULL, blobMesh.primitiveCount * sizeof(SceneBlobPrimitive), SCENE_BLOB_ALIGNMENT);
+
+		for (unsigned int p = 0; p < blobMesh.primitiveCount; p++)
+		{
+			const gef::PrimitiveData* primitive = meshData.primitives[p];
+
+			SceneBlobPrimitive blobPrimitive;
+			blobPrimitive.indexCount = primitive->num_indices;
+			blobPrimitive.indexByteSize = primitive->index_byte_size;
+			blobPrimitive.indicesOffset = writer.Append(primitive->indices, primitive->num_indices * primitive->index_byte_size, SCENE_BLOB_ALIGNMENT);
+			blobPrimitive.materialIndex = NO_MATERIAL;
+
+			// resolves the primitive's material from its name
+			// materials the same in every scene are stored once
+
+			for (std::list<gef::MaterialData>::const_iterator materialData = scene->material_data.begin(); materialData != scene->material_data.end(); ++materialData)
+			{
+				if (materialData->name_id != primitive->material_name_id)
+				{
+					continue;
+				}
+
+				MaterialKey key(materialData->colour, RelativeTexturePath(materialData->diffuse_texture));
+				std::map<MaterialKey, unsigned int>::iterator found = materialIndices.find(key);
+
+				if (found != materialIndices.end())
+				{
+					blobPrimitive.materialIndex = found->second;
+				}
+				else
+				{
+					SceneBlobMaterial blobMaterial;
+					blobMaterial.colour = key.first;
+					blobMaterial.textureNameOffset = key.second.empty() ? 0 : writer.AppendString(key.second);
+
+					blobPrimitive.materialIndex = (unsigned int)blobMaterials.size();
+					materialIndices[key] = blobPrimitive.materialIndex;
+					blobMaterials.push_back(blobMaterial);
+				}
+
+				break;
+			}
+
+			*writer.At<SceneBlobPrimitive>(blobMesh.primitivesOffset + p * sizeof(SceneBlobPrimitive)) = blobPrimitive;
+		}
+
+		*writer.At<SceneBlobMesh>(meshesOffset + m * sizeof(SceneBlobMesh)) = blobMesh;
+	}
+
+	unsigned int materialsOffset = writer.Append(blobMaterials.empty() ? NULL : &blobMaterials[0],
+		blobMaterials.size() * sizeof(SceneBlobMaterial), SCENE_BLOB_ALIGNMENT);
+
+	SceneBlobHeader* header = writer.At<SceneBlobHeader>(headerOffset);
+	header->magic = SCENE_BLOB_MAGIC;
+	header->version = SCENE_BLOB_VERSION;
+	header->fileSize = (unsigned int)writer.bytes.size();
+	header->meshCount = meshCount;
+	header->meshesOffset = meshesOffset;
+	header->materialCount = (unsigned int)blobMaterials.size();
+	header->materialsOffset = materialsOffset;
+
+	for (size_t i = 0; i < scenes.size(); i++)
+	{
+		delete scenes[i];
+	}
+
+	FILE* file = fopen(blobFilename, "wb");
+
+	if (!file)
+	{
+		gef::DebugOut("scene blob: could not write %s\n", blobFilename);
+		return false;
+	}
+
+	fwrite(&writer.bytes[0], 1, writer.bytes.size(), file);
+	fclose(file);
+
+	gef::DebugOut("scene blob: wrote %s, %i meshes, %u bytes\n", blobFilename, meshCount, (unsigned int)writer.bytes.size());
+
+	return true;
+}
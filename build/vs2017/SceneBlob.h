@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+
+namespace gef
+{
+	class Platform;
+	class Mesh;
+	class Material;
+	class Texture;
+}
+
+// scene blob file identifier and version
+// the version changes whenever the layout below does
+
+#define SCENE_BLOB_MAGIC 0x424c4253
+#define SCENE_BLOB_VERSION 1
+
+// every offset in a scene blob is in bytes from the start of the file
+// so the file can be read anywhere in memory and used in place
+
+struct SceneBlobHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int fileSize;
+	unsigned int meshCount;
+	unsigned int meshesOffset;
+	unsigned int materialCount;
+	unsigned int materialsOffset;
+};
+
+// texture name is relative to the media folder
+// zero offset means no texture
+
+struct SceneBlobMaterial
+{
+	unsigned int colour;
+	unsigned int textureNameOffset;
+};
+
+struct SceneBlobMesh
+{
+	float aabbMin[3];
+	float aabbMax[3];
+	float sphereCentre[3];
+	float sphereRadius;
+	unsigned int vertexCount;
+	unsigned int vertexByteSize;
+	unsigned int verticesOffset;
+	unsigned int primitiveCount;
+	unsigned int primitivesOffset;
+};
+
+// material index is into the blob's materials
+// no material is 0xffffffff
+
+struct SceneBlobPrimitive
+{
+	unsigned int indexCount;
+	unsigned int indexByteSize;
+	unsigned int indicesOffset;
+	unsigned int materialIndex;
+};
+
+// scene blob
+// flat, relocatable mesh file cooked offline from .scn files
+// loading it is one file read, the vertex and index data
+// is aligned so it goes straight to the gpu buffers
+//
+// a blob cooked from name.scn holds one mesh for each level of detail
+// mesh 0 from name.scn, then the first mesh of each name_lodN.scn found
+
+class SceneBlob
+{
+public:
+
+	// scene blob constructor
+
+	SceneBlob();
+	~SceneBlob();
+
+	// reads the blob and creates its textures, materials and meshes
+	// returns false if the file is missing or was cooked by another version
+
+	bool Load(gef::Platform& platform, const char* filename);
+
+	// frees everything created by Load
+
+	void CleanUp();
+
+	// getters for the loaded meshes
+
+	int getMeshCount() const { return (int)meshes.size(); }
+	gef::Mesh* GetMesh(int index) const;
+	int getTriangleCount(int index) const;
+
+	// offline step
+	// cooks a .scn file and its lod files into a scene blob
+	// returns false if the scene could not be read or the blob written
+
+	static bool Cook(gef::Platform& platform, const char* sceneFilename, const char* blobFilename);
+
+private:
+
+	// scene blob is not copyable as it owns its meshes
+	SceneBlob(const SceneBlob&);
+	SceneBlob& operator=(const SceneBlob&);
+
+	// scene blob variables
+
+	std::vector<gef::Mesh*> meshes;
+	std::vector<int> triangleCounts;
+	std::vector<gef::Material*> materials;
+	std::vector<gef::Texture*> textures;
+};
+
@@ -0,0 +1,128 @@
+#include "SimulationFarm.h"
+#include "Timer.h"
+#include "Logger.h"
+#include <thread>
+
+// simulation farm constructor
+// initialising simulation farm values
+
+SimulationFarm::SimulationFarm()
+{
+	threadsUsed = 0;
+	totalTicks = 0;
+	runMS = 0.0;
+	ticksPerSecond = 0.0;
+}
+
+void SimulationFarm::AddWorld(const InputScript* script, const PlayerTuning& tuning)
+{
+	FarmWorld world;
+	world.script = script;
+	world.tuning = tuning;
+
+	worlds.push_back(world);
+}
+
+void SimulationFarm::Run(const LevelDescription& level, int maxTicks, int threadCount)
+{
+	if (worlds.empty())
+	{
+		return;
+	}
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+
+	if (threadCount <= 0)
+	{
+		threadCount = 1;
+	}
+
+	if (threadCount > (int)worlds.size())
+	{
+		threadCount = (int)worlds.size();
+	}
+
+	threadsUsed = threadCount;
+
+	Timer timer;
+	timer.Start();
+
+	// the calling thread runs the last share itself
+
+	std::vector<std::thread> workers;
+
+	for (int i = 0; i < threadCount - 1; i++)
+	{
+		workers.push_back(std::thread(&SimulationFarm::RunWorker, this, std::cref(level), maxTicks, i, threadCount));
+	}
+
+	RunWorker(level, maxTicks, threadCount - 1, threadCount);
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	timer.GetTimeStop();
+	runMS = timer.elapsedMS();
+
+	totalTicks = 0;
+
+	for (size_t i = 0; i < worlds.size(); i++)
+	{
+		totalTicks += worlds[i].result.ticks;
+	}
+
+	ticksPerSecond = runMS > 0.0 ? totalTicks * 1000.0 / runMS : 0.0;
+}
+
+void SimulationFarm::RunWorker(const LevelDescription& level, int maxTicks, int worker, int workerCount)
+{
+	// one simulation is reused for each world this thread runs
+	// its world is built, run to the end and released before the next
+
+	LevelSimulation simulation;
+
+	for (size_t i = worker; i < worlds.size(); i += workerCount)
+	{
+		simulation.Init(level, worlds[i].script, worlds[i].tuning, maxTicks);
+
+		while (simulation.Step())
+		{
+		}
+
+		worlds[i].result = simulation.getResult();
+		simulation.Release();
+	}
+}
+
+void SimulationFarm::PrintReport() const
+{
+	LOG_INFO(LOG_GAME, "simulation farm: %i worlds on %i threads, %lld ticks in %.1fms, %.0f ticks/s",
+		(int)worlds.size(), threadsUsed, totalTicks, runMS, ticksPerSecond);
+
+	for (size_t i = 0; i < worlds.size(); i++)
+	{
+		const SimulationResult& result = worlds[i].result;
+		const char* outcome = result.won ? "won" : (result.died ? "died" : "timed out");
+
+		// split in two as the logger takes eight values at most
+
+		LOG_INFO(LOG_GAME, "simulation farm: world %i jump %.1f, %s after %i ticks, health %i, hits %i, abilities %i",
+			(int)i, worlds[i].tuning.jumpValue, outcome, result.ticks, result.health, result.playerHits, result.abilitiesAcquired);
+		LOG_INFO(LOG_GAME, "simulation farm: world %i end (%.1f, %.1f), highest %.1f",
+			(int)i, result.finalPosition.x, result.finalPosition.y, result.highestY);
+	}
+}
+
+void SimulationFarm::Clear()
+{
+	worlds.clear();
+	threadsUsed = 0;
+	totalTicks = 0;
+	runMS = 0.0;
+	ticksPerSecond = 0.0;
+}
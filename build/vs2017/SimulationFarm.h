@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include "LevelSimulation.h"
+
+// simulation farm
+// runs many copies of the level at once, one per input script and tuning
+// each copy has its own world so worker threads never share physics state
+// used to test tuning and scripted runs far faster than playing them
+
+class SimulationFarm
+{
+public:
+
+	// simulation farm constructor
+
+	SimulationFarm();
+
+	// adds a copy of the level to run
+	// the script must outlive the farm's run
+
+	void AddWorld(const InputScript* script, const PlayerTuning& tuning);
+
+	// runs every world until it finishes or reaches the tick limit
+	// worlds are split evenly between the threads, 0 uses one per core
+	// returns once all of them are done
+
+	void Run(const LevelDescription& level, int maxTicks, int threadCount = 0);
+
+	// prints ticks per second and how each world finished
+
+	void PrintReport() const;
+
+	// forgets every world and result
+
+	void Clear();
+
+	// getters
+
+	int getWorldCount() const { return (int)worlds.size(); }
+	const SimulationResult& getResult(int index) const { return worlds[index].result; }
+	double getTicksPerSecond() const { return ticksPerSecond; }
+
+private:
+
+	// one world to run and how it finished
+	struct FarmWorld
+	{
+		const InputScript* script;
+		PlayerTuning tuning;
+		SimulationResult result;
+	};
+
+	// runs every world given to one thread
+	void RunWorker(const LevelDescription& level, int maxTicks, int worker, int workerCount);
+
+	// simulation farm variables
+
+	std::vector<FarmWorld> worlds;
+
+	int threadsUsed;
+	long long totalTicks;
+	double runMS;
+	double ticksPerSecond;
+};
@@ -0,0 +1,588 @@
+#include "SpatialHash.h"
+#include "Timer.h"
+#include <system/debug_log.h>
+#include <math.h>
+#include <float.h>
+#include <stdlib.h>
+
+// objects covering more cells than this are kept in a list
+// checked by every query instead of filling the buckets
+// the level borders span the whole level
+
+#define MAX_CELLS_PER_OBJECT 64
+
+// longest ray walked through the grid, in cells
+
+#define MAX_RAY_CELLS 1024
+
+// large primes used to hash cell coordinates
+
+#define CELL_HASH_X 73856093
+#define CELL_HASH_Y 19349663
+
+// returns true if the two boxes overlap
+
+static bool Overlaps(const b2AABB& a, const b2AABB& b)
+{
+	return a.lowerBound.x <= b.upperBound.x && a.upperBound.x >= b.lowerBound.x &&
+		a.lowerBound.y <= b.upperBound.y && a.upperBound.y >= b.lowerBound.y;
+}
+
+// returns the squared distance from a point to the closest point of a box
+// zero if the point is inside it
+
+static float DistanceSquared(b2Vec2 point, const b2AABB& box)
+{
+	float dx = point.x < box.lowerBound.x ? box.lowerBound.x - point.x :
+		(point.x > box.upperBound.x ? point.x - box.upperBound.x : 0.0f);
+	float dy = point.y < box.lowerBound.y ? box.lowerBound.y - point.y :
+		(point.y > box.upperBound.y ? point.y - box.upperBound.y : 0.0f);
+
+	return dx * dx + dy * dy;
+}
+
+// returns the fraction along the ray p1 + t * d where it enters the box
+// or a negative value if it misses within t = 0 to 1
+
+static float RayBoxFraction(b2Vec2 p1, b2Vec2 d, const b2AABB& box)
+{
+	float tMin = 0.0f;
+	float tMax = 1.0f;
+
+	float origin[2] = { p1.x, p1.y };
+	float direction[2] = { d.x, d.y };
+	float lower[2] = { box.lowerBound.x, box.lowerBound.y };
+	float upper[2] = { box.upperBound.x, box.upperBound.y };
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (fabsf(direction[axis]) < FLT_EPSILON)
+		{
+			// parallel to this slab, misses if outside it
+
+			if (origin[axis] < lower[axis] || origin[axis] > upper[axis])
+			{
+				return -1.0f;
+			}
+		}
+		else
+		{
+			float inverse = 1.0f / direction[axis];
+			float t1 = (lower[axis] - origin[axis]) * inverse;
+			float t2 = (upper[axis] - origin[axis]) * inverse;
+
+			if (t1 > t2)
+			{
+				float temp = t1;
+				t1 = t2;
+				t2 = temp;
+			}
+
+			tMin = t1 > tMin ? t1 : tMin;
+			tMax = t2 < tMax ? t2 : tMax;
+
+			if (tMin > tMax)
+			{
+				return -1.0f;
+			}
+		}
+	}
+
+	return tMin;
+}
+
+// spatial hash constructor
+// initialising spatial hash values
+
+SpatialHash::SpatialHash(float cellSize, int bucketCount)
+{
+	this->cellSize = cellSize;
+	inverseCellSize = 1.0f / cellSize;
+	queryStamp = 0;
+	objectCount = 0;
+
+	buckets.resize(bucketCount);
+}
+
+int SpatialHash::Insert(GameObject* object, const b2AABB& box, unsigned int category)
+{
+	int handle;
+
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		handle = (int)entries.size();
+		entries.push_back(Entry());
+	}
+
+	Entry& entry = entries[handle];
+	entry.object = object;
+	entry.box = box;
+	entry.category = category;
+	entry.minX = CellCoord(box.lowerBound.x);
+	entry.minY = CellCoord(box.lowerBound.y);
+	entry.maxX = CellCoord(box.upperBound.x);
+	entry.maxY = CellCoord(box.upperBound.y);
+	entry.queryStamp = queryStamp;
+	entry.inUse = true;
+
+	AddToCells(handle);
+	objectCount++;
+
+	return handle;
+}
+
+int SpatialHash::InsertBody(GameObject* object, const b2Body* body, unsigned int category)
+{
+	return Insert(object, ComputeBodyAABB(body), category);
+}
+
+void SpatialHash::Move(int handle, const b2AABB& box)
+{
+	if (handle < 0 || handle >= (int)entries.size() || !entries[handle].inUse)
+	{
+		return;
+	}
+
+	Entry& entry = entries[handle];
+
+	int minX = CellCoord(box.lowerBound.x);
+	int minY = CellCoord(box.lowerBound.y);
+	int maxX = CellCoord(box.upperBound.x);
+	int maxY = CellCoord(box.upperBound.y);
+
+	// most frames a mover stays within the same cells
+	// so only its box needs changing
+
+	if (minX == entry.minX && minY == entry.minY && maxX == entry.maxX && maxY == entry.maxY)
+	{
+		entry.box = box;
+		return;
+	}
+
+	RemoveFromCells(handle);
+
+	entry.box = box;
+	entry.minX = minX;
+	entry.minY = minY;
+	entry.maxX = maxX;
+	entry.maxY = maxY;
+
+	AddToCells(handle);
+}
+
+void SpatialHash::MoveBody(int handle, const b2Body* body)
+{
+	Move(handle, ComputeBodyAABB(body));
+}
+
+void SpatialHash::Remove(int handle)
+{
+	if (handle < 0 || handle >= (int)entries.size() || !entries[handle].inUse)
+	{
+		return;
+	}
+
+	RemoveFromCells(handle);
+
+	entries[handle].inUse = false;
+	entries[handle].object = NULL;
+	freeHandles.push_back(handle);
+	objectCount--;
+}
+
+void SpatialHash::Clear()
+{
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		buckets[i].clear();
+	}
+
+	entries.clear();
+	freeHandles.clear();
+	oversizedEntries.clear();
+	objectCount = 0;
+}
+
+int SpatialHash::QueryRadius(b2Vec2 centre, float radius, unsigned int mask, std::vector<GameObject*>& results)
+{
+	b2AABB box;
+	box.lowerBound = b2Vec2(centre.x - radius, centre.y - radius);
+	box.upperBound = b2Vec2(centre.x + radius, centre.y + radius);
+
+	return Query(box, mask, &centre, radius * radius, results);
+}
+
+int SpatialHash::QueryAABB(const b2AABB& box, unsigned int mask, std::vector<GameObject*>& results)
+{
+	return Query(box, mask, NULL, 0.0f, results);
+}
+
+GameObject* SpatialHash::RayCast(b2Vec2 p1, b2Vec2 p2, unsigned int mask, float* fraction)
+{
+	NextQueryStamp();
+
+	b2Vec2 d(p2.x - p1.x, p2.y - p1.y);
+
+	GameObject* closestObject = NULL;
+	float closestFraction = 1.0f;
+
+	RayCastBucket(oversizedEntries, p1, d, mask, closestObject, closestFraction);
+
+	// walks the cells the ray passes through in order
+	// stopping once a hit is closer than the next cell
+
+	int x = CellCoord(p1.x);
+	int y = CellCoord(p1.y);
+	int endX = CellCoord(p2.x);
+	int endY = CellCoord(p2.y);
+
+	int stepX = d.x > 0.0f ? 1 : -1;
+	int stepY = d.y > 0.0f ? 1 : -1;
+
+	float tMaxX = FLT_MAX;
+	float tMaxY = FLT_MAX;
+	float tDeltaX = FLT_MAX;
+	float tDeltaY = FLT_MAX;
+
+	if (fabsf(d.x) > FLT_EPSILON)
+	{
+		float boundary = (stepX > 0 ? x + 1 : x) * cellSize;
+		tMaxX = (boundary - p1.x) / d.x;
+		tDeltaX = cellSize / fabsf(d.x);
+	}
+
+	if (fabsf(d.y) > FLT_EPSILON)
+	{
+		float boundary = (stepY > 0 ? y + 1 : y) * cellSize;
+		tMaxY = (boundary - p1.y) / d.y;
+		tDeltaY = cellSize / fabsf(d.y);
+	}
+
+	for (int i = 0; i < MAX_RAY_CELLS; i++)
+	{
+		RayCastBucket(buckets[BucketIndex(x, y)], p1, d, mask, closestObject, closestFraction);
+
+		float cellExit = tMaxX < tMaxY ? tMaxX : tMaxY;
+
+		if ((closestObject && closestFraction <= cellExit) || (x == endX && y == endY))
+		{
+			break;
+		}
+
+		if (tMaxX < tMaxY)
+		{
+			x += stepX;
+			tMaxX += tDeltaX;
+		}
+		else
+		{
+			y += stepY;
+			tMaxY += tDeltaY;
+		}
+	}
+
+	if (fraction)
+	{
+		*fraction = closestFraction;
+	}
+
+	return closestObject;
+}
+
+b2AABB SpatialHash::ComputeBodyAABB(const b2Body* body)
+{
+	b2AABB box;
+	box.lowerBound = body->GetPosition();
+	box.upperBound = body->GetPosition();
+
+	bool first = true;
+
+	for (const b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+	{
+		const b2Shape* shape = fixture->GetShape();
+
+		for (int32 child = 0; child < shape->GetChildCount(); child++)
+		{
+			b2AABB shapeBox;
+			shape->ComputeAABB(&shapeBox, body->GetTransform(), child);
+
+			if (first)
+			{
+				box = shapeBox;
+				first = false;
+			}
+			else
+			{
+				box.Combine(shapeBox);
+			}
+		}
+	}
+
+	return box;
+}
+
+void SpatialHash::RunBenchmark(int queryCount, float radius)
+{
+	if (objectCount == 0 || queryCount <= 0)
+	{
+		return;
+	}
+
+	// query centres spread over the area the objects cover
+	// oversized objects are left out so the borders don't set the area
+
+	b2AABB area;
+	bool first = true;
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (!entries[i].inUse || entries[i].oversized)
+		{
+			continue;
+		}
+
+		if (first)
+		{
+			area = entries[i].box;
+			first = false;
+		}
+		else
+		{
+			area.Combine(entries[i].box);
+		}
+	}
+
+	if (first)
+	{
+		return;
+	}
+
+	std::vector<b2Vec2> centres(queryCount);
+	srand(1);
+
+	for (int i = 0; i < queryCount; i++)
+	{
+		float u = (float)rand() / RAND_MAX;
+		float v = (float)rand() / RAND_MAX;
+		centres[i].x = area.lowerBound.x + u * (area.upperBound.x - area.lowerBound.x);
+		centres[i].y = area.lowerBound.y + v * (area.upperBound.y - area.lowerBound.y);
+	}
+
+	std::vector<GameObject*> results;
+	results.reserve(objectCount);
+
+	Timer timer;
+
+	// checks every object, as walking the object vectors does
+
+	int bruteForceFound = 0;
+	timer.Start();
+
+	for (int i = 0; i < queryCount; i++)
+	{
+		for (size_t e = 0; e < entries.size(); e++)
+		{
+			if (entries[e].inUse && DistanceSquared(centres[i], entries[e].box) <= radius * radius)
+			{
+				bruteForceFound++;
+			}
+		}
+	}
+
+	timer.GetTimeStop();
+	double bruteForceMS = timer.elapsedMS();
+
+	// checks the nearby cells
+
+	int hashFound = 0;
+	timer.Start();
+
+	for (int i = 0; i < queryCount; i++)
+	{
+		results.clear();
+		hashFound += QueryRadius(centres[i], radius, SPATIAL_ALL, results);
+	}
+
+	timer.GetTimeStop();
+	double hashMS = timer.elapsedMS();
+
+	gef::DebugOut("spatial hash: %i objects, %i oversized, cell size %.1f\n", objectCount, (int)oversizedEntries.size(), cellSize);
+	gef::DebugOut("spatial hash: %i radius %.1f queries, every object %.1fms (%i found), hash %.1fms (%i found)\n",
+		queryCount, radius, bruteForceMS, bruteForceFound, hashMS, hashFound);
+}
+
+int SpatialHash::CellCoord(float position) const
+{
+	return (int)floorf(position * inverseCellSize);
+}
+
+int SpatialHash::BucketIndex(int x, int y) const
+{
+	unsigned int hash = ((unsigned int)x * CELL_HASH_X) ^ ((unsigned int)y * CELL_HASH_Y);
+	return (int)(hash % buckets.size());
+}
+
+void SpatialHash::AddToCells(int handle)
+{
+	Entry& entry = entries[handle];
+
+	int cellCount = (entry.maxX - entry.minX + 1) * (entry.maxY - entry.minY + 1);
+	entry.oversized = cellCount > MAX_CELLS_PER_OBJECT;
+
+	if (entry.oversized)
+	{
+		oversizedEntries.push_back(handle);
+		return;
+	}
+
+	for (int y = entry.minY; y <= entry.maxY; y++)
+	{
+		for (int x = entry.minX; x <= entry.maxX; x++)
+		{
+			buckets[BucketIndex(x, y)].push_back(handle);
+		}
+	}
+}
+
+// removes one copy of the handle for each cell
+// cells hashing to the same bucket each added their own copy
+
+static void RemoveOne(std::vector<int>& list, int handle)
+{
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		if (list[i] == handle)
+		{
+			list[i] = list.back();
+			list.pop_back();
+			return;
+		}
+	}
+}
+
+void SpatialHash::RemoveFromCells(int handle)
+{
+	Entry& entry = entries[handle];
+
+	if (entry.oversized)
+	{
+		RemoveOne(oversizedEntries, handle);
+		return;
+	}
+
+	for (int y = entry.minY; y <= entry.maxY; y++)
+	{
+		for (int x = entry.minX; x <= entry.maxX; x++)
+		{
+			RemoveOne(buckets[BucketIndex(x, y)], handle);
+		}
+	}
+}
+
+int SpatialHash::Query(const b2AABB& box, unsigned int mask, const b2Vec2* centre, float radiusSquared, std::vector<GameObject*>& results)
+{
+	size_t first = results.size();
+
+	NextQueryStamp();
+
+	// oversized objects are always checked
+
+	QueryBucket(oversizedEntries, box, mask, centre, radiusSquared, results);
+
+	int minX = CellCoord(box.lowerBound.x);
+	int minY = CellCoord(box.lowerBound.y);
+	int maxX = CellCoord(box.upperBound.x);
+	int maxY = CellCoord(box.upperBound.y);
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			QueryBucket(buckets[BucketIndex(x, y)], box, mask, centre, radiusSquared, results);
+		}
+	}
+
+	return (int)(results.size() - first);
+}
+
+void SpatialHash::QueryBucket(const std::vector<int>& bucket, const b2AABB& box, unsigned int mask,
+	const b2Vec2* centre, float radiusSquared, std::vector<GameObject*>& results)
+{
+	for (size_t i = 0; i < bucket.size(); i++)
+	{
+		Entry& entry = entries[bucket[i]];
+
+		if (entry.queryStamp == queryStamp)
+		{
+			continue;
+		}
+
+		entry.queryStamp = queryStamp;
+
+		if (!(entry.category & mask) || !Overlaps(entry.box, box))
+		{
+			continue;
+		}
+
+		// radius queries also skip objects in the corners of the box
+
+		if (centre && DistanceSquared(*centre, entry.box) > radiusSquared)
+		{
+			continue;
+		}
+
+		results.push_back(entry.object);
+	}
+}
+
+void SpatialHash::RayCastBucket(const std::vector<int>& bucket, b2Vec2 p1, b2Vec2 d, unsigned int mask,
+	GameObject*& closestObject, float& closestFraction)
+{
+	for (size_t i = 0; i < bucket.size(); i++)
+	{
+		Entry& entry = entries[bucket[i]];
+
+		if (entry.queryStamp == queryStamp)
+		{
+			continue;
+		}
+
+		entry.queryStamp = queryStamp;
+
+		if (!(entry.category & mask))
+		{
+			continue;
+		}
+
+		float t = RayBoxFraction(p1, d, entry.box);
+
+		if (t >= 0.0f && t <= closestFraction)
+		{
+			closestFraction = t;
+			closestObject = entry.object;
+		}
+	}
+}
+
+void SpatialHash::NextQueryStamp()
+{
+	queryStamp++;
+
+	// when the stamp wraps every entry is reset
+	// so none are skipped by an old stamp
+
+	if (queryStamp == 0)
+	{
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			entries[i].queryStamp = 0;
+		}
+
+		queryStamp = 1;
+	}
+}
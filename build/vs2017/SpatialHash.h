@@ -0,0 +1,146 @@
+#pragma once
+#include <box2d/Box2D.h>
+#include <vector>
+
+class GameObject;
+
+// spatial hash categories
+// each object has one, queries pass a mask of the ones they want back
+
+enum SPATIAL_CATEGORY
+{
+	SPATIAL_PLAYER = 1 << 0,
+	SPATIAL_PLATFORM = 1 << 1,
+	SPATIAL_WALL = 1 << 2,
+	SPATIAL_RESET_WALL = 1 << 3,
+	SPATIAL_ENEMY = 1 << 4,
+	SPATIAL_PICKUP = 1 << 5,
+	SPATIAL_SPIKE = 1 << 6
+};
+
+// mask matching every category
+
+#define SPATIAL_ALL 0xffffffff
+
+// spatial hash
+// uniform grid over the level's game objects
+// cells are hashed into a fixed number of buckets so the grid has no bounds
+// gameplay asks for objects near a point, box or ray without
+// walking every object vector or the physics contact list
+
+class SpatialHash
+{
+public:
+
+	// spatial hash constructor
+	// cellSize is the width of a grid cell in world units
+
+	SpatialHash(float cellSize = 8.0f, int bucketCount = 1024);
+
+	// adds an object covering the box
+	// returns its handle for Move and Remove
+
+	int Insert(GameObject* object, const b2AABB& box, unsigned int category);
+
+	// adds an object covering its body's fixtures
+
+	int InsertBody(GameObject* object, const b2Body* body, unsigned int category);
+
+	// moves an object to a new box
+	// the buckets are only touched if it moved into different cells
+
+	void Move(int handle, const b2AABB& box);
+	void MoveBody(int handle, const b2Body* body);
+
+	// removes an object
+	// its handle is reused by the next insert
+
+	void Remove(int handle);
+
+	// removes every object
+
+	void Clear();
+
+	// adds every object in the mask overlapping the circle or box to results
+	// returns the number added
+
+	int QueryRadius(b2Vec2 centre, float radius, unsigned int mask, std::vector<GameObject*>& results);
+	int QueryAABB(const b2AABB& box, unsigned int mask, std::vector<GameObject*>& results);
+
+	// returns the first object in the mask the ray from p1 to p2 hits
+	// or NULL if it hits nothing
+	// fraction is set to how far along the ray the hit is
+
+	GameObject* RayCast(b2Vec2 p1, b2Vec2 p2, unsigned int mask, float* fraction = NULL);
+
+	// returns the box around every fixture of a body
+
+	static b2AABB ComputeBodyAABB(const b2Body* body);
+
+	// times radius queries against checking every object
+	// results are printed to the debug output
+
+	void RunBenchmark(int queryCount, float radius);
+
+	// getters
+
+	int getObjectCount() { return objectCount; }
+	float getCellSize() { return cellSize; }
+
+private:
+
+	struct Entry
+	{
+		GameObject* object;
+		b2AABB box;
+		unsigned int category;
+
+		// cells covered, inclusive
+		int minX, minY, maxX, maxY;
+
+		// set to the query number once checked
+		// so objects covering several cells are only checked once per query
+		unsigned int queryStamp;
+
+		bool inUse;
+		bool oversized;
+	};
+
+	// cell coordinate of a world position
+	int CellCoord(float position) const;
+
+	// bucket a cell hashes to
+	int BucketIndex(int x, int y) const;
+
+	// adds or removes the entry from the buckets of every cell it covers
+	// objects covering too many cells are kept in the oversized list instead
+	void AddToCells(int handle);
+	void RemoveFromCells(int handle);
+
+	// adds the objects overlapping the box to results
+	// and the circle too if a centre is given
+	int Query(const b2AABB& box, unsigned int mask, const b2Vec2* centre, float radiusSquared, std::vector<GameObject*>& results);
+
+	// checks one bucket for objects overlapping the box and circle
+	void QueryBucket(const std::vector<int>& bucket, const b2AABB& box, unsigned int mask,
+		const b2Vec2* centre, float radiusSquared, std::vector<GameObject*>& results);
+
+	// checks one bucket against the ray keeping the closest hit
+	void RayCastBucket(const std::vector<int>& bucket, b2Vec2 p1, b2Vec2 d, unsigned int mask,
+		GameObject*& closestObject, float& closestFraction);
+
+	// starts a new query so every entry can be checked again
+	void NextQueryStamp();
+
+	// spatial hash variables
+
+	std::vector<Entry> entries;
+	std::vector<int> freeHandles;
+	std::vector<std::vector<int> > buckets;
+	std::vector<int> oversizedEntries;
+
+	float cellSize;
+	float inverseCellSize;
+	unsigned int queryStamp;
+	int objectCount;
+};
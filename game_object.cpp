@@ -1,8 +1,17 @@
 #include "game_object.h"
 #include <system/debug_log.h>
 
-#define JUMP_VALUE 11.0f
-#define DOUBLE_JUMP_VALUE 11.0f
+// seconds the player can't be hurt again after being hit
+
+#define PLAYER_INVINCIBLE_SECONDS 2.0f
+
+// game object constructor
+// objects are drawn at their mesh size until scaled
+
+GameObject::GameObject()
+{
+	object_scale_vec = gef::Vector4(1.0f, 1.0f, 1.0f);
+}
 
 //
 // UpdateFromSimulation
@@ -22,8 +31,13 @@ void GameObject::UpdateFromSimulation(const b2Body* body)
 
 		object_translation = gef::Vector4(body->GetPosition().x, body->GetPosition().y, 0.0f);
 
+		// setup the object scale
+		// boxes sharing the unit cube are scaled to their size here
+		gef::Matrix44 object_scale;
+		object_scale.Scale(object_scale_vec);
+
 		// build object transformation matrix
-		gef::Matrix44 object_transform = object_rotation;
+		gef::Matrix44 object_transform = object_scale * object_rotation;
 		object_transform.SetTranslation(object_translation);
 		set_transform(object_transform);
 
@@ -53,376 +67,51 @@ Player::Player()
 	previousPlayerState = STANDING;
 	secondPreviousPlayerState = STANDING;
 	invincibleCheck = false;
+	invincibleTime = 0.0f;
 	health = 5;
+	groundProbed = false;
+	grounded = false;
 }
 
 // handles player inputs, updating the players state
 // and position based on the inputs
 // also updates player variables
 
-void Player::HandleInput(gef::InputManager* im, b2Body* body, float frame_time)
+bool Player::HandleInput(const ActionInput& input, b2Body* body, float frame_time)
 {
+	return HandleInput(ReadInput(input), body, frame_time);
+}
 
-	// creates keyboard controls inside the player class
-
-	const gef::Keyboard* kb = im->keyboard();
-
-
-	if (kb)
-	{
-		// checks for current state of player
-		// based on current state allows for certain controls
-		// and actions to occur
-
-		switch (currentPlayerState)
-		{
-		case STANDING:
-
-			// jumps if player is standing still
-
-			if (kb->IsKeyPressed(gef::Keyboard::KC_UP) && (body->GetLinearVelocity().y <= 0.05f && body->GetLinearVelocity().y >= -0.05f))
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-				
-			}
-
-			// allows for player to jump after coming off a Double Jump Reset wall
-
-			else if (kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == ON_WALL)
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-
-			}
-
-			// allows for player to double jump while falling before reaching a certain velocity
-
-			else if (kb->IsKeyPressed(gef::Keyboard::KC_UP) && body->GetLinearVelocity().y > -25.0f && secondPreviousPlayerState == JUMPING && (previousPlayerState == MOVING_LEFT || previousPlayerState == MOVING_RIGHT) && doubleJumpActive == true)
-			{
-				setPlayerState(DOUBLE_JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, DOUBLE_JUMP_VALUE), true);
-				
-			}
-
-			// moves the player right
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				setPlayerState(MOVING_RIGHT);
-			}
-
-			// moves the player left
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				setPlayerState(MOVING_LEFT);
-			}
-			break;
-		case MOVING_RIGHT:
-
-			// limits speed player can reach when moving right
-			if (body->GetLinearVelocity().x <= 6.0f)
-			{
-				body->ApplyLinearImpulseToCenter(b2Vec2(1.0f, 0.0f), true);
-			}
-			
-			// dashes player right if ability is active
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT) && kb->IsKeyPressed(gef::Keyboard::KC_LCONTROL) && dashActive)
-			{
-				
-				setPlayerState(DASHING_RIGHT);
-
-				// limits dash speed
-				if (body->GetLinearVelocity().x <= 16.0f)
-					body->ApplyLinearImpulseToCenter(b2Vec2(8.0f, 0.0f), true);
-			}
-
-			// moves player left
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				setPlayerState(MOVING_LEFT);
-			}
-
-			// allows player to jump while moving right
-			// stops player from jumping infinitely
-			if (kb->IsKeyPressed(gef::Keyboard::KC_UP) && (body->GetLinearVelocity().y <= 0.05f && body->GetLinearVelocity().y >= -0.05f))
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-				
-				
-			}
-
-			// alows player to jump on a moving platform while moving right
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == ON_MOVING_PLAT && secondPreviousPlayerState != JUMPING)
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-
-
-			}
-
-			// alows player to double jump after being on a moving platform while moving right
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == ON_MOVING_PLAT && secondPreviousPlayerState == JUMPING && doubleJumpActive == true)
-			{
-				setPlayerState(DOUBLE_JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, DOUBLE_JUMP_VALUE), true);
-
+// handles player inputs already read for this tick
+// used by the simulations, which play back scripted input
 
-			}
+bool Player::HandleInput(const PlayerInput& playerInput, b2Body* body, float frame_time)
+{
+	PlayerStateContext ctx;
+	InitPlayerStateContext(ctx, playerInput, body->GetLinearVelocity(),
+		currentPlayerState, previousPlayerState, secondPreviousPlayerState,
+		doubleJumpActive, dashActive, tuning);
+	ctx.groundProbed = groundProbed;
+	ctx.grounded = grounded;
 
-			// allows player to double jump while moving right if ability is active
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == JUMPING && doubleJumpActive == true)
-			{
-				setPlayerState(DOUBLE_JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, DOUBLE_JUMP_VALUE), true);
-
-
-			}
-
-
-			// allows player to jump after being on a Double Jump Reset wall
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == ON_WALL)
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-
-
-			}
-
-			// brings player to a standing state
-			else if(kb->IsKeyReleased(gef::Keyboard::KC_RIGHT)) 
-			{
-				setPlayerState(STANDING);
-			}
-			break;
-		case MOVING_LEFT:
-			
-			// limits speed player can reach when moving left
-			if (body->GetLinearVelocity().x >= -6.0f)
-			{
-				body->ApplyLinearImpulseToCenter(b2Vec2(-1.0f, 0.0f), true);
-			}
-			
-			// dashes player left if ability is active
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT) && kb->IsKeyPressed(gef::Keyboard::KC_LCONTROL) && dashActive)
-			{
-				
-				setPlayerState(DASHING_LEFT);
-
-				// limits dash speed
-				if (body->GetLinearVelocity().x >= -16.0f)
-					body->ApplyLinearImpulseToCenter(b2Vec2(-8.0f, 0.0f), true);
-			}
-
-			// moves player right
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				setPlayerState(MOVING_RIGHT);
-			}
-
-
-			// allows player to jump while moving left
-			// stops player from jumping infinitely
-			if (kb->IsKeyPressed(gef::Keyboard::KC_UP) && (body->GetLinearVelocity().y <= 0.05f && body->GetLinearVelocity().y >= -0.05f))
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-				
-				
-			}
-
-			// alows player to jump on a moving platform while moving left
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == ON_MOVING_PLAT && secondPreviousPlayerState != JUMPING)
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-
-
-			}
-
-			// alows player to double jump after being on a moving platform while moving left
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == ON_MOVING_PLAT && secondPreviousPlayerState == JUMPING && doubleJumpActive == true)
-			{
-				setPlayerState(DOUBLE_JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, DOUBLE_JUMP_VALUE), true);
-
-
-			}
-
-			// allows player to double jump while moving left if ability is active
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == JUMPING && doubleJumpActive == true)
-			{
-				setPlayerState(DOUBLE_JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, DOUBLE_JUMP_VALUE), true);
-
-
-			}
-
-			// allows player to jump after being on a Double Jump Reset wall
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT) && kb->IsKeyPressed(gef::Keyboard::KC_UP) && previousPlayerState == ON_WALL)
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-
-
-			}
-
-			// brings player to a standing state
-			else if (kb->IsKeyReleased(gef::Keyboard::KC_LEFT)) 
-			{
-				setPlayerState(STANDING);
-			}
-			break;
-		case DASHING_RIGHT:
-
-			// moves player left
-			if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				setPlayerState(MOVING_LEFT);
-			}
-
-			// moves player right
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				setPlayerState(MOVING_RIGHT);
-			}
-
-			break;
-		case DASHING_LEFT:
-			
-			// moves player left
-			if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				setPlayerState(MOVING_LEFT);
-			}
-
-
-			// moves player right
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				setPlayerState(MOVING_RIGHT);
-			}
-
-			
-			break;
-
-			
-		case JUMPING:
-			
-			// allows player to double jump if ability is active
-			if (kb->IsKeyPressed(gef::Keyboard::KC_UP) && doubleJumpActive == true)
-			{
-				setPlayerState(DOUBLE_JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, DOUBLE_JUMP_VALUE), true);
-			}
-
-			// brings player to a standing state
-			// if no input is present and the player comes
-			// to a complete stop
-
-			else if (body->GetLinearVelocity().y <= 0.05f && body->GetLinearVelocity().y >= -0.05f)
-			{
-				setPlayerState(STANDING);
-			}
-
-			// moves player right
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				setPlayerState(MOVING_RIGHT);
-			}
+	// runs the player state machine
+	// based on current state allows for certain controls
+	// and actions to occur
 
-			// moves player left
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				setPlayerState(MOVING_LEFT);
-				
-			}
+	UpdatePlayerStateMachine(ctx);
 
-			break;
-		case DOUBLE_JUMPING:
-
-			// brings player to a standing state
-			// if no input is present and the player comes
-			// to a complete stop
-			if (body->GetLinearVelocity().y <= 0.05f && body->GetLinearVelocity().y >= -0.05f)
-			{
-				setPlayerState(STANDING);
-			}
-
-			// moves player right
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				setPlayerState(MOVING_RIGHT);
-			}
-
-			// moves player left
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				setPlayerState(MOVING_LEFT);
-			}
-
-			break;
-
-		case ON_WALL:
-
-
-			// moves player right
-			// off from wall
-
-			if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				
-				setPlayerState(MOVING_RIGHT);
-			}
-
-			// moves player left
-			// off from wall
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				
-				setPlayerState(MOVING_LEFT);
-			}
-
-
-			break;
-
-		case ON_MOVING_PLAT:
-
-
-			// allows player to jump from moving platform
-
-			if (kb->IsKeyPressed(gef::Keyboard::KC_UP) & previousPlayerState != ON_MOVING_PLAT)
-			{
-				setPlayerState(JUMPING);
-				body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, JUMP_VALUE), true);
-			}
-
-			// allows player to move right on moving platform
-
-			else if (kb->IsKeyDown(gef::Keyboard::KC_RIGHT))
-			{
-				setPlayerState(MOVING_RIGHT);
-			}
+	// copies the new states back into the player
 
-			// allows player to move left on moving platform
-			else if (kb->IsKeyDown(gef::Keyboard::KC_LEFT))
-			{
-				setPlayerState(MOVING_LEFT);
-			}
+	currentPlayerState = ctx.current;
+	previousPlayerState = ctx.previous;
+	secondPreviousPlayerState = ctx.secondPrevious;
 
-			break;
+	// applies any jump, dash or movement impulses
+	// from this tick in one go
 
-		default: STANDING;
-			break;
-		}
-		
+	if (ctx.hasImpulse)
+	{
+		body->ApplyLinearImpulseToCenter(ctx.impulse, true);
 	}
 	
 	// checks if player has been hit
@@ -430,18 +119,37 @@ void Player::HandleInput(gef::InputManager* im, b2Body* body, float frame_time)
 
 	if (invincibleCheck)
 	{
-		// once timer goes over a certain limit
-		// stops and resets the timer
+		// counts game time rather than real time
+		// so simulations running faster than real time behave the same
+		// once it goes over a certain limit
 		// takes player out of invulnerability
 
-		if (healthTimer.elapsedSeconds() > 2.0)
+		invincibleTime += frame_time;
+
+		if (invincibleTime > PLAYER_INVINCIBLE_SECONDS)
 		{
-			healthTimer.Stop();
+			invincibleTime = 0.0f;
 			invincibleCheck = false;
 
 		}
 	}
 
+	return ctx.hasImpulse;
+}
+
+// reads the actions the player state machine uses
+
+PlayerInput Player::ReadInput(const ActionInput& input)
+{
+	PlayerInput playerInput;
+	playerInput.upPressed = input.IsPressed(ACTION_JUMP);
+	playerInput.leftDown = input.IsDown(ACTION_LEFT);
+	playerInput.rightDown = input.IsDown(ACTION_RIGHT);
+	playerInput.leftReleased = input.IsReleased(ACTION_LEFT);
+	playerInput.rightReleased = input.IsReleased(ACTION_RIGHT);
+	playerInput.dashPressed = input.IsPressed(ACTION_DASH);
+
+	return playerInput;
 }
 
 void Player::DecrementHealth()
@@ -459,7 +167,7 @@ void Player::DecrementHealth()
 
 		health--;
 		invincibleCheck = true;
-		healthTimer.Start();
+		invincibleTime = 0.0f;
 
 	}
 
@@ -513,6 +221,13 @@ MovingPlatform::MovingPlatform()
 
 void MovingPlatform::setPlatPosAndSpeedYaxis(b2Body* body, float startPos, float endPos, float ySpeed)
 {
+	// body is frozen while its activity region is off
+
+	if (!body->IsActive())
+	{
+		return;
+	}
+
 	if (endPos > startPos)
 	{
 		if (body->GetPosition().y >= endPos)
@@ -571,6 +286,13 @@ void MovingPlatform::setPlatPosAndSpeedYaxis(b2Body* body, float startPos, float
 
 void MovingPlatform::setPlatPosAndSpeedXaxis(b2Body* body, float startPos, float endPos, float xSpeed)
 {
+	// body is frozen while its activity region is off
+
+	if (!body->IsActive())
+	{
+		return;
+	}
+
 	
 
 	if (endPos > startPos)
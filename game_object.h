@@ -3,9 +3,9 @@
 
 #include <graphics/mesh_instance.h>
 #include <box2d/Box2D.h>
-#include "input/input_manager.h"
-#include "input/keyboard.h"
+#include "ActionInput.h"
 #include "Timer.h"
+#include "PlayerStateMachine.h"
 
 // object states
 // used to set different types
@@ -24,13 +24,20 @@ enum OBJECT_TYPE
 	WALL,
 	STICKY_WALL,
 	STICKY_ROOF,
-	MOVING
+	MOVING,
+	PATROL_ENEMY,
+	DESTRUCTIBLE,
+	DEBRIS
 };
 
 class GameObject : public gef::MeshInstance
 {
 public:
 
+	// game object constructor
+	// objects start with no scale
+	GameObject();
+
 	// Update the transform of this object from a physics rigid body
 	void UpdateFromSimulation(const b2Body* body);
 
@@ -42,6 +49,7 @@ public:
 	void setSize(gef::Vector4 size);
 	gef::Vector4 getSize();
 	void setScale(gef::Vector4 scale) { object_scale_vec = scale; }
+	gef::Vector4 getScale() { return object_scale_vec; }
 	
 private:
 
@@ -54,24 +62,6 @@ private:
 	gef::Vector4 objectSize;
 };
 
-// player states
-// used to determine what the 
-// player is doing and how to control
-// the player during said state
-
-enum PLAYER_STATE
-{
-	STANDING,
-	MOVING_RIGHT,
-	MOVING_LEFT,
-	DASHING_RIGHT,
-	DASHING_LEFT,
-	JUMPING,
-	DOUBLE_JUMPING,
-	ON_WALL,
-	ON_MOVING_PLAT
-};
-
 class Player : public GameObject
 {
 
@@ -97,8 +87,14 @@ public:
 	inline PLAYER_STATE getPlayerSecondPreviousState() { return secondPreviousPlayerState; }
 
 	// updates player inputs and variables
+	// returns true if an impulse was applied to the player
+
+	bool HandleInput(const ActionInput& input, b2Body* body, float frame_time);
+	bool HandleInput(const PlayerInput& input, b2Body* body, float frame_time);
 
-	void HandleInput(gef::InputManager* im, b2Body* body, float frame_time);
+	// reads the actions used by the player from the action input
+
+	static PlayerInput ReadInput(const ActionInput& input);
 
 	// decreases health of player
 	// sets player to invulnerable based on
@@ -123,6 +119,14 @@ public:
 	bool getDoubleJumpActive() { return doubleJumpActive; }
 	void setResetWallActive(bool);
 	bool getResetWallActive() { return resetWallActive; }
+
+	// ground probe
+	// set before each tick when the ground under the player has been probed
+	void setGroundProbe(bool probed, bool grounded) { groundProbed = probed; this->grounded = grounded; }
+
+	// movement tuning
+	// read by the state machine every tick
+	PlayerTuning& getTuning() { return tuning; }
 	
 private:
 
@@ -141,8 +145,14 @@ private:
 	PLAYER_STATE previousPlayerState;
 	PLAYER_STATE secondPreviousPlayerState;
 
-	// timer for invulnerability
-	Timer healthTimer;
+	// ground probe results
+	bool groundProbed, grounded;
+
+	// game time spent invulnerable
+	float invincibleTime;
+
+	// impulses and speed limits
+	PlayerTuning tuning;
 
 };
 
@@ -5,6 +5,17 @@
 #include <maths/math_utils.h>
 #include <vector>
 #include <math.h>
+#include <float.h>
+
+// sphere tessellation for each level of detail
+// level 1 matches the spheres the game was built with
+static const int kSphereLodTessellation[PrimitiveBuilder::kNumSphereLods] = { 24, 15, 8 };
+
+// smallest on screen radius in pixels for each level of detail
+static const float kSphereLodScreenRadius[PrimitiveBuilder::kNumSphereLods] = { 60.0f, 20.0f, 0.0f };
+
+// post transform cache size the triangle order is tuned for
+static const int kVertexCacheSize = 32;
 
 
 //
@@ -13,7 +24,8 @@
 PrimitiveBuilder::PrimitiveBuilder(gef::Platform& platform) :
 	platform_(platform),
 	default_cube_mesh_(NULL),
-	default_sphere_mesh_(NULL)
+	default_sphere_mesh_(NULL),
+	unit_box_meshes_(false)
 {
 	Init();
 }
@@ -56,6 +68,11 @@ void PrimitiveBuilder::Init()
 //
 void PrimitiveBuilder::CleanUp()
 {
+	// any registry mesh still in use goes with the builder
+	for (size_t i = 0; i < cached_meshes_.size(); ++i)
+		delete cached_meshes_[i].mesh;
+	cached_meshes_.clear();
+
 	delete default_sphere_mesh_;
 	default_sphere_mesh_ = NULL;
 
@@ -118,7 +135,7 @@ gef::Mesh* PrimitiveBuilder::CreateBoxMesh(const gef::Vector4& half_size, gef::V
 	};
 
 	const int kNumIndices = 6 * 6;
-	Int32 indices[kNumIndices] =
+	UInt32 indices[kNumIndices] =
 	{
 		// front
 		0, 1, 2,
@@ -148,20 +165,33 @@ gef::Mesh* PrimitiveBuilder::CreateBoxMesh(const gef::Vector4& half_size, gef::V
 	// create the vertex buffer for the box vertices
 	mesh->InitVertexBuffer(platform_, vertices, kNumVertices, sizeof(gef::Mesh::Vertex));
 
-	// create a primitive per face so we can alter the material per face
-	const int num_faces = 6;
-	mesh->AllocatePrimitives(num_faces);
+	// vertices are not shared between faces as each face needs its own normal
 
-	for (int primitive_num = 0; primitive_num < num_faces; ++primitive_num)
+	if (materials)
 	{
-		gef::Primitive* primitive = mesh->GetPrimitive(primitive_num);
-		primitive->InitIndexBuffer(platform_, &indices[primitive_num*6], 6, sizeof(Int32));
-		primitive->set_type(gef::TRIANGLE_LIST);
+		// create a primitive per face so we can alter the material per face
+		const int num_faces = 6;
+		mesh->AllocatePrimitives(num_faces);
+
+		for (int primitive_num = 0; primitive_num < num_faces; ++primitive_num)
+		{
+			gef::Primitive* primitive = mesh->GetPrimitive(primitive_num);
+			InitIndexBuffer(primitive, &indices[primitive_num*6], 6, kNumVertices);
+			primitive->set_type(gef::TRIANGLE_LIST);
 
-		// if materials pointer is valid then assume we have an array of Material pointers
-		// with a size greater than 6 (one material per face)
-		if(materials)
+			// materials is an array of Material pointers
+			// with a size greater than 6 (one material per face)
 			primitive->set_material(materials[primitive_num]);
+		}
+	}
+	else
+	{
+		// without materials every face is drawn by one primitive
+		mesh->AllocatePrimitives(1);
+
+		gef::Primitive* primitive = mesh->GetPrimitive(0);
+		InitIndexBuffer(primitive, indices, kNumIndices, kNumVertices);
+		primitive->set_type(gef::TRIANGLE_LIST);
 	}
 
 	// set the bounds
@@ -263,67 +293,456 @@ gef::Mesh* PrimitiveBuilder::CreateSphereMesh(const float radius, const int phi,
 
 
 	mesh->InitVertexBuffer(platform_, &vertices[0], kNumVertices, sizeof(gef::Mesh::Vertex));
-	mesh->AllocatePrimitives(2);
 
-	// side quads
-	std::vector<Int32> index_buffer;
-	index_buffer.resize((theta - 1)*phi * 6);
+	// side quads and top/bottom fans share one material
+	// so they go in one primitive reordered for the vertex cache
+	std::vector<UInt32> index_buffer;
+	BuildSphereIndices(phi, theta, index_buffer);
+	OptimiseVertexCache(index_buffer, kNumVertices);
+
+	mesh->AllocatePrimitives(1);
+
+	gef::Primitive* primitive = mesh->GetPrimitive(0);
+	primitive->set_type(gef::TRIANGLE_LIST);
+	primitive->set_material(material);
+	InitIndexBuffer(primitive, &index_buffer[0], (int)index_buffer.size(), kNumVertices);
+
+	// bounds
+	gef::Aabb aabb(gef::Vector4(-radius, -radius, -radius) - origin, gef::Vector4(radius, radius, radius)+ origin);
+	mesh->set_aabb(aabb);
+	gef::Sphere sphere(origin, radius);
+	mesh->set_bounding_sphere(sphere);
+
+	return mesh;
+}
+
+//
+// MeshKey
+//
+bool PrimitiveBuilder::MeshKey::operator==(const MeshKey& other) const
+{
+	return shape == other.shape &&
+		dimensions[0] == other.dimensions[0] && dimensions[1] == other.dimensions[1] && dimensions[2] == other.dimensions[2] &&
+		phi == other.phi && theta == other.theta &&
+		centre[0] == other.centre[0] && centre[1] == other.centre[1] && centre[2] == other.centre[2];
+}
+
+//
+// AcquireBoxMesh
+//
+gef::Mesh* PrimitiveBuilder::AcquireBoxMesh(const gef::Vector4& half_size, gef::Vector4 centre)
+{
+	MeshKey key;
+	key.shape = kBoxShape;
+	key.dimensions[0] = half_size.x();
+	key.dimensions[1] = half_size.y();
+	key.dimensions[2] = half_size.z();
+	key.phi = 0;
+	key.theta = 0;
+	key.centre[0] = centre.x();
+	key.centre[1] = centre.y();
+	key.centre[2] = centre.z();
+
+	return AcquireMesh(key);
+}
+
+//
+// AcquireScaledBoxMesh
+//
+gef::Mesh* PrimitiveBuilder::AcquireScaledBoxMesh(const gef::Vector4& half_size, gef::Vector4& scale)
+{
+	if (unit_box_meshes_)
+	{
+		// the unit cube has a half size of 0.5 so the scale is the full size
+		scale = gef::Vector4(half_size.x() * 2.0f, half_size.y() * 2.0f, half_size.z() * 2.0f);
+		return AcquireBoxMesh(gef::Vector4(0.5f, 0.5f, 0.5f));
+	}
+
+	scale = gef::Vector4(1.0f, 1.0f, 1.0f);
+	return AcquireBoxMesh(half_size);
+}
+
+//
+// AcquireSphereMesh
+//
+gef::Mesh* PrimitiveBuilder::AcquireSphereMesh(const float radius, const int phi, const int theta, gef::Vector4 centre)
+{
+	MeshKey key;
+	key.shape = kSphereShape;
+	key.dimensions[0] = radius;
+	key.dimensions[1] = radius;
+	key.dimensions[2] = radius;
+	key.phi = phi;
+	key.theta = theta;
+	key.centre[0] = centre.x();
+	key.centre[1] = centre.y();
+	key.centre[2] = centre.z();
+
+	return AcquireMesh(key);
+}
 
-	int idx = 0;
-	for (int i = 0; i<theta - 1; ++i)
+//
+// AcquireMesh
+//
+gef::Mesh* PrimitiveBuilder::AcquireMesh(const MeshKey& key)
+{
+	// the registry only holds a handful of meshes so a linear search is fine
+	for (size_t i = 0; i < cached_meshes_.size(); ++i)
 	{
-		for (int j = 0; j<phi; ++j)
+		if (cached_meshes_[i].key == key)
 		{
-			// 2 triangles per quad
-			index_buffer.at(idx++) = 1 + phi*(i + 0) + (j + 1) % phi;
-			index_buffer.at(idx++) = 1 + phi*(i + 1) + (j + 1) % phi;
-			index_buffer.at(idx++) = 1 + phi*(i + 1) + (j + 0) % phi;
+			cached_meshes_[i].ref_count++;
+			return cached_meshes_[i].mesh;
+		}
+	}
+
+	CachedMesh cached;
+	cached.key = key;
+	cached.ref_count = 1;
+
+	if (key.shape == kBoxShape)
+		cached.mesh = CreateBoxMesh(gef::Vector4(key.dimensions[0], key.dimensions[1], key.dimensions[2]), gef::Vector4(key.centre[0], key.centre[1], key.centre[2]));
+	else
+		cached.mesh = CreateSphereMesh(key.dimensions[0], key.phi, key.theta, gef::Vector4(key.centre[0], key.centre[1], key.centre[2]));
+
+	cached_meshes_.push_back(cached);
+
+	return cached.mesh;
+}
+
+//
+// ReleaseMesh
+//
+void PrimitiveBuilder::ReleaseMesh(const gef::Mesh* mesh)
+{
+	if (!mesh)
+		return;
 
-			index_buffer.at(idx++) = 1 + phi*(i + 0) + (j + 0) % phi;
-			index_buffer.at(idx++) = 1 + phi*(i + 0) + (j + 1) % phi;
-			index_buffer.at(idx++) = 1 + phi*(i + 1) + (j + 0) % phi;
+	for (size_t i = 0; i < cached_meshes_.size(); ++i)
+	{
+		if (cached_meshes_[i].mesh == mesh)
+		{
+			if (--cached_meshes_[i].ref_count == 0)
+			{
+				delete cached_meshes_[i].mesh;
+				cached_meshes_[i] = cached_meshes_.back();
+				cached_meshes_.pop_back();
+			}
+			return;
 		}
 	}
+}
 
-	gef::Primitive* primitive;
+//
+// AcquireSphereLodMesh
+//
+gef::Mesh* PrimitiveBuilder::AcquireSphereLodMesh(const float radius, const int lod, gef::Vector4 centre)
+{
+	const int tessellation = GetSphereLodTessellation(lod);
 
-	// setup primitive for side quads
-	primitive = mesh->GetPrimitive(0);
-	primitive->set_type(gef::TRIANGLE_LIST);
-	primitive->set_material(material);
-	primitive->InitIndexBuffer(platform_, &index_buffer[0], (UInt32)index_buffer.size(), sizeof(Int32));
+	return AcquireSphereMesh(radius, tessellation, tessellation, centre);
+}
 
-	// top/bottom triangles
-	index_buffer.resize(phi * 3 + phi * 3);
+//
+// GetSphereLodTessellation
+//
+int PrimitiveBuilder::GetSphereLodTessellation(const int lod)
+{
+	int clamped_lod = lod < 0 ? 0 : (lod >= kNumSphereLods ? kNumSphereLods - 1 : lod);
+
+	return kSphereLodTessellation[clamped_lod];
+}
+
+//
+// SelectSphereLod
+//
+int PrimitiveBuilder::SelectSphereLod(const float screen_radius)
+{
+	for (int lod = 0; lod < kNumSphereLods - 1; ++lod)
+	{
+		if (screen_radius >= kSphereLodScreenRadius[lod])
+			return lod;
+	}
+
+	return kNumSphereLods - 1;
+}
+
+//
+// BuildSphereIndices
+//
+void PrimitiveBuilder::BuildSphereIndices(const int phi, const int theta, std::vector<UInt32>& indices)
+{
+	const UInt32 bottom_vertex = theta*phi + 1;
+
+	// side quads then top and bottom fans
+	indices.resize((theta - 1)*phi * 6 + phi * 3 + phi * 3);
+	UInt32* index = &indices[0];
+
+	for (int i = 0; i < theta - 1; ++i)
+	{
+		for (int j = 0; j < phi; ++j)
+		{
+			// 2 triangles per quad
+			*index++ = 1 + phi*(i + 0) + (j + 1) % phi;
+			*index++ = 1 + phi*(i + 1) + (j + 1) % phi;
+			*index++ = 1 + phi*(i + 1) + (j + 0) % phi;
+
+			*index++ = 1 + phi*(i + 0) + (j + 0) % phi;
+			*index++ = 1 + phi*(i + 0) + (j + 1) % phi;
+			*index++ = 1 + phi*(i + 1) + (j + 0) % phi;
+		}
+	}
 
-	idx = 0;
 	// top fan
-	for (int j = 0; j<phi; ++j)
+	for (int j = 0; j < phi; ++j)
 	{
-		index_buffer.at(idx++) = 1 + (j + 1) % phi;
-		index_buffer.at(idx++) = 1 + (j + 0) % phi;
-		index_buffer.at(idx++) = 0;
+		*index++ = 1 + (j + 1) % phi;
+		*index++ = 1 + (j + 0) % phi;
+		*index++ = 0;
 	}
-	
+
 	// bottom fan
-	for (int j = 0; j<phi; ++j)
+	for (int j = 0; j < phi; ++j)
 	{
-		index_buffer.at(idx++) = 1 + phi*(theta - 1) + (j + 0) % phi;
-		index_buffer.at(idx++) = 1 + phi*(theta - 1) + (j + 1) % phi;
-		index_buffer.at(idx++) = (int)kNumVertices - 1;
+		*index++ = 1 + phi*(theta - 1) + (j + 0) % phi;
+		*index++ = 1 + phi*(theta - 1) + (j + 1) % phi;
+		*index++ = bottom_vertex;
 	}
+}
 
-	// setup primitive for top and bottom fans
-	primitive = mesh->GetPrimitive(1);
-	primitive->set_type(gef::TRIANGLE_LIST);
-	primitive->set_material(material);
-	primitive->InitIndexBuffer(platform_, &index_buffer[0], (UInt32)index_buffer.size(), sizeof(Int32));
+//
+// VertexCacheScore
+//
+// scores a vertex by where it is in the cache and how many triangles still use it
+// see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+static float VertexCacheScore(const int cache_position, const int remaining_triangles)
+{
+	if (remaining_triangles == 0)
+		return -1.0f;
 
-	// bounds
-	gef::Aabb aabb(gef::Vector4(-radius, -radius, -radius) - origin, gef::Vector4(radius, radius, radius)+ origin);
-	mesh->set_aabb(aabb);
-	gef::Sphere sphere(origin, radius);
-	mesh->set_bounding_sphere(sphere);
+	float score = 0.0f;
 
-	return mesh;
+	if (cache_position >= 0)
+	{
+		// the last triangle's vertices get a fixed score
+		// so the next triangle does not always use them
+		if (cache_position < 3)
+			score = 0.75f;
+		else
+			score = powf(1.0f - (float)(cache_position - 3) / (float)(kVertexCacheSize - 3), 1.5f);
+	}
+
+	// favour vertices with few triangles left so they are finished and leave the cache
+	score += 2.0f * powf((float)remaining_triangles, -0.5f);
+
+	return score;
+}
+
+//
+// OptimiseVertexCache
+//
+void PrimitiveBuilder::OptimiseVertexCache(std::vector<UInt32>& indices, const int num_vertices)
+{
+	const int num_triangles = (int)indices.size() / 3;
+
+	if (num_triangles == 0)
+		return;
+
+	// triangles using each vertex
+	std::vector<int> vertex_triangle_start(num_vertices + 1, 0);
+	std::vector<int> vertex_remaining(num_vertices, 0);
+
+	for (int i = 0; i < num_triangles * 3; ++i)
+		vertex_remaining[indices[i]]++;
+
+	for (int v = 0; v < num_vertices; ++v)
+		vertex_triangle_start[v + 1] = vertex_triangle_start[v] + vertex_remaining[v];
+
+	std::vector<int> vertex_triangles(num_triangles * 3);
+	std::vector<int> vertex_fill(vertex_triangle_start.begin(), vertex_triangle_start.end() - 1);
+
+	for (int t = 0; t < num_triangles; ++t)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			int v = indices[t * 3 + k];
+			vertex_triangles[vertex_fill[v]++] = t;
+		}
+	}
+
+	// starting scores
+	std::vector<int> vertex_cache_position(num_vertices, -1);
+	std::vector<float> vertex_score(num_vertices);
+
+	for (int v = 0; v < num_vertices; ++v)
+		vertex_score[v] = VertexCacheScore(-1, vertex_remaining[v]);
+
+	std::vector<float> triangle_score(num_triangles);
+	std::vector<bool> triangle_added(num_triangles, false);
+
+	for (int t = 0; t < num_triangles; ++t)
+		triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+
+	std::vector<UInt32> output;
+	output.reserve(num_triangles * 3);
+
+	// cache holds three extra entries for the triangle being added
+	int cache[kVertexCacheSize + 3];
+	int cache_count = 0;
+
+	int best_triangle = -1;
+	int next_unadded = 0;
+
+	for (int added = 0; added < num_triangles; ++added)
+	{
+		// nothing in the cache is usable, take the next triangle not yet added
+		if (best_triangle < 0)
+		{
+			while (triangle_added[next_unadded])
+				next_unadded++;
+
+			best_triangle = next_unadded;
+		}
+
+		int triangle_vertices[3] = { (int)indices[best_triangle * 3], (int)indices[best_triangle * 3 + 1], (int)indices[best_triangle * 3 + 2] };
+
+		triangle_added[best_triangle] = true;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			int v = triangle_vertices[k];
+			output.push_back(v);
+
+			// remove the triangle from the vertex's list of remaining triangles
+			int start = vertex_triangle_start[v];
+			int end = start + vertex_remaining[v];
+
+			for (int i = start; i < end; ++i)
+			{
+				if (vertex_triangles[i] == best_triangle)
+				{
+					vertex_triangles[i] = vertex_triangles[end - 1];
+					break;
+				}
+			}
+
+			vertex_remaining[v]--;
+		}
+
+		// move the triangle's vertices to the front of the cache
+		int new_cache[kVertexCacheSize + 3];
+		int new_cache_count = 0;
+
+		for (int k = 0; k < 3; ++k)
+			new_cache[new_cache_count++] = triangle_vertices[k];
+
+		for (int i = 0; i < cache_count; ++i)
+		{
+			int v = cache[i];
+
+			if (v != triangle_vertices[0] && v != triangle_vertices[1] && v != triangle_vertices[2])
+				new_cache[new_cache_count++] = v;
+		}
+
+		// update the scores of every vertex in the cache
+		// and of anything pushed out of it
+		for (int i = 0; i < new_cache_count; ++i)
+		{
+			int v = new_cache[i];
+			vertex_cache_position[v] = i < kVertexCacheSize ? i : -1;
+			vertex_score[v] = VertexCacheScore(vertex_cache_position[v], vertex_remaining[v]);
+		}
+
+		cache_count = new_cache_count < kVertexCacheSize ? new_cache_count : kVertexCacheSize;
+
+		for (int i = 0; i < cache_count; ++i)
+			cache[i] = new_cache[i];
+
+		// rescore triangles using cached vertices and pick the best
+		best_triangle = -1;
+		float best_score = -FLT_MAX;
+
+		for (int i = 0; i < new_cache_count; ++i)
+		{
+			int v = new_cache[i];
+			int start = vertex_triangle_start[v];
+			int end = start + vertex_remaining[v];
+
+			for (int j = start; j < end; ++j)
+			{
+				int t = vertex_triangles[j];
+
+				triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+
+				if (i < cache_count && triangle_score[t] > best_score)
+				{
+					best_score = triangle_score[t];
+					best_triangle = t;
+				}
+			}
+		}
+	}
+
+	// small meshes can already fit the cache in generation order
+	// so only keep the new order if it transforms fewer vertices
+	if (CalculateACMR(output, kVertexCacheSize) < CalculateACMR(indices, kVertexCacheSize))
+		indices.swap(output);
+}
+
+//
+// CalculateACMR
+//
+float PrimitiveBuilder::CalculateACMR(const std::vector<UInt32>& indices, const int cache_size)
+{
+	if (indices.size() < 3)
+		return 0.0f;
+
+	// simulated FIFO cache
+	std::vector<UInt32> cache(cache_size);
+	int cache_count = 0;
+	int cache_next = 0;
+	int misses = 0;
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		bool hit = false;
+
+		for (int c = 0; c < cache_count; ++c)
+		{
+			if (cache[c] == indices[i])
+			{
+				hit = true;
+				break;
+			}
+		}
+
+		if (!hit)
+		{
+			misses++;
+			cache[cache_next] = indices[i];
+			cache_next = (cache_next + 1) % cache_size;
+
+			if (cache_count < cache_size)
+				cache_count++;
+		}
+	}
+
+	return (float)misses / (float)(indices.size() / 3);
+}
+
+//
+// InitIndexBuffer
+//
+void PrimitiveBuilder::InitIndexBuffer(gef::Primitive* primitive, const UInt32* indices, const int num_indices, const int num_vertices)
+{
+	if (num_vertices <= 0xffff)
+	{
+		// every index fits in 16 bits, halving the index buffer
+		std::vector<UInt16> short_indices(indices, indices + num_indices);
+		primitive->InitIndexBuffer(platform_, &short_indices[0], num_indices, sizeof(UInt16));
+	}
+	else
+	{
+		primitive->InitIndexBuffer(platform_, indices, num_indices, sizeof(UInt32));
+	}
 }
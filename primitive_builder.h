@@ -4,11 +4,13 @@
 #include <maths/vector4.h>
 #include <graphics/material.h>
 #include <cstddef>
+#include <vector>
 
 namespace gef
 {
 	class Mesh;
 	class Platform;
+	class Primitive;
 }
 
 class PrimitiveBuilder
@@ -43,6 +45,82 @@ public:
 	gef::Mesh* CreateSphereMesh(const float radius, const int phi, const int theta, gef::Vector4 centre = gef::Vector4(0.0f, 0.0f, 0.0f), gef::Material* material = NULL);
 
 
+	/// @brief Gets a shared box shaped mesh from the mesh registry
+	/// @return The shared mesh
+	/// @param[in] half_size	The half size of the box.
+	/// @param[in] centre		The centre of the box.
+	/// @note The mesh is built the first time it is asked for. Every call must be matched with ReleaseMesh.
+	gef::Mesh* AcquireBoxMesh(const gef::Vector4& half_size, gef::Vector4 centre = gef::Vector4(0.0f, 0.0f, 0.0f));
+
+	/// @brief Gets a shared box mesh for an object, sized by the unit box mode
+	/// @return The shared mesh
+	/// @param[in] half_size	The half size of the box.
+	/// @param[out] scale		The scale the object must be drawn with.
+	/// @note With unit box meshes on every box shares the 1 x 1 x 1 cube and the size goes in the scale.
+	gef::Mesh* AcquireScaledBoxMesh(const gef::Vector4& half_size, gef::Vector4& scale);
+
+	/// @brief Sets whether AcquireScaledBoxMesh shares one unit cube between all sizes.
+	/// @param[in] unit_box_meshes	True to share the unit cube.
+	inline void set_unit_box_meshes(bool unit_box_meshes) {
+		unit_box_meshes_ = unit_box_meshes;
+	};
+
+	/// @brief Gets a shared sphere shaped mesh from the mesh registry
+	/// @return The shared mesh
+	/// @param[in] radius		The radius of the sphere.
+	/// @param[in] centre		The centre of the sphere.
+	/// @note The mesh is built the first time it is asked for. Every call must be matched with ReleaseMesh.
+	gef::Mesh* AcquireSphereMesh(const float radius, const int phi, const int theta, gef::Vector4 centre = gef::Vector4(0.0f, 0.0f, 0.0f));
+
+	/// @brief Gets a shared sphere shaped mesh at a level of detail from the mesh registry
+	/// @return The shared mesh
+	/// @param[in] radius		The radius of the sphere.
+	/// @param[in] lod			The level of detail, 0 is the most detailed. See SelectSphereLod.
+	/// @param[in] centre		The centre of the sphere.
+	gef::Mesh* AcquireSphereLodMesh(const float radius, const int lod, gef::Vector4 centre = gef::Vector4(0.0f, 0.0f, 0.0f));
+
+	/// @brief Gets the phi and theta tessellation of a sphere level of detail.
+	/// @return The number of vertices around each ring and the number of rings.
+	/// @param[in] lod			The level of detail, clamped to the levels available.
+	static int GetSphereLodTessellation(const int lod);
+
+	/// @brief Picks the sphere level of detail for the size of a sphere on screen.
+	/// @return The level of detail, 0 to kNumSphereLods - 1.
+	/// @param[in] screen_radius	The radius of the sphere on screen in pixels.
+	static int SelectSphereLod(const float screen_radius);
+
+	/// @brief Builds the triangle list indices for a sphere in the order they are generated.
+	/// @param[in] phi			The number of vertices around each ring.
+	/// @param[in] theta		The number of rings.
+	/// @param[out] indices		The triangle list indices.
+	static void BuildSphereIndices(const int phi, const int theta, std::vector<UInt32>& indices);
+
+	/// @brief Reorders a triangle list so each vertex is reused while it is still in the post transform cache.
+	/// @param[in,out] indices	The triangle list indices.
+	/// @param[in] num_vertices	The number of vertices the indices refer to.
+	/// @note Uses Tom Forsyth's linear speed vertex cache optimisation. The original order is kept if it was already better.
+	static void OptimiseVertexCache(std::vector<UInt32>& indices, const int num_vertices);
+
+	/// @brief Calculates the average cache miss ratio of a triangle list.
+	/// @return The number of vertices transformed per triangle, from 0.5 at best to 3 at worst.
+	/// @param[in] indices		The triangle list indices.
+	/// @param[in] cache_size	The number of entries in the simulated FIFO cache.
+	static float CalculateACMR(const std::vector<UInt32>& indices, const int cache_size);
+
+	/// @brief The number of sphere levels of detail.
+	static const int kNumSphereLods = 3;
+
+	/// @brief Releases a mesh from the mesh registry
+	/// @param[in] mesh		The mesh returned by AcquireBoxMesh or AcquireSphereMesh. NULL is valid.
+	/// @note The mesh is deleted once its last reference is released.
+	void ReleaseMesh(const gef::Mesh* mesh);
+
+	/// @brief Get the number of meshes in the mesh registry.
+	/// @return The number of meshes currently built.
+	inline int cached_mesh_count() const {
+		return (int)cached_meshes_.size();
+	};
+
 	/// @brief Get the default cube mesh.
 	/// @return The mesh for the default cube.
 	/// @note The default cube has dimensions 1 x 1 x 1 with the centre at 0, 0, 0.
@@ -127,8 +205,42 @@ public:
 	}
 
 protected:
+	enum MeshShape
+	{
+		kBoxShape,
+		kSphereShape
+	};
+
+	/// @brief Everything that makes a registry mesh different from another.
+	struct MeshKey
+	{
+		MeshShape shape;
+		float dimensions[3];
+		int phi;
+		int theta;
+		float centre[3];
+
+		bool operator==(const MeshKey& other) const;
+	};
+
+	/// @brief A mesh in the registry and the number of users it has.
+	struct CachedMesh
+	{
+		MeshKey key;
+		gef::Mesh* mesh;
+		int ref_count;
+	};
+
+	gef::Mesh* AcquireMesh(const MeshKey& key);
+
+	/// @brief Creates a primitive's index buffer with 16 bit indices when every index fits.
+	void InitIndexBuffer(gef::Primitive* primitive, const UInt32* indices, const int num_indices, const int num_vertices);
+
 	gef::Platform& platform_;
 
+	std::vector<CachedMesh> cached_meshes_;
+	bool unit_box_meshes_;
+
 	gef::Mesh* default_cube_mesh_;
 	gef::Mesh* default_sphere_mesh_;
 
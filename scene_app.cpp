@@ -8,7 +8,15 @@
 #include <maths/math_utils.h>
 #include "input\keyboard.h"
 #include "load_texture.h"
+#include "PrimitiveBenchmark.h"
+#include "LevelEnvironment.h"
+#include "ReachabilitySolver.h"
+#include "NavPlanner.h"
+#include "PatrolEnemyManager.h"
+#include "FlyingSwarm.h"
 #include <set>
+#include <math.h>
+#include <float.h>
 
 #define SMALL_PLATFORM_NUM_SA 95
 #define MEDIUM_PLATFORM_NUM_MA 12
@@ -22,8 +30,322 @@
 #define GROUND_ENEMY_NUM 11
 #define SPIKE_NUM 40
 
+// player, collectable, three ability pickups and four borders
+#define SINGLE_BODY_NUM 9
+
+// total bodies created by the level
+// each has one fixture
+#define LEVEL_BODY_NUM (SINGLE_BODY_NUM + SMALL_PLATFORM_NUM_SA + MEDIUM_PLATFORM_NUM_MA + MOVING_PLATFORM_NUM + \
+	VERY_SMALL_PLATFORM_NUM + BIG_PLATFORM_NUM + BLOCKING_WALL_NUM + BIGGER_BLOCKING_WALL_NUM + AREA_WALL_NUM + \
+	RESET_WALL_NUM + GROUND_ENEMY_NUM + SPIKE_NUM + PATROL_PROMOTED_NUM + DESTRUCTIBLE_BLOCK_NUM + \
+	DEBRIS_POOL_BLOCKS * DEBRIS_PER_BLOCK)
+
+// memory arena sizes
+
+#define FRAME_ARENA_SIZE (64 * 1024)
+#define LEVEL_ARENA_SIZE (256 * 1024)
+
+// input latency instrumentation
+// set to 1 to record input to rendered frame latency
+// the report is printed when the level is released
+
+#define INPUT_LATENCY_TRACKING 0
+
+// set to 1 to handle player input before the physics step
+// so the impulse is simulated and drawn in the same frame
+
+#define HANDLE_INPUT_BEFORE_PHYSICS 0
+
+// set to 1 to draw every box with the one unit cube mesh
+// scaled to size by each object's transform
+
+#define UNIT_BOX_MESHES 1
+
+// set to 1 to print the primitive mesh benchmark when the level starts
+
+#define PRIMITIVE_BENCHMARK 0
+
+// set to 1 to simplify the loaded models into lod scene files
+// written next to the originals when the app starts
+
+#define COOK_MESH_LODS 0
+
+// set to 1 to cook the models into scene blobs
+// run after COOK_MESH_LODS so the blobs hold every level of detail
+
+#define COOK_SCENE_BLOBS 0
+
+// radius of the ability pickup spheres
+
+#define ABILITY_PICKUP_RADIUS 1.0f
+
+// heap tracking
+// set to 1 to show live heap use for each category on the hud
+// the csv is written when the app is cleaned up
+
+#define MEMORY_OVERLAY 0
+#define MEMORY_CSV_FILENAME "memory_report.csv"
+
+// heap budgets for each category
+
+#define PHYSICS_MEMORY_BUDGET (4 * 1024 * 1024)
+#define RENDER_MEMORY_BUDGET (48 * 1024 * 1024)
+#define AUDIO_MEMORY_BUDGET (32 * 1024 * 1024)
+#define UI_MEMORY_BUDGET (4 * 1024 * 1024)
+#define LEVEL_MEMORY_BUDGET (8 * 1024 * 1024)
+
+// log records the ring buffer holds before messages are dropped
+
+#define LOG_BUFFER_RECORDS 4096
+
+// hot reload
+// set to 1 to reload the tuning and level layout files
+// when they are saved while the level is running
+// the files are written from the built in values when the level starts
+// so only changes saved after that are applied
+
+#define HOT_RELOAD 0
+#define HOT_RELOAD_POLL_SECONDS 0.5f
+#define TUNING_FILENAME "tuning.txt"
+#define LEVEL_LAYOUT_FILENAME "level.txt"
+
+// spatial hash
+// cell size in world units, about the width of a small platform
+// set the benchmark to 1 to time gameplay queries when the level starts
+
+#define SPATIAL_HASH_CELL_SIZE 8.0f
+#define SPATIAL_HASH_BENCHMARK 0
+
+// simulation farm
+// set the worlds above 0 to run that many copies of the level when it starts
+// each plays the input script with the jump value spread either side of the current one
+// threads at 0 uses one per core
+
+#define SIMULATION_FARM_WORLDS 0
+#define SIMULATION_FARM_TICKS (60 * 60)
+#define SIMULATION_FARM_THREADS 0
+#define SIMULATION_FARM_JUMP_SPREAD 0.25f
+#define SIMULATION_FARM_INPUT "farm_input.txt"
+
+// set to 1 to record the player's input each tick
+// saved as a farm input script when the level is released
+
+#define RECORD_INPUT 0
+#define RECORD_INPUT_FILENAME "input_recording.txt"
+
+// level environment
+// set the benchmark to 1 to time a batch of automated player environments
+// stepped with random actions when the level starts
+
+#define LEVEL_ENV_BENCHMARK 0
+#define LEVEL_ENV_COUNT 64
+#define LEVEL_ENV_BENCHMARK_STEPS 1000
+
+// reachability solver
+// set to 1 to search the level for a route to the collectable when it starts
+// prints the par time and the abilities each area was reached with
+// the fastest route is saved as a farm input script
+
+#define REACHABILITY_SOLVER 0
+#define REACHABILITY_MAX_STATES 200000
+#define REACHABILITY_ROUTE_FILENAME "par_route.txt"
+
+// enemy navigation
+// set to 1 for ground enemies to chase the player when in range
+// finding their way over the platforms instead of patrolling
+// the planner expands at most the given nodes a frame and keeps the given paths
+
+#define ENEMY_NAVIGATION 0
+#define ENEMY_CHASE_RANGE 30.0f
+#define ENEMY_CHASE_SPEED 4.5f
+#define ENEMY_JUMP_SPEED 12.0f
+#define NAV_EXPANSIONS_PER_FRAME 256
+#define NAV_PATH_CACHE_SIZE 64
+
+// patrol enemies
+// set the number above 0 to spawn that many enemies with no physics body along the platforms
+// an enemy the player runs into is knocked back with one of the promoted bodies
+// set the benchmark to 1 to time a separate set of enemies against the frame budget
+
+#define PATROL_ENEMY_NUM 0
+#define PATROL_ENEMY_SPEED 3.0f
+#define PATROL_PROMOTED_NUM 16
+#define PATROL_KNOCKBACK_SPEED 8.0f
+#define PATROL_ENEMY_BENCHMARK 0
+#define PATROL_BENCHMARK_ENEMIES 10000
+#define PATROL_BENCHMARK_FRAMES 600
+#define PATROL_BENCHMARK_BUDGET_MS 1.0f
+
+// flying swarm
+// set the number above 0 to spawn a flocking swarm over the level that chases the player
+// set the benchmark to 1 to time doubling swarm sizes up to the agents given against the budget
+
+#define FLYING_SWARM_NUM 0
+#define FLYING_SWARM_NEIGHBOUR_RADIUS 3.0f
+#define FLYING_SWARM_AGENT_SIZE 0.5f
+#define FLYING_SWARM_HIT_RADIUS 1.5f
+#define FLYING_SWARM_BENCHMARK 0
+#define FLYING_SWARM_BENCHMARK_AGENTS 8000
+#define FLYING_SWARM_BENCHMARK_TICKS 120
+#define FLYING_SWARM_BUDGET_MS 2.0f
+
+// physics queries
+// rays and box queries asked for during a frame are run together after the physics step
+// spread over the threads given, 0 for one per core
+// set the ground probe to 1 for the player to find the ground with two rays down from their feet
+// instead of from their vertical velocity
+// set line of sight to 1 for chasing enemies to only follow a player they can see
+// set the benchmark to 1 to time the given rays one at a time against batched
+
+#define PHYSICS_QUERY_THREADS 0
+#define GROUND_PROBE 0
+#define GROUND_PROBE_DEPTH 0.1f
+#define ENEMY_LINE_OF_SIGHT 1
+#define PHYSICS_QUERY_BENCHMARK 0
+#define PHYSICS_QUERY_BENCHMARK_RAYS 10000
+
+// destructible blocks
+// set to 1 to place the blocks below, which crumble a short time after the player touches them
+// and are destroyed along with picked up pickups once the physics step is done
+
+#define DESTRUCTIBLE_BLOCKS 0
+#define DESTRUCTIBLE_BLOCK_NUM 8
+#define DESTRUCTIBLE_BLOCK_HALF_SIZE 0.5f
+#define DESTRUCTIBLE_CRUMBLE_SECONDS 0.5f
+
+// a wall on the ground left of the start with a ledge off the top of it
+
+static const b2Vec2 destructibleBlockPositions[DESTRUCTIBLE_BLOCK_NUM] =
+{
+	b2Vec2(-12.5f, 1.0f),
+	b2Vec2(-12.5f, 2.0f),
+	b2Vec2(-12.5f, 3.0f),
+	b2Vec2(-12.5f, 4.0f),
+	b2Vec2(-13.5f, 6.0f),
+	b2Vec2(-14.5f, 6.0f),
+	b2Vec2(-15.5f, 6.0f),
+	b2Vec2(-16.5f, 6.0f)
+};
+
+// debris
+// each crumbled block throws out pieces spawned from a pool of bodies created with the level
+// the pool holds enough for the given number of blocks crumbling at once,
+// or every block if there are fewer
+
+#define DEBRIS_PER_BLOCK 4
+#define DEBRIS_POOL_BLOCKS 4
+#define DEBRIS_HALF_SIZE 0.2f
+#define DEBRIS_SPEED 4.0f
+#define DEBRIS_LIFETIME 1.5f
+
+// level areas
+// the start, middle and top of the level, each split into a left and right half
+// used for the activity regions and the reachability report
+
+#define LEVEL_AREA_NUM 6
+
+struct LevelArea
+{
+	const char* name;
+	b2Vec2 lowerBound;
+	b2Vec2 upperBound;
+};
+
+static const LevelArea levelAreas[LEVEL_AREA_NUM] =
+{
+	{ "start left", b2Vec2(-200.0f, 0.0f), b2Vec2(0.0f, 70.0f) },
+	{ "start right", b2Vec2(0.0f, 0.0f), b2Vec2(200.0f, 70.0f) },
+	{ "middle left", b2Vec2(-200.0f, 70.0f), b2Vec2(0.0f, 170.0f) },
+	{ "middle right", b2Vec2(0.0f, 70.0f), b2Vec2(200.0f, 170.0f) },
+	{ "top left", b2Vec2(-200.0f, 170.0f), b2Vec2(0.0f, 300.0f) },
+	{ "top right", b2Vec2(0.0f, 170.0f), b2Vec2(200.0f, 300.0f) }
+};
+
+// moving platform routes
+// start, end, speed and whether the platform moves along the y axis
+
+static const PatrolRoute movingPlatformRoutes[MOVING_PLATFORM_NUM] =
+{
+	{ 53.0f, 100.0f, 4.0f, true },
+	{ 25.0f, -50.0f, 4.0f, false },
+	{ 160.0f, 120.0f, 2.125f, true },
+	{ 90.0f, 130.0f, 2.125f, true },
+	{ 187.5f, 212.0f, 4.0f, true },
+	{ 243.0f, 223.0f, 4.25f, true },
+	{ 228.0f, 248.0f, 4.25f, true },
+	{ 253.0f, 233.0f, 4.25f, true },
+	{ 238.0f, 258.0f, 4.25f, true },
+	{ 162.5f, 105.0f, 4.0f, false },
+	{ 187.5f, 215.0f, 4.15f, true },
+	{ 55.0f, 35.0f, 4.0f, false },
+	{ 243.0f, 265.0f, 4.0f, true }
+};
+
+// ground enemy routes
+// start, end and speed along the x axis
+
+static const PatrolRoute groundEnemyRoutes[GROUND_ENEMY_NUM] =
+{
+	{ 45.0f, 80.0f, 4.0f, false },
+	{ 125.0f, 90.0f, 4.0f, false },
+	{ 109.0f, 125.0f, 4.5f, false },
+	{ 61.0f, 45.0f, 4.5f, false },
+	{ 60.0f, 25.0f, 7.0f, false },
+	{ 20.0f, -10.0f, 7.0f, false },
+	{ -33.0f, -50.0f, 6.5f, false },
+	{ -115.0f, -85.0f, 6.5f, false },
+	{ -80.0f, -55.0f, 6.5f, false },
+	{ 116.0f, 135.0f, 3.5f, false },
+	{ 95.0f, 105.0f, 4.25f, false }
+};
+
+// the pressed action a player state is entered by
+// used to tell which press a move came from
+
+static unsigned int PlayerStateAction(PLAYER_STATE state)
+{
+	switch (state)
+	{
+	case JUMPING:
+	case DOUBLE_JUMPING:
+		return ActionInput::ActionBit(ACTION_JUMP);
+	case DASHING_RIGHT:
+	case DASHING_LEFT:
+		return ActionInput::ActionBit(ACTION_DASH);
+	case MOVING_RIGHT:
+		return ActionInput::ActionBit(ACTION_RIGHT);
+	case MOVING_LEFT:
+		return ActionInput::ActionBit(ACTION_LEFT);
+	default:
+		return 0;
+	}
+}
+
 SceneApp::SceneApp(gef::Platform& platform) :
 	Application(platform),
+	frameArena(FRAME_ARENA_SIZE, "frame"),
+	levelArena(LEVEL_ARENA_SIZE, "level"),
+	groundEnemyVec(LevelGroundEnemyVec::allocator_type(&levelArena)),
+	spikes_vec(LevelSpikeVec::allocator_type(&levelArena)),
+	spikes_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
+	small_platforms_SA(LevelObjectVec::allocator_type(&levelArena)),
+	small_platform_bodies_SA(LevelBodyVec::allocator_type(&levelArena)),
+	medium_platforms_MA(LevelObjectVec::allocator_type(&levelArena)),
+	medium_platform_bodies_MA(LevelBodyVec::allocator_type(&levelArena)),
+	big_platforms_vec(LevelObjectVec::allocator_type(&levelArena)),
+	big_platform_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
+	movPlatformsVec(LevelMovingPlatformVec::allocator_type(&levelArena)),
+	movPlatform_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
+	very_small_plat_vec(LevelObjectVec::allocator_type(&levelArena)),
+	very_small_plat_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
+	blocking_wall_vec(LevelObjectVec::allocator_type(&levelArena)),
+	blocking_wall_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
+	bigger_blocking_wall_vec(LevelObjectVec::allocator_type(&levelArena)),
+	bigger_blocking_wall_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
+	area_walls_vec(LevelObjectVec::allocator_type(&levelArena)),
+	area_walls_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
+	reset_walls_vec(LevelObjectVec::allocator_type(&levelArena)),
+	reset_walls_bodies_vec(LevelBodyVec::allocator_type(&levelArena)),
 	sprite_renderer_(NULL),
 	renderer_3d_(NULL),
 	primitive_builder_(NULL),
@@ -58,32 +380,61 @@ SceneApp::SceneApp(gef::Platform& platform) :
 	htp_background_(NULL),
 	win_game_background(NULL),
 	audio_manager(NULL),
-	scene_assets_(NULL)
+	spike_scene_assets_(NULL),
+	collectable_scene_assets_(NULL),
+	hotReloadWatcher(HOT_RELOAD_POLL_SECONDS),
+	spatialHash(SPATIAL_HASH_CELL_SIZE),
+	playerSpatialHandle(-1),
+	tuningFileIndex(-1),
+	levelLayoutFileIndex(-1),
+	debrisArchetype(-1)
 {
 }
 
 void SceneApp::Init()
 {
-	
+	// starts the logging thread first so everything after can log
+
+	Logger::Start(LOG_BUFFER_RECORDS);
+
+	// records the heap before anything is created
+	// and sets the budget for each category
+
+	MemoryTracker::TakeSnapshot(memoryBaseline);
+
+	MemoryTracker::SetBudget(MEM_PHYSICS, PHYSICS_MEMORY_BUDGET);
+	MemoryTracker::SetBudget(MEM_RENDER, RENDER_MEMORY_BUDGET);
+	MemoryTracker::SetBudget(MEM_AUDIO, AUDIO_MEMORY_BUDGET);
+	MemoryTracker::SetBudget(MEM_UI, UI_MEMORY_BUDGET);
+	MemoryTracker::SetBudget(MEM_LEVEL, LEVEL_MEMORY_BUDGET);
+
+	{
+		MemoryScope uiScope(MEM_UI);
 
-	sprite_renderer_ = gef::SpriteRenderer::Create(platform_);
-	InitFont();
+		sprite_renderer_ = gef::SpriteRenderer::Create(platform_);
+		InitFont();
+	}
 
 	// initialise input manager
 	input_manager_ = gef::InputManager::Create(platform_);
-	audio_manager = gef::AudioManager::Create();
 
 	// loads all audio samples
 
-	menu_music = audio_manager->LoadSample("win-music.wav", platform_);
-	level_music = audio_manager->LoadSample("level_music.wav", platform_);
-	game_over = audio_manager->LoadSample("SamusDeath_1.wav", platform_);
-	player_wins = audio_manager->LoadSample("menu-music.wav", platform_);
-	ability_pickup = audio_manager->LoadSample("ability-pickup.wav", platform_);
-	jump_sound = audio_manager->LoadSample("jump.wav", platform_);
-	dash_sound = audio_manager->LoadSample("dash-sound.wav", platform_);
-	hit_sound = audio_manager->LoadSample("game-hit.wav", platform_);
-	menu_button_sound = audio_manager->LoadSample("menu-click.wav", platform_);
+	{
+		MemoryScope audioScope(MEM_AUDIO);
+
+		audio_manager = gef::AudioManager::Create();
+
+		menu_music = audio_manager->LoadSample("win-music.wav", platform_);
+		level_music = audio_manager->LoadSample("level_music.wav", platform_);
+		game_over = audio_manager->LoadSample("SamusDeath_1.wav", platform_);
+		player_wins = audio_manager->LoadSample("menu-music.wav", platform_);
+		ability_pickup = audio_manager->LoadSample("ability-pickup.wav", platform_);
+		jump_sound = audio_manager->LoadSample("jump.wav", platform_);
+		dash_sound = audio_manager->LoadSample("dash-sound.wav", platform_);
+		hit_sound = audio_manager->LoadSample("game-hit.wav", platform_);
+		menu_button_sound = audio_manager->LoadSample("menu-click.wav", platform_);
+	}
 	
 
 	// initialising bool values
@@ -98,9 +449,6 @@ void SceneApp::Init()
 	menu_music_playing = true;
 	audio_manager->PlaySample(0,true);
 	
-	// initialise controls for keyboard
-	kb = input_manager_->keyboard();
-
 	// set initial app state
 	set_type_gamestate(INIT);
 
@@ -108,11 +456,34 @@ void SceneApp::Init()
 	difficulty = DIFF_NORMAL;
 	volume = SEVENTY_FIVE;
 
+	// builds the lod scene files and scene blobs offline
+
+	if (COOK_MESH_LODS)
+	{
+		MeshLod::CookLodScenes(platform_, "spike.scn");
+		MeshLod::CookLodScenes(platform_, "morph-ball.scn");
+	}
+
+	// cooks the scene files and their lods into scene blobs
+
+	if (COOK_SCENE_BLOBS)
+	{
+		SceneBlob::Cook(platform_, "spike.scn", "spike.mblob");
+		SceneBlob::Cook(platform_, "morph-ball.scn", "morph-ball.mblob");
+	}
+
+	// set up input latency instrumentation
+	inputLatency.setEnabled(INPUT_LATENCY_TRACKING != 0);
+	handleInputBeforePhysics = HANDLE_INPUT_BEFORE_PHYSICS != 0;
+
 	// set app is running
 	isApplicationRunning = true;
 
 	// call frontend initialiser
-	FrontendInit();
+	{
+		MemoryScope uiScope(MEM_UI);
+		FrontendInit();
+	}
 	
 }
 
@@ -126,25 +497,58 @@ void SceneApp::CleanUp()
 	delete sprite_renderer_;
 	sprite_renderer_ = NULL;
 
-	audio_manager->UnloadAllSamples();
+	if (audio_manager)
+	{
+		audio_manager->UnloadAllSamples();
+	}
+
+	delete audio_manager;
+	audio_manager = NULL;
+
+	frameArena.PrintStats();
+
+	// prints anything left in the log buffer
+	// and frees it before the leak report
+
+	Logger::Stop();
+
+	// reports heap use and anything not freed since init
+
+	MemoryTracker::PrintReport();
+	MemoryTracker::PrintLeaks(memoryBaseline);
+	MemoryTracker::WriteCSV(MEMORY_CSV_FILENAME);
 
 }
 
 bool SceneApp::Update(float frame_time)
 {
+	// frees last frame's scratch memory
+	frameArena.Reset();
+
 	fps_ = 1.0f / frame_time;
 
+	inputLatency.OnFrameStart();
+
 	if(input_manager_)
 		input_manager_->Update();
 
-	if (kb)
+	// reads the keyboard and controller once
+	// for every state to use this frame
+	action_input_.Update(input_manager_);
+
+	// starts following any input that moves the player
+	if (gamestatetype == LEVEL1)
 	{
-		// returns current function false
-		// closes app
-		if (kb->IsKeyPressed(gef::Keyboard::KC_ESCAPE))
-		{
-			return false;
-		}
+		inputLatency.OnInputEdge(action_input_.getPressedActions() &
+			(ActionInput::ActionBit(ACTION_JUMP) | ActionInput::ActionBit(ACTION_DASH) |
+			ActionInput::ActionBit(ACTION_LEFT) | ActionInput::ActionBit(ACTION_RIGHT)));
+	}
+
+	// returns current function false
+	// closes app
+	if (action_input_.IsPressed(ACTION_QUIT))
+	{
+		return false;
 	}
 
 	// sets volume based on 
@@ -173,6 +577,9 @@ bool SceneApp::Update(float frame_time)
 	
 	UpdateGameStateMachine(frame_time);
 
+	// reports any category that has gone over budget
+	MemoryTracker::CheckBudgets();
+
 	return isApplicationRunning;
 }
 
@@ -181,6 +588,8 @@ void SceneApp::Render()
 	
 	RenderGameStateMachine();
 
+	// finishes any input latency sample drawn this frame
+	inputLatency.OnFrameRendered();
 }
 
 gef::Scene* SceneApp::LoadSceneAssets(gef::Platform& platform, const char* filename)
@@ -223,6 +632,7 @@ void SceneApp::InitPlayer()
 	player_.setDashActive(false);
 	player_.setDoubleJumpActive(false);
 	player_.setResetWallActive(false);
+	abilityEvents.Reset();
 
 	// changes starting health value
 	// based on difficulty selected in options
@@ -286,21 +696,36 @@ void SceneApp::InitAllSpikes()
 
 	const char* scene_assest_filename = "spike.scn";
 	
-	scene_assets_ = LoadSceneAssets(platform_, scene_assest_filename);
+	// uses the cooked scene blob when there is one
 
-	if (scene_assets_)
+	if (spikeBlob.Load(platform_, "spike.mblob"))
 	{
-		spikeObj.set_mesh(GetMeshFromSceneAssets(scene_assets_));
+		spikeObj.set_mesh(spikeBlob.GetMesh(0));
+		spikeLods.InitFromBlob(spikeBlob);
 	}
 
 	else
 	{
-		gef::DebugOut("Scene file %s failed to load\n", scene_assest_filename);
+		spike_scene_assets_ = LoadSceneAssets(platform_, scene_assest_filename);
+
+		if (spike_scene_assets_)
+		{
+			spikeObj.set_mesh(GetMeshFromSceneAssets(spike_scene_assets_));
+			spikeLods.Init(platform_, spike_scene_assets_, scene_assest_filename);
+		}
+
+		else
+		{
+			gef::DebugOut("Scene file %s failed to load\n", scene_assest_filename);
+		}
 	}
 
 
 	// push back values for spike obj and body vectors
 
+	spikes_vec.reserve(SPIKE_NUM);
+	spikes_bodies_vec.reserve(SPIKE_NUM);
+
 	for (int i = 0; i < SPIKE_NUM; i++)
 	{
 		spikes_vec.push_back(spikeObj);
@@ -424,16 +849,28 @@ void SceneApp::InitCollectables()
 
 	const char* scene_assest_filename = "morph-ball.scn";
 
-	scene_assets_ = LoadSceneAssets(platform_, scene_assest_filename);
+	// uses the cooked scene blob when there is one
 
-	if (scene_assets_)
+	if (collectableBlob.Load(platform_, "morph-ball.mblob"))
 	{
-		collectable_.set_mesh(GetMeshFromSceneAssets(scene_assets_));
+		collectable_.set_mesh(collectableBlob.GetMesh(0));
+		collectableLods.InitFromBlob(collectableBlob);
 	}
 
 	else
 	{
-		gef::DebugOut("Scene file %s failed to load\n", scene_assest_filename);
+		collectable_scene_assets_ = LoadSceneAssets(platform_, scene_assest_filename);
+
+		if (collectable_scene_assets_)
+		{
+			collectable_.set_mesh(GetMeshFromSceneAssets(collectable_scene_assets_));
+			collectableLods.Init(platform_, collectable_scene_assets_, scene_assest_filename);
+		}
+
+		else
+		{
+			gef::DebugOut("Scene file %s failed to load\n", scene_assest_filename);
+		}
 	}
 
 	gef::Vector4 collectable_half_dimensions(1.75f, 1.75, 2.0f);
@@ -477,7 +914,7 @@ void SceneApp::InitAllAbilities()
 
 	// setting mesh and mesh values for dash object
 
-	dashPickupMesh = primitive_builder_->CreateSphereMesh(1.0f, 15.0f, 15.0f, dash_half_dimensions); 
+	dashPickupMesh = primitive_builder_->AcquireSphereLodMesh(ABILITY_PICKUP_RADIUS, 1, dash_half_dimensions);
 
 	dashPickup_.set_mesh(dashPickupMesh);
 
@@ -516,7 +953,7 @@ void SceneApp::InitAllAbilities()
 
 	// setting mesh and mesh values for double jump object
 
-	doubleJumpPickupMesh = primitive_builder_->CreateSphereMesh(1.0f, 15.0f, 15.0f, doubleJump_half_dimensions); 
+	doubleJumpPickupMesh = primitive_builder_->AcquireSphereLodMesh(ABILITY_PICKUP_RADIUS, 1, doubleJump_half_dimensions);
 
 	doubleJumpPickup_.set_mesh(doubleJumpPickupMesh);
 
@@ -555,7 +992,7 @@ void SceneApp::InitAllAbilities()
 
 	// setting mesh and mesh values for reset wall object
 
-	resetWallPickupMesh = primitive_builder_->CreateSphereMesh(1.0f, 15.0f, 15.0f, resetWall_half_dimensions); 
+	resetWallPickupMesh = primitive_builder_->AcquireSphereLodMesh(ABILITY_PICKUP_RADIUS, 1, resetWall_half_dimensions);
 
 	resetWallPickup_.set_mesh(resetWallPickupMesh);
 
@@ -586,6 +1023,73 @@ void SceneApp::InitAllAbilities()
 
 	// create a connection between the rigid body and GameObject
 	resetWallPickup_body_->SetUserData(&resetWallPickup_);
+
+	// every level of detail for the pickups
+	// all three pickups share the same sphere
+
+	for (int i = 0; i < PrimitiveBuilder::kNumSphereLods; i++)
+	{
+		abilityPickupLodMeshes[i] = primitive_builder_->AcquireSphereLodMesh(ABILITY_PICKUP_RADIUS, i, resetWall_half_dimensions);
+	}
+}
+
+void SceneApp::InitDestructibleBlocks()
+{
+	b2Vec2 halfSize(DESTRUCTIBLE_BLOCK_HALF_SIZE, DESTRUCTIBLE_BLOCK_HALF_SIZE);
+
+	destructibleBlocks.Init(world_, DESTRUCTIBLE_BLOCK_NUM, halfSize, DESTRUCTIBLE_CRUMBLE_SECONDS);
+
+	for (int i = 0; i < DESTRUCTIBLE_BLOCK_NUM; i++)
+	{
+		destructibleBlocks.AddBlock(destructibleBlockPositions[i]);
+	}
+
+	// setup the mesh every block shares
+	gef::Vector4 box_scale;
+	gef::Mesh* mesh = primitive_builder_->AcquireScaledBoxMesh(gef::Vector4(halfSize.x, halfSize.y, halfSize.x), box_scale);
+	destructibleBlocks.SetMesh(mesh, box_scale);
+}
+
+void SceneApp::InitSpawner()
+{
+	spawner.Init(world_);
+
+	// the debris pool is sized from the blocks placed in the level
+
+	SpawnArchetype debris;
+	debris.name = "debris";
+	debris.objectType = DEBRIS;
+	debris.halfSize = b2Vec2(DEBRIS_HALF_SIZE, DEBRIS_HALF_SIZE);
+	debris.density = 0.5f;
+	debris.poolSize = b2Min(destructibleBlocks.getBlockCount(), DEBRIS_POOL_BLOCKS) * DEBRIS_PER_BLOCK;
+
+	debrisArchetype = spawner.AddArchetype(debris);
+
+	if (debrisArchetype < 0)
+	{
+		return;
+	}
+
+	// setup the mesh every piece shares
+	gef::Vector4 box_scale;
+	gef::Mesh* mesh = primitive_builder_->AcquireScaledBoxMesh(gef::Vector4(DEBRIS_HALF_SIZE, DEBRIS_HALF_SIZE, DEBRIS_HALF_SIZE), box_scale);
+	spawner.SetMesh(debrisArchetype, mesh, box_scale);
+}
+
+void SceneApp::SpawnDebris(b2Vec2 position)
+{
+	// thrown up and out from each corner of the block
+
+	for (int i = 0; i < DEBRIS_PER_BLOCK; i++)
+	{
+		float side = (i % 2 == 0) ? -1.0f : 1.0f;
+		float height = (i / 2 == 0) ? -1.0f : 1.0f;
+
+		b2Vec2 offset(side * DESTRUCTIBLE_BLOCK_HALF_SIZE * 0.5f, height * DESTRUCTIBLE_BLOCK_HALF_SIZE * 0.5f);
+		b2Vec2 velocity(side * DEBRIS_SPEED * 0.5f, DEBRIS_SPEED);
+
+		spawner.Spawn(debrisArchetype, position + offset, velocity, DEBRIS_LIFETIME);
+	}
 }
 
 void SceneApp::InitBottomBorder()
@@ -597,8 +1101,10 @@ void SceneApp::InitBottomBorder()
 	gef::Vector4 bottom_border_half_dimensions(200.0f, 0.5f, 0.5f);
 
 	// setup the mesh for the ground
-	bottom_border_mesh_ = primitive_builder_->CreateBoxMesh(bottom_border_half_dimensions);
+	gef::Vector4 box_scale;
+	bottom_border_mesh_ = primitive_builder_->AcquireScaledBoxMesh(bottom_border_half_dimensions, box_scale);
 	bottom_border_.set_mesh(bottom_border_mesh_);
+	bottom_border_.setScale(box_scale);
 
 	// create a physics body
 	b2BodyDef bottom_border_def;
@@ -635,8 +1141,10 @@ void SceneApp::InitTopBorder()
 	gef::Vector4 top_border_half_dimensions(200.0f, 0.5f, 0.5f);
 
 	// setup the mesh for the roof
-	top_border_mesh_ = primitive_builder_->CreateBoxMesh(top_border_half_dimensions);
+	gef::Vector4 box_scale;
+	top_border_mesh_ = primitive_builder_->AcquireScaledBoxMesh(top_border_half_dimensions, box_scale);
 	top_border_.set_mesh(top_border_mesh_);
+	top_border_.setScale(box_scale);
 
 	// create a physics body
 	b2BodyDef top_border_def;
@@ -672,8 +1180,10 @@ void SceneApp::InitRightBorder()
 	gef::Vector4 right_border_half_dimensions(0.5f, 150.0f, 0.5f);
 
 	// setup the mesh for the right wall
-	right_border_mesh_ = primitive_builder_->CreateBoxMesh(right_border_half_dimensions);
+	gef::Vector4 box_scale;
+	right_border_mesh_ = primitive_builder_->AcquireScaledBoxMesh(right_border_half_dimensions, box_scale);
 	right_border_.set_mesh(right_border_mesh_);
+	right_border_.setScale(box_scale);
 
 	// create a physics body
 	b2BodyDef right_border_def;
@@ -710,8 +1220,10 @@ void SceneApp::InitLeftBorder()
 	gef::Vector4 left_border_half_dimensions(0.5f, 150.0f, 0.5f);
 
 	// setup the mesh for the left wall
-	left_border_mesh_ = primitive_builder_->CreateBoxMesh(left_border_half_dimensions);
+	gef::Vector4 box_scale;
+	left_border_mesh_ = primitive_builder_->AcquireScaledBoxMesh(left_border_half_dimensions, box_scale);
 	left_border_.set_mesh(left_border_mesh_);
+	left_border_.setScale(box_scale);
 
 	// create a physics body
 	b2BodyDef left_border_def;
@@ -749,11 +1261,16 @@ void SceneApp::InitSmallPlatformsSA()
 
 	// setting mesh and mesh values for small platforms
 
-	small_platform_mesh_SA = primitive_builder_->CreateBoxMesh(small_platform_half_dimensions);
+	gef::Vector4 box_scale;
+	small_platform_mesh_SA = primitive_builder_->AcquireScaledBoxMesh(small_platform_half_dimensions, box_scale);
 	small_platform.set_mesh(small_platform_mesh_SA);
+	small_platform.setScale(box_scale);
 
 	// push back values for small platform obj and body vectors
 
+	small_platforms_SA.reserve(SMALL_PLATFORM_NUM_SA);
+	small_platform_bodies_SA.reserve(SMALL_PLATFORM_NUM_SA);
+
 	for (int i = 0; i < SMALL_PLATFORM_NUM_SA; i++)
 	{
 		small_platforms_SA.push_back(small_platform);
@@ -937,11 +1454,16 @@ void SceneApp::InitMeduimPlatformsMA()
 
 	// setting mesh and mesh values for medium platforms
 
-	medium_platform_mesh_MA = primitive_builder_->CreateBoxMesh(medium_platform_half_dimensions);
+	gef::Vector4 box_scale;
+	medium_platform_mesh_MA = primitive_builder_->AcquireScaledBoxMesh(medium_platform_half_dimensions, box_scale);
 	medium_platform.set_mesh(medium_platform_mesh_MA);
+	medium_platform.setScale(box_scale);
 
 	// push back values for medium platform obj and body vectors
 
+	medium_platforms_MA.reserve(MEDIUM_PLATFORM_NUM_MA);
+	medium_platform_bodies_MA.reserve(MEDIUM_PLATFORM_NUM_MA);
+
 	for (int i = 0; i < MEDIUM_PLATFORM_NUM_MA; i++)
 	{
 		medium_platforms_MA.push_back(medium_platform);
@@ -1014,12 +1536,17 @@ void SceneApp::InitBigPlatforms()
 
 	// setting mesh and mesh values for big platforms
 
-	big_platform_mesh_ = primitive_builder_->CreateBoxMesh(big_platform_half_dimensions);
+	gef::Vector4 box_scale;
+	big_platform_mesh_ = primitive_builder_->AcquireScaledBoxMesh(big_platform_half_dimensions, box_scale);
 	big_platform.set_mesh(big_platform_mesh_);
+	big_platform.setScale(box_scale);
 
 
 	// push back values for big platform obj and body vectors
 
+	big_platforms_vec.reserve(BIG_PLATFORM_NUM);
+	big_platform_bodies_vec.reserve(BIG_PLATFORM_NUM);
+
 	for (int i = 0; i < BIG_PLATFORM_NUM; i++)
 	{
 		big_platforms_vec.push_back(big_platform);
@@ -1077,11 +1604,16 @@ void SceneApp::InitMovingPlatforms()
 
 	// setting mesh and mesh values for moving platforms
 
-	movPlatform_mesh = primitive_builder_->CreateBoxMesh(movPlatform_half_dimensions);
+	gef::Vector4 box_scale;
+	movPlatform_mesh = primitive_builder_->AcquireScaledBoxMesh(movPlatform_half_dimensions, box_scale);
 	movPlatform.set_mesh(movPlatform_mesh);
+	movPlatform.setScale(box_scale);
 
 	// push back values for moving platform obj and body vectors
 
+	movPlatformsVec.reserve(MOVING_PLATFORM_NUM);
+	movPlatform_bodies_vec.reserve(MOVING_PLATFORM_NUM);
+
 	for (int i = 0; i < MOVING_PLATFORM_NUM; i++)
 	{
 		movPlatformsVec.push_back(movPlatform);
@@ -1157,12 +1689,17 @@ void SceneApp::InitVerySmallPlats()
 
 	// setting mesh and mesh values for v-small platforms
 
-	very_small_plat_mesh_ = primitive_builder_->CreateBoxMesh(very_small_platform_half_dimensions);
+	gef::Vector4 box_scale;
+	very_small_plat_mesh_ = primitive_builder_->AcquireScaledBoxMesh(very_small_platform_half_dimensions, box_scale);
 	very_small_plat_.set_mesh(very_small_plat_mesh_);
+	very_small_plat_.setScale(box_scale);
 
 
 	// push back values for v-small platform obj and body vectors
 
+	very_small_plat_vec.reserve(VERY_SMALL_PLATFORM_NUM);
+	very_small_plat_bodies_vec.reserve(VERY_SMALL_PLATFORM_NUM);
+
 	for (int i = 0; i < VERY_SMALL_PLATFORM_NUM; i++)
 	{
 		very_small_plat_vec.push_back(very_small_plat_);
@@ -1262,11 +1799,16 @@ void SceneApp::InitBlockingWalls()
 
 	// setting mesh and mesh values for blocking walls
 
-	blocking_wall_mesh_ = primitive_builder_->CreateBoxMesh(blocking_wall_half_dimensions);
+	gef::Vector4 box_scale;
+	blocking_wall_mesh_ = primitive_builder_->AcquireScaledBoxMesh(blocking_wall_half_dimensions, box_scale);
 	blocking_wall_.set_mesh(blocking_wall_mesh_);
+	blocking_wall_.setScale(box_scale);
 
 	// push back values for blocking wall obj and body vectors
 
+	blocking_wall_vec.reserve(BLOCKING_WALL_NUM);
+	blocking_wall_bodies_vec.reserve(BLOCKING_WALL_NUM);
+
 	for (int i = 0; i < BLOCKING_WALL_NUM; i++)
 	{
 		blocking_wall_vec.push_back(blocking_wall_);
@@ -1332,11 +1874,16 @@ void SceneApp::InitBiggerBlockingWalls()
 
 	// setting mesh and mesh values for bigger blocking walls
 
-	bigger_blocking_wall_mesh_ = primitive_builder_->CreateBoxMesh(bigger_blocking_wall_half_dimensions);
+	gef::Vector4 box_scale;
+	bigger_blocking_wall_mesh_ = primitive_builder_->AcquireScaledBoxMesh(bigger_blocking_wall_half_dimensions, box_scale);
 	bigger_blocking_wall_.set_mesh(bigger_blocking_wall_mesh_);
+	bigger_blocking_wall_.setScale(box_scale);
 
 	// push back values for bigger blocking wall obj and body vectors
 
+	bigger_blocking_wall_vec.reserve(BIGGER_BLOCKING_WALL_NUM);
+	bigger_blocking_wall_bodies_vec.reserve(BIGGER_BLOCKING_WALL_NUM);
+
 	for (int i = 0; i < BIGGER_BLOCKING_WALL_NUM; i++)
 	{
 		bigger_blocking_wall_vec.push_back(bigger_blocking_wall_);
@@ -1397,11 +1944,16 @@ void SceneApp::InitAreaWalls()
 
 	// setting mesh and mesh values for area walls
 
-	area_wall_mesh_ = primitive_builder_->CreateBoxMesh(area_wall_half_dimensions);
+	gef::Vector4 box_scale;
+	area_wall_mesh_ = primitive_builder_->AcquireScaledBoxMesh(area_wall_half_dimensions, box_scale);
 	area_wall_.set_mesh(area_wall_mesh_);
+	area_wall_.setScale(box_scale);
 
 	// push back values for area wall obj and body vectors
 
+	area_walls_vec.reserve(AREA_WALL_NUM);
+	area_walls_bodies_vec.reserve(AREA_WALL_NUM);
+
 	for (int i = 0; i < AREA_WALL_NUM; i++)
 	{
 		area_walls_vec.push_back(area_wall_);
@@ -1464,11 +2016,16 @@ void SceneApp::InitResetWalls()
 
 	// setting mesh and mesh values for reset walls
 
-	reset_wall_mesh_ = primitive_builder_->CreateBoxMesh(reset_wall_half_dimensions);
+	gef::Vector4 box_scale;
+	reset_wall_mesh_ = primitive_builder_->AcquireScaledBoxMesh(reset_wall_half_dimensions, box_scale);
 	reset_wall_.set_mesh(reset_wall_mesh_);
+	reset_wall_.setScale(box_scale);
 
 	// push back values for reset wall obj and body vectors
 
+	reset_walls_vec.reserve(RESET_WALL_NUM);
+	reset_walls_bodies_vec.reserve(RESET_WALL_NUM);
+
 	for (int i = 0; i < RESET_WALL_NUM; i++)
 	{
 		reset_walls_vec.push_back(reset_wall_);
@@ -1507,6 +2064,7 @@ void SceneApp::InitResetWalls()
 		resetWallShape[i].SetAsBox(reset_wall_half_dimensions.x(), reset_wall_half_dimensions.y());
 
 		reset_wall_fixture_def[i].shape = &resetWallShape[i];
+		reset_wall_fixture_def[i].friction = 0.0f;
 		
 		reset_walls_bodies_vec[i]->CreateFixture(&reset_wall_fixture_def[i]);
 
@@ -1521,6 +2079,35 @@ void SceneApp::InitResetWalls()
 }
 
 
+void SceneApp::InitActivityRegions()
+{
+	// splits the level into the start, middle and top areas
+	// used for colouring the platforms, each split into a left
+	// and right half
+
+	for (int i = 0; i < LEVEL_AREA_NUM; i++)
+	{
+		activityRegions.AddRegion(levelAreas[i].lowerBound, levelAreas[i].upperBound);
+	}
+
+	// adds all bodies that move on their own
+	// static bodies cost nothing to step so are left out
+
+	for (int i = 0; i < groundEnemyVec.size(); i++)
+	{
+		activityRegions.AddBody(groundEnemyVec[i].getBody());
+	}
+
+	for (int i = 0; i < MOVING_PLATFORM_NUM; i++)
+	{
+		activityRegions.AddBody(movPlatform_bodies_vec[i]);
+	}
+
+	// sets the starting state of every region
+	activityRegions.Update(player_body_->GetPosition());
+}
+
+
 void SceneApp::InitFont()
 {
 	font_ = new gef::Font(platform_);
@@ -1540,6 +2127,29 @@ void SceneApp::DrawHUD()
 		// display frame rate
 		font_->RenderText(sprite_renderer_, gef::Vector4(830.0f, 510.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "FPS: %.1f", fps_);
 
+		// display input latency while it is being tracked
+		if (inputLatency.getEnabled())
+		{
+			InputLatencyReport latencyReport;
+			inputLatency.BuildReport(latencyReport, &frameArena);
+
+			font_->RenderText(sprite_renderer_, gef::Vector4(600.0f, 510.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "Input: %.1fms / %.1fms", latencyReport.p50MS, latencyReport.p95MS);
+		}
+
+		// display live heap use for each category
+
+		if (MEMORY_OVERLAY)
+		{
+			MemorySnapshot memorySnapshot;
+			MemoryTracker::TakeSnapshot(memorySnapshot);
+
+			for (int i = 0; i < MEM_CATEGORY_COUNT; i++)
+			{
+				font_->RenderText(sprite_renderer_, gef::Vector4(10.0f, 300.0f + i * 30.0f, -0.9f), 0.75f, 0xffffffff, gef::TJ_LEFT, "%s: %uKB",
+					MemoryTracker::CategoryName((MEMORY_CATEGORY)i), (unsigned int)(memorySnapshot.categories[i].liveBytes / 1024));
+			}
+		}
+
 		if (gamestatetype == LEVEL1)
 		{
 			// displays message to show when the player can and can't be damaged
@@ -1853,6 +2463,9 @@ void SceneApp::UpdateSimulation(float frame_time)
 
 	world_->Step(timeStep, velocityIterations, positionIterations);
 
+	inputLatency.OnSimulationStep();
+	physicsMemory.Update(world_);
+
 	// update object visuals from simulation data
 
 	player_.UpdateFromSimulation(player_body_);
@@ -1870,288 +2483,736 @@ void SceneApp::UpdateSimulation(float frame_time)
 	// don't have to update the ground visuals as it is static
 
 	// collision detection
-	// get the head of the contact list
-	b2Contact* contact = world_->GetContactList();
-	// get contact count
-	int contact_count = world_->GetContactCount();
+	// runs the level rules for every touching contact
+
+	LevelContactResults contactResults;
+	ProcessLevelContacts(world_, player_body_, abilityEvents, contactResults);
 
-	//std::set<b2Body* > deletionList;
+	// plays a hitting sound if an enemy or spike hit the player
 
-	for (int contact_num = 0; contact_num < contact_count; ++contact_num)
+	if (contactResults.playerHits > 0)
 	{
-		if (contact->IsTouching())
-		{
-			// get the colliding bodies
-			b2Body* bodyA = contact->GetFixtureA()->GetBody();
-			b2Body* bodyB = contact->GetFixtureB()->GetBody();
+		audio_manager->PlaySample(hit_sound);
+	}
 
-			// DO COLLISION RESPONSE HERE
+	// if the player reached the Morph Ball object
+	// the game plays the end game sequence
 
-			// seperate class objects
-			// declared for collision
+	if (contactResults.collectableReached)
+	{
+		isCollectableUp = true;
+	}
 
-			Player* player = NULL;
-			GroundEnemy* groundEnemy = NULL;
-			Spike* spikeEnv = NULL;
-			Collectable* theCollectable = NULL;
+	// gives the player any abilities picked up this step
 
-			// objects derived from game object class
-			// declared for collision
+	PICKUP_ABILITY ability;
 
-			GameObject* stickyWall = NULL;
-			GameObject* movingPlat = NULL;
-			GameObject* dashAbility = NULL;
-			GameObject* doubleJumpAbility = NULL;
-			GameObject* resetWallAbility = NULL;
+	while (abilityEvents.PopEvent(ability))
+	{
+		OnAbilityAcquired(ability);
+	}
 
-			GameObject* gameObjectA = NULL;
-			GameObject* gameObjectB = NULL;
+	// crumbles the blocks the player has touched
 
-			gameObjectA = (GameObject*)bodyA->GetUserData();
-			gameObjectB = (GameObject*)bodyB->GetUserData();
+	if (DESTRUCTIBLE_BLOCKS)
+	{
+		destructibleBlocks.Update(frame_time, player_body_, destructionQueue);
+	}
 
-			// setting gameObjectA to correct object / object type
+	// moves spawned entities and clears away those that have had their time
+	// does nothing when no pools were made
 
-			if (gameObjectA)
-			{
-				if (gameObjectA->type() == PLAYER)
-				{
-					player = (Player*)bodyA->GetUserData();
-				}
+	spawner.Update(frame_time);
 
-				if (gameObjectA->type() == GROUND_ENEMY)
-				{
-					groundEnemy = (GroundEnemy*)bodyA->GetUserData();
-				}
+	// removes the bodies picked up or broken this step
+	// now the step and contacts are done with them
 
-				if (gameObjectA->type() == SPIKE)
-				{
-					spikeEnv = (Spike*)bodyA->GetUserData();
-				}
+	FlushDestruction();
+}
 
-				if (gameObjectA->type() == STICKY_WALL)
-				{
-					stickyWall = (GameObject*)bodyA->GetUserData();
-				}
+void SceneApp::FlushDestruction()
+{
+	if (destructionQueue.Flush(world_) == 0)
+	{
+		return;
+	}
 
-				if (gameObjectA->type() == MOVING)
-				{
-					movingPlat = (GameObject*)bodyA->GetUserData();
-				}
+	// lets go of every destroyed body
 
-				if (gameObjectA->type() == ABILITY_DASH)
-				{
-					dashAbility = (GameObject*)bodyA->GetUserData();
-				}
+	b2Body** pickupBodies[PICKUP_ABILITY_NUM] = { &dashPickup_body_, &doubleJumpPickup_body_, &resetWallPickup_body_ };
+	const std::vector<DestroyedBody>& destroyed = destructionQueue.getDestroyed();
 
-				if (gameObjectA->type() == ABILITY_DJ)
-				{
-					doubleJumpAbility = (GameObject*)bodyA->GetUserData();
-				}
+	for (size_t i = 0; i < destroyed.size(); i++)
+	{
+		for (int p = 0; p < PICKUP_ABILITY_NUM; p++)
+		{
+			if (*pickupBodies[p] == destroyed[i].body)
+			{
+				*pickupBodies[p] = NULL;
+				spatialHash.Remove(pickupSpatialHandles[p]);
+				pickupSpatialHandles[p] = -1;
+			}
+		}
 
-				if (gameObjectA->type() == ABILITY_RW)
-				{
-					resetWallAbility = (GameObject*)bodyA->GetUserData();
-				}
+		// crumbled blocks break into debris
 
-				if (gameObjectA->type() == COLLECTABLE)
-				{
-					theCollectable = (Collectable*)bodyA->GetUserData();
-				}
+		if (destructibleBlocks.Remove(destroyed[i].body))
+		{
+			SpawnDebris(destroyed[i].position);
+		}
+	}
 
+	LOG_DEBUG(LOG_GAME, "destruction: %i bodies destroyed, %i left in the world",
+		(int)destroyed.size(), world_->GetBodyCount());
+}
 
-			}
+void SceneApp::OnAbilityAcquired(PICKUP_ABILITY ability)
+{
+	LOG_INFO(LOG_GAME, "ability acquired: %s", AbilityEventQueue::AbilityName(ability));
 
+	// activates the ability for the player
+	// and turns off the body of the ability object
+	// the hud and pickup drawing read the player's abilities
 
-			// setting gameObjectB to correct object / object type
+	b2Body* pickupBodies[PICKUP_ABILITY_NUM] = { dashPickup_body_, doubleJumpPickup_body_, resetWallPickup_body_ };
 
-			if (gameObjectB)
-			{
-				if (gameObjectB->type() == PLAYER)
-				{
-					player = (Player*)bodyB->GetUserData();
-				}
+	ApplyAbility(ability, player_, pickupBodies[ability], &reset_walls_bodies_vec[0], (int)reset_walls_bodies_vec.size(),
+		destructionQueue);
 
-				if (gameObjectB->type() == GROUND_ENEMY)
-				{
-					groundEnemy = (GroundEnemy*)bodyB->GetUserData();
-				}
+	// plays ability pickup sound
+	audio_manager->PlaySample(ability_pickup);
+}
 
-				if (gameObjectB->type() == SPIKE)
-				{
-					spikeEnv = (Spike*)bodyB->GetUserData();
-				}
+void SceneApp::UpdatePlayerInput(float frame_time)
+{
+	// updates player functionality and variables
+	// and tells the latency tracker which action moved the player
 
-				if (gameObjectB->type() == STICKY_WALL)
-				{
-					stickyWall = (GameObject*)bodyB->GetUserData();
-				}
+	PlayerInput input = Player::ReadInput(action_input_);
 
-				if (gameObjectB->type() == MOVING)
-				{
-					movingPlat = (GameObject*)bodyB->GetUserData();
-				}
+	if (RECORD_INPUT)
+	{
+		recordedInput.Record(input);
+	}
 
-				if (gameObjectB->type() == ABILITY_DASH)
-				{
-					dashAbility = (GameObject*)bodyB->GetUserData();
-				}
+	// the player is grounded if either foot's ray found something
 
-				if (gameObjectB->type() == ABILITY_DJ)
-				{
-					doubleJumpAbility = (GameObject*)bodyB->GetUserData();
-				}
+	if (GROUND_PROBE)
+	{
+		bool probed = groundProbeTickets[0].isValid();
+		bool grounded = physicsQueries.getResult(groundProbeTickets[0]).hit || physicsQueries.getResult(groundProbeTickets[1]).hit;
 
-				if (gameObjectB->type() == ABILITY_RW)
-				{
-					resetWallAbility = (GameObject*)bodyB->GetUserData();
-				}
+		player_.setGroundProbe(probed, grounded);
+	}
 
-				if (gameObjectB->type() == COLLECTABLE)
-				{
-					theCollectable = (Collectable*)bodyB->GetUserData();
-				}
-			}
+	bool movedPlayer = player_.HandleInput(input, player_body_, frame_time);
 
+	// moving applies an impulse every tick, so a press only counts
+	// once the state it leads to is the one moving the player
 
-			// checks if player is colliding with a
-			// Double Jump Reset wall --- stickyWall was original name of ability / object
+	inputLatency.OnInputConsumed(movedPlayer ? PlayerStateAction(player_.getPlayerState()) : 0);
+}
 
-			if (player && stickyWall)
-			{
+void SceneApp::SubmitGroundProbe()
+{
+	// a ray down from each corner of the player's feet
+	// starting just inside the body so ground already touched is found
 
-				// checks if player state is currently or just was on the wall
-				// also checks if player has Double Jump Reset ability unlocked
+	b2Vec2 position = player_body_->GetPosition();
+	float footInset = 0.45f;
 
-				if (player->getPlayerState() != ON_WALL && player->getPlayerPreviousState() != ON_WALL && player->getResetWallActive() == true)
-				{
-					// if all true, change player state on collision
-					player->setPlayerState(ON_WALL);
-				}
+	for (int i = 0; i < 2; i++)
+	{
+		b2Vec2 start(position.x + (i == 0 ? -footInset : footInset), position.y - footInset);
+		b2Vec2 end(start.x, position.y - 0.5f - GROUND_PROBE_DEPTH);
 
-			}
+		groundProbeTickets[i] = physicsQueries.SubmitRayCast(start, end, player_body_);
+	}
+}
 
+void SceneApp::UpdateLods(const gef::Vector4& camera_eye, float fov)
+{
+	// ability pickups
 
-			// checks if player is colliding with a
-			// moving platform
+	GameObject* pickups[3] = { &dashPickup_, &doubleJumpPickup_, &resetWallPickup_ };
 
-			if (player && movingPlat)
-			{
+	for (int i = 0; i < 3; i++)
+	{
+		float screenRadius = ScreenRadius(pickups[i]->transform(), ABILITY_PICKUP_RADIUS, camera_eye, fov);
+		pickups[i]->set_mesh(abilityPickupLodMeshes[PrimitiveBuilder::SelectSphereLod(screenRadius)]);
+	}
 
-				// checks if player state is currently or just was on a moving platform
-				if (player->getPlayerState() != ON_MOVING_PLAT && player->getPlayerPreviousState() != ON_MOVING_PLAT)
-				{
-					// if true, change player state on collision
-					player->setPlayerState(ON_MOVING_PLAT);
-				}
+	// spikes and the collectable
 
+	if (spikeLods.isLoaded())
+	{
+		for (int i = 0; i < spikes_vec.size(); i++)
+		{
+			float screenRadius = ScreenRadius(spikes_vec[i].transform(), spikeLods.getBoundingRadius(), camera_eye, fov);
+			spikes_vec[i].set_mesh(spikeLods.SelectMesh(screenRadius));
+		}
+	}
 
-			}
+	if (collectableLods.isLoaded())
+	{
+		float screenRadius = ScreenRadius(collectable_.transform(), collectableLods.getBoundingRadius(), camera_eye, fov);
+		collectable_.set_mesh(collectableLods.SelectMesh(screenRadius));
+	}
+}
 
+float SceneApp::ScreenRadius(const gef::Matrix44& transform, float radius, const gef::Vector4& camera_eye, float fov)
+{
+	// largest scale along the transform's axes
 
-			// checks if player is colliding with a 
-			// ground enemy
+	gef::Vector4 origin = gef::Vector4(0.0f, 0.0f, 0.0f).Transform(transform);
 
-			if (player && groundEnemy)
-			{
-				// if true
+	float scale = (gef::Vector4(1.0f, 0.0f, 0.0f).Transform(transform) - origin).Length();
+	scale = fmaxf(scale, (gef::Vector4(0.0f, 1.0f, 0.0f).Transform(transform) - origin).Length());
+	scale = fmaxf(scale, (gef::Vector4(0.0f, 0.0f, 1.0f).Transform(transform) - origin).Length());
 
-				// carries out enemy's collision response to player
-				groundEnemy->PlayerCollisionResponse(player, player_body_);
+	float distance = (origin - camera_eye).Length();
 
-				// decrements player health
-				player->DecrementHealth();
+	if (distance <= 0.0f)
+	{
+		return FLT_MAX;
+	}
 
-				// plays a hitting sound
-				audio_manager->PlaySample(hit_sound);
-			}
+	// pixels covered by one unit one unit away from the camera
 
+	float pixelsPerUnit = (platform_.height() * 0.5f) / tanf(fov * 0.5f);
 
-			// checks if player is colling with a
-			// spike
+	return radius * scale * pixelsPerUnit / distance;
+}
 
-			if (player && spikeEnv)
-			{
-				// if true
+void SceneApp::InitHotReload()
+{
+	// binds the player tuning values
+
+	PlayerTuning& tuning = player_.getTuning();
+
+	tuningFile.Bind("jump", &tuning.jumpValue);
+	tuningFile.Bind("double_jump", &tuning.doubleJumpValue);
+	tuningFile.Bind("grounded_velocity", &tuning.groundedVelocity);
+	tuningFile.Bind("move_speed_limit", &tuning.moveSpeedLimit);
+	tuningFile.Bind("move_impulse", &tuning.moveImpulse);
+	tuningFile.Bind("dash_speed_limit", &tuning.dashSpeedLimit);
+	tuningFile.Bind("dash_impulse", &tuning.dashImpulse);
+	tuningFile.Bind("double_jump_fall_limit", &tuning.doubleJumpFallLimit);
+
+	// adds the static bodies and routes the layout file can move
+	// the level vectors don't change size once created
+
+	levelLayout.AddBodies("small_platform", &small_platform_bodies_SA[0], (int)small_platform_bodies_SA.size());
+	levelLayout.AddBodies("medium_platform", &medium_platform_bodies_MA[0], (int)medium_platform_bodies_MA.size());
+	levelLayout.AddBodies("big_platform", &big_platform_bodies_vec[0], (int)big_platform_bodies_vec.size());
+	levelLayout.AddBodies("very_small_plat", &very_small_plat_bodies_vec[0], (int)very_small_plat_bodies_vec.size());
+	levelLayout.AddBodies("blocking_wall", &blocking_wall_bodies_vec[0], (int)blocking_wall_bodies_vec.size());
+	levelLayout.AddBodies("bigger_blocking_wall", &bigger_blocking_wall_bodies_vec[0], (int)bigger_blocking_wall_bodies_vec.size());
+	levelLayout.AddBodies("area_wall", &area_walls_bodies_vec[0], (int)area_walls_bodies_vec.size());
+	levelLayout.AddBodies("reset_wall", &reset_walls_bodies_vec[0], (int)reset_walls_bodies_vec.size());
+	levelLayout.AddBodies("spike", &spikes_bodies_vec[0], (int)spikes_bodies_vec.size());
+
+	levelLayout.AddRoutes("moving_platform", &movPlatformRoutes[0], (int)movPlatformRoutes.size());
+	levelLayout.AddRoutes("ground_enemy", &enemyRoutes[0], (int)enemyRoutes.size());
+
+	// writes the files from the built in values
+	// files left from an earlier run are replaced rather than applied
+	// so they never hide changes made to the values in the source since
+
+	tuningFile.Write(TUNING_FILENAME);
+	levelLayout.Write(LEVEL_LAYOUT_FILENAME);
+
+	// only saves after this are picked up
+
+	tuningFileIndex = hotReloadWatcher.AddFile(TUNING_FILENAME);
+	levelLayoutFileIndex = hotReloadWatcher.AddFile(LEVEL_LAYOUT_FILENAME);
+}
 
-				// decrements player health
-				player->DecrementHealth();
+void SceneApp::UpdateHotReload(float frame_time)
+{
+	if (!hotReloadWatcher.Update(frame_time))
+	{
+		return;
+	}
 
-				// plays a hitting sound
-				audio_manager->PlaySample(hit_sound);
-			}
+	if (hotReloadWatcher.HasChanged(tuningFileIndex))
+	{
+		int changed = tuningFile.Load(TUNING_FILENAME);
+		LOG_INFO(LOG_GAME, "hot reload: %s, %i values changed", TUNING_FILENAME, changed);
+	}
 
+	if (hotReloadWatcher.HasChanged(levelLayoutFileIndex))
+	{
+		int changed = levelLayout.Apply(LEVEL_LAYOUT_FILENAME);
+		LOG_INFO(LOG_GAME, "hot reload: %s, %i bodies and routes changed", LEVEL_LAYOUT_FILENAME, changed);
 
-			// checks if player is colliding with
-			// the Dash ability object
+		if (changed > 0)
+		{
+			RefreshStaticVisuals();
+			InitSpatialHash();
 
-			if (player && dashAbility)
+			if (ENEMY_NAVIGATION)
 			{
-				// if true
+				InitNavigation();
+			}
+		}
+	}
+}
 
-				// activates ability for player
-				player->setDashActive(true);
+void SceneApp::RefreshStaticVisuals()
+{
+	// static objects are only updated from their bodies when created
+	// so they are moved here after the layout file moves their bodies
 
-				// plays ability pickup sound
-				audio_manager->PlaySample(ability_pickup);
+	for (int i = 0; i < small_platforms_SA.size(); i++)
+	{
+		small_platforms_SA[i].UpdateFromSimulation(small_platform_bodies_SA[i]);
+	}
 
-			}
+	for (int i = 0; i < medium_platforms_MA.size(); i++)
+	{
+		medium_platforms_MA[i].UpdateFromSimulation(medium_platform_bodies_MA[i]);
+	}
 
+	for (int i = 0; i < big_platforms_vec.size(); i++)
+	{
+		big_platforms_vec[i].UpdateFromSimulation(big_platform_bodies_vec[i]);
+	}
 
-			// checks if player is colliding with
-			// the Double Jump ability object
+	for (int i = 0; i < very_small_plat_vec.size(); i++)
+	{
+		very_small_plat_vec[i].UpdateFromSimulation(very_small_plat_bodies_vec[i]);
+	}
 
-			if (player && doubleJumpAbility)
-			{
-				// if true
+	for (int i = 0; i < blocking_wall_vec.size(); i++)
+	{
+		blocking_wall_vec[i].UpdateFromSimulation(blocking_wall_bodies_vec[i]);
+	}
 
-				// activates ability for player
-				player->setDoubleJumpActive(true);
+	for (int i = 0; i < bigger_blocking_wall_vec.size(); i++)
+	{
+		bigger_blocking_wall_vec[i].UpdateFromSimulation(bigger_blocking_wall_bodies_vec[i]);
+	}
 
-				// plays ability pickup sound
-				audio_manager->PlaySample(ability_pickup);
+	for (int i = 0; i < area_walls_vec.size(); i++)
+	{
+		area_walls_vec[i].UpdateFromSimulation(area_walls_bodies_vec[i]);
+	}
 
-			}
+	for (int i = 0; i < reset_walls_vec.size(); i++)
+	{
+		reset_walls_vec[i].UpdateFromSimulation(reset_walls_bodies_vec[i]);
+	}
 
+	for (int i = 0; i < spikes_vec.size(); i++)
+	{
+		spikes_vec[i].UpdateFromSimulationSpike(spikes_bodies_vec[i]);
+	}
+}
 
-			// checks if player is colliding with
-			// the Double Jump Reset ability object
+void SceneApp::InitSpatialHash()
+{
+	spatialHash.Clear();
 
-			if (player && resetWallAbility)
-			{
-				// if true
+	// static objects
+	// inserted once and only moved again by a level layout reload
 
-				// activates ability for player
-				player->setResetWallActive(true);
+	for (int i = 0; i < small_platforms_SA.size(); i++)
+	{
+		spatialHash.InsertBody(&small_platforms_SA[i], small_platform_bodies_SA[i], SPATIAL_PLATFORM);
+	}
 
-				// plays ability pickup sound
-				audio_manager->PlaySample(ability_pickup);
+	for (int i = 0; i < medium_platforms_MA.size(); i++)
+	{
+		spatialHash.InsertBody(&medium_platforms_MA[i], medium_platform_bodies_MA[i], SPATIAL_PLATFORM);
+	}
 
-			}
+	for (int i = 0; i < big_platforms_vec.size(); i++)
+	{
+		spatialHash.InsertBody(&big_platforms_vec[i], big_platform_bodies_vec[i], SPATIAL_PLATFORM);
+	}
 
+	for (int i = 0; i < very_small_plat_vec.size(); i++)
+	{
+		spatialHash.InsertBody(&very_small_plat_vec[i], very_small_plat_bodies_vec[i], SPATIAL_PLATFORM);
+	}
 
-			// checks if player is colliding with
-			// the Morph Ball object
+	for (int i = 0; i < blocking_wall_vec.size(); i++)
+	{
+		spatialHash.InsertBody(&blocking_wall_vec[i], blocking_wall_bodies_vec[i], SPATIAL_WALL);
+	}
 
-			if (player && theCollectable)
-			{
-				// if true
+	for (int i = 0; i < bigger_blocking_wall_vec.size(); i++)
+	{
+		spatialHash.InsertBody(&bigger_blocking_wall_vec[i], bigger_blocking_wall_bodies_vec[i], SPATIAL_WALL);
+	}
 
-				// player wins, plays the end game sequence
-				isCollectableUp = true;
-			}
+	for (int i = 0; i < area_walls_vec.size(); i++)
+	{
+		spatialHash.InsertBody(&area_walls_vec[i], area_walls_bodies_vec[i], SPATIAL_WALL);
+	}
 
-			
-			// Get next contact point
-			contact = contact->GetNext();
+	for (int i = 0; i < reset_walls_vec.size(); i++)
+	{
+		spatialHash.InsertBody(&reset_walls_vec[i], reset_walls_bodies_vec[i], SPATIAL_RESET_WALL);
+	}
+
+	for (int i = 0; i < spikes_vec.size(); i++)
+	{
+		spatialHash.InsertBody(&spikes_vec[i], spikes_bodies_vec[i], SPATIAL_SPIKE);
+	}
+
+	spatialHash.InsertBody(&bottom_border_, bottom_border_body, SPATIAL_WALL);
+	spatialHash.InsertBody(&top_border_, top_border_body, SPATIAL_WALL);
+	spatialHash.InsertBody(&right_border_, right_border_body_, SPATIAL_WALL);
+	spatialHash.InsertBody(&left_border_, left_border_body_, SPATIAL_WALL);
+
+	// pickups already picked up have no body
+
+	GameObject* pickups[PICKUP_ABILITY_NUM] = { &dashPickup_, &doubleJumpPickup_, &resetWallPickup_ };
+	b2Body* pickupBodies[PICKUP_ABILITY_NUM] = { dashPickup_body_, doubleJumpPickup_body_, resetWallPickup_body_ };
+
+	for (int i = 0; i < PICKUP_ABILITY_NUM; i++)
+	{
+		pickupSpatialHandles[i] = pickupBodies[i] ? spatialHash.InsertBody(pickups[i], pickupBodies[i], SPATIAL_PICKUP) : -1;
+	}
+
+	spatialHash.InsertBody(&collectable_, collectable_body_, SPATIAL_PICKUP);
+
+	// moving objects
+	// handles are kept so they can be moved every update
+
+	playerSpatialHandle = spatialHash.InsertBody(&player_, player_body_, SPATIAL_PLAYER);
+
+	enemySpatialHandles.clear();
+
+	for (int i = 0; i < groundEnemyVec.size(); i++)
+	{
+		enemySpatialHandles.push_back(spatialHash.InsertBody(&groundEnemyVec[i], groundEnemyVec[i].getBody(), SPATIAL_ENEMY));
+	}
+
+	movPlatformSpatialHandles.clear();
+
+	for (int i = 0; i < movPlatformsVec.size(); i++)
+	{
+		movPlatformSpatialHandles.push_back(spatialHash.InsertBody(&movPlatformsVec[i], movPlatform_bodies_vec[i], SPATIAL_PLATFORM));
+	}
+}
+
+void SceneApp::UpdateSpatialHash()
+{
+	spatialHash.MoveBody(playerSpatialHandle, player_body_);
+
+	for (int i = 0; i < enemySpatialHandles.size(); i++)
+	{
+		spatialHash.MoveBody(enemySpatialHandles[i], groundEnemyVec[i].getBody());
+	}
+
+	for (int i = 0; i < movPlatformSpatialHandles.size(); i++)
+	{
+		spatialHash.MoveBody(movPlatformSpatialHandles[i], movPlatform_bodies_vec[i]);
+	}
+}
+
+void SceneApp::CaptureLevel(LevelDescription& level)
+{
+	level.Clear();
+
+	// every static body, including pickups, spikes, walls and the borders
+	// the player, enemies and moving platforms are added with their routes below
+
+	for (b2Body* body = world_->GetBodyList(); body; body = body->GetNext())
+	{
+		GameObject* object = (GameObject*)body->GetUserData();
+
+		if (body == player_body_ || (object && (object->type() == GROUND_ENEMY || object->type() == MOVING ||
+			object->type() == PATROL_ENEMY || object->type() == DESTRUCTIBLE || object->type() == DEBRIS)))
+		{
+			continue;
 		}
 
-		/*for (auto bodies : deletionList)
+		level.AddStaticBody(body);
+	}
+
+	for (int i = 0; i < MOVING_PLATFORM_NUM; i++)
+	{
+		level.AddMovingPlatform(movPlatform_bodies_vec[i], movPlatformRoutes[i]);
+	}
+
+	for (int i = 0; i < groundEnemyVec.size(); i++)
+	{
+		level.AddGroundEnemy(groundEnemyVec[i].getBody()->GetPosition(), enemyRoutes[i]);
+	}
+
+	level.SetPlayer(player_body_, player_.getHealth());
+}
+
+void SceneApp::RunSimulationFarm()
+{
+	LevelDescription level;
+	CaptureLevel(level);
+
+	// plays the input script if there is one
+	// otherwise runs right and jumps every second
+
+	InputScript script;
+
+	if (!script.Load(SIMULATION_FARM_INPUT))
+	{
+		LOG_WARNING(LOG_GAME, "simulation farm: %s not found, using the built in script", SIMULATION_FARM_INPUT);
+
+		for (int i = 0; i < SIMULATION_FARM_TICKS / 60; i++)
+		{
+			script.Add(59, false, true, false, false);
+			script.Add(1, false, true, true, false);
+		}
+	}
+
+	// spreads the jump value across the worlds
+	// starting from the current tuning
+
+	SimulationFarm farm;
+
+	for (int i = 0; i < SIMULATION_FARM_WORLDS; i++)
+	{
+		PlayerTuning tuning = player_.getTuning();
+
+		if (SIMULATION_FARM_WORLDS > 1)
 		{
-			world_->DestroyBody(bodies);
-		}*/
+			float step = (float)i / (SIMULATION_FARM_WORLDS - 1);
+			tuning.jumpValue *= 1.0f - SIMULATION_FARM_JUMP_SPREAD + step * 2.0f * SIMULATION_FARM_JUMP_SPREAD;
+		}
+
+		farm.AddWorld(&script, tuning);
+	}
+
+	farm.Run(level, SIMULATION_FARM_TICKS, SIMULATION_FARM_THREADS);
+	farm.PrintReport();
+}
+
+void SceneApp::RunReachabilitySolver()
+{
+	LevelDescription level;
+	CaptureLevel(level);
+
+	ReachabilitySolver solver;
+
+	for (int i = 0; i < LEVEL_AREA_NUM; i++)
+	{
+		solver.AddRegion(levelAreas[i].name, levelAreas[i].lowerBound, levelAreas[i].upperBound);
+	}
+
+	solver.Solve(level, player_.getTuning(), REACHABILITY_MAX_STATES);
+	solver.PrintReport();
+
+	// saves the route so the simulation farm can play it back
+
+	InputScript route;
+
+	if (solver.BuildRoute(route))
+	{
+		route.Save(REACHABILITY_ROUTE_FILENAME);
+	}
+}
+
+void SceneApp::InitNavigation()
+{
+	LevelDescription level;
+	CaptureLevel(level);
+
+	// the ground enemy body and how it moves when chasing
+
+	NavAgentPhysics physics;
+	physics.halfWidth = 1.0f;
+	physics.halfHeight = 2.0f;
+	physics.walkSpeed = ENEMY_CHASE_SPEED;
+	physics.jumpSpeed = ENEMY_JUMP_SPEED;
+	physics.gravity = 9.81f;
+
+	Timer timer;
+	timer.Start();
+
+	navGraph.Build(level, physics);
+	navPlanner.Init(&navGraph, GROUND_ENEMY_NUM, NAV_PATH_CACHE_SIZE);
+
+	timer.GetTimeStop();
+
+	LOG_INFO(LOG_GAME, "navigation: %i surfaces, %i nodes, %i walk, %i fall and %i jump edges in %.2f ms",
+		navGraph.getSurfaceCount(), navGraph.getNodeCount(), navGraph.getEdgeTypeCount(NAV_EDGE_WALK),
+		navGraph.getEdgeTypeCount(NAV_EDGE_FALL), navGraph.getEdgeTypeCount(NAV_EDGE_JUMP), timer.elapsedMS());
+}
+
+void SceneApp::ChasePlayer(int enemy)
+{
+	const PatrolRoute& route = enemyRoutes[enemy];
+	b2Vec2 position = groundEnemyVec[enemy].getBody()->GetPosition();
+	b2Vec2 target = player_body_->GetPosition();
+
+	bool inRange = b2DistanceSquared(position, target) <= ENEMY_CHASE_RANGE * ENEMY_CHASE_RANGE;
+
+	// the player is seen if last frame's ray reached them without hitting the level
+	// and a new ray is asked for while they're in range
+
+	bool seen = true;
+
+	if (ENEMY_LINE_OF_SIGHT)
+	{
+		const PhysicsQueryResult& sight = physicsQueries.getResult(enemySightTickets[enemy]);
+		seen = enemySightTickets[enemy].isValid() && (!sight.hit || sight.body == player_body_);
+
+		enemySightTickets[enemy] = inRange ? physicsQueries.SubmitRayCast(position, target, groundEnemyVec[enemy].getBody()) : PhysicsQueryTicket();
+	}
+
+	// patrols when the player is out of range or out of sight
+
+	if (!inRange || !seen)
+	{
+		navPlanner.ClearAgent(enemy);
+		groundEnemyVec[enemy].Movement(route.start, route.end, route.speed);
+		return;
+	}
+
+	int startNode = navGraph.FindNode(position);
+	int goalNode = navGraph.FindNode(target);
+
+	navPlanner.SetGoal(enemy, startNode, goalNode);
+
+	b2Vec2 waypoint;
+	bool jump;
+
+	if (navPlanner.GetWaypoint(enemy, position, waypoint, jump))
+	{
+		groundEnemyVec[enemy].MoveTowards(waypoint, ENEMY_CHASE_SPEED, jump ? ENEMY_JUMP_SPEED : 0.0f);
+	}
+
+	// keeps patrolling while the path is being found
+	// and heads straight for the player at the end of it
+
+	else if (startNode == goalNode)
+	{
+		groundEnemyVec[enemy].MoveTowards(target, ENEMY_CHASE_SPEED, 0.0f);
+	}
+
+	else
+	{
+		groundEnemyVec[enemy].Movement(route.start, route.end, route.speed);
+	}
+}
+
+void SceneApp::InitPatrolEnemies()
+{
+	// the walkable runs come from the navigation graph
+
+	if (navGraph.getNodeCount() == 0)
+	{
+		InitNavigation();
+	}
+
+	if (PATROL_ENEMY_BENCHMARK)
+	{
+		PatrolEnemyManager benchmark;
+		benchmark.Init(NULL, b2Vec2(1.0f, 2.0f), SPATIAL_HASH_CELL_SIZE, 0);
+		benchmark.AddSegments(navGraph);
+		benchmark.SpawnEnemies(PATROL_BENCHMARK_ENEMIES, PATROL_ENEMY_SPEED);
+		benchmark.RunBenchmark(PATROL_BENCHMARK_FRAMES, PATROL_BENCHMARK_BUDGET_MS);
+	}
+
+	if (PATROL_ENEMY_NUM > 0)
+	{
+		patrolEnemies.Init(world_, b2Vec2(1.0f, 2.0f), SPATIAL_HASH_CELL_SIZE, PATROL_PROMOTED_NUM);
+		patrolEnemies.AddSegments(navGraph);
+		patrolEnemies.SpawnEnemies(PATROL_ENEMY_NUM, PATROL_ENEMY_SPEED);
+
+		// same size as the ground enemies
+
+		gef::Vector4 box_scale;
+		gef::Mesh* mesh = primitive_builder_->AcquireScaledBoxMesh(gef::Vector4(1.0f, 2.0f, 1.0f), box_scale);
+		patrolEnemies.SetMesh(mesh, box_scale);
+
+		LOG_INFO(LOG_GAME, "patrol enemies: %i enemies on %i segments", patrolEnemies.getEnemyCount(), patrolEnemies.getSegmentCount());
+	}
+}
+
+void SceneApp::UpdatePatrolEnemies(float frame_time)
+{
+	patrolEnemies.Update(frame_time);
+
+	patrolHits.clear();
+
+	if (patrolEnemies.QueryAABB(SpatialHash::ComputeBodyAABB(player_body_), patrolHits) == 0)
+	{
+		return;
 	}
 
+	// hurts the player and knocks the enemies away from them
+
+	if (!player_.getInvincibleCheck())
+	{
+		player_.DecrementHealth();
+		audio_manager->PlaySample(hit_sound);
+	}
+
+	for (int i = 0; i < patrolHits.size(); i++)
+	{
+		float direction = patrolEnemies.getPosition(patrolHits[i]).x >= player_body_->GetPosition().x ? 1.0f : -1.0f;
+		patrolEnemies.Promote(patrolHits[i], b2Vec2(direction * PATROL_KNOCKBACK_SPEED, 0.5f * PATROL_KNOCKBACK_SPEED));
+	}
+}
+
+void SceneApp::InitFlyingSwarm()
+{
+	// flies anywhere within the level areas
+
+	b2AABB bounds;
+	bounds.lowerBound = levelAreas[0].lowerBound;
+	bounds.upperBound = levelAreas[0].upperBound;
+
+	for (int i = 1; i < LEVEL_AREA_NUM; i++)
+	{
+		bounds.lowerBound = b2Min(bounds.lowerBound, levelAreas[i].lowerBound);
+		bounds.upperBound = b2Max(bounds.upperBound, levelAreas[i].upperBound);
+	}
+
+	if (FLYING_SWARM_BENCHMARK)
+	{
+		FlyingSwarm::RunBenchmark(bounds, FLYING_SWARM_NEIGHBOUR_RADIUS, FLYING_SWARM_BENCHMARK_AGENTS,
+			FLYING_SWARM_BENCHMARK_TICKS, FLYING_SWARM_BUDGET_MS);
+	}
+
+	if (FLYING_SWARM_NUM > 0)
+	{
+		flyingSwarm.Init(FLYING_SWARM_NUM, bounds, FLYING_SWARM_NEIGHBOUR_RADIUS);
+		flyingSwarm.Spawn(FLYING_SWARM_NUM, bounds);
+		flyingSwarm.InitMesh(platform_, FLYING_SWARM_AGENT_SIZE);
+	}
+}
+
+void SceneApp::RunPhysicsQueryBenchmark()
+{
+	// rays across the whole level
+
+	b2AABB area;
+	area.lowerBound = levelAreas[0].lowerBound;
+	area.upperBound = levelAreas[0].upperBound;
+
+	for (int i = 1; i < LEVEL_AREA_NUM; i++)
+	{
+		area.lowerBound = b2Min(area.lowerBound, levelAreas[i].lowerBound);
+		area.upperBound = b2Max(area.upperBound, levelAreas[i].upperBound);
+	}
+
+	physicsQueries.RunBenchmark(world_, area, PHYSICS_QUERY_BENCHMARK_RAYS);
+}
+
+void SceneApp::UpdateFlyingSwarm(float frame_time)
+{
+	flyingSwarm.Update(frame_time, player_body_->GetPosition());
+
+	if (!player_.getInvincibleCheck() && flyingSwarm.CountInRadius(player_body_->GetPosition(), FLYING_SWARM_HIT_RADIUS) > 0)
+	{
+		player_.DecrementHealth();
+		audio_manager->PlaySample(hit_sound);
+	}
 }
 
 void SceneApp::FrontendInit()
@@ -2175,7 +3236,7 @@ void SceneApp::FrontendUpdate(float frame_time)
 {
 	// pressing space changes app to menu state
 
-	if (kb->IsKeyPressed(gef::Keyboard::KC_SPACE))
+	if (action_input_.IsPressed(ACTION_SKIP))
 	{
 		set_type_gamestate(MENU);
 		MenuInit();
@@ -2244,22 +3305,39 @@ void SceneApp::InitAllWalls()
 
 void SceneApp::GameInit()
 {
-	// create the renderer for draw 3D geometry
-	renderer_3d_ = gef::Renderer3D::Create(platform_);
+	{
+		MemoryScope renderScope(MEM_RENDER);
+
+		// create the renderer for draw 3D geometry
+		renderer_3d_ = gef::Renderer3D::Create(platform_);
 
-	// initialise primitive builder to make create some 3D geometry easier
-	primitive_builder_ = new PrimitiveBuilder(platform_);
+		// initialise primitive builder to make create some 3D geometry easier
+		primitive_builder_ = new PrimitiveBuilder(platform_);
+		primitive_builder_->set_unit_box_meshes(UNIT_BOX_MESHES != 0);
 
-	// creates the lights within the scene
-	SetupLights();
+		if (PRIMITIVE_BENCHMARK)
+		{
+			RunPrimitiveBenchmark(primitive_builder_);
+		}
 
-	// initialise the physics world
-	b2Vec2 gravity(0.0f, -9.81f);
-	world_ = new b2World(gravity);
+		// creates the lights within the scene
+		SetupLights();
+	}
+
+	{
+		MemoryScope physicsScope(MEM_PHYSICS);
+
+		// initialise the physics world
+		// with space reserved for every body in the level
+		b2Vec2 gravity(0.0f, -9.81f);
+		world_ = physicsMemory.CreateWorld(gravity, LEVEL_BODY_NUM, LEVEL_BODY_NUM);
+	}
 
 	// calls all object initialisers
 	// to be created once the level starts
 
+	MemoryScope levelScope(MEM_LEVEL);
+
 	InitPlayer();
 	InitCollectables();
 	InitAllAbilities();
@@ -2267,8 +3345,16 @@ void SceneApp::GameInit()
 	InitAllGrounds();
 	InitAllWalls();
 
+	if (DESTRUCTIBLE_BLOCKS)
+	{
+		InitDestructibleBlocks();
+		InitSpawner();
+	}
+
 	// creating and pushing back ground enemies into a vector
 
+	groundEnemyVec.reserve(GROUND_ENEMY_NUM);
+
 	for (int i = 0; i < GROUND_ENEMY_NUM; i++)
 	{
 		groundEnemyVec.push_back(GroundEnemy());
@@ -2299,6 +3385,80 @@ void SceneApp::GameInit()
 	{
 		groundEnemyVec[i].Init(world_, primitive_builder_);
 	}
+
+	// copies the built in routes so they can be changed
+	// by the level layout file
+
+	movPlatformRoutes.assign(movingPlatformRoutes, movingPlatformRoutes + MOVING_PLATFORM_NUM);
+	enemyRoutes.assign(groundEnemyRoutes, groundEnemyRoutes + GROUND_ENEMY_NUM);
+
+	// sets up the activity regions now all
+	// moving bodies have been created
+	InitActivityRegions();
+
+	if (HOT_RELOAD)
+	{
+		InitHotReload();
+	}
+
+	// adds every object to the spatial hash
+
+	InitSpatialHash();
+
+	if (SPATIAL_HASH_BENCHMARK)
+	{
+		spatialHash.RunBenchmark(10000, 10.0f);
+	}
+
+	// runs the batch of scripted worlds
+	// once the layout and tuning files have been applied
+
+	if (SIMULATION_FARM_WORLDS > 0)
+	{
+		RunSimulationFarm();
+	}
+
+	if (LEVEL_ENV_BENCHMARK)
+	{
+		LevelDescription level;
+		CaptureLevel(level);
+
+		LevelEnvironment environment;
+		environment.Init(level, player_.getTuning(), LEVEL_ENV_COUNT, SIMULATION_FARM_TICKS);
+		environment.RunBenchmark(LEVEL_ENV_BENCHMARK_STEPS);
+	}
+
+	if (REACHABILITY_SOLVER)
+	{
+		RunReachabilitySolver();
+	}
+
+	// starts the query threads, asking for no queries until the first frame
+
+	physicsQueries.Init(PHYSICS_QUERY_THREADS);
+	groundProbeTickets[0] = PhysicsQueryTicket();
+	groundProbeTickets[1] = PhysicsQueryTicket();
+	enemySightTickets.assign(GROUND_ENEMY_NUM, PhysicsQueryTicket());
+
+	if (PHYSICS_QUERY_BENCHMARK)
+	{
+		RunPhysicsQueryBenchmark();
+	}
+
+	if (ENEMY_NAVIGATION)
+	{
+		InitNavigation();
+	}
+
+	if (PATROL_ENEMY_NUM > 0 || PATROL_ENEMY_BENCHMARK)
+	{
+		InitPatrolEnemies();
+	}
+
+	if (FLYING_SWARM_NUM > 0 || FLYING_SWARM_BENCHMARK)
+	{
+		InitFlyingSwarm();
+	}
 	
 	// initialises the end game collectable as not collected
 	isCollectableUp = false;
@@ -2320,70 +3480,221 @@ void SceneApp::GameInit()
 		game_over_playing = false;
 	}
 
-	// checks if level music is play
-	// if not, play it and loop it
+	// checks if level music is play
+	// if not, play it and loop it
+
+	if (!level_music_playing)
+	{
+		level_music_playing = true;
+		audio_manager->PlaySample(level_music, true);
+	}
+
+	// loads in the background screens for each camera perspective 
+
+	MemoryScope renderScope(MEM_RENDER);
+
+	game_screen_ = CreateTextureFromPNG("game-background.png", platform_);
+	game_screen_diff_camera = CreateTextureFromPNG("game-background2.png", platform_);
+
+	// starts in game timer shown to player
+	gameTimer.Start();
+}
+
+void SceneApp::GameRelease()
+{
+	// saves the input recorded this run of the level
+
+	if (RECORD_INPUT)
+	{
+		recordedInput.Save(RECORD_INPUT_FILENAME);
+		recordedInput.Clear();
+	}
+
+	// prints the input latency for this run of the level
+
+	if (inputLatency.getEnabled())
+	{
+		inputLatency.PrintReport();
+		inputLatency.Reset();
+	}
+
+	// clearing the patrol enemies destroys their promoted bodies while the world still exists
+
+	if (patrolEnemies.getMesh())
+	{
+		primitive_builder_->ReleaseMesh(patrolEnemies.getMesh());
+		patrolEnemies.SetMesh(NULL, gef::Vector4(1.0f, 1.0f, 1.0f));
+	}
+
+	patrolEnemies.Clear();
+	patrolHits.clear();
+
+	flyingSwarm.ReleaseMesh();
+	flyingSwarm.Clear();
+
+	// queued queries and results refer to the world's bodies
+
+	physicsQueries.Clear();
+
+	// the blocks' bodies are destroyed with the world
+
+	if (destructibleBlocks.getMesh())
+	{
+		primitive_builder_->ReleaseMesh(destructibleBlocks.getMesh());
+		destructibleBlocks.SetMesh(NULL, gef::Vector4(1.0f, 1.0f, 1.0f));
+	}
+
+	destructibleBlocks.Clear();
+	destructionQueue.Clear();
+
+	// pooled bodies are destroyed with the world
+
+	spawner.PrintStats();
+
+	for (int i = 0; i < spawner.getArchetypeCount(); i++)
+	{
+		primitive_builder_->ReleaseMesh(spawner.getMesh(i));
+	}
+
+	spawner.Clear();
+	debrisArchetype = -1;
+
+	physicsMemory.PrintStats(world_);
+
+	// destroying the physics world also destroys all the objects within it
+	delete world_;
+	world_ = NULL;
+
+	// releasing objects and meshs
+	// meshes are shared through the primitive builder's registry
+	// so each one is released rather than deleted
+
+	primitive_builder_->ReleaseMesh(bottom_border_mesh_);
+	bottom_border_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(top_border_mesh_);
+	top_border_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(left_border_mesh_);
+	left_border_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(right_border_mesh_);
+	right_border_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(small_platform_mesh_SA);
+	small_platform_mesh_SA = NULL;
+
+	primitive_builder_->ReleaseMesh(medium_platform_mesh_MA);
+	medium_platform_mesh_MA = NULL;
+
+	primitive_builder_->ReleaseMesh(big_platform_mesh_);
+	big_platform_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(movPlatform_mesh);
+	movPlatform_mesh = NULL;
+
+	primitive_builder_->ReleaseMesh(very_small_plat_mesh_);
+	very_small_plat_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(blocking_wall_mesh_);
+	blocking_wall_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(bigger_blocking_wall_mesh_);
+	bigger_blocking_wall_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(area_wall_mesh_);
+	area_wall_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(reset_wall_mesh_);
+	reset_wall_mesh_ = NULL;
+
+	primitive_builder_->ReleaseMesh(dashPickupMesh);
+	dashPickupMesh = NULL;
+
+	primitive_builder_->ReleaseMesh(doubleJumpPickupMesh);
+	doubleJumpPickupMesh = NULL;
+
+	primitive_builder_->ReleaseMesh(resetWallPickupMesh);
+	resetWallPickupMesh = NULL;
+
+	for (int i = 0; i < groundEnemyVec.size(); i++)
+	{
+		primitive_builder_->ReleaseMesh(groundEnemyVec[i].mesh());
+	}
+
+	for (int i = 0; i < PrimitiveBuilder::kNumSphereLods; i++)
+	{
+		primitive_builder_->ReleaseMesh(abilityPickupLodMeshes[i]);
+		abilityPickupLodMeshes[i] = NULL;
+	}
+
+	// clearing all vectors
+	// gives their storage back to the level arena
+	// so the game level may be started again
+	// after completing, failing or generally going back
+	// to main menu
+
+	ReleaseArenaContainer(groundEnemyVec);
+	ReleaseArenaContainer(spikes_vec);
+	ReleaseArenaContainer(spikes_bodies_vec);
+	ReleaseArenaContainer(small_platforms_SA);
+	ReleaseArenaContainer(small_platform_bodies_SA);
+	ReleaseArenaContainer(medium_platforms_MA);
+	ReleaseArenaContainer(medium_platform_bodies_MA);
+	ReleaseArenaContainer(big_platforms_vec);
+	ReleaseArenaContainer(big_platform_bodies_vec);
+	ReleaseArenaContainer(movPlatformsVec);
+	ReleaseArenaContainer(movPlatform_bodies_vec);
+	ReleaseArenaContainer(very_small_plat_vec);
+	ReleaseArenaContainer(very_small_plat_bodies_vec);
+	ReleaseArenaContainer(blocking_wall_vec);
+	ReleaseArenaContainer(blocking_wall_bodies_vec);
+	ReleaseArenaContainer(bigger_blocking_wall_vec);
+	ReleaseArenaContainer(bigger_blocking_wall_bodies_vec);
+	ReleaseArenaContainer(area_walls_vec);
+	ReleaseArenaContainer(area_walls_bodies_vec);
+	ReleaseArenaContainer(reset_walls_vec);
+	ReleaseArenaContainer(reset_walls_bodies_vec);
 
-	if (!level_music_playing)
-	{
-		level_music_playing = true;
-		audio_manager->PlaySample(level_music, true);
-	}
+	// resets the level arena now nothing is using it
 
-	// loads in the background screens for each camera perspective 
+	levelArena.PrintStats();
+	levelArena.Reset();
 
-	game_screen_ = CreateTextureFromPNG("game-background.png", platform_);
-	game_screen_diff_camera = CreateTextureFromPNG("game-background2.png", platform_);
+	activityRegions.Clear();
 
-	// starts in game timer shown to player
-	gameTimer.Start();
-}
+	// stops watching the files as the bodies they move are gone
 
-void SceneApp::GameRelease()
-{
-	// destroying the physics world also destroys all the objects within it
-	delete world_;
-	world_ = NULL;
+	hotReloadWatcher.Clear();
+	levelLayout.Clear();
+	tuningFile.Clear();
 
-	// releasing objects and meshs
+	spatialHash.Clear();
+	enemySpatialHandles.clear();
 
-	delete bottom_border_mesh_;
-	bottom_border_mesh_ = NULL;
+	navPlanner.Clear();
+	navGraph.Clear();
+	movPlatformSpatialHandles.clear();
+	playerSpatialHandle = -1;
 
-	delete top_border_mesh_;
-	top_border_mesh_ = NULL;
+	// releasing loaded models and background screens
 
-	delete left_border_mesh_;
-	left_border_mesh_ = NULL;
+	spikeLods.CleanUp();
+	collectableLods.CleanUp();
+	spikeBlob.CleanUp();
+	collectableBlob.CleanUp();
 
-	delete right_border_mesh_;
-	right_border_mesh_ = NULL;
+	delete spike_scene_assets_;
+	spike_scene_assets_ = NULL;
 
-	// clearing all vectors
-	// so the game level may be started again
-	// after completing, failing or generally going back
-	// to main menu
-	// without over filling the vectors
-
-	small_platforms_SA.clear();
-	medium_platforms_MA.clear();
-	big_platforms_vec.clear();
-	very_small_plat_vec.clear();
-	blocking_wall_vec.clear();
-	bigger_blocking_wall_vec.clear();
-	area_walls_vec.clear();
-	reset_walls_vec.clear();
-	spikes_vec.clear();
-	movPlatformsVec.clear();
-	groundEnemyVec.clear();
-
-	delete dashPickupMesh;
-	dashPickupMesh = NULL;
+	delete collectable_scene_assets_;
+	collectable_scene_assets_ = NULL;
 
-	delete doubleJumpPickupMesh;
-	doubleJumpPickupMesh = NULL;
+	delete game_screen_;
+	game_screen_ = NULL;
 
-	delete resetWallPickupMesh;
-	resetWallPickupMesh = NULL;
+	delete game_screen_diff_camera;
+	game_screen_diff_camera = NULL;
 
 	delete primitive_builder_;
 	primitive_builder_ = NULL;
@@ -2395,95 +3706,97 @@ void SceneApp::GameRelease()
 
 void SceneApp::GameUpdate(float frame_time)
 {
-	// calls update simulation to update the physics engine
+	// picks up any saved changes to the tuning and level layout files
 
-	UpdateSimulation(frame_time);
+	if (HOT_RELOAD)
+	{
+		UpdateHotReload(frame_time);
+	}
 
-	// updates position of all moving platforms based on the function
-	// call and the value entered inside them
+	// handles player input before the physics step if set
+	// so the player reacts in the same frame
 
-	// all Y axis platforms
-	movPlatformsVec[0].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[0], 53.0f, 100.0f, 4.0f);
-	movPlatformsVec[2].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[2], 160.0f, 120.0f, 2.125f);
-	movPlatformsVec[3].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[3], 90.0f, 130.0f, 2.125f);
+	if (handleInputBeforePhysics)
+	{
+		UpdatePlayerInput(frame_time);
+	}
 
-	movPlatformsVec[4].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[4], 187.5f, 212.0f, 4.0f);
+	// turns off moving bodies in areas of the level
+	// far away from the player before stepping the world
 
-	movPlatformsVec[5].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[5], 243.0f, 223.0f, 4.25f);
-	movPlatformsVec[6].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[6], 228.0f, 248.0f, 4.25f);
-	movPlatformsVec[7].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[7], 253.0f, 233.0f, 4.25f);
-	movPlatformsVec[8].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[8], 238.0f, 258.0f, 4.25f);
-	
+	activityRegions.Update(player_body_->GetPosition());
 
-	movPlatformsVec[10].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[10], 187.5f, 215.0f, 4.15f);
-	movPlatformsVec[12].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[12], 243.0f, 265.0f, 4.0f);
+	// calls update simulation to update the physics engine
 
+	UpdateSimulation(frame_time);
 
-	// all X axis platforms
-	movPlatformsVec[1].setPlatPosAndSpeedXaxis(movPlatform_bodies_vec[1], 25.0f, -50.0f, 4.0f);
-	movPlatformsVec[9].setPlatPosAndSpeedXaxis(movPlatform_bodies_vec[9], 162.5f, 105.0f, 4.0f);
-	movPlatformsVec[11].setPlatPosAndSpeedXaxis(movPlatform_bodies_vec[11], 55.0f, 35.0f, 4.0f);
-	
+	// probes the ground where the step left the player
+	// then runs every query asked for since the last step in one batch
 
-	// updates position of all ground enemies based on
-	// the values placed inside the function calls
+	if (GROUND_PROBE)
+	{
+		SubmitGroundProbe();
+	}
 
-	groundEnemyVec[0].Movement(45.0f, 80.0f, 4.0f);
-	groundEnemyVec[1].Movement(125.0f, 90.0f, 4.0f);
+	physicsQueries.Execute(world_);
 
-	groundEnemyVec[2].Movement(109.0f, 125.0f, 4.5f);
-	groundEnemyVec[3].Movement(61.0f, 45.0f, 4.5f);
+	// moves the player, enemies and moving platforms in the spatial hash
 
-	groundEnemyVec[4].Movement(60.0f, 25.0f, 7.0f);
-	groundEnemyVec[5].Movement(20.0f, -10.0f, 7.0f);
+	UpdateSpatialHash();
 
-	groundEnemyVec[6].Movement(-33.0f, -50.0f, 6.5f);
-	groundEnemyVec[7].Movement(-115.0f, -85.0f, 6.5f);
-	groundEnemyVec[8].Movement(-80.0f,-55.0f, 6.5f);
-	
+	// updates position of all moving platforms
+	// along their routes
 
-	groundEnemyVec[9].Movement(116.0f, 135.0f, 3.5f);
-	groundEnemyVec[10].Movement(95.0f, 105.0f, 4.25f);
+	for (int i = 0; i < MOVING_PLATFORM_NUM; i++)
+	{
+		const PatrolRoute& route = movPlatformRoutes[i];
 
+		if (route.yAxis)
+		{
+			movPlatformsVec[i].setPlatPosAndSpeedYaxis(movPlatform_bodies_vec[i], route.start, route.end, route.speed);
+		}
+		else
+		{
+			movPlatformsVec[i].setPlatPosAndSpeedXaxis(movPlatform_bodies_vec[i], route.start, route.end, route.speed);
+		}
+	}
 
-	// loops through all reset wall bodies
-	// and sets the friction value to a certain value
-	// based on whether or not the player has the Double Jump Reset
-	// ability
+	// updates position of all ground enemies
+	// along their routes, or towards the player if they are chasing
 
-	for (int i = 0; i < RESET_WALL_NUM; i++)
+	if (ENEMY_NAVIGATION)
 	{
-		if (player_.getResetWallActive() == true)
-		{
-			reset_walls_bodies_vec[i]->GetFixtureList()->SetFriction(3.5f);
+		navPlanner.Update(NAV_EXPANSIONS_PER_FRAME);
 
-			// if player picks up Double Jump Reset ability
-			// turn off the body of the ability object
-			resetWallPickup_body_->SetActive(false);
+		for (int i = 0; i < GROUND_ENEMY_NUM; i++)
+		{
+			ChasePlayer(i);
 		}
+	}
 
-		else
+	else
+	{
+		for (int i = 0; i < GROUND_ENEMY_NUM; i++)
 		{
-			reset_walls_bodies_vec[i]->GetFixtureList()->SetFriction(0.0f);
+			groundEnemyVec[i].Movement(enemyRoutes[i].start, enemyRoutes[i].end, enemyRoutes[i].speed);
 		}
 	}
 
-	// if player picks up Dash ability
-	// turn off the body of the ability object
+	// moves the patrol enemies and knocks back any the player runs into
 
-	if (player_.getDashActive() == true)
+	if (PATROL_ENEMY_NUM > 0)
 	{
-		dashPickup_body_->SetActive(false);
+		UpdatePatrolEnemies(frame_time);
 	}
 
-	// if player picks up Double Jump ability
-	// turn off the body of the ability object
+	// flocks the flying swarm towards the player
 
-	if (player_.getDoubleJumpActive() == true)
+	if (FLYING_SWARM_NUM > 0)
 	{
-		doubleJumpPickup_body_->SetActive(false);
+		UpdateFlyingSwarm(frame_time);
 	}
 
+
 	// plays sound queue if player is double jumping
 
 	if (player_.getPlayerState() == DOUBLE_JUMPING)
@@ -2499,13 +3812,17 @@ void SceneApp::GameUpdate(float frame_time)
 	}
 
 	// debugs player position and state values
+	// trace level so it is compiled out unless LOG_COMPILED_LEVEL is lowered
 
-	gef::DebugOut("playerPos.y %f, playerPos.x %f, playerState %i, previousState %i, secondPreviousState %i\n",
+	LOG_TRACE(LOG_GAME, "playerPos.y %f, playerPos.x %f, playerState %i, previousState %i, secondPreviousState %i",
 		player_body_->GetPosition().y, player_body_->GetPosition().x, player_.getPlayerState(), player_.getPlayerPreviousState(), player_.getPlayerSecondPreviousState());
 	
 	// updates player functionality and variables
 
-	player_.HandleInput(input_manager_, player_body_, frame_time);
+	if (!handleInputBeforePhysics)
+	{
+		UpdatePlayerInput(frame_time);
+	}
 
 	// if collectable object collides with the player
 	// game changes to win state
@@ -2530,28 +3847,25 @@ void SceneApp::GameUpdate(float frame_time)
 
 
 	
-	if (kb)
-	{
-		// resets player position back to starting point
-		// used for debugging and testing
+	// resets player position back to starting point
+	// used for debugging and testing
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_R) && gamestatetype == LEVEL1)
-		{
-			player_body_->SetTransform(b2Vec2(0.0f, 4.0f), 0);
-			player_body_->SetAwake(false);
-			player_body_->SetAwake(true);
-		}
+	if (action_input_.IsPressed(ACTION_RESET) && gamestatetype == LEVEL1)
+	{
+		player_body_->SetTransform(b2Vec2(0.0f, 4.0f), 0);
+		player_body_->SetAwake(false);
+		player_body_->SetAwake(true);
+	}
 
-		// P key takes player back to menu 
-		// player is shown this key in How To Play screen
+	// P key takes player back to menu 
+	// player is shown this key in How To Play screen
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_P))
-		{
-			set_type_gamestate(MENU);
-			GameRelease();
-			MenuInit();
-			audio_manager->PlaySample(menu_button_sound);
-		}
+	if (action_input_.IsPressed(ACTION_PAUSE))
+	{
+		set_type_gamestate(MENU);
+		GameRelease();
+		MenuInit();
+		audio_manager->PlaySample(menu_button_sound);
 	}
 	
 }
@@ -2591,7 +3905,7 @@ void SceneApp::GameRender()
 
 	// pressing M key changes which camera is currently active
 
-	if (kb->IsKeyPressed(gef::Keyboard::KC_M))
+	if (action_input_.IsPressed(ACTION_MAP_TOGGLE))
 	{
 		if (!cameraSwitch)
 		{
@@ -2612,6 +3926,8 @@ void SceneApp::GameRender()
 	view_matrix.LookAt(camera_eye, camera_lookat, camera_up);
 	renderer_3d_->set_view_matrix(view_matrix);
 
+	UpdateLods(camera_eye, fov);
+
 	
 	// draw 3d geometry
 	renderer_3d_->Begin();
@@ -2769,12 +4085,46 @@ void SceneApp::GameRender()
 		renderer_3d_->set_override_material(NULL);
 	}
 
-	// draws all ground enemies
-	for (int i = 0; i < groundEnemyVec.size(); i++)
+	// draws the ground enemies within view of the camera
+	// the camera looks down the z axis at the level
+	// so the view is a box around the look at point
+	// widened by a cell as the player camera is tilted slightly
+
+	float viewHalfHeight = camera_eye.z() * tanf(fov * 0.5f) + SPATIAL_HASH_CELL_SIZE;
+	float viewHalfWidth = camera_eye.z() * tanf(fov * 0.5f) * aspect_ratio + SPATIAL_HASH_CELL_SIZE;
+
+	b2AABB viewArea;
+	viewArea.lowerBound = b2Vec2(camera_lookat.x() - viewHalfWidth, camera_lookat.y() - viewHalfHeight);
+	viewArea.upperBound = b2Vec2(camera_lookat.x() + viewHalfWidth, camera_lookat.y() + viewHalfHeight);
+
+	spatialResults.clear();
+	spatialHash.QueryAABB(viewArea, SPATIAL_ENEMY, spatialResults);
+
+	for (int i = 0; i < spatialResults.size(); i++)
 	{
-	//	renderer_3d_->set_override_material(&primitive_builder_->blue_material());
-		groundEnemyVec[i].RenderGroundEnemy(renderer_3d_, primitive_builder_);
-	//	renderer_3d_->set_override_material(NULL);
+		static_cast<GroundEnemy*>(spatialResults[i])->RenderGroundEnemy(renderer_3d_, primitive_builder_);
+	}
+
+	if (PATROL_ENEMY_NUM > 0)
+	{
+		patrolEnemies.Render(renderer_3d_, viewArea);
+	}
+
+	if (DESTRUCTIBLE_BLOCKS || spawner.getArchetypeCount() > 0)
+	{
+		renderer_3d_->set_override_material(&primitive_builder_->brown_material());
+		destructibleBlocks.Render(renderer_3d_);
+		spawner.Render(renderer_3d_);
+		renderer_3d_->set_override_material(NULL);
+	}
+
+	// the whole swarm is one mesh, drawn in one call
+
+	if (FLYING_SWARM_NUM > 0)
+	{
+		renderer_3d_->set_override_material(&primitive_builder_->purple_material());
+		flyingSwarm.Render(renderer_3d_);
+		renderer_3d_->set_override_material(NULL);
 	}
 
 
@@ -2866,89 +4216,86 @@ void SceneApp::MenuInit()
 
 void SceneApp::MenuUpdate(float frame_time)
 {
-	if (kb)
-	{
-		// changes menu state
-		// to option above
+	// changes menu state
+	// to option above
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_UP))
+	if (action_input_.IsPressed(ACTION_UP))
+	{
+		switch (menuStateType)
 		{
-			switch (menuStateType)
-			{
-			case MENU_PLAY:
-				menuStateType = MENU_EXIT;
-				break;
-			case MENU_HTP:
-				menuStateType = MENU_PLAY;
-				break;
-			case MENU_OPTIONS:
-				menuStateType = MENU_HTP;
-				break;
-			case MENU_EXIT:
-				menuStateType = MENU_OPTIONS;
-				break;
-			}
-
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
+		case MENU_PLAY:
+			menuStateType = MENU_EXIT;
+			break;
+		case MENU_HTP:
+			menuStateType = MENU_PLAY;
+			break;
+		case MENU_OPTIONS:
+			menuStateType = MENU_HTP;
+			break;
+		case MENU_EXIT:
+			menuStateType = MENU_OPTIONS;
+			break;
 		}
 
-		// changes menu state
-		// to option below
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
+	}
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_DOWN))
-		{
-			switch (menuStateType)
-			{
-			case MENU_PLAY:
-				menuStateType = MENU_HTP;
-				break;
-			case MENU_HTP:
-				menuStateType = MENU_OPTIONS;
-				break;
-			case MENU_OPTIONS:
-				menuStateType = MENU_EXIT;
-				break;
-			case MENU_EXIT:
-				menuStateType = MENU_PLAY;
-				break;
-			}
+	// changes menu state
+	// to option below
 
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
+	if (action_input_.IsPressed(ACTION_DOWN))
+	{
+		switch (menuStateType)
+		{
+		case MENU_PLAY:
+			menuStateType = MENU_HTP;
+			break;
+		case MENU_HTP:
+			menuStateType = MENU_OPTIONS;
+			break;
+		case MENU_OPTIONS:
+			menuStateType = MENU_EXIT;
+			break;
+		case MENU_EXIT:
+			menuStateType = MENU_PLAY;
+			break;
 		}
 
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
+	}
 
-		// selects whichever option is currently
-		// highlighted, moves to different state
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_RETURN))
-		{
-			switch (menuStateType)
-			{
-			case MENU_PLAY:
-				set_type_gamestate(LEVEL1);
-				GameInit();
-				MenuRelease();
-				break;
-			case MENU_HTP:
-				set_type_gamestate(HOW_TO_PLAY);
-				HowToPlayInit();
-				MenuRelease();
-				break;
-			case MENU_OPTIONS:
-				set_type_gamestate(OPTIONS);
-				OptionsInit();
-				MenuRelease();
-				break;
-			case MENU_EXIT:
-				isApplicationRunning = false;
-				break;
-			}
+	// selects whichever option is currently
+	// highlighted, moves to different state
 
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
+	if (action_input_.IsPressed(ACTION_CONFIRM))
+	{
+		switch (menuStateType)
+		{
+		case MENU_PLAY:
+			set_type_gamestate(LEVEL1);
+			GameInit();
+			MenuRelease();
+			break;
+		case MENU_HTP:
+			set_type_gamestate(HOW_TO_PLAY);
+			HowToPlayInit();
+			MenuRelease();
+			break;
+		case MENU_OPTIONS:
+			set_type_gamestate(OPTIONS);
+			OptionsInit();
+			MenuRelease();
+			break;
+		case MENU_EXIT:
+			isApplicationRunning = false;
+			break;
 		}
+
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
 	}
 }
 
@@ -3020,162 +4367,159 @@ void SceneApp::OptionsInit()
 
 void SceneApp::OptionsUpdate(float frame_time)
 {
-	if (kb)
+	// changes state back to menu
+
+	if (action_input_.IsPressed(ACTION_BACK))
 	{
-		// changes state back to menu
+		set_type_gamestate(MENU);
+		MenuInit();
+		OptionsRelease();
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_BACKSPACE))
-		{
-			set_type_gamestate(MENU);
-			MenuInit();
-			OptionsRelease();
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
+	}
 
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
+	// changes selected option state 
+	// to one above
+
+	if (action_input_.IsPressed(ACTION_UP))
+	{
+		switch (optionsStateType)
+		{
+		case OPTIONS_DIFFICULTY:
+			optionsStateType = OPTIONS_VOLUME;
+			break;
+		case OPTIONS_VOLUME:
+			optionsStateType = OPTIONS_DIFFICULTY;
+			break;
 		}
 
-		// changes selected option state 
-		// to one above
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
+	}
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_UP))
-		{
-			switch (optionsStateType)
-			{
-			case OPTIONS_DIFFICULTY:
-				optionsStateType = OPTIONS_VOLUME;
-				break;
-			case OPTIONS_VOLUME:
-				optionsStateType = OPTIONS_DIFFICULTY;
-				break;
-			}
 
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
+	// changes selected option state 
+	// to one below
+
+	if (action_input_.IsPressed(ACTION_DOWN))
+	{
+		switch (optionsStateType)
+		{
+		case OPTIONS_DIFFICULTY:
+			optionsStateType = OPTIONS_VOLUME;
+			break;
+		case OPTIONS_VOLUME:
+			optionsStateType = OPTIONS_DIFFICULTY;
+			break;
 		}
 
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
+	}
 
-		// changes selected option state 
-		// to one below
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_DOWN))
+	// based on which option state is currently active
+	
+	if (action_input_.IsPressed(ACTION_RIGHT))
+	{
+		switch (optionsStateType)
 		{
-			switch (optionsStateType)
+		case OPTIONS_DIFFICULTY:
+			// changes difficulty state to state to the right
+			switch (difficulty)
 			{
-			case OPTIONS_DIFFICULTY:
-				optionsStateType = OPTIONS_VOLUME;
+			case DIFF_EASY:
+				difficulty = DIFF_NORMAL;
+				break;
+			case DIFF_NORMAL:
+				difficulty = DIFF_HARD;
+				break;
+			case DIFF_HARD:
+				difficulty = DIFF_ONESHOT;
 				break;
-			case OPTIONS_VOLUME:
-				optionsStateType = OPTIONS_DIFFICULTY;
+			case DIFF_ONESHOT:
+				difficulty = DIFF_EASY;
 				break;
 			}
-
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
-		}
-
-
-		// based on which option state is currently active
-		
-		if (kb->IsKeyPressed(gef::Keyboard::KC_RIGHT))
-		{
-			switch (optionsStateType)
+			break;
+		case OPTIONS_VOLUME:
+			// changes volume state to state to the right
+			switch (volume)
 			{
-			case OPTIONS_DIFFICULTY:
-				// changes difficulty state to state to the right
-				switch (difficulty)
-				{
-				case DIFF_EASY:
-					difficulty = DIFF_NORMAL;
-					break;
-				case DIFF_NORMAL:
-					difficulty = DIFF_HARD;
-					break;
-				case DIFF_HARD:
-					difficulty = DIFF_ONESHOT;
-					break;
-				case DIFF_ONESHOT:
-					difficulty = DIFF_EASY;
-					break;
-				}
+			case ONE_HUNDRED:
+				volume = ZERO;
 				break;
-			case OPTIONS_VOLUME:
-				// changes volume state to state to the right
-				switch (volume)
-				{
-				case ONE_HUNDRED:
-					volume = ZERO;
-					break;
-				case SEVENTY_FIVE:
-					volume = ONE_HUNDRED;
-					break;
-				case FIFTY:
-					volume = SEVENTY_FIVE;
-					break;
-				case TWENTY_FIVE:
-					volume = FIFTY;
-					break;
-				case ZERO:
-					volume = TWENTY_FIVE;
-					break;
-				}
+			case SEVENTY_FIVE:
+				volume = ONE_HUNDRED;
+				break;
+			case FIFTY:
+				volume = SEVENTY_FIVE;
+				break;
+			case TWENTY_FIVE:
+				volume = FIFTY;
+				break;
+			case ZERO:
+				volume = TWENTY_FIVE;
 				break;
 			}
-
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
-			
+			break;
 		}
 
-		// based on which option state is currently active
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
+		
+	}
+
+	// based on which option state is currently active
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_LEFT))
+	if (action_input_.IsPressed(ACTION_LEFT))
+	{
+		switch (optionsStateType)
 		{
-			switch (optionsStateType)
+		case OPTIONS_DIFFICULTY:
+			// changes difficulty state to state to the left
+			switch (difficulty)
 			{
-			case OPTIONS_DIFFICULTY:
-				// changes difficulty state to state to the left
-				switch (difficulty)
-				{
-				case DIFF_EASY:
-					difficulty = DIFF_ONESHOT;
-					break;
-				case DIFF_NORMAL:
-					difficulty = DIFF_EASY;
-					break;
-				case DIFF_HARD:
-					difficulty = DIFF_NORMAL;
-					break;
-				case DIFF_ONESHOT:
-					difficulty = DIFF_HARD;
-					break;
-				}
+			case DIFF_EASY:
+				difficulty = DIFF_ONESHOT;
 				break;
-			case OPTIONS_VOLUME:
-				// changes volume state to state to the left
-				switch (volume)
-				{
-				case ONE_HUNDRED:
-					volume = SEVENTY_FIVE;
-					break;
-				case SEVENTY_FIVE:
-					volume = FIFTY;
-					break;
-				case FIFTY:
-					volume = TWENTY_FIVE;
-					break;
-				case TWENTY_FIVE:
-					volume = ZERO;
-					break;
-				case ZERO:
-					volume = ONE_HUNDRED;
-					break;
-				}
+			case DIFF_NORMAL:
+				difficulty = DIFF_EASY;
+				break;
+			case DIFF_HARD:
+				difficulty = DIFF_NORMAL;
+				break;
+			case DIFF_ONESHOT:
+				difficulty = DIFF_HARD;
 				break;
 			}
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
-			
+			break;
+		case OPTIONS_VOLUME:
+			// changes volume state to state to the left
+			switch (volume)
+			{
+			case ONE_HUNDRED:
+				volume = SEVENTY_FIVE;
+				break;
+			case SEVENTY_FIVE:
+				volume = FIFTY;
+				break;
+			case FIFTY:
+				volume = TWENTY_FIVE;
+				break;
+			case TWENTY_FIVE:
+				volume = ZERO;
+				break;
+			case ZERO:
+				volume = ONE_HUNDRED;
+				break;
+			}
+			break;
 		}
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
+		
 	}
 }
 
@@ -3396,19 +4740,16 @@ void SceneApp::EndGameInit()
 
 void SceneApp::EndGameUpdate(float frame_time)
 {
-	if (kb)
-	{
-		// changes state to menu
+	// changes state to menu
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_BACKSPACE))
-		{
-			set_type_gamestate(MENU);
-			MenuInit();
-			EndGameRelease();
+	if (action_input_.IsPressed(ACTION_BACK))
+	{
+		set_type_gamestate(MENU);
+		MenuInit();
+		EndGameRelease();
 
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
-		}
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
 	}
 }
 
@@ -3474,37 +4815,34 @@ void SceneApp::FailedInit()
 void SceneApp::FailedUpdate(float frame_time)
 {
 
-	if (kb)
-	{
-		// changes state to menu state
-
-		if (kb->IsKeyPressed(gef::Keyboard::KC_SPACE))
-		{
-			set_type_gamestate(MENU);
-			MenuInit();
-			FailedRelease();
+	// changes state to menu state
 
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
+	if (action_input_.IsPressed(ACTION_SKIP))
+	{
+		set_type_gamestate(MENU);
+		MenuInit();
+		FailedRelease();
 
-		}
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
 
-		// changes state back to level state
-		// allows the player to retry
+	}
 
-		if (kb->IsKeyPressed(gef::Keyboard::KC_RETURN))
-		{
-			set_type_gamestate(LEVEL1);
-			GameInit();
-			FailedRelease();
+	// changes state back to level state
+	// allows the player to retry
 
-			// plays sound queue
-			audio_manager->PlaySample(menu_button_sound);
+	if (action_input_.IsPressed(ACTION_CONFIRM))
+	{
+		set_type_gamestate(LEVEL1);
+		GameInit();
+		FailedRelease();
 
-		}
+		// plays sound queue
+		audio_manager->PlaySample(menu_button_sound);
 
-		
 	}
+
+	
 }
 
 void SceneApp::FailedRelease()
@@ -3548,7 +4886,7 @@ void SceneApp::HowToPlayUpdate(float frame_time)
 {
 	// changes state to menu state
 
-	if (kb->IsKeyPressed(gef::Keyboard::KC_BACKSPACE))
+	if (action_input_.IsPressed(ACTION_BACK))
 	{
 		set_type_gamestate(MENU);
 		MenuInit();
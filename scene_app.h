@@ -16,6 +16,26 @@
 #include <vector>
 #include "audio/audio_manager.h"
 #include "Collectable.h"
+#include "ActivityRegion.h"
+#include "InputLatency.h"
+#include "LinearArena.h"
+#include "PhysicsMemory.h"
+#include "MemoryTracker.h"
+#include "MeshLod.h"
+#include "SceneBlob.h"
+#include "HotReload.h"
+#include "SpatialHash.h"
+#include "AbilityEvents.h"
+#include "LevelRules.h"
+#include "SimulationFarm.h"
+#include "Logger.h"
+#include "NavPlanner.h"
+#include "PatrolEnemyManager.h"
+#include "FlyingSwarm.h"
+#include "PhysicsQueries.h"
+#include "DestructionQueue.h"
+#include "DestructibleBlocks.h"
+#include "EntitySpawner.h"
 
 
 // FRAMEWORK FORWARD DECLARATIONS
@@ -92,6 +112,16 @@ enum DIFFICULTY_SETTING
 
 };
 
+// level object vectors
+// storage for these comes from the level arena
+// and is given back all at once when the level is released
+
+typedef std::vector<GameObject, ArenaAllocator<GameObject> > LevelObjectVec;
+typedef std::vector<b2Body*, ArenaAllocator<b2Body*> > LevelBodyVec;
+typedef std::vector<Spike, ArenaAllocator<Spike> > LevelSpikeVec;
+typedef std::vector<MovingPlatform, ArenaAllocator<MovingPlatform> > LevelMovingPlatformVec;
+typedef std::vector<GroundEnemy, ArenaAllocator<GroundEnemy> > LevelGroundEnemyVec;
+
 class SceneApp : public gef::Application
 {
 public:
@@ -134,6 +164,78 @@ private:
 	void InitAreaWalls();
 	void InitResetWalls();
 
+	// destructible block init
+	// places the crumbling blocks and their shared mesh
+	void InitDestructibleBlocks();
+
+	// spawner functions
+	// creates the pools of bodies spawned during the level
+	// and throws debris out of a crumbled block
+	void InitSpawner();
+	void SpawnDebris(b2Vec2 position);
+
+	// activity region init
+	// splits the level into areas so moving bodies
+	// far from the player are not simulated
+	void InitActivityRegions();
+
+	// hot reload functions
+	// watches the tuning and level layout files and applies them when saved
+
+	void InitHotReload();
+	void UpdateHotReload(float frame_time);
+
+	// moves the static object visuals to their bodies
+
+	void RefreshStaticVisuals();
+
+	// spatial hash functions
+	// adds every level object to the spatial hash
+	// and moves the moving ones after each physics step
+
+	void InitSpatialHash();
+	void UpdateSpatialHash();
+
+	// simulation farm functions
+	// copies the level into a description the farm can rebuild
+	// and runs the farm's batch of scripted worlds
+
+	void CaptureLevel(LevelDescription& level);
+	void RunSimulationFarm();
+
+	// searches the level for a route to the collectable
+	// and prints the par time and abilities needed for each area
+
+	void RunReachabilitySolver();
+
+	// enemy navigation functions
+	// builds the navigation graph from the level
+	// and moves an enemy along its path to the player, patrolling when it has none
+
+	void InitNavigation();
+	void ChasePlayer(int enemy);
+
+	// patrol enemy functions
+	// spawns the lightweight enemies along the navigation graph's walkable runs
+	// and knocks back any the player runs into
+
+	void InitPatrolEnemies();
+	void UpdatePatrolEnemies(float frame_time);
+
+	// flying swarm functions
+	// spawns the swarm over the level areas
+	// and hurts the player when any of it flies into them
+
+	void InitFlyingSwarm();
+	void UpdateFlyingSwarm(float frame_time);
+
+	// physics query functions
+	// asks for the rays under the player's feet read by the next input update
+	// and times the batched queries against calling the world one at a time
+
+	void SubmitGroundProbe();
+	void RunPhysicsQueryBenchmark();
+
 	// font functions
 
 	void InitFont();
@@ -150,6 +252,30 @@ private:
 
 	void UpdateSimulation(float frame_time);
 
+	// applies an ability's changes to the level once
+	// when the player picks it up
+
+	void OnAbilityAcquired(PICKUP_ABILITY ability);
+
+	// destroys the bodies queued during the step
+	// and takes them out of the pickups, blocks and spatial hash
+
+	void FlushDestruction();
+
+	// handles player input
+	// and passes the result to the input latency tracker
+
+	void UpdatePlayerInput(float frame_time);
+
+	// sets each ability pickup, spike and collectable mesh
+	// to the level of detail for its size on screen from the camera
+
+	void UpdateLods(const gef::Vector4& camera_eye, float fov);
+
+	// returns the radius in pixels of a transformed bounding sphere
+
+	float ScreenRadius(const gef::Matrix44& transform, float radius, const gef::Vector4& camera_eye, float fov);
+
 	// update and render state machine functions
 	// used within the game
 
@@ -191,12 +317,34 @@ private:
 	gef::Texture* htp_background_;
 	gef::Texture* win_game_background;
 
-	gef::Scene* scene_assets_;
+	gef::Scene* spike_scene_assets_;
+	gef::Scene* collectable_scene_assets_;
+
+	// levels of detail for the loaded models
+	MeshLod spikeLods;
+	MeshLod collectableLods;
+
+	// cooked models, used instead of the scene files when found
+	SceneBlob spikeBlob;
+	SceneBlob collectableBlob;
 
 	//
 	// GAME DECLARATIONS
 	//
 
+	// memory arenas
+	// frame arena is reset at the start of every update
+	// level arena holds the level object vectors and is reset on release
+	// must be declared before the level object vectors
+
+	LinearArena frameArena;
+	LinearArena levelArena;
+
+	// heap usage when the app was initialised
+	// anything newer still live at clean up is reported as a leak
+
+	MemorySnapshot memoryBaseline;
+
 	// declaring gef variables
 	// used within the game
 
@@ -211,21 +359,89 @@ private:
 	// create the physics world
 	b2World* world_;
 
+	// reserves and tracks the physics world memory
+	PhysicsMemory physicsMemory;
+
 	// player variables
 	Player player_;
 	b2Body* player_body_;
 
 	// enemy variables;
 
-	std::vector<GroundEnemy> groundEnemyVec;
+	LevelGroundEnemyVec groundEnemyVec;
+
+	// abilities picked up during the physics step
+	// waiting to be applied
+
+	AbilityEventQueue abilityEvents;
+
+	// activity region variables
+
+	ActivityRegionManager activityRegions;
+
+	// hot reload variables
+
+	FileWatcher hotReloadWatcher;
+	TuningFile tuningFile;
+	LevelLayout levelLayout;
+	int tuningFileIndex;
+	int levelLayoutFileIndex;
+
+	// spatial hash variables
+	// results is reused by every query to save allocating
+
+	SpatialHash spatialHash;
+	int playerSpatialHandle;
+	std::vector<int> enemySpatialHandles;
+	std::vector<int> movPlatformSpatialHandles;
+	std::vector<GameObject*> spatialResults;
+
+	// input recording variables
+	// each tick of player input, saved as a farm script
+
+	InputScript recordedInput;
+
+	// enemy navigation variables
+
+	NavGraph navGraph;
+	NavPlanner navPlanner;
+
+	// patrol enemy variables
+	// hits is reused every update to save allocating
+
+	PatrolEnemyManager patrolEnemies;
+	std::vector<int> patrolHits;
+
+	// flying swarm variables
+
+	FlyingSwarm flyingSwarm;
+
+	// physics query variables
+	// tickets of the queries asked for, left invalid for none
+
+	PhysicsQueries physicsQueries;
+	PhysicsQueryTicket groundProbeTickets[2];
+	std::vector<PhysicsQueryTicket> enemySightTickets;
+
+	// destruction variables
+	// bodies queued during the step are destroyed once it's done
+
+	DestructionQueue destructionQueue;
+	DestructibleBlocks destructibleBlocks;
+	int pickupSpatialHandles[PICKUP_ABILITY_NUM];
+
+	// spawner variables
+
+	EntitySpawner spawner;
+	int debrisArchetype;
 
 	// spike variables
 	gef::Mesh* spikeMesh_;
 	Spike spikeObj;
 	b2Body* spike_body_;
 
-	std::vector<Spike> spikes_vec;
-	std::vector<b2Body*> spikes_bodies_vec;
+	LevelSpikeVec spikes_vec;
+	LevelBodyVec spikes_bodies_vec;
 
 	// collectable / ability pickup variables
 
@@ -246,6 +462,10 @@ private:
 	GameObject resetWallPickup_;
 	b2Body* resetWallPickup_body_;
 
+	// ability pickup sphere at each level of detail
+	// picked each frame from its size on screen
+	gef::Mesh* abilityPickupLodMeshes[PrimitiveBuilder::kNumSphereLods];
+
 
 	// ground variables - solid ground, platforms, out of bounds
 
@@ -263,8 +483,8 @@ private:
 	b2Body* small_platform_body;
 	gef::Mesh* small_platform_mesh_SA;
 
-	std::vector<GameObject> small_platforms_SA;
-	std::vector<b2Body*> small_platform_bodies_SA;
+	LevelObjectVec small_platforms_SA;
+	LevelBodyVec small_platform_bodies_SA;
 
 	// platforms - middle area
 
@@ -274,8 +494,8 @@ private:
 	b2Body* medium_platform_body;
 	gef::Mesh* medium_platform_mesh_MA;
 
-	std::vector<GameObject> medium_platforms_MA;
-	std::vector<b2Body*> medium_platform_bodies_MA;
+	LevelObjectVec medium_platforms_MA;
+	LevelBodyVec medium_platform_bodies_MA;
 
 	// big platforms
 
@@ -283,8 +503,8 @@ private:
 	b2Body* big_platform_body;
 	gef::Mesh* big_platform_mesh_;
 
-	std::vector<GameObject> big_platforms_vec;
-	std::vector<b2Body*> big_platform_bodies_vec;
+	LevelObjectVec big_platforms_vec;
+	LevelBodyVec big_platform_bodies_vec;
 	
 	// moving platforms - all areas
 
@@ -292,8 +512,12 @@ private:
 	b2Body* movPlatform_body;
 	gef::Mesh* movPlatform_mesh;
 
-	std::vector<MovingPlatform> movPlatformsVec;
-	std::vector<b2Body*> movPlatform_bodies_vec;
+	LevelMovingPlatformVec movPlatformsVec;
+	LevelBodyVec movPlatform_bodies_vec;
+
+	// routes for the moving platforms and ground enemies
+	std::vector<PatrolRoute> movPlatformRoutes;
+	std::vector<PatrolRoute> enemyRoutes;
 
 
 	// wall variables
@@ -313,8 +537,8 @@ private:
 	GameObject very_small_plat_;
 	b2Body* very_small_plat_body_;
 
-	std::vector<GameObject> very_small_plat_vec;
-	std::vector<b2Body*> very_small_plat_bodies_vec;
+	LevelObjectVec very_small_plat_vec;
+	LevelBodyVec very_small_plat_bodies_vec;
 
 	// blocking walls
 
@@ -322,8 +546,8 @@ private:
 	GameObject blocking_wall_;
 	b2Body* blocking_wall_body_;
 
-	std::vector<GameObject> blocking_wall_vec;
-	std::vector<b2Body*> blocking_wall_bodies_vec;
+	LevelObjectVec blocking_wall_vec;
+	LevelBodyVec blocking_wall_bodies_vec;
 
 	// bigger blocking walls
 
@@ -331,8 +555,8 @@ private:
 	GameObject bigger_blocking_wall_;
 	b2Body* bigger_blocking_wall_body_;
 
-	std::vector<GameObject> bigger_blocking_wall_vec;
-	std::vector<b2Body*> bigger_blocking_wall_bodies_vec;
+	LevelObjectVec bigger_blocking_wall_vec;
+	LevelBodyVec bigger_blocking_wall_bodies_vec;
 
 	// area walls
 
@@ -340,8 +564,8 @@ private:
 	GameObject area_wall_;
 	b2Body* area_wall_body_;
 
-	std::vector<GameObject> area_walls_vec;
-	std::vector<b2Body*> area_walls_bodies_vec;
+	LevelObjectVec area_walls_vec;
+	LevelBodyVec area_walls_bodies_vec;
 
 	// reset wall variables
 
@@ -349,12 +573,18 @@ private:
 	GameObject reset_wall_;
 	b2Body* reset_wall_body_;
 
-	std::vector<GameObject> reset_walls_vec;
-	std::vector<b2Body*> reset_walls_bodies_vec;
+	LevelObjectVec reset_walls_vec;
+	LevelBodyVec reset_walls_bodies_vec;
 
 	// control variables
-	const gef::Keyboard* kb;
-	const gef::SonyController* controller;
+	// keyboard and controller mapped to actions
+	ActionInput action_input_;
+
+	// input latency variables
+	// measures the time from an input to the frame drawing its result
+
+	InputLatencyTracker inputLatency;
+	bool handleInputBeforePhysics;
 
 	// camera bool
 	bool cameraSwitch;